@@ -3,6 +3,8 @@
 
 #include "rs232int.h"                       // Include header for serial port class
 #include "Solenoid.h"
+#include "params.h"                         // The pulse width is one of the settings
+#include "shot_trace.h"                     // For timing the stages of each shot
 
 /*
  * two-wire constructor.
@@ -26,8 +28,10 @@ Solenoid::Solenoid( emstream *p_serial_port,
 
 void Solenoid::release() {
    *p_port |= (1 << activation_Pin);
-   _delay_ms(200);
+   p_shots->mark(SHOT_ENERGISED);
+   vTaskDelay(configMS_TO_TICKS(p_params->get(&machine_params::fire_pulse_ms)));
   *p_port &= ~(1 << activation_Pin);
+   p_shots->mark(SHOT_RELEASED);
    doneFiring->put(true);
 }
 
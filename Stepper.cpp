@@ -48,7 +48,8 @@ http://www.arduino.cc/en/Tutorial/Stepper
 
 #include "rs232int.h"                       // Include header for serial port class
 #include "Stepper.h"
-#define ROTATIONS_PER_MINUTE 80
+#include "params.h"                         // The speed is one of the settings
+#include "shot_trace.h"                     // For timing the stages of each shot
 
 /*
  * two-wire constructor.
@@ -76,8 +77,9 @@ Stepper::Stepper( emstream *p_serial_port,
   // setup the pins on the microcontroller:
   *p_ddr |= (1 << motor_pin_1) | (1 << motor_pin_2);
 
-  //hard coded to 20 rotations per minute
-  step_delay = 60L * 1000L / number_of_steps / ROTATIONS_PER_MINUTE;
+  //start at the speed saved in the settings
+  step_delay = 60L * 1000000L / number_of_steps 
+               / p_params->get (&machine_params::stepper_rpm);
 
   DBG(ptr_to_serial, "Motor driver 2 pins constructor OK" << endl);
 }
@@ -108,8 +110,9 @@ Stepper::Stepper( emstream *p_serial_port,
 
   p_port = pPort;
 
-  //hard coded to 20 rotations per minute
-  step_delay = 60L * 1000L / number_of_steps / ROTATIONS_PER_MINUTE;
+  //start at the speed saved in the settings
+  step_delay = 60L * 1000000L / number_of_steps 
+               / p_params->get (&machine_params::stepper_rpm);
 
   // setup the pins on the microcontroller:
   *p_ddr |= (1 << motor_pin_1) | (1 << motor_pin_2) | (1 << motor_pin_3) | (1 << motor_pin_4);
@@ -122,7 +125,7 @@ Stepper::Stepper( emstream *p_serial_port,
 */
 void Stepper::setSpeed(uint64_t whatSpeed)
 {
-  step_delay = 60L * 1000L / number_of_steps / whatSpeed;
+  step_delay = 60L * 1000000L / number_of_steps / whatSpeed;
 
 }
 
@@ -140,8 +143,8 @@ void Stepper::step(int16_t steps_to_move)
   
   // decrement the number of steps, moving one step each time:
   while(steps_left > 0) {
-    // move only if the appropriate delay has passed:
-    myDelayMS(step_delay);
+    // move only if the appropriate delay has passed; other tasks run meanwhile
+    frt_delay_us(step_delay);
     // get the timeStamp of when you stepped:
     // increment or decrement the step number,
     // depending on direction:
@@ -161,8 +164,10 @@ void Stepper::step(int16_t steps_to_move)
     steps_left--;
     // step the motor to step number 0, 1, 2, or 3:
     stepMotor(step_number % 4);
+    p_shots->mark(SHOT_FIRST_STEP);
   }
   stepperDone->put(true);
+  p_shots->mark_axis(SHOT_AXIS_STEPPER);
 }
 
 /*
@@ -223,10 +228,4 @@ void Stepper::stepMotor(uint8_t thisStep)
 void Stepper::printStatus(void){
   DBG(ptr_to_serial, "Step number: " << step_number << endl);
   DBG(ptr_to_serial, "Total number of steps: " << number_of_steps << endl);
-}
-
-void Stepper::myDelayMS(uint64_t waitTime) {
-  while(waitTime--) {
-    _delay_ms(1);
-  }
 } 
\ No newline at end of file
@@ -56,6 +56,7 @@
 #include "frt_shared_data.h"                // Header for thread-safe shared data
 #include "frt_text_queue.h"                 // Header for text queue class
 #include "shares.h"
+#include "frt_delay_us.h"                  // Sleeping between steps in microseconds
 
 // library interface description
 class Stepper {
@@ -86,10 +87,9 @@ class Stepper {
     void printStatus(void);
   protected:
     void stepMotor(uint8_t thisStep);
-    void myDelayMS(uint64_t waitTime);
     
     uint8_t direction;        // Direction of rotation
-    uint64_t step_delay;    // delay between steps, in ms, based on speed
+    uint32_t step_delay;    // delay between steps, in us, based on speed
     uint16_t number_of_steps;      // total number of steps this motor can take
     uint32_t step_number;        // which step the motor is on
     
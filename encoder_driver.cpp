@@ -9,6 +9,7 @@
 
 #include "rs232int.h"                       // Include header for serial port class
 #include "encoder_driver.h"                 // Include header for the encoder class
+#include "isr_profile.h"                    // For timing the encoder ISR
 
 //-------------------------------------------------------------------------------------
 /**\brief This constructor sets up a encoder driver. 
@@ -66,6 +67,8 @@ ISR (INT4_vect) {
    static uint8_t lastA = 0, lastB = 0;
    uint8_t currentA, currentB;
 
+   ISR_PROFILE_START (ISR_PROF_ENCODER);
+
    currentA = PINE & (1 << PE4);
    currentB = PINE & (1 << PE5);
 
@@ -125,6 +128,8 @@ ISR (INT4_vect) {
    }
    lastA = currentA;
    lastB = currentB;
+
+   ISR_PROFILE_END (ISR_PROF_ENCODER);
 }
 
 /**
@@ -54,6 +54,9 @@
 nRF24L01_base::nRF24L01_base (emstream* debug_port)
 {
 	p_serport = debug_port;                 // Save pointer to serial port
+	tx_packets = 0;
+	tx_retries = 0;
+	tx_failures = 0;
 
 	// Set up the SPI port and make its bits inputs or outputs as needed
 	nRF_DDR_SPI &= ~nRF_MASK_MISO;                // Set MISO as an input
@@ -205,18 +208,31 @@ bool nRF24L01_base::transmit (uint8_t* buffer)
 	while (((cmd[1] & (nRF24_TX_DS | nRF24_MAX_RT)) == 0) 
 			&& (++timeout < nRF24_SEND_TIMEOUT));
 
-	// Save an indication of whether the transmission was successful
-	bool success = (cmd[0] & nRF24_TX_DS) != 0;
+	// Save an indication of whether the transmission was successful. The status
+	// register's contents are used, not the status byte sent back with the command,
+	// because the packet may have finished going out between the two
+	bool success = (cmd[1] & nRF24_TX_DS) != 0;
 
 	// If something went wrong, the TX_DS bit will be 0; complain about it
-	if (((cmd[0] & nRF24_TX_DS) == 0) && p_serport)
+	if (!success && p_serport)
 	{
-		*p_serport << PMS ("TX error: ") << bin << cmd[0] << dec << endl;
+		*p_serport << PMS ("TX error: ") << bin << cmd[1] << dec << endl;
 	}
 
-	// Clear the TX_DS bit
+	// Count the packet; the low 4 bits of OBSERVE_TX are the retries it needed
+	cmd[0] = nRF24_RD_REG | nRF24_REG_OBS_TX;
+	cmd[1] = 0x00;
+	nRF24_spi_transfer (cmd, 2);
+	tx_packets++;
+	tx_retries += cmd[1] & 0x0F;
+	if (!success)
+	{
+		tx_failures++;
+	}
+
+	// Clear the TX_DS bit, and MAX_RT, which would stop any more sending if set
 	cmd[0] = nRF24_WR_REG | nRF24_REG_STATUS;
-	cmd[1] = nRF24_TX_DS;
+	cmd[1] = nRF24_TX_DS | nRF24_MAX_RT;
 	nRF24_spi_transfer (cmd, 2);
 
 	// Turn the receiver back on again
@@ -227,6 +243,106 @@ bool nRF24L01_base::transmit (uint8_t* buffer)
 }
 
 
+//-------------------------------------------------------------------------------------
+/** This method sets the RF channel on which the radio sends and receives. The radio
+ *  works at (2400 + channel) MHz. Setting the channel also clears the count of lost
+ *  packets in the radio's OBSERVE_TX register. 
+ *  @param channel The channel number, from 0 to 125
+ */
+
+void nRF24L01_base::set_channel (uint8_t channel)
+{
+	uint8_t cmd[2];                         // Temporary storage for commands & data
+
+	if (channel <= 125)
+	{
+		cmd[0] = nRF24_WR_REG | nRF24_REG_RF_CH;
+		cmd[1] = channel;
+		nRF24_spi_transfer (cmd, 2);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the number of the RF channel which the radio is using.
+ *  @return The channel number, from 0 to 125
+ */
+
+uint8_t nRF24L01_base::get_channel (void)
+{
+	uint8_t cmd[2];                         // Temporary storage for commands & data
+
+	cmd[0] = nRF24_RD_REG | nRF24_REG_RF_CH;
+	cmd[1] = 0x00;
+	nRF24_spi_transfer (cmd, 2);
+
+	return (cmd[1] & 0x7F);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks the radio's carrier detect bit, which is set when the receiver
+ *  hears a signal on its channel. The receiver must have been on for about 170 us on
+ *  the channel before the bit means anything. 
+ *  @return True if a carrier was detected, false if the channel seems quiet
+ */
+
+bool nRF24L01_base::carrier_detected (void)
+{
+	uint8_t cmd[2];                         // Temporary storage for commands & data
+
+	cmd[0] = nRF24_RD_REG | nRF24_REG_CD;
+	cmd[1] = 0x00;
+	nRF24_spi_transfer (cmd, 2);
+
+	return ((cmd[1] & 0x01) != 0);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method turns on auto-acknowledgement for all pipes, so that the radio resends
+ *  each packet until the receiver acks it or the retries are used up. The retries 
+ *  are then counted by \c transmit(), giving a measure of how busy the channel is. 
+ *  For the acks to be heard, the receiver address of Pipe 0 must be the same as the
+ *  transmitter address, and both radios must have auto-acknowledgement turned on.
+ *  @param delay_code The wait between retries, in units of 250 us, minus one (0-15)
+ *  @param retries The largest number of times to resend a packet (0-15)
+ */
+
+void nRF24L01_base::set_auto_retry (uint8_t delay_code, uint8_t retries)
+{
+	uint8_t cmd[2];                         // Temporary storage for commands & data
+
+	cmd[0] = nRF24_WR_REG | nRF24_REG_EN_AA;
+	cmd[1] = 0b00111111;
+	nRF24_spi_transfer (cmd, 2);
+
+	cmd[0] = nRF24_WR_REG | nRF24_REG_SETUP_RETR;
+	cmd[1] = ((delay_code & 0x0F) << 4) | (retries & 0x0F);
+	nRF24_spi_transfer (cmd, 2);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method gets the numbers of packets sent, retries and failed sends counted by
+ *  \c transmit() since the last time it was called, then sets them all to zero. 
+ *  @param packets A reference to a variable which gets the number of packets sent
+ *  @param retries A reference to a variable which gets the number of retries
+ *  @param failures A reference to a variable which gets the number of failed sends
+ */
+
+void nRF24L01_base::take_tx_counts (uint16_t& packets, uint16_t& retries, 
+									uint16_t& failures)
+{
+	packets = tx_packets;
+	retries = tx_retries;
+	failures = tx_failures;
+	tx_packets = 0;
+	tx_retries = 0;
+	tx_failures = 0;
+}
+
+
 //-------------------------------------------------------------------------------------
 /** This method resets the radio. It can be used if the radio gets into an unknown
  *  state. It sets the following configuration:
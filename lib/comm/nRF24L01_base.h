@@ -293,6 +293,16 @@ class nRF24L01_base
 		/// radio modem code. Left blank, it defaults to NULL and no debugging info
 		emstream* p_serport;
 
+		/// The number of packets which \c transmit() has tried to send.
+		uint16_t tx_packets;
+
+		/// The number of times the radio has resent packets because no ack came back;
+		/// this only counts when auto-acknowledgement has been turned on.
+		uint16_t tx_retries;
+
+		/// The number of packets which couldn't be sent at all.
+		uint16_t tx_failures;
+
 	// Public methods can be called from anywhere in the program where there is a 
 	// pointer or reference to an object of this class
 	public:
@@ -338,6 +348,21 @@ class nRF24L01_base
 
 		// This method checks if there is a packet of data available
 		bool data_ready (void);
+
+		// Set the RF channel on which the radio sends and receives
+		void set_channel (uint8_t);
+
+		// Find which RF channel the radio is using
+		uint8_t get_channel (void);
+
+		// Check if the receiver hears a carrier on the channel it's tuned to
+		bool carrier_detected (void);
+
+		// Turn on auto-acknowledgement with the given retry delay and count
+		void set_auto_retry (uint8_t, uint8_t);
+
+		// Get the numbers of packets sent, retries and failures, and zero them
+		void take_tx_counts (uint16_t&, uint16_t&, uint16_t&);
 };
 
 // This function transfers information through the SPI port to the radio and receives 
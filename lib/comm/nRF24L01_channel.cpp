@@ -0,0 +1,314 @@
+//*************************************************************************************
+/** \file nRF24L01_channel.cpp
+ *    This file contains the methods of a class which moves a pair of nRF24L01
+ *    radios together to the quietest RF channel.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For memset()
+#include <avr/io.h>                         // For the radio's chip enable pin
+#include <util/delay.h>                     // For the short waits between samples
+
+#include "nRF24L01_channel.h"               // Header for this file
+
+
+// This is the channel chooser which gets packets from the radio's receiver interrupt
+nRF24L01_channel* p_nRF24_channel = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets up a channel chooser and tunes the radio to the home
+ *  channel. Both ends must be given the same home channel and survey range.
+ *  @param p_a_radio The radio whose channel is chosen
+ *  @param master True at the end which decides when to move, false at the other
+ *  @param a_home The channel on which both ends start, from 0 to 125
+ *  @param first The lowest channel to be surveyed (default 2)
+ *  @param last The highest channel to be surveyed (default 80)
+ *  @param a_threshold The number of retries and failures per 100 packets sent which
+ *                     causes a new survey (default 25)
+ *  @param confirm_ms The time in milliseconds within which something must be heard
+ *                    on a new channel for a move to be kept (default 1000 ms)
+ *  @param p_ser_dev A serial device for debugging messages (default: NULL, none)
+ */
+
+nRF24L01_channel::nRF24L01_channel (nRF24L01_base* p_a_radio, bool master,
+									uint8_t a_home, uint8_t first, uint8_t last,
+									uint8_t a_threshold, uint16_t confirm_ms,
+									emstream* p_ser_dev)
+{
+	p_radio = p_a_radio;
+	p_serial = p_ser_dev;
+	is_master = master;
+	home = a_home;
+	first_channel = first;
+	last_channel = (last <= 125) ? last : 125;
+	threshold = a_threshold;
+	confirm_ticks = configMS_TO_TICKS ((uint32_t)confirm_ms);
+
+	channel = home;
+	previous = home;
+	requested = nRF_NO_CHANNEL;
+	confirming = false;
+	heard = false;
+	heard_at = 0;
+	moved_at = 0;
+	checked_at = 0;
+	last_rate = 0;
+	last_busy = 0;
+
+	surveys = 0;
+	moves = 0;
+	reverts = 0;
+
+	p_radio->set_channel (home);
+	p_nRF24_channel = this;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method listens to each channel in the survey range and counts how many times
+ *  the receiver's carrier detect bit is set. The receiver has to settle for a while
+ *  on each channel before it can tell; the calling task sleeps for that time, so 
+ *  other tasks run between channels and only the checks themselves, under a 
+ *  millisecond per channel, keep the processor busy. A survey of 80 channels takes 
+ *  about 200 ms, during which nothing can be received; the radio is tuned back to 
+ *  the channel in use afterwards. This method must be called from a task, as it 
+ *  sleeps.
+ *  @param samples The number of times to check each channel (default 16)
+ *  @return The channel on which a carrier was detected least often
+ */
+
+uint8_t nRF24L01_channel::survey (uint8_t samples)
+{
+	uint8_t best = channel;
+	uint8_t fewest = 0xFF;
+
+	for (uint8_t a_channel = first_channel; a_channel <= last_channel; a_channel++)
+	{
+		// The receiver must be off while it's being tuned. It needs about 200 us to 
+		// settle; sleeping for two ticks makes sure at least one whole tick goes by
+		nRF_PORT_CE &= ~nRF_MASK_CE;
+		p_radio->set_channel (a_channel);
+		nRF_PORT_CE |= nRF_MASK_CE;
+		vTaskDelay (configMS_TO_TICKS (1) + 1);
+
+		uint8_t busy = 0;
+		for (uint8_t count = 0; count < samples; count++)
+		{
+			if (p_radio->carrier_detected ())
+			{
+				busy++;
+			}
+			_delay_us (40);
+		}
+
+		if (busy < fewest)
+		{
+			fewest = busy;
+			best = a_channel;
+		}
+	}
+
+	nRF_PORT_CE &= ~nRF_MASK_CE;
+	p_radio->set_channel (channel);
+	nRF_PORT_CE |= nRF_MASK_CE;
+
+	surveys++;
+	last_busy = fewest;
+	DBG (p_serial, PMS ("Quietest channel ") << best << PMS (", ") << fewest
+		 << PMS (" of ") << samples << PMS (" busy") << endl);
+
+	return (best);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method tunes the radio to another channel. A move made on purpose must be
+ *  confirmed by hearing from the other end on the new channel; a move back to an
+ *  old channel needn't be.
+ *  @param new_channel The channel to which to move
+ *  @param confirm True if the move must be confirmed or else undone
+ */
+
+void nRF24L01_channel::move_to (uint8_t new_channel, bool confirm)
+{
+	previous = channel;
+	channel = new_channel;
+	p_radio->set_channel (new_channel);
+
+	portENTER_CRITICAL ();
+	heard = false;
+	portEXIT_CRITICAL ();
+
+	moved_at = xTaskGetTickCount ();
+	confirming = confirm;
+	if (confirm)
+	{
+		moves++;
+	}
+	else
+	{
+		reverts++;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method tells the other end to move to another channel, then moves there too.
+ *  Switch messages aren't acked, so the message is sent a few times.
+ *  @param new_channel The channel to which both ends should move
+ */
+
+void nRF24L01_channel::switch_to (uint8_t new_channel)
+{
+	uint8_t packet[33];
+
+	if (new_channel == channel || new_channel > 125)
+	{
+		return;
+	}
+
+	memset (packet, 0, sizeof (packet));
+	packet[1] = nRF_CHANNEL_MARK;
+	packet[2] = nRF_CHANNEL_SWITCH;
+	packet[3] = new_channel;
+	packet[4] = ~new_channel;
+	for (uint8_t count = 0; count < nRF_CHANNEL_REPEATS; count++)
+	{
+		p_radio->transmit (packet);
+	}
+
+	move_to (new_channel, true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method should be called every few milliseconds by the task which owns the
+ *  radio. It moves to a channel the other end has asked for, keeps or undoes a move
+ *  depending on whether anything has been heard since, and goes home if nothing has
+ *  been heard for a long time. At the master, it also checks the retry rate every
+ *  second and surveys for a quieter channel if the rate is too high.
+ */
+
+void nRF24L01_channel::service (void)
+{
+	uint8_t wanted;
+	bool got_one;
+	portTickType last_heard;
+	portTickType now = xTaskGetTickCount ();
+
+	portENTER_CRITICAL ();
+	wanted = requested;
+	requested = nRF_NO_CHANNEL;
+	got_one = heard;
+	last_heard = heard_at;
+	portEXIT_CRITICAL ();
+
+	// The follower moves as soon as the other end asks it to
+	if (wanted != nRF_NO_CHANNEL && wanted != channel)
+	{
+		move_to (wanted, true);
+		return;
+	}
+
+	if (confirming)
+	{
+		if (got_one)
+		{
+			confirming = false;
+		}
+		else if ((now - moved_at) >= confirm_ticks)
+		{
+			DBG (p_serial, PMS ("Nothing heard on channel ") << channel << endl);
+			move_to (previous, false);
+		}
+		return;
+	}
+
+	// If the other end has been lost, meet it back on the home channel
+	if (channel != home && (now - moved_at) >= 3 * confirm_ticks
+		&& (!got_one || (now - last_heard) >= 3 * confirm_ticks))
+	{
+		DBG (p_serial, PMS ("Link lost; back to channel ") << home << endl);
+		move_to (home, false);
+		return;
+	}
+
+	if (!is_master || (now - checked_at) < configMS_TO_TICKS (1000))
+	{
+		return;
+	}
+	checked_at = now;
+
+	uint16_t packets, retries, failures;
+	p_radio->take_tx_counts (packets, retries, failures);
+	if (packets < nRF_CHANNEL_MIN_PACKETS)
+	{
+		return;
+	}
+	last_rate = (uint16_t)(((uint32_t)retries + failures) * 100 / packets);
+
+	if (last_rate >= threshold)
+	{
+		switch_to (survey ());
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called by the radio's receiver interrupt when a channel switch
+ *  message arrives. The move itself is made later by \c service(), as tuning the
+ *  radio from within the interrupt could upset a transfer the task was making. It
+ *  must only be called from within an interrupt service routine.
+ *  @param p_payload A pointer to the 32 byte payload, beginning with the mark
+ */
+
+void nRF24L01_channel::ISR_receive (const uint8_t* p_payload)
+{
+	if (p_payload[1] == nRF_CHANNEL_SWITCH && p_payload[2] <= 125
+		&& p_payload[3] == (uint8_t)~p_payload[2])
+	{
+		requested = p_payload[2];
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called by the radio's receiver interrupt whenever any packet
+ *  arrives, showing that the other end can be heard on the channel in use. It must
+ *  only be called from within an interrupt service routine.
+ */
+
+void nRF24L01_channel::ISR_heard (void)
+{
+	heard = true;
+	heard_at = xTaskGetTickCountFromISR ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the channel in use, the retry rate found at the last check,
+ *  and the numbers of surveys, moves, and moves undone.
+ *  @param ser_dev A pointer to the serial device on which to print
+ */
+
+void nRF24L01_channel::print_stats (emstream* ser_dev)
+{
+	*ser_dev << PMS ("Radio channel ") << channel << PMS (", retries ") << last_rate
+			 << PMS ("%, ") << surveys << PMS (" surveys (quietest ") << last_busy
+			 << PMS (" busy), ") << moves << PMS (" moves, ") << reverts
+			 << PMS (" undone") << endl;
+}
@@ -0,0 +1,181 @@
+//*************************************************************************************
+/** \file nRF24L01_channel.h
+ *    This file contains a class which keeps a pair of nRF24L01 radios on a quiet RF
+ *    channel. It surveys the channels with the radio's carrier detect bit, moves
+ *    both ends to the quietest one with a switch message, and surveys again when
+ *    the retry rate shows that the channel in use has become busy.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _NRF24L01_CHANNEL_H_
+#define _NRF24L01_CHANNEL_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For the RTOS tick count
+#include "emstream.h"                       // Header for base serial devices
+#include "nRF24L01_base.h"                  // Header for base nRF24L01 radio driver
+
+
+/** This byte begins every channel switch packet, so the radio's receiver interrupt
+ *  can tell these packets from text, replication and star network packets.
+ */
+#define nRF_CHANNEL_MARK		0x03
+
+/// This code in a packet's second byte means the packet asks for a channel switch.
+#define nRF_CHANNEL_SWITCH		0x01
+
+/// This is the number of times a switch message is sent, as it isn't acked.
+#define nRF_CHANNEL_REPEATS		3
+
+/// This value in place of a channel number means no channel.
+#define nRF_NO_CHANNEL			0xFF
+
+/// This is the fewest packets sent in a check period for the retry rate to count.
+#define nRF_CHANNEL_MIN_PACKETS	20
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class moves two nRF24L01 radios together to the quietest RF channel.
+ *  \details One end is the master, which decides when to move; the other follows.
+ *  Every second or so, the master's \c service() works out how many retries and
+ *  failed sends there were per packet sent. If that rate reaches the threshold, the
+ *  master surveys the channels and, if a quieter one is found, sends the follower a
+ *  switch message a few times and then moves to the new channel itself. Retries are
+ *  only counted when auto-acknowledgement has been turned on with
+ *  \c nRF24L01_base::set_auto_retry(); otherwise only failed sends count.
+ *
+ *  A move is kept only if something is heard from the other end on the new channel
+ *  within the confirmation time; if not, the switch message was probably lost, so
+ *  the radio goes back to the channel it came from. An end which hears nothing at
+ *  all for three confirmation times goes back to the home channel which both ends
+ *  were given, so the two can always find each other again. Both ends must
+ *  therefore send something regularly, such as the heartbeats of a replicator or
+ *  the polls and replies of a star network. On a one-way link, where only one end 
+ *  sends, a move can't be confirmed: the master never hears the follower, so each 
+ *  move it makes is undone when the confirmation time runs out, and a follower which
+ *  misses the switch message is only found again when both go back home. Channel 
+ *  moves should therefore only be used on links where both ends send.
+ *  \code
+ *  nRF24L01_channel* p_agile = new nRF24L01_channel (p_radio, true, 76);
+ *  p_agile->switch_to (p_agile->survey ());     // When the link starts up
+ *  ...
+ *  p_agile->service ();                         // Every few ms in the radio task
+ *  \endcode
+ */
+
+class nRF24L01_channel
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The radio whose channel is chosen.
+		nRF24L01_base* p_radio;
+
+		/// A serial device for debugging messages, or NULL for none.
+		emstream* p_serial;
+
+		/// True at the end which decides when to move, false at the follower.
+		bool is_master;
+
+		/// The channel both ends use when they start and go back to when lost.
+		uint8_t home;
+
+		/// The lowest and highest channels which are surveyed.
+		uint8_t first_channel, last_channel;
+
+		/// The retry rate, in retries and failures per 100 packets, which causes a
+		/// new survey.
+		uint8_t threshold;
+
+		/// The channel now in use.
+		uint8_t channel;
+
+		/// The channel which was in use before the last move.
+		uint8_t previous;
+
+		/// A channel which the other end has asked to move to, or \c nRF_NO_CHANNEL.
+		uint8_t requested;
+
+		/// Set after a move until something is heard on the new channel.
+		bool confirming;
+
+		/// Set by the receiver interrupt whenever any packet arrives.
+		bool heard;
+
+		/// The tick count when a packet last arrived.
+		portTickType heard_at;
+
+		/// The tick count of the last move to another channel.
+		portTickType moved_at;
+
+		/// The tick count when the retry rate was last checked.
+		portTickType checked_at;
+
+		/// The time in RTOS ticks within which a move must be confirmed.
+		portTickType confirm_ticks;
+
+		/// The retry rate found at the last check, per 100 packets.
+		uint16_t last_rate;
+
+		/// The number of busy samples on the quietest channel in the last survey.
+		uint8_t last_busy;
+
+		uint16_t surveys;                   ///< Channel surveys done
+		uint16_t moves;                     ///< Moves to another channel
+		uint16_t reverts;                   ///< Moves undone or abandoned
+
+		// Tune the radio to another channel and wait for the move to be confirmed
+		void move_to (uint8_t, bool);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor tunes the radio to the home channel
+		nRF24L01_channel (nRF24L01_base*, bool, uint8_t, uint8_t = 2, uint8_t = 80,
+						  uint8_t = 25, uint16_t = 1000, emstream* = NULL);
+
+		// Listen to each channel in the survey range and find the quietest one
+		uint8_t survey (uint8_t = 16);
+
+		// Tell the other end to move to a channel, then move there too
+		void switch_to (uint8_t);
+
+		// Follow or confirm moves, and survey again if the retry rate is too high
+		void service (void);
+
+		// Take a switch message which has arrived
+		void ISR_receive (const uint8_t*);
+
+		// Note that a packet of any kind has arrived from the other end
+		void ISR_heard (void);
+
+		// Print the channel in use and the numbers of surveys and moves
+		void print_stats (emstream*);
+
+		/** This method returns the channel which the radio is now using.
+		 *  @return The channel number, from 0 to 125
+		 */
+		uint8_t get_channel (void)
+		{
+			return (channel);
+		}
+};
+
+
+/// This is the channel chooser which gets packets from the radio's receiver interrupt.
+extern nRF24L01_channel* p_nRF24_channel;
+
+#endif // _NRF24L01_CHANNEL_H_
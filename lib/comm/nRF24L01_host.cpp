@@ -0,0 +1,625 @@
+//*************************************************************************************
+/** \file nRF24L01_host.cpp
+ *    This file contains a simulated nRF24L01 radio chip which lets the radio drivers
+ *    run on a PC, and the simulated air which carries packets between simulated
+ *    radios. It isn't compiled for the AVR.
+ *
+ *    The chip's registers, FIFO's and SPI commands are simulated closely enough for
+ *    the drivers in this directory. A packet is put on the air when CE is high with
+ *    the chip in transmit mode; the transmitter stays busy for the packet's time on
+ *    the air, and TX_DS or MAX_RT is set when it's done. With auto-acknowledgement
+ *    on, lost tries are resent as the chip would, and counted in OBSERVE_TX; acks
+ *    themselves are never lost. A packet arrives when \c nRF24_host_poll() is called
+ *    after its delivery time, and is only received if the receiver is on and tuned
+ *    to the right channel and address at that moment. Carrier detect is set at
+ *    random on the noisy channels, which also lose that many more packets.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef __AVR__                             // Only for programs which run on a PC
+
+#include <stdlib.h>                         // For rand_r()
+#include <string.h>                         // For memcpy() and memcmp()
+#include <sys/socket.h>                     // For the socket which is the air
+
+#include "nRF24L01_host.h"                  // Header for this file
+#include "host_avr.h"                       // For the clock and the register hooks
+#include "nRF24L01_text.h"                  // For the registers and the ISR's vector
+
+
+// This is the receiver interrupt service routine in the text mode driver
+extern "C" void nRF24_IRQ_VECT (void);
+
+/// This is the largest number of packets which can be on their way at once.
+#define HOST_IN_FLIGHT			32
+
+/// These are the register numbers which hold whole addresses rather than one byte.
+#define HOST_IS_ADDRESS(reg)	((reg) == nRF24_REG_RX_ADDR_P0 \
+								 || (reg) == nRF24_REG_RX_ADDR_P1 \
+								 || (reg) == nRF24_REG_TX_ADDR)
+
+
+/** This structure is what travels through the socket: one packet and the time at
+ *  which it reaches the other radio.
+ */
+
+struct air_packet
+{
+	uint64_t deliver_at;                    ///< Time of arrival in microseconds
+	uint8_t channel;                        ///< The channel it was sent on
+	uint8_t width;                          ///< The number of bytes in the address
+	uint8_t address[5];                     ///< The address, least significant first
+	uint8_t payload[32];                    ///< The data
+};
+
+
+// The settings of the air, the socket, the random seed, and the counts
+static nRF24_air air;
+static int air_socket = -1;
+static unsigned int seed;
+static nRF24_host_stats stats;
+
+// The chip's one-byte registers, its three address registers, and its status bits
+static uint8_t regs[0x20];
+static uint8_t addr_p0[5], addr_p1[5], addr_tx[5];
+static uint8_t status_flags;
+
+// The receive and transmit FIFO's, each three packets deep
+static uint8_t rx_fifo[3][32];
+static uint8_t rx_pipe[3];
+static uint8_t rx_count;
+static uint8_t tx_fifo[3][32];
+static uint8_t tx_count;
+
+// The state of the SPI bus and the chip enable pin
+static bool csn_low;
+static bool ce_high;
+static uint8_t command;
+static uint8_t byte_index;
+
+// The packet being sent: when it's done, and which status bit it sets then
+static bool tx_running;
+static uint64_t tx_done_at;
+static uint8_t tx_result;
+
+// Packets on their way to this radio
+static air_packet in_flight[HOST_IN_FLIGHT];
+static uint8_t in_flight_count;
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds the number of bytes in the addresses, from SETUP_AW.
+ *  @return The address width, 3 to 5
+ */
+
+static uint8_t address_width (void)
+{
+	uint8_t code = regs[nRF24_REG_SETUP_AW] & 0x03;
+	return ((code == 0) ? 3 : code + 2);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function checks whether a random event with the given odds happens.
+ *  @param per_1000 How many times in a thousand it should happen
+ *  @return True if it happened this time
+ */
+
+static bool chance (uint16_t per_1000)
+{
+	return ((uint16_t)(rand_r (&seed) % 1000) < per_1000);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function checks whether a channel is one of the noisy ones.
+ *  @param channel The channel to check
+ *  @return True if the channel has interference
+ */
+
+static bool noisy (uint8_t channel)
+{
+	return (air.noise_percent > 0 && channel >= air.noise_first
+			&& channel <= air.noise_last);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function makes the status byte which the chip sends back first in every SPI
+ *  command.
+ *  @return The status byte
+ */
+
+static uint8_t status (void)
+{
+	return (status_flags | (rx_count ? (rx_pipe[0] << 1) : nRF24_RX_P_NO)
+			| ((tx_count >= 3) ? nRF24_TX_FULL : 0));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function sets TX_DS or MAX_RT once the packet being sent has finished.
+ */
+
+static void update_tx (void)
+{
+	if (tx_running && host_time_us () >= tx_done_at)
+	{
+		status_flags |= tx_result;
+		tx_running = false;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function reads one byte of a register.
+ *  @param reg The register number
+ *  @param index Which byte of the register, for the address registers
+ *  @return The byte
+ */
+
+static uint8_t read_register (uint8_t reg, uint8_t index)
+{
+	if (HOST_IS_ADDRESS (reg))
+	{
+		const uint8_t* p_address = (reg == nRF24_REG_RX_ADDR_P0) ? addr_p0
+								   : ((reg == nRF24_REG_RX_ADDR_P1) ? addr_p1 : addr_tx);
+		return ((index < address_width ()) ? p_address[index] : 0);
+	}
+	if (index > 0 || reg > nRF24_REG_FIFO_STATUS)
+	{
+		return (0);
+	}
+
+	switch (reg)
+	{
+		case nRF24_REG_STATUS:
+			return (status ());
+		case nRF24_REG_CD:
+			return ((noisy (regs[nRF24_REG_RF_CH]) && chance (air.noise_percent * 10))
+					? 1 : 0);
+		case nRF24_REG_FIFO_STATUS:
+			return ((rx_count == 0 ? 0x01 : 0) | (rx_count >= 3 ? 0x02 : 0)
+					| (tx_count == 0 ? 0x10 : 0) | (tx_count >= 3 ? 0x20 : 0));
+		default:
+			return (regs[reg]);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function writes one byte of a register.
+ *  @param reg The register number
+ *  @param index Which byte of the register, for the address registers
+ *  @param value The byte to write
+ */
+
+static void write_register (uint8_t reg, uint8_t index, uint8_t value)
+{
+	if (HOST_IS_ADDRESS (reg))
+	{
+		uint8_t* p_address = (reg == nRF24_REG_RX_ADDR_P0) ? addr_p0
+							 : ((reg == nRF24_REG_RX_ADDR_P1) ? addr_p1 : addr_tx);
+		if (index < 5)
+		{
+			p_address[index] = value;
+		}
+		return;
+	}
+	if (index > 0 || reg > nRF24_REG_FIFO_STATUS)
+	{
+		return;
+	}
+
+	switch (reg)
+	{
+		case nRF24_REG_STATUS:              // Writing a 1 clears an interrupt bit
+			status_flags &= ~(value & (nRF24_RX_DR | nRF24_TX_DS | nRF24_MAX_RT));
+			break;
+		case nRF24_REG_RF_CH:               // Changing channel clears PLOS_CNT
+			regs[reg] = value & 0x7F;
+			regs[nRF24_REG_OBS_TX] &= 0x0F;
+			break;
+		case nRF24_REG_OBS_TX:              // These registers can only be read
+		case nRF24_REG_CD:
+		case nRF24_REG_FIFO_STATUS:
+			break;
+		default:
+			regs[reg] = value;
+			break;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function puts a packet on its way to the other radio through the socket.
+ *  @param at The time in microseconds when the packet leaves the air
+ *  @param p_payload The 32 bytes of data
+ */
+
+static void send_to_air (uint64_t at, const uint8_t* p_payload)
+{
+	air_packet packet;
+
+	packet.deliver_at = at + air.latency_us
+						+ (air.jitter_us ? rand_r (&seed) % air.jitter_us : 0);
+	packet.channel = regs[nRF24_REG_RF_CH];
+	packet.width = address_width ();
+	memcpy (packet.address, addr_tx, 5);
+	memcpy (packet.payload, p_payload, 32);
+
+	send (air_socket, &packet, sizeof (packet), MSG_DONTWAIT);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function sends the packet at the front of the transmit FIFO. The packet
+ *  takes its time on the air at the simulated bit rate, after any packet which is
+ *  still being sent. With auto-acknowledgement on, a lost try is resent after the
+ *  retry delay until the retries run out.
+ */
+
+static void transmit_packet (void)
+{
+	uint64_t now = host_time_us ();
+	uint64_t at = (tx_running && tx_done_at > now) ? tx_done_at : now;
+
+	// Preamble, address, payload, CRC and 9 bits of packet control field
+	uint32_t air_us = (uint32_t)((8ULL * (1 + address_width () + 32 + 2) + 9)
+								 * 1000000ULL / air.bit_rate);
+	uint8_t retries = regs[nRF24_REG_SETUP_RETR] & 0x0F;
+	bool auto_ack = (regs[nRF24_REG_EN_AA] & 0x01) && retries > 0;
+	uint32_t retry_us = 250UL * ((regs[nRF24_REG_SETUP_RETR] >> 4) + 1);
+	uint16_t loss = air.loss_per_1000
+					+ (noisy (regs[nRF24_REG_RF_CH]) ? air.noise_percent * 10 : 0);
+
+	bool delivered = false;
+	uint8_t tries = 0;
+	while (!delivered && tries <= (auto_ack ? retries : 0))
+	{
+		if (tries++ > 0)
+		{
+			at += retry_us;
+		}
+		at += air_us;
+		stats.attempts++;
+		if (chance (loss))
+		{
+			stats.air_lost++;
+			continue;
+		}
+		send_to_air (at, tx_fifo[0]);
+		delivered = true;
+	}
+
+	// Without auto-acknowledgement, the chip never knows a packet was lost
+	tx_result = (delivered || !auto_ack) ? nRF24_TX_DS : nRF24_MAX_RT;
+	uint8_t lost = regs[nRF24_REG_OBS_TX] >> 4;
+	if (tx_result == nRF24_MAX_RT && lost < 15)
+	{
+		lost++;
+	}
+	regs[nRF24_REG_OBS_TX] = (lost << 4) | ((tries - 1) & 0x0F);
+	tx_done_at = at;
+	tx_running = true;
+	stats.sent++;
+
+	memmove (tx_fifo[0], tx_fifo[1], 2 * 32);
+	tx_count--;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called whenever an I/O port is written. It watches the CSN line
+ *  for the start and end of SPI commands, and starts sending whenever the CE line is
+ *  high in transmit mode with something in the transmit FIFO.
+ */
+
+static void pins_changed (void)
+{
+	bool csn = (nRF_PORT_SS & nRF_MASK_SS) == 0;
+	bool ce = (nRF_PORT_CE & nRF_MASK_CE) != 0;
+
+	if (csn && !csn_low)
+	{
+		byte_index = 0;
+	}
+	else if (!csn && csn_low && byte_index > 1)
+	{
+		// Reading a payload removes it; writing one adds it
+		if (command == nRF24_RD_PLD && rx_count > 0)
+		{
+			memmove (rx_fifo[0], rx_fifo[1], 2 * 32);
+			rx_pipe[0] = rx_pipe[1];
+			rx_pipe[1] = rx_pipe[2];
+			rx_count--;
+		}
+		else if (command == nRF24_WR_PLD && tx_count < 3)
+		{
+			tx_count++;
+		}
+	}
+	csn_low = csn;
+
+	ce_high = ce;
+
+	// With CE high in transmit mode, the chip sends everything in its FIFO
+	while (ce_high && (regs[nRF24_REG_CONF] & nRF24_PWR_UP)
+		   && !(regs[nRF24_REG_CONF] & nRF24_PRIM_RX) && tx_count > 0)
+	{
+		transmit_packet ();
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is given each byte which the driver writes to the SPI data
+ *  register, and returns the byte the chip sends back. It takes as long as an SPI
+ *  transfer would.
+ *  @param mosi The byte from the processor
+ *  @return The byte from the chip
+ */
+
+static uint8_t spi_exchange (uint8_t mosi)
+{
+	host_spin_us (air.spi_byte_us);
+	update_tx ();
+
+	if (!csn_low)
+	{
+		return (0xFF);
+	}
+
+	// The first byte is the command, and the chip answers it with the status
+	if (byte_index++ == 0)
+	{
+		command = mosi;
+		if (command == nRF24_FLUSH_TX)
+		{
+			tx_count = 0;
+		}
+		else if (command == nRF24_FLUSH_RX)
+		{
+			rx_count = 0;
+		}
+		return (status ());
+	}
+
+	uint8_t index = byte_index - 2;
+	if ((command & 0xE0) == nRF24_RD_REG)
+	{
+		return (read_register (command & 0x1F, index));
+	}
+	if ((command & 0xE0) == nRF24_WR_REG)
+	{
+		write_register (command & 0x1F, index, mosi);
+	}
+	else if (command == nRF24_RD_PLD)
+	{
+		return ((index < 32 && rx_count > 0) ? rx_fifo[0][index] : 0);
+	}
+	else if (command == nRF24_WR_PLD && index < 32 && tx_count < 3)
+	{
+		tx_fifo[tx_count][index] = mosi;
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds which receiver pipe, if any, is listening for an address.
+ *  @param p_address The address, least significant byte first
+ *  @return The pipe number, or 0xFF if no enabled pipe has that address
+ */
+
+static uint8_t match_pipe (const uint8_t* p_address)
+{
+	uint8_t width = address_width ();
+
+	for (uint8_t pipe = 0; pipe < 6; pipe++)
+	{
+		if (!(regs[nRF24_REG_EN_RXADDR] & (1 << pipe))
+			|| regs[nRF24_REG_PW_P0 + pipe] != 32)
+		{
+			continue;
+		}
+		if (pipe == 0)
+		{
+			if (memcmp (p_address, addr_p0, width) == 0)
+			{
+				return (0);
+			}
+		}
+		else if (p_address[0] == ((pipe == 1) ? addr_p1[0]
+								  : regs[nRF24_REG_RX_ADDR_P0 + pipe])
+				 && memcmp (p_address + 1, addr_p1 + 1, width - 1) == 0)
+		{
+			return (pipe);
+		}
+	}
+	return (0xFF);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function puts a packet which has arrived into the receive FIFO, if the chip
+ *  would have received it, and runs the receiver ISR if its interrupt is enabled.
+ *  @param p_packet The packet
+ */
+
+static void arrive (const air_packet* p_packet)
+{
+	stats.arrived++;
+
+	if (!(regs[nRF24_REG_CONF] & nRF24_PWR_UP) || !(regs[nRF24_REG_CONF] & nRF24_PRIM_RX)
+		|| !ce_high)
+	{
+		stats.not_listening++;
+		return;
+	}
+
+	uint8_t pipe = 0xFF;
+	if (p_packet->channel == regs[nRF24_REG_RF_CH] && p_packet->width == address_width ())
+	{
+		pipe = match_pipe (p_packet->address);
+	}
+	if (pipe == 0xFF)
+	{
+		stats.wrong_address++;
+		return;
+	}
+	if (rx_count >= 3)
+	{
+		stats.fifo_full++;
+		return;
+	}
+
+	memcpy (rx_fifo[rx_count], p_packet->payload, 32);
+	rx_pipe[rx_count++] = pipe;
+	status_flags |= nRF24_RX_DR;
+	stats.received++;
+
+	if (!(regs[nRF24_REG_CONF] & nRF24_INT_RX) && (nRF24_EIMSK & (1 << nRF24_IRQ_MASK)))
+	{
+		stats.interrupts++;
+		nRF24_IRQ_VECT ();
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function sets up the simulated radio as a real chip is set at power-up, and
+ *  connects it to the stand-in registers. It must be called before the radio driver
+ *  is created.
+ *  @param a_socket One end of a datagram socket; the other radio has the other end
+ *  @param p_air The settings of the air, or NULL for a perfect 2 Mbit/s link
+ *  @param a_seed The seed for the random losses, delays and noise
+ */
+
+void nRF24_host_start (int a_socket, const nRF24_air* p_air, unsigned int a_seed)
+{
+	static const uint8_t default_p0[5] = {0xE7, 0xE7, 0xE7, 0xE7, 0xE7};
+	static const uint8_t default_p1[5] = {0xC2, 0xC2, 0xC2, 0xC2, 0xC2};
+
+	air_socket = a_socket;
+	seed = a_seed;
+	memset (&air, 0, sizeof (air));
+	air.bit_rate = 2000000;
+	air.spi_byte_us = 4;
+	if (p_air != NULL)
+	{
+		air = *p_air;
+	}
+	memset (&stats, 0, sizeof (stats));
+
+	memset (regs, 0, sizeof (regs));
+	regs[nRF24_REG_CONF] = 0x08;
+	regs[nRF24_REG_EN_AA] = 0x3F;
+	regs[nRF24_REG_EN_RXADDR] = 0x03;
+	regs[nRF24_REG_SETUP_AW] = 0x03;
+	regs[nRF24_REG_SETUP_RETR] = 0x03;
+	regs[nRF24_REG_RF_CH] = 0x02;
+	regs[nRF24_REG_RF_SETUP] = 0x0F;
+	regs[nRF24_REG_RX_ADDR_P2] = 0xC3;
+	regs[nRF24_REG_RX_ADDR_P3] = 0xC4;
+	regs[nRF24_REG_RX_ADDR_P4] = 0xC5;
+	regs[nRF24_REG_RX_ADDR_P5] = 0xC6;
+	memcpy (addr_p0, default_p0, 5);
+	memcpy (addr_p1, default_p1, 5);
+	memcpy (addr_tx, default_p0, 5);
+	status_flags = 0;
+	rx_count = 0;
+	tx_count = 0;
+	tx_running = false;
+	in_flight_count = 0;
+
+	// Start with CSN high, as the chip's pull-up would hold it
+	nRF_PORT_SS |= nRF_MASK_SS;
+	csn_low = false;
+	ce_high = false;
+	host_port_hook = pins_changed;
+	host_spi_hook = spi_exchange;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function takes packets off the socket and delivers those whose time has
+ *  come, earliest first. A test program calls it often, between calls to the radio
+ *  drivers, much as the receiver interrupt could happen at any time between them.
+ */
+
+void nRF24_host_poll (void)
+{
+	update_tx ();
+
+	while (in_flight_count < HOST_IN_FLIGHT
+		   && recv (air_socket, &in_flight[in_flight_count], sizeof (air_packet),
+					MSG_DONTWAIT) == (ssize_t)sizeof (air_packet))
+	{
+		in_flight_count++;
+	}
+
+	uint64_t now = host_time_us ();
+	for (;;)
+	{
+		uint8_t earliest = 0xFF;
+		for (uint8_t index = 0; index < in_flight_count; index++)
+		{
+			if (in_flight[index].deliver_at <= now && (earliest == 0xFF
+				|| in_flight[index].deliver_at < in_flight[earliest].deliver_at))
+			{
+				earliest = index;
+			}
+		}
+		if (earliest == 0xFF)
+		{
+			break;
+		}
+
+		air_packet packet = in_flight[earliest];
+		in_flight[earliest] = in_flight[--in_flight_count];
+		arrive (&packet);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function gives the counts kept by the simulated radio.
+ *  @return A pointer to the counts
+ */
+
+const nRF24_host_stats* nRF24_host_get_stats (void)
+{
+	return (&stats);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints the counts kept by the simulated radio on one line.
+ *  @param p_file The file on which to print, such as \c stdout
+ *  @param name A name for the radio at the start of the line
+ */
+
+void nRF24_host_print_stats (FILE* p_file, const char* name)
+{
+	fprintf (p_file, "%s radio: %u sent in %u tries (%u lost in air); %u arrived, "
+			 "%u received, %u not listening, %u wrong address, %u FIFO full\n", name,
+			 stats.sent, stats.attempts, stats.air_lost, stats.arrived,
+			 stats.received, stats.not_listening, stats.wrong_address,
+			 stats.fifo_full);
+}
+
+#endif // __AVR__
@@ -0,0 +1,86 @@
+//*************************************************************************************
+/** \file nRF24L01_host.h
+ *    This file contains a simulated nRF24L01 radio chip which lets the radio drivers
+ *    run on a PC. The drivers talk to it through stand-in SPI and I/O port registers
+ *    just as they talk to a real chip, so \c nRF24L01_text, the replicator and the
+ *    star network can be tested and timed without any boards. Packets travel between
+ *    simulated radios in separate processes through a local socket, which plays the
+ *    part of the air: packets can be lost, delayed, and slowed to a given bit rate.
+ *    It isn't compiled for the AVR.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _NRF24L01_HOST_H_
+#define _NRF24L01_HOST_H_
+
+#ifndef __AVR__                             // Only for programs which run on a PC
+
+#include <stdio.h>                          // For printing the statistics
+#include <stdint.h>                         // Integer types such as uint16_t
+
+
+//-------------------------------------------------------------------------------------
+/** This structure describes the simulated air between the radios. Each radio uses
+ *  its own copy, so the two directions of a link can be made different.
+ */
+
+struct nRF24_air
+{
+	uint16_t loss_per_1000;                 ///< Packets lost per thousand sent
+	uint32_t latency_us;                    ///< Delay added to every packet
+	uint32_t jitter_us;                     ///< Largest random delay added on top
+	uint32_t bit_rate;                      ///< Bits per second on the air
+	uint32_t spi_byte_us;                   ///< Time to move one byte over SPI
+	uint8_t noise_first;                    ///< Lowest channel with interference
+	uint8_t noise_last;                     ///< Highest channel with interference
+	uint8_t noise_percent;                  ///< How often those channels are busy
+};
+
+
+//-------------------------------------------------------------------------------------
+/** This structure holds the counts kept by a simulated radio.
+ */
+
+struct nRF24_host_stats
+{
+	uint32_t sent;                          ///< Packets put on the air
+	uint32_t attempts;                      ///< Tries, including automatic resends
+	uint32_t air_lost;                      ///< Tries lost in the air
+	uint32_t arrived;                       ///< Packets which reached this radio
+	uint32_t received;                      ///< Packets put into the receive FIFO
+	uint32_t not_listening;                 ///< Arrived with the receiver off
+	uint32_t wrong_address;                 ///< Arrived for another channel or address
+	uint32_t fifo_full;                     ///< Arrived with the receive FIFO full
+	uint32_t interrupts;                    ///< Calls to the receiver ISR
+};
+
+
+// Connect the simulated radio to the registers and to one end of a datagram socket
+void nRF24_host_start (int, const nRF24_air*, unsigned int);
+
+// Deliver packets whose time has come and run the receiver ISR if it's enabled
+void nRF24_host_poll (void);
+
+// Get the simulated radio's counts
+const nRF24_host_stats* nRF24_host_get_stats (void);
+
+// Print the simulated radio's counts
+void nRF24_host_print_stats (FILE*, const char*);
+
+#endif // __AVR__
+
+#endif // _NRF24L01_HOST_H_
@@ -0,0 +1,343 @@
+//*************************************************************************************
+/** \file nRF24L01_replicator.cpp
+ *    This file contains the methods of the classes which keep shared data items the
+ *    same on two computers connected by nRF24L01 radios, sending only the items 
+ *    which have changed. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For memcpy() and memcmp()
+
+#include "nRF24L01_replicator.h"            // Header for this file
+
+
+// This is the replicator which gets packets from the radio's receiver interrupt
+nRF24L01_replicator* p_nRF24_replicator = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor saves the description of a replicated item and adds the item to 
+ *  a replicator's list. It's called by the constructor of \c nRF24L01_shared_data.
+ *  @param p_replicator The replicator which sends and receives the item
+ *  @param an_ID The item's ID, from 1 to 255; it must be the same on both computers
+ *  @param is_sender True on the computer which sends the item, false on the one
+ *                   which receives it
+ *  @param a_size The number of bytes in the item's value
+ *  @param p_val A pointer to the item's value
+ *  @param p_copy A pointer to space for a copy of the value as it was last sent; 
+ *                it's only used by the sender
+ *  @param min_ms The shortest time in milliseconds between sends of the item
+ *  @param max_ms The longest time in milliseconds between sends of the item; the 
+ *                receiver must be given the same time so it can tell when its copy
+ *                is stale
+ */
+
+nRF24L01_replica::nRF24L01_replica (nRF24L01_replicator* p_replicator, uint8_t an_ID, 
+									bool is_sender, uint8_t a_size, uint8_t* p_val, 
+									uint8_t* p_copy, uint16_t min_ms, uint16_t max_ms)
+{
+	item_ID = an_ID;
+	sending = is_sender;
+	size = a_size;
+	p_value = p_val;
+	p_sent = p_copy;
+	min_ticks = configMS_TO_TICKS ((uint32_t)min_ms);
+	max_ticks = configMS_TO_TICKS ((uint32_t)max_ms);
+	stamp = 0;
+	received = false;
+	p_next = NULL;
+
+	p_replicator->add (this);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the local copy of a value which comes from the other 
+ *  computer is too old to be trusted. The sender sends each item at least once in 
+ *  its longest time, so if twice that time has passed, packets have been lost. 
+ *  @return True if no value has arrived yet, or none has arrived for a while
+ */
+
+bool nRF24L01_replica::is_stale (void)
+{
+	portTickType last_heard;
+	bool got_one;
+
+	portENTER_CRITICAL ();
+	last_heard = stamp;
+	got_one = received;
+	portEXIT_CRITICAL ();
+
+	return (!got_one || (xTaskGetTickCount () - last_heard) > 2 * max_ticks);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets up a replicator. The newest replicator is the one to which 
+ *  the radio's receiver interrupt gives the packets which arrive. 
+ *  @param p_a_radio The radio through which packets are sent
+ *  @param heartbeat_ms The longest time in milliseconds between packets; if nothing
+ *                      else has been sent for this long, an empty packet is sent 
+ *                      (default 250 ms)
+ *  @param p_ser_dev A serial device for debugging messages (default: NULL, none)
+ */
+
+nRF24L01_replicator::nRF24L01_replicator (nRF24L01_base* p_a_radio, 
+										  uint16_t heartbeat_ms, emstream* p_ser_dev)
+{
+	p_radio = p_a_radio;
+	p_serial = p_ser_dev;
+	p_items = NULL;
+	heartbeat_ticks = configMS_TO_TICKS ((uint32_t)heartbeat_ms);
+	sent_at = 0;
+	heard_at = 0;
+	heard = false;
+	next_sequence = 0;
+	expected_sequence = 0;
+
+	packets_sent = 0;
+	heartbeats_sent = 0;
+	items_sent = 0;
+	send_failures = 0;
+	packets_received = 0;
+	packets_lost = 0;
+
+	p_nRF24_replicator = this;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method adds an item to the list of items which are sent and received. It's 
+ *  called by the item's constructor. Items too big to fit in a packet aren't added.
+ *  @param p_item A pointer to the item
+ */
+
+void nRF24L01_replicator::add (nRF24L01_replica* p_item)
+{
+	if (p_item->item_ID == 0 
+		|| p_item->size > nRF_PAYLOAD_SIZE - nRF_REPLICA_HEADER - 2)
+	{
+		DBG (p_serial, PMS ("Can't replicate item ") << p_item->item_ID << endl);
+		return;
+	}
+
+	portENTER_CRITICAL ();
+	p_item->p_next = p_items;
+	p_items = p_item;
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends one packet of items. It fills in the mark and sequence number 
+ *  at the start of the packet and clears the unused bytes at the end. If the radio
+ *  can't send the packet, the copies of the items' values as last sent are spoiled,
+ *  so the items look changed and will be sent again the next time around. 
+ *  @param p_packet A pointer to a 33 byte buffer; byte 0 is used by the radio driver
+ *                  and the payload begins at byte 1
+ *  @param fill The number of bytes in the buffer which are in use, including byte 0
+ *  @param p_list A pointer to an array of pointers to the items in the packet
+ *  @param count The number of items in the packet; zero for a heartbeat
+ */
+
+void nRF24L01_replicator::send_packet (uint8_t* p_packet, uint8_t fill, 
+									   nRF24L01_replica** p_list, uint8_t count)
+{
+	p_packet[1] = nRF_REPLICA_MARK;
+	p_packet[2] = next_sequence++;
+	memset (p_packet + fill, 0, nRF_PAYLOAD_SIZE + 1 - fill);
+
+	sent_at = xTaskGetTickCount ();
+	packets_sent++;
+	if (count == 0)
+	{
+		heartbeats_sent++;
+	}
+
+	if (p_radio->transmit (p_packet))
+	{
+		items_sent += count;
+		return;
+	}
+
+	send_failures++;
+	for (uint8_t index = 0; index < count; index++)
+	{
+		portENTER_CRITICAL ();
+		p_list[index]->p_sent[0] = ~(p_list[index]->p_value[0]);
+		portEXIT_CRITICAL ();
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends the items which are due to be sent. An item is due if it was 
+ *  last sent at least its shortest time ago and has changed since then, or if it 
+ *  was last sent its longest time ago or more, or if it has never been sent. As many
+ *  items as fit are packed into each packet. If nothing at all has been sent for the
+ *  heartbeat time, an empty packet is sent instead. This method should be called 
+ *  every few milliseconds by the task which owns the radio. 
+ */
+
+void nRF24L01_replicator::service (void)
+{
+	uint8_t packet[nRF_PAYLOAD_SIZE + 1];
+	nRF24L01_replica* in_packet[(nRF_PAYLOAD_SIZE - nRF_REPLICA_HEADER) / 3];
+	uint8_t fill = 1 + nRF_REPLICA_HEADER;
+	uint8_t count = 0;
+	portTickType now = xTaskGetTickCount ();
+
+	for (nRF24L01_replica* p_item = p_items; p_item != NULL; p_item = p_item->p_next)
+	{
+		// Items which come from the other computer are never sent from this one
+		if (!p_item->sending || (now - p_item->stamp) < p_item->min_ticks)
+		{
+			continue;
+		}
+
+		bool due;
+		portENTER_CRITICAL ();
+		due = !p_item->received || ((now - p_item->stamp) >= p_item->max_ticks)
+			  || memcmp (p_item->p_value, p_item->p_sent, p_item->size) != 0;
+		portEXIT_CRITICAL ();
+		if (!due)
+		{
+			continue;
+		}
+
+		// If the item won't fit in this packet, send the packet and start another
+		if (fill + 2 + p_item->size > nRF_PAYLOAD_SIZE + 1)
+		{
+			send_packet (packet, fill, in_packet, count);
+			fill = 1 + nRF_REPLICA_HEADER;
+			count = 0;
+		}
+
+		// Copy the value into the packet and keep a copy to see when it changes
+		packet[fill++] = p_item->item_ID;
+		packet[fill++] = p_item->size;
+		portENTER_CRITICAL ();
+		memcpy (packet + fill, p_item->p_value, p_item->size);
+		memcpy (p_item->p_sent, p_item->p_value, p_item->size);
+		portEXIT_CRITICAL ();
+		fill += p_item->size;
+
+		in_packet[count++] = p_item;
+		p_item->stamp = now;
+		p_item->received = true;
+	}
+
+	// Send the last packet, or a heartbeat if nothing's been sent for a while
+	if (count > 0 || (now - sent_at) >= heartbeat_ticks)
+	{
+		send_packet (packet, fill, in_packet, count);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called by the radio's receiver interrupt when a replication packet 
+ *  arrives. Each item in the packet whose ID and size match an item in the list is 
+ *  copied into that item's value; other items are skipped. It must only be called 
+ *  from within an interrupt service routine. 
+ *  @param p_payload A pointer to the 32 byte payload, beginning with the mark
+ */
+
+void nRF24L01_replicator::ISR_receive (const uint8_t* p_payload)
+{
+	portTickType now = xTaskGetTickCountFromISR ();
+
+	// Count the packets which were skipped in the sequence as lost
+	if (heard)
+	{
+		packets_lost += (uint8_t)(p_payload[1] - expected_sequence);
+	}
+	expected_sequence = p_payload[1] + 1;
+	heard = true;
+	heard_at = now;
+	packets_received++;
+
+	// An ID of zero marks the unused end of the packet
+	uint8_t index = nRF_REPLICA_HEADER;
+	while (index + 2 <= nRF_PAYLOAD_SIZE && p_payload[index] != 0)
+	{
+		uint8_t an_ID = p_payload[index];
+		uint8_t a_size = p_payload[index + 1];
+		index += 2;
+		if (index + a_size > nRF_PAYLOAD_SIZE)
+		{
+			break;
+		}
+
+		for (nRF24L01_replica* p_item = p_items; p_item != NULL; 
+			 p_item = p_item->p_next)
+		{
+			if (p_item->item_ID == an_ID && p_item->size == a_size && !p_item->sending)
+			{
+				memcpy (p_item->p_value, p_payload + index, a_size);
+				p_item->stamp = now;
+				p_item->received = true;
+				break;
+			}
+		}
+		index += a_size;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the link to the other computer seems to be down. The 
+ *  other computer sends something at least every heartbeat time, so if nothing has 
+ *  arrived for three heartbeat times, several packets in a row have been lost. 
+ *  @return True if nothing has arrived yet, or nothing has arrived for a while
+ */
+
+bool nRF24L01_replicator::link_stale (void)
+{
+	portTickType last_heard;
+	bool got_one;
+
+	portENTER_CRITICAL ();
+	last_heard = heard_at;
+	got_one = heard;
+	portEXIT_CRITICAL ();
+
+	return (!got_one || (xTaskGetTickCount () - last_heard) > 3 * heartbeat_ticks);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the numbers of packets and items sent, the number of packets 
+ *  which were heartbeats or couldn't be sent, and the numbers of packets received 
+ *  and lost. 
+ *  @param ser_dev A pointer to the serial device on which to print
+ */
+
+void nRF24L01_replicator::print_stats (emstream* ser_dev)
+{
+	*ser_dev << PMS ("Radio sent ") << packets_sent << PMS (" packets, ") 
+			 << items_sent << PMS (" items, ") << heartbeats_sent 
+			 << PMS (" heartbeats, ") << send_failures << PMS (" failed; received ")
+			 << packets_received << PMS (", lost ") << packets_lost;
+	if (link_stale ())
+	{
+		*ser_dev << PMS ("; link stale") << endl;
+	}
+	else
+	{
+		*ser_dev << PMS ("; link OK") << endl;
+	}
+}
@@ -0,0 +1,210 @@
+//*************************************************************************************
+/** \file nRF24L01_replicator.h
+ *    This file contains classes which keep copies of shared data items up to date on
+ *    two computers connected by nRF24L01 radios. Only items whose values have changed
+ *    are sent, several to a radio packet, and each item has a shortest and a longest
+ *    time between sends. When nothing needs sending, a heartbeat packet tells the 
+ *    other end that the link is still working, so a receiver can tell when its 
+ *    copies have become stale. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _NRF24L01_REPLICATOR_H_
+#define _NRF24L01_REPLICATOR_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For the RTOS tick count
+#include "emstream.h"                       // Header for base serial devices
+#include "nRF24L01_base.h"                  // Header for base nRF24L01 radio driver
+
+
+/** This byte begins every replication packet. Text packets begin with a printable
+ *  character, so the radio's receiver interrupt can tell the two kinds apart. 
+ */
+#define nRF_REPLICA_MARK		0x01
+
+/// This is the number of bytes in a radio packet's payload.
+#define nRF_PAYLOAD_SIZE		32
+
+/** This is the number of bytes at the start of each packet before the first item: 
+ *  the mark and a sequence number. Each item then takes its ID, its size, and its 
+ *  data, so the largest item which fits in a packet is 28 bytes.
+ */
+#define nRF_REPLICA_HEADER		2
+
+
+class nRF24L01_replicator;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This is the base class for data items which are kept the same on two 
+ *  computers by a \c nRF24L01_replicator. 
+ *  \details It holds what the replicator needs to know about an item: the item's ID, 
+ *  which must be the same on both computers and can't be zero; whether this computer
+ *  sends or receives it; where the item's value is and how big it is; a copy of the
+ *  value as it was last sent; and the shortest and longest times between sends. The 
+ *  template class \c nRF24L01_shared_data supplies the storage and the methods to 
+ *  read and write the value. 
+ */
+
+class nRF24L01_replica
+{
+	// The replicator reads and writes the values and times directly
+	friend class nRF24L01_replicator;
+
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The number which identifies this item in the radio packets.
+		uint8_t item_ID;
+
+		/// True if this computer sends the item, false if it receives it.
+		bool sending;
+
+		/// The number of bytes in the item's value.
+		uint8_t size;
+
+		/// The shortest time in RTOS ticks between sends, which limits the send rate.
+		portTickType min_ticks;
+
+		/** The longest time in RTOS ticks between sends; an item is sent this often
+		 *  even if it hasn't changed. The receiver uses the same time to decide 
+		 *  when its copy has become stale. 
+		 */
+		portTickType max_ticks;
+
+		/// The tick count when the item was last sent or received.
+		portTickType stamp;
+
+		/// This flag is set once a value has been sent to or received from the other
+		/// computer.
+		bool received;
+
+		/// A pointer to the bytes of the item's value.
+		uint8_t* p_value;
+
+		/// A pointer to a copy of the value as it was last sent.
+		uint8_t* p_sent;
+
+		/// The next item in the replicator's list.
+		nRF24L01_replica* p_next;
+
+	// Public methods can be called from anywhere in the program where there is a 
+	// pointer or reference to an object of this class
+	public:
+		// The constructor saves the item's description and joins a replicator's list
+		nRF24L01_replica (nRF24L01_replicator*, uint8_t, bool, uint8_t, uint8_t*, 
+						  uint8_t*, uint16_t, uint16_t);
+
+		// Check whether a received value is too old to be trusted
+		bool is_stale (void);
+};
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class sends changed data items through an nRF24L01 radio and puts 
+ *  items which arrive from the other computer into their local copies. 
+ *  \details A task calls \c service() every few milliseconds. Each item which has 
+ *  changed since it was last sent, and which was last sent at least its shortest 
+ *  time ago, is packed into a packet; so is each item which hasn't been sent for its
+ *  longest time. Full packets are sent right away and a partly full one at the end. 
+ *  If nothing has been sent for the heartbeat time, an empty packet is sent so the
+ *  other end knows the link is alive. If a packet can't be sent, the items in it are
+ *  marked as changed so they'll be sent next time. 
+ *
+ *  Packets which arrive are handed to \c ISR_receive() by the radio's receiver 
+ *  interrupt. Each packet has a sequence number, so packets which were lost can be
+ *  counted. Only one replicator can receive packets; the most recently created one
+ *  is given them. 
+ *  \code
+ *  nRF24L01_text* p_radio = new nRF24L01_text (&ser_port);
+ *  nRF24L01_replicator* p_link = new nRF24L01_replicator (p_radio, 250, &ser_port);
+ *  nRF24L01_shared_data<int32_t>* p_remote_position 
+ *      = new nRF24L01_shared_data<int32_t> (p_link, 1, true, 20, 1000);
+ *  ...
+ *  p_remote_position->put (count->get ());      // In one task on the turret
+ *  p_link->service ();                          // Every 10 ms in the radio task
+ *  \endcode
+ */
+
+class nRF24L01_replicator
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The radio through which packets are sent.
+		nRF24L01_base* p_radio;
+
+		/// A serial device for debugging messages, or NULL for none.
+		emstream* p_serial;
+
+		/// The first item in the list of replicated items.
+		nRF24L01_replica* p_items;
+
+		/// The longest time in RTOS ticks between packets before a heartbeat is sent.
+		portTickType heartbeat_ticks;
+
+		/// The tick count when a packet was last sent.
+		portTickType sent_at;
+
+		/// The tick count when a packet last arrived.
+		portTickType heard_at;
+
+		/// This flag is set once any packet has arrived from the other computer.
+		bool heard;
+
+		/// The sequence number of the next packet to be sent.
+		uint8_t next_sequence;
+
+		/// The sequence number expected in the next packet received.
+		uint8_t expected_sequence;
+
+		uint16_t packets_sent;              ///< Packets sent, including heartbeats
+		uint16_t heartbeats_sent;           ///< Empty packets sent as heartbeats
+		uint16_t items_sent;                ///< Items sent in all the packets
+		uint16_t send_failures;             ///< Packets the radio couldn't send
+		uint16_t packets_received;          ///< Packets which arrived
+		uint16_t packets_lost;              ///< Gaps in the received sequence numbers
+
+		// Send one packet of items, filling in its header
+		void send_packet (uint8_t*, uint8_t, nRF24L01_replica**, uint8_t);
+
+	// Public methods can be called from anywhere in the program where there is a 
+	// pointer or reference to an object of this class
+	public:
+		// The constructor sets up a replicator which uses the given radio
+		nRF24L01_replicator (nRF24L01_base*, uint16_t = 250, emstream* = NULL);
+
+		// Add an item to the list of items to be replicated
+		void add (nRF24L01_replica*);
+
+		// Send whichever items are due, or a heartbeat if nothing has been sent
+		void service (void);
+
+		// Put the items in a packet which has arrived into their local copies
+		void ISR_receive (const uint8_t*);
+
+		// Check whether nothing has been heard from the other computer for a while
+		bool link_stale (void);
+
+		// Print the numbers of packets sent, received and lost
+		void print_stats (emstream*);
+};
+
+
+/// This is the replicator which gets packets from the radio's receiver interrupt.
+extern nRF24L01_replicator* p_nRF24_replicator;
+
+#endif // _NRF24L01_REPLICATOR_H_
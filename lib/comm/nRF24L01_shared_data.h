@@ -1,9 +1,11 @@
 //*************************************************************************************
 /** \file nRF24L01_shared_data.h
  *    This file contains a template class for data which is to be shared between
- *    classes. The data must be protected against damage due to context switches, so
- *    it can be protected by a mutex or by making transfers take place inside critical
- *    sections which are protected from being interrupted. 
+ *    computers connected by nRF24L01 radios. On each computer the data must be 
+ *    protected against damage due to context switches, so transfers take place 
+ *    inside critical sections which are protected from being interrupted. The 
+ *    sending is done by an \c nRF24L01_replicator, which only sends items that have
+ *    changed. 
  *
  *  Revised:
  *    \li 10-29-2012 JRR Original file, holding class \c frt_shared_data
@@ -30,36 +32,50 @@
 #define _nRF24L01_SHARED_DATA_H_
 
 #include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "nRF24L01_replicator.h"            // Sends the changes through the radio
 
 
 //-------------------------------------------------------------------------------------
 /** \brief This class implements an item of data which can be shared between computers
  *  connected by Nordic nRF24L01 radios. 
  *  \details Shared data items are simpler than queues, as they don't involve memory 
- *  buffers or the task synchronization associated with queues. The sending task sends 
- *  the data through the radio; the receiving task keeps one and only one copy of the 
- *  data. The copy is double-buffered so that any task can read the latest value of 
- *  the data which has been received. Reading of the data is protected using critical 
- *  code sections (see the FreeRTOS documentation of \c portENTER_CRITICAL() ). The 
- *  C++ template mechanism is used to ensure that only data of the correct type is put 
- *  into or taken from a shared data item. A \c shared_data<DataType> object keeps its 
- *  own separate copy of the data. This uses some memory, but it is necessary to 
- *  reliably prevent data corruption; it prevents possible side effects from causing 
- *  the sender's copy of the data from being inadvertently changed. 
+ *  buffers or the task synchronization associated with queues. On the sending 
+ *  computer, tasks \c put() values into the item, and the replicator sends the value
+ *  when it has changed, but no more often than the item's shortest time between 
+ *  sends, and at least once in its longest time. On the receiving computer the 
+ *  radio's interrupt puts the values which arrive into the item, where any task can
+ *  \c get() the latest one; \c is_stale() tells whether that value is too old to be
+ *  trusted. Reading and writing are protected using critical code sections (see the 
+ *  FreeRTOS documentation of \c portENTER_CRITICAL() ). The C++ template mechanism 
+ *  is used to ensure that only data of the correct type is put into or taken from a
+ *  shared data item. The sender keeps a second copy of the value as it was last sent
+ *  so that it can tell when the value has changed. 
  */
 
 template <class DataType> 
-class nRF24L01_shared_data
+class nRF24L01_shared_data : public nRF24L01_replica
 {
 	protected:
 		DataType the_data;					///< Holds the data to be shared
+		DataType last_sent;					///< The data as it was last sent
 
 	public:
-		/** This default constructor for a shared data item doesn't do much
-		 *  because there isn't any particular setup required. 
+		/** This constructor creates a shared data item and adds it to the list kept
+		 *  by a replicator. 
+		 *  @param p_replicator The replicator which sends or receives the item
+		 *  @param ID_number The item's ID, from 1 to 255, the same on both computers
+		 *  @param is_sender True on the computer which sends the item, false on the
+		 *                   computer which receives it
+		 *  @param min_ms The shortest time in milliseconds between sends (default 0)
+		 *  @param max_ms The longest time in milliseconds between sends, which must 
+		 *                be the same on both computers (default 1000)
 		 */
-		nRF24L01_shared_data<DataType> (uint8_t ID_number)
-			: 
+		nRF24L01_shared_data<DataType> (nRF24L01_replicator* p_replicator, 
+										uint8_t ID_number, bool is_sender, 
+										uint16_t min_ms = 0, uint16_t max_ms = 1000)
+			: nRF24L01_replica (p_replicator, ID_number, is_sender, sizeof (DataType),
+								(uint8_t*)(&the_data), (uint8_t*)(&last_sent), 
+								min_ms, max_ms)
 		{
 		}
 
@@ -75,7 +91,7 @@ class nRF24L01_shared_data
 		// This method is used to read data from within an ISR only
 		DataType ISR_get (void);
 
-}; // class shared_data<DataType>
+}; // class nRF24L01_shared_data<DataType>
 
 
 //---------------------------------------------------------------------------------
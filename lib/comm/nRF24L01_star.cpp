@@ -0,0 +1,519 @@
+//*************************************************************************************
+/** \file nRF24L01_star.cpp
+ *    This file contains the methods of the classes which run a star network of
+ *    nRF24L01 radios, in which a base station polls as many as five nodes in turn.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For memcpy() and memset()
+
+#include "nRF24L01_star.h"                  // Header for this file
+
+
+// This is the network which gets packets from the radio's receiver interrupt
+nRF24L01_star* p_nRF24_star = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a link with empty queues, nothing waiting to be sent, and
+ *  all its statistics set to zero.
+ */
+
+nRF24L01_star_link::nRF24L01_star_link (void)
+	: emstream ()
+{
+	pending_count = 0;
+	send_sequence = 0;
+	heard_sequence = 0;
+	polled_at = 0;
+	heard_at = 0;
+	longest_cycle = 0;
+
+	polls = 0;
+	replies = 0;
+	missed = 0;
+	resent = 0;
+	send_failures = 0;
+	overflows = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts a character into the queue of characters waiting to be sent in
+ *  the link's next turn.
+ *  @param chout The character to be sent
+ *  @return True if the character was queued, false if the queue was full
+ */
+
+bool nRF24L01_star_link::putchar (char chout)
+{
+	bool queued;
+
+	portENTER_CRITICAL ();
+	queued = outgoing.put ((uint8_t)chout);
+	portEXIT_CRITICAL ();
+
+	return (queued);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks if a character has arrived on this link and not been read.
+ *  @return True for character available, false for no character available
+ */
+
+bool nRF24L01_star_link::check_for_char (void)
+{
+	return (!incoming.is_empty ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method gets a character which has arrived on this link. One should use
+ *  \c check_for_char() to be sure there's a character available first.
+ *  @return The character, or (-1) if none had arrived
+ */
+
+int16_t nRF24L01_star_link::getchar (void)
+{
+	int16_t char_in = -1;
+
+	portENTER_CRITICAL ();
+	if (!incoming.is_empty ())
+	{
+		char_in = incoming.get ();
+	}
+	portEXIT_CRITICAL ();
+
+	return (char_in);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method fills in a packet to be sent on this link. If the other end has acked
+ *  the last data sent, as many waiting characters as fit are moved into a new lot of
+ *  data with the next sequence number; if not, the old data is sent again. Every
+ *  packet also acks the last data which arrived from the other end.
+ *  @param p_packet A pointer to a 33 byte buffer; byte 0 is used by the radio driver
+ *                  and the payload begins at byte 1
+ *  @param kind \c nRF_STAR_POLL or \c nRF_STAR_REPLY
+ *  @param node The number of the node at the far end of the link
+ *  @return The number of data bytes in the packet
+ */
+
+uint8_t nRF24L01_star_link::fill_packet (uint8_t* p_packet, uint8_t kind, uint8_t node)
+{
+	portENTER_CRITICAL ();
+	if (pending_count == 0)
+	{
+		while (pending_count < nRF_STAR_DATA_SIZE && !outgoing.is_empty ())
+		{
+			pending[pending_count++] = outgoing.get ();
+		}
+
+		// Sequence number zero means the packet carries no data
+		if (pending_count > 0 && ++send_sequence == 0)
+		{
+			send_sequence = 1;
+		}
+	}
+	else
+	{
+		resent++;
+	}
+
+	p_packet[1] = nRF_STAR_MARK;
+	p_packet[2] = kind;
+	p_packet[3] = node;
+	p_packet[4] = (pending_count > 0) ? send_sequence : 0;
+	p_packet[5] = heard_sequence;
+	p_packet[6] = pending_count;
+	memcpy (p_packet + 1 + nRF_STAR_HEADER, pending, pending_count);
+	uint8_t count = pending_count;
+	portEXIT_CRITICAL ();
+
+	memset (p_packet + 1 + nRF_STAR_HEADER + count, 0, nRF_STAR_DATA_SIZE - count);
+	return (count);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method takes the ack and the data from a packet which has arrived on this
+ *  link. Data which has arrived before is acked again but not queued twice. If the
+ *  incoming queue hasn't room for all the data, none of it is taken or acked, so the
+ *  other end will send it again in the next turn.
+ *  @param p_payload A pointer to the 32 byte payload, beginning with the mark
+ *  @param now The tick count when the packet arrived
+ */
+
+void nRF24L01_star_link::ISR_take_packet (const uint8_t* p_payload, portTickType now)
+{
+	heard_at = now;
+
+	if (pending_count > 0 && p_payload[4] == send_sequence)
+	{
+		pending_count = 0;
+	}
+
+	uint8_t count = p_payload[5];
+	if (count == 0 || count > nRF_STAR_DATA_SIZE || p_payload[3] == heard_sequence)
+	{
+		return;
+	}
+	if (incoming.num_items () + count > nRF_STAR_QUEUE_SIZE)
+	{
+		overflows++;
+		return;
+	}
+
+	heard_sequence = p_payload[3];
+	for (uint8_t index = 0; index < count; index++)
+	{
+		incoming.put (p_payload[nRF_STAR_HEADER + index]);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets up the radio for a star network. At the base station, the
+ *  receiver pipes 1 through 5 are given the addresses of nodes 1 through 5. At a
+ *  node, pipe 0 and the transmitter are both given the node's own address. The
+ *  radio should have been reset before this constructor is called and mustn't be
+ *  reset afterwards.
+ *  @param p_a_radio The radio through which packets are sent
+ *  @param node This computer's node number, 1 through 5, or 0 for the base station
+ *  @param p_address A pointer to the \c nRF24_ADDR_WIDTH bytes of the address which
+ *                   all the radios share, most significant byte first. The node
+ *                   numbers are added to the last byte, so it must be 250 or less
+ *  @param slot_ms The time in milliseconds which the base station gives each node
+ *                 to answer a poll (default 5 ms)
+ *  @param p_ser_dev A serial device for debugging messages (default: NULL, none)
+ */
+
+nRF24L01_star::nRF24L01_star (nRF24L01_base* p_a_radio, uint8_t node,
+							  const uint8_t* p_address, uint16_t slot_ms,
+							  emstream* p_ser_dev)
+{
+	uint8_t cmd[2];                         // Temporary storage for commands & data
+
+	p_radio = p_a_radio;
+	p_serial = p_ser_dev;
+	my_node = node;
+	memcpy (address, p_address, nRF24_ADDR_WIDTH);
+	slot_ticks = configMS_TO_TICKS ((uint32_t)slot_ms);
+	current = node;
+	awaiting = false;
+	answered = false;
+	for (uint8_t index = 0; index <= nRF_STAR_MAX_NODES; index++)
+	{
+		links[index] = NULL;
+	}
+
+	cmd[0] = nRF24_WR_REG | nRF24_REG_EN_RXADDR;
+	if (my_node == 0)
+	{
+		// Pipe 1 takes a whole address; pipes 2 - 5 share all but its last byte
+		for (uint8_t pipe = 1; pipe <= nRF_STAR_MAX_NODES; pipe++)
+		{
+			write_address (nRF24_REG_RX_ADDR_P0 + pipe, pipe, (pipe == 1));
+			p_radio->set_payload_width (32, pipe);
+		}
+		cmd[1] = 0b00111110;
+	}
+	else if (my_node <= nRF_STAR_MAX_NODES)
+	{
+		links[my_node] = new nRF24L01_star_link;
+		write_address (nRF24_REG_RX_ADDR_P0, my_node, true);
+		write_address (nRF24_REG_TX_ADDR, my_node, true);
+		p_radio->set_payload_width (32, 0);
+		cmd[1] = 0b00000001;
+	}
+	else
+	{
+		DBG (p_serial, PMS ("Invalid star network node ") << my_node << endl);
+		return;
+	}
+	nRF24_spi_transfer (cmd, 2);
+
+	p_nRF24_star = this;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method writes the address of a node into one of the radio's address
+ *  registers. The radio takes the least significant byte first.
+ *  @param reg The number of the register, such as \c nRF24_REG_TX_ADDR
+ *  @param node The number of the node whose address is written
+ *  @param whole True to write the whole address, false to write only the last byte,
+ *               as for pipes 2 through 5
+ */
+
+void nRF24L01_star::write_address (uint8_t reg, uint8_t node, bool whole)
+{
+	uint8_t bytes[nRF24_ADDR_WIDTH + 1];    // Array to be sent via SPI to radio
+
+	bytes[0] = nRF24_WR_REG | reg;
+	bytes[1] = address[nRF24_ADDR_WIDTH - 1] + node;
+	for (uint8_t index = 2; index <= nRF24_ADDR_WIDTH; index++)
+	{
+		bytes[index] = address[nRF24_ADDR_WIDTH - index];
+	}
+
+	nRF24_spi_transfer (bytes, whole ? (nRF24_ADDR_WIDTH + 1) : 2);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method adds a node to the base station's polling cycle. Each node is polled
+ *  once per cycle, so every node added makes the cycle one slot longer.
+ *  @param node The number of the node, 1 through 5
+ */
+
+void nRF24L01_star::add_node (uint8_t node)
+{
+	if (my_node != 0 || node == 0 || node > nRF_STAR_MAX_NODES)
+	{
+		DBG (p_serial, PMS ("Can't add star network node ") << node << endl);
+		return;
+	}
+	if (links[node] == NULL)
+	{
+		links[node] = new nRF24L01_star_link;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends a poll or a reply on one link and counts it. At the base
+ *  station, it also keeps track of the longest time between polls of the link,
+ *  which is the longest a command could have waited to be sent.
+ *  @param kind \c nRF_STAR_POLL or \c nRF_STAR_REPLY
+ *  @param node The number of the node at the far end of the link
+ */
+
+void nRF24L01_star::send (uint8_t kind, uint8_t node)
+{
+	uint8_t packet[33];
+	nRF24L01_star_link* p_link = links[node];
+
+	p_link->fill_packet (packet, kind, node);
+
+	if (kind == nRF_STAR_POLL)
+	{
+		portTickType now = xTaskGetTickCount ();
+		if (p_link->polls > 0 && (now - p_link->polled_at) > p_link->longest_cycle)
+		{
+			p_link->longest_cycle = now - p_link->polled_at;
+		}
+		p_link->polled_at = now;
+		p_link->polls++;
+	}
+	else
+	{
+		p_link->replies++;
+	}
+
+	if (!p_radio->transmit (packet))
+	{
+		p_link->send_failures++;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method runs the network; it should be called every millisecond or so by the
+ *  task which owns the radio. At the base station, once the node which was polled
+ *  last has answered or its slot time is up, the next node in the cycle is polled.
+ *  At a node, the answer to a poll which has arrived is sent.
+ */
+
+void nRF24L01_star::service (void)
+{
+	bool got_answer;
+
+	// A node only ever speaks when it has been polled
+	if (my_node != 0)
+	{
+		portENTER_CRITICAL ();
+		got_answer = answered;
+		answered = false;
+		portEXIT_CRITICAL ();
+
+		if (got_answer && links[my_node] != NULL)
+		{
+			send (nRF_STAR_REPLY, my_node);
+		}
+		return;
+	}
+
+	portENTER_CRITICAL ();
+	got_answer = answered;
+	portEXIT_CRITICAL ();
+
+	// Wait for the node which was polled last until its slot is over
+	if (awaiting)
+	{
+		if (!got_answer)
+		{
+			if ((xTaskGetTickCount () - links[current]->polled_at) < slot_ticks)
+			{
+				return;
+			}
+			links[current]->missed++;
+		}
+		awaiting = false;
+	}
+
+	// Find the next node in the cycle, if there are any nodes at all
+	uint8_t next = current;
+	for (uint8_t count = 0; count < nRF_STAR_MAX_NODES; count++)
+	{
+		next = (next % nRF_STAR_MAX_NODES) + 1;
+		if (links[next] != NULL)
+		{
+			break;
+		}
+	}
+	if (links[next] == NULL)
+	{
+		return;
+	}
+
+	current = next;
+	answered = false;
+	write_address (nRF24_REG_TX_ADDR, current, true);
+	send (nRF_STAR_POLL, current);
+	awaiting = true;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called by the radio's receiver interrupt when a star network
+ *  packet arrives. At the base station, answers are taken only from the pipe which
+ *  belongs to the node they claim to come from. At a node, only polls for this node
+ *  are taken. It must only be called from within an interrupt service routine.
+ *  @param pipe The number of the receiver pipe in which the packet arrived
+ *  @param p_payload A pointer to the 32 byte payload, beginning with the mark
+ */
+
+void nRF24L01_star::ISR_receive (uint8_t pipe, const uint8_t* p_payload)
+{
+	uint8_t node = p_payload[2];
+	if (node > nRF_STAR_MAX_NODES || links[node] == NULL)
+	{
+		return;
+	}
+
+	nRF24L01_star_link* p_link = links[node];
+	portTickType now = xTaskGetTickCountFromISR ();
+
+	if (my_node == 0)
+	{
+		if (p_payload[1] != nRF_STAR_REPLY || pipe != node)
+		{
+			return;
+		}
+		p_link->replies++;
+		if (node == current)
+		{
+			answered = true;
+		}
+	}
+	else
+	{
+		if (p_payload[1] != nRF_STAR_POLL)
+		{
+			return;
+		}
+		if (p_link->polls > 0 && (now - p_link->polled_at) > p_link->longest_cycle)
+		{
+			p_link->longest_cycle = now - p_link->polled_at;
+		}
+		p_link->polled_at = now;
+		p_link->polls++;
+		answered = true;
+	}
+
+	p_link->ISR_take_packet (p_payload, now);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the link to a node seems to be down. Each node should
+ *  be heard from once per polling cycle, and no cycle can be longer than one slot
+ *  per possible node, so if nothing has arrived for three such cycles, several
+ *  answers in a row have been lost.
+ *  @param node The number of the node whose link is checked
+ *  @return True if nothing has arrived yet, or nothing has arrived for a while
+ */
+
+bool nRF24L01_star::link_stale (uint8_t node)
+{
+	nRF24L01_star_link* p_link = link (node);
+	portTickType last_heard;
+
+	if (p_link == NULL)
+	{
+		return (true);
+	}
+
+	portENTER_CRITICAL ();
+	last_heard = p_link->heard_at;
+	portEXIT_CRITICAL ();
+
+	return (last_heard == 0 || (xTaskGetTickCount () - last_heard)
+							   > 3 * nRF_STAR_MAX_NODES * slot_ticks);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a table with one line for each link. It shows the numbers of
+ *  polls and replies, polls which got no reply in time, packets which were sent
+ *  again because they weren't acked, packets the radio couldn't send, and packets
+ *  refused because the incoming queue was full. The longest time between two polls
+ *  is the longest that data could have waited for its turn to be sent.
+ *  @param ser_dev A pointer to the serial device on which to print
+ */
+
+void nRF24L01_star::print_stats (emstream* ser_dev)
+{
+	*ser_dev << PMS ("Node\tPolls\tReplies\tMissed\tResent\tFailed\tRefused\tCycle\tLink")
+			 << endl;
+	*ser_dev << PMS ("----\t-----\t-------\t------\t------\t------\t-------\t-----\t----")
+			 << endl;
+
+	for (uint8_t node = 1; node <= nRF_STAR_MAX_NODES; node++)
+	{
+		nRF24L01_star_link* p_link = links[node];
+		if (p_link == NULL)
+		{
+			continue;
+		}
+
+		*ser_dev << node << '\t' << p_link->polls << '\t' << p_link->replies << '\t'
+				 << p_link->missed << '\t' << p_link->resent << '\t'
+				 << p_link->send_failures << '\t' << p_link->overflows << '\t'
+				 << (uint32_t)(p_link->longest_cycle * 1000UL / configTICK_RATE_HZ);
+		if (link_stale (node))
+		{
+			*ser_dev << PMS ("\tstale") << endl;
+		}
+		else
+		{
+			*ser_dev << PMS ("\tOK") << endl;
+		}
+	}
+}
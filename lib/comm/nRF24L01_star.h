@@ -0,0 +1,247 @@
+//*************************************************************************************
+/** \file nRF24L01_star.h
+ *    This file contains classes which run a star network of nRF24L01 radios. One
+ *    base station talks to as many as five nodes, such as turrets, each of which
+ *    has its own address and its own receiver pipe at the base station. The base
+ *    station polls the nodes in turn, giving each one a time slot in which to
+ *    answer, so no two radios ever transmit at once and every node hears from the
+ *    base station at least once in each polling cycle.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _NRF24L01_STAR_H_
+#define _NRF24L01_STAR_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For the RTOS tick count
+#include "circ_buffer.h"                    // Template header for circular buffer
+#include "emstream.h"                       // Header for base serial devices
+#include "nRF24L01_base.h"                  // Header for base nRF24L01 radio driver
+
+
+/** This byte begins every star network packet, so the radio's receiver interrupt
+ *  can tell these packets from text and replication packets.
+ */
+#define nRF_STAR_MARK			0x02
+
+/// This is the largest number of nodes, which is the number of pipes 1 through 5.
+#define nRF_STAR_MAX_NODES		5
+
+/// This is the number of bytes at the start of each packet before the data.
+#define nRF_STAR_HEADER			6
+
+/// This is the largest number of data bytes carried in one packet.
+#define nRF_STAR_DATA_SIZE		(32 - nRF_STAR_HEADER)
+
+/// This is the number of bytes each node's queues hold in each direction.
+#define nRF_STAR_QUEUE_SIZE		32
+
+/// This code in a packet's second byte means the packet is a poll from the base.
+#define nRF_STAR_POLL			0x01
+
+/// This code in a packet's second byte means the packet is a node's answer.
+#define nRF_STAR_REPLY			0x02
+
+
+class nRF24L01_star;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class is the link between the base station and one node of a star
+ *  network.
+ *  \details It's a serial device, so text can be printed to it with \c << and read
+ *  from it with \c getchar() as with a serial port. Characters printed to the link
+ *  wait in a queue until the link's turn comes in the polling cycle; characters
+ *  which arrive wait in another queue until they're read. The link also keeps the
+ *  statistics which show how well the radio connection to its node is working.
+ *
+ *  Each packet of data is sent again in every turn until the other end says it got
+ *  it, and a packet which arrives twice is only put into the queue once, so no data
+ *  is lost or doubled when packets are lost.
+ */
+
+class nRF24L01_star_link : public emstream
+{
+	// The network fills and empties the queues and counts the statistics directly
+	friend class nRF24L01_star;
+
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// Characters waiting to be sent to the other end.
+		circ_buffer<uint8_t, nRF_STAR_QUEUE_SIZE> outgoing;
+
+		/// Characters which have arrived from the other end and haven't been read.
+		circ_buffer<uint8_t, nRF_STAR_QUEUE_SIZE> incoming;
+
+		/// The data in the packet which is being sent until the other end has it.
+		uint8_t pending[nRF_STAR_DATA_SIZE];
+
+		/// The number of bytes in \c pending, or zero if nothing's waiting for an ack.
+		uint8_t pending_count;
+
+		/// The sequence number of the data in \c pending.
+		uint8_t send_sequence;
+
+		/// The sequence number of the last data which arrived from the other end.
+		uint8_t heard_sequence;
+
+		/// The tick count when this link was last polled, or when a node was polled.
+		portTickType polled_at;
+
+		/// The tick count when a packet last arrived on this link.
+		portTickType heard_at;
+
+		/// The longest time in RTOS ticks between two polls of this link.
+		portTickType longest_cycle;
+
+		uint16_t polls;                     ///< Polls sent or received
+		uint16_t replies;                   ///< Replies sent or received
+		uint16_t missed;                    ///< Polls which got no reply in the slot
+		uint16_t resent;                    ///< Packets sent again for want of an ack
+		uint16_t send_failures;             ///< Packets the radio couldn't send
+		uint16_t overflows;                 ///< Bytes lost to a full queue
+
+		// Move waiting characters into a packet and fill in its header
+		uint8_t fill_packet (uint8_t*, uint8_t, uint8_t);
+
+		// Take the ack and data from a packet which has arrived
+		void ISR_take_packet (const uint8_t*, portTickType);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor makes a link with empty queues and statistics
+		nRF24L01_star_link (void);
+
+		// Queue a character to be sent in this link's next turn
+		bool putchar (char);
+
+		// Check if a character has arrived on this link
+		bool check_for_char (void);
+
+		// Get a character which has arrived on this link
+		int16_t getchar (void);
+};
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class runs a star network of nRF24L01 radios from either end: the
+ *  base station or one of the nodes.
+ *  \details The radios all share the first bytes of their addresses. A node's
+ *  address is the shared address with the node's number, 1 through 5, added to the
+ *  last byte; at the base station, the node's packets arrive in the pipe which has
+ *  the same number. Poll and reply packets for one node both use that node's
+ *  address, so each node only hears the packets meant for it.
+ *
+ *  At the base station, \c service() polls the nodes one at a time. Each poll
+ *  carries any data waiting for the node, and the node answers with any data it
+ *  has waiting. The base station waits one slot time for the answer, then moves on
+ *  to the next node whether it got one or not, so with \c N nodes each one is
+ *  polled at least every \c N slots. At a node, \c service() sends the answer to a
+ *  poll which has arrived, and nothing else; the node must call it more often than
+ *  once per slot time or its answers will be late.
+ *
+ *  The radio must be an \c nRF24L01_text, whose receiver interrupt passes star
+ *  packets to the most recently created network object.
+ *  \code
+ *  const uint8_t address[nRF24_ADDR_WIDTH] = {0xA4, 0x05, 0x10};
+ *  nRF24L01_text* p_radio = new nRF24L01_text (&ser_port);
+ *  nRF24L01_star* p_star = new nRF24L01_star (p_radio, 0, address, 5);
+ *  p_star->add_node (1);
+ *  p_star->add_node (2);
+ *  ...
+ *  *(p_star->link (2)) << PMS ("aim 30") << endl;  // In the user interface task
+ *  p_star->service ();                             // Every 1 ms in the radio task
+ *  \endcode
+ */
+
+class nRF24L01_star
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The radio through which packets are sent.
+		nRF24L01_base* p_radio;
+
+		/// A serial device for debugging messages, or NULL for none.
+		emstream* p_serial;
+
+		/// This computer's node number, or zero at the base station.
+		uint8_t my_node;
+
+		/// The address shared by all the radios, most significant byte first.
+		uint8_t address[nRF24_ADDR_WIDTH];
+
+		/// The links to the nodes, by node number; unused numbers have NULL.
+		nRF24L01_star_link* links[nRF_STAR_MAX_NODES + 1];
+
+		/// The time in RTOS ticks which the base station waits for each answer.
+		portTickType slot_ticks;
+
+		/// The node which was polled last; at a node, the node's own number.
+		uint8_t current;
+
+		/// At the base station, set while waiting for the current node to answer.
+		bool awaiting;
+
+		/// Set by the receiver interrupt when a poll or an answer arrives.
+		bool answered;
+
+		// Write the address of a node into one of the radio's address registers
+		void write_address (uint8_t, uint8_t, bool);
+
+		// Send a poll or a reply on a link
+		void send (uint8_t, uint8_t);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor sets up the radio as the base station or as a node
+		nRF24L01_star (nRF24L01_base*, uint8_t, const uint8_t*, uint16_t = 5,
+					   emstream* = NULL);
+
+		// At the base station, add a node to the polling cycle
+		void add_node (uint8_t);
+
+		// Send the next poll, or the answer to a poll, if it's time
+		void service (void);
+
+		// Take a packet which has arrived from the radio's receiver interrupt
+		void ISR_receive (uint8_t, const uint8_t*);
+
+		// Check whether nothing has been heard from a node for a few polling cycles
+		bool link_stale (uint8_t);
+
+		// Print a table of statistics for the links
+		void print_stats (emstream*);
+
+		/** This method returns the link to a node, through which text can be sent to
+		 *  and received from that node. At a node, the only link is the one with the
+		 *  node's own number.
+		 *  @param node The number of the node, 1 through 5
+		 *  @return A pointer to the link, or NULL if there's no link to that node
+		 */
+		nRF24L01_star_link* link (uint8_t node)
+		{
+			return ((node <= nRF_STAR_MAX_NODES) ? links[node] : NULL);
+		}
+};
+
+
+/// This is the network which gets packets from the radio's receiver interrupt.
+extern nRF24L01_star* p_nRF24_star;
+
+#endif // _NRF24L01_STAR_H_
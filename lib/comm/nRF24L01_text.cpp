@@ -43,6 +43,11 @@
 
 #include "FreeRTOS.h"                       // Header for the RTOS in which this runs
 #include "nRF24L01_text.h"                  // Header for this file
+#include "isr_profile.h"                    // For timing the radio ISR
+#include "nRF24L01_replicator.h"            // Receives replicated data packets
+#include "nRF24L01_star.h"                  // Receives star network packets
+#include "nRF24L01_channel.h"               // Receives channel switch messages
+#include "nRF24L01_time_sync.h"             // Receives time synchronization packets
 
 
 /** This circular buffer holds characters received from the radio. The characters can
@@ -149,14 +154,43 @@ ISR (nRF24_IRQ_VECT)
 	static uint8_t buffer[34];              // Buffer holds data from radio
 	uint8_t index;                          // Index into the buffer
 
+	ISR_PROFILE_START (ISR_PROF_RADIO);
+
 	// Get data out from the buffer
 	buffer[0] = nRF24_RD_PLD;
 	nRF24_spi_transfer (buffer, 33);
 
-	// Put data from the buffer into the queue until we hit a '\0'
-	for (index = 1; (index <= 33) && (buffer[index]); index++)
+	// Any packet at all shows that the other end can be heard on this channel
+	if (p_nRF24_channel != NULL)
+	{
+		p_nRF24_channel->ISR_heard ();
+	}
+
+	// A replicated data packet goes to the replicator and a star network packet to
+	// the network, along with the pipe number from the status byte which the radio
+	// sent back first; text goes into the queue until we hit a '\0'
+	if (buffer[1] == nRF_REPLICA_MARK && p_nRF24_replicator != NULL)
+	{
+		p_nRF24_replicator->ISR_receive (buffer + 1);
+	}
+	else if (buffer[1] == nRF_STAR_MARK && p_nRF24_star != NULL)
+	{
+		p_nRF24_star->ISR_receive ((buffer[0] & nRF24_RX_P_NO) >> 1, buffer + 1);
+	}
+	else if (buffer[1] == nRF_CHANNEL_MARK && p_nRF24_channel != NULL)
 	{
-		g_RX_queue->put (buffer[index]);
+		p_nRF24_channel->ISR_receive (buffer + 1);
+	}
+	else if (buffer[1] == nRF_TIME_MARK && p_nRF24_time_sync != NULL)
+	{
+		p_nRF24_time_sync->ISR_receive (buffer + 1);
+	}
+	else
+	{
+		for (index = 1; (index <= 33) && (buffer[index]); index++)
+		{
+			g_RX_queue->put (buffer[index]);
+		}
 	}
 
 	// Flush the buffer
@@ -167,4 +201,6 @@ ISR (nRF24_IRQ_VECT)
 	buffer[0] = nRF24_WR_REG | nRF24_REG_STATUS;
 	buffer[1] = nRF24_RX_DR | nRF24_TX_DS | nRF24_MAX_RT;
 	nRF24_spi_transfer (buffer, 2);
+
+	ISR_PROFILE_END (ISR_PROF_RADIO);
 }
@@ -0,0 +1,427 @@
+//*************************************************************************************
+/** \file nRF24L01_time_sync.cpp
+ *    This file contains the methods of a class which keeps track of the time on
+ *    another computer which can be reached through an nRF24L01 radio.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For memcpy() and memset()
+
+#include "nRF24L01_time_sync.h"             // Header for this file
+
+
+// This is the time keeper which gets packets from the radio's receiver interrupt
+nRF24L01_time_sync* p_nRF24_time_sync = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets up the server, whose clock is followed, or a client, which
+ *  follows it.
+ *  @param p_a_radio The radio through which the packets are sent
+ *  @param server True at the end whose clock is followed, false at the other end
+ *  @param interval_ms The time in milliseconds between the client's requests
+ *                     (default 1000 ms); it isn't used at the server
+ *  @param p_ser_dev A serial device for debugging messages (default: NULL, none)
+ */
+
+nRF24L01_time_sync::nRF24L01_time_sync (nRF24L01_base* p_a_radio, bool server,
+										uint16_t interval_ms, emstream* p_ser_dev)
+{
+	p_radio = p_a_radio;
+	p_serial = p_ser_dev;
+	is_server = server;
+	interval_ticks = configMS_TO_TICKS ((uint32_t)interval_ms);
+	asked_at = 0;
+	sequence = 0;
+	awaiting = false;
+	got_packet = false;
+	t1 = t2 = t3 = t4 = 0;
+
+	sample_count = 0;
+	next_sample = 0;
+	memset (&best, 0, sizeof (best));
+	memset (&anchor, 0, sizeof (anchor));
+	synced = false;
+	drift_known = false;
+	drift = 0.0;
+	jitter = 0;
+
+	requests = 0;
+	replies = 0;
+	lost = 0;
+	send_failures = 0;
+
+	p_nRF24_time_sync = this;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the local clock. It must not be called from within an interrupt
+ *  service routine; use \c ISR_local_us() there.
+ *  @return The time in microseconds since the scheduler started, modulo 2^32
+ */
+
+uint32_t nRF24L01_time_sync::local_us (void)
+{
+	time_stamp now;
+
+	now.set_to_now ();
+	return (now.get_seconds () * 1000000UL + now.get_microsec ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the local clock from within an interrupt service routine.
+ *  @return The time in microseconds since the scheduler started, modulo 2^32
+ */
+
+uint32_t nRF24L01_time_sync::ISR_local_us (void)
+{
+	time_stamp now;
+
+	now.set_to_now_in_ISR ();
+	return (now.get_seconds () * 1000000UL + now.get_microsec ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends a request or an answer. The time of sending is read just before
+ *  the packet goes to the radio, so the time the radio takes to send it counts as
+ *  part of the round trip and can't make the estimate worse than its error bound.
+ *  @param kind \c nRF_TIME_REQUEST or \c nRF_TIME_REPLY
+ */
+
+void nRF24L01_time_sync::send (uint8_t kind)
+{
+	uint8_t packet[33];
+	uint32_t request_time, arrival_time;
+
+	memset (packet, 0, sizeof (packet));
+	packet[1] = nRF_TIME_MARK;
+	packet[2] = kind;
+
+	portENTER_CRITICAL ();
+	packet[3] = sequence;
+	request_time = t1;
+	arrival_time = t2;
+	portEXIT_CRITICAL ();
+
+	if (kind == nRF_TIME_REPLY)
+	{
+		memcpy (packet + 4, &request_time, 4);
+		memcpy (packet + 8, &arrival_time, 4);
+		uint32_t now = local_us ();
+		memcpy (packet + 12, &now, 4);
+	}
+	else
+	{
+		uint32_t now = local_us ();
+		memcpy (packet + 4, &now, 4);
+	}
+
+	requests++;
+	if (!p_radio->transmit (packet))
+	{
+		send_failures++;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method estimates the difference between the clocks at a given local time,
+ *  carrying the best sample's estimate forward with the drift.
+ *  @param local A local time in microseconds
+ *  @return The server's time minus the local time, in microseconds
+ */
+
+int32_t nRF24L01_time_sync::offset_at (uint32_t local)
+{
+	sample base;
+	float rate;
+
+	portENTER_CRITICAL ();
+	base = best;
+	rate = drift;
+	portEXIT_CRITICAL ();
+
+	return (base.offset + (int32_t)(rate * (float)(int32_t)(local - base.local_at)));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method works out the result of the exchange which has just finished, adds it
+ *  to the filter, and bases the estimate on the sample with the shortest round trip.
+ *  When that sample is far enough from the one where the drift measurement began,
+ *  the drift is measured again.
+ */
+
+void nRF24L01_time_sync::add_sample (void)
+{
+	sample result;
+
+	// The offset is the average of (t2 - t1) and (t3 - t4), which differ by the delay
+	int32_t delay = (int32_t)(t4 - t1) - (int32_t)(t3 - t2);
+	if (delay < 0)
+	{
+		delay = 0;
+	}
+	result.local_at = t4;
+	result.delay = (uint32_t)delay;
+	result.offset = (int32_t)(t2 - t1) - delay / 2;
+
+	samples[next_sample] = result;
+	next_sample = (next_sample + 1) % nRF_TIME_FILTER_SIZE;
+	if (sample_count < nRF_TIME_FILTER_SIZE)
+	{
+		sample_count++;
+	}
+
+	uint8_t pick = 0;
+	for (uint8_t index = 1; index < sample_count; index++)
+	{
+		if (samples[index].delay < samples[pick].delay)
+		{
+			pick = index;
+		}
+	}
+
+	// Nothing changes until a better sample arrives or the best one is forgotten
+	if (synced && samples[pick].local_at == best.local_at)
+	{
+		return;
+	}
+
+	if (synced)
+	{
+		int32_t miss = offset_at (samples[pick].local_at) - samples[pick].offset;
+		if (miss < 0)
+		{
+			miss = -miss;
+		}
+		jitter = (3 * jitter + (uint32_t)miss) / 4;
+	}
+
+	float new_drift = drift;
+	bool measured = false;
+	if (synced && (samples[pick].local_at - anchor.local_at)
+				  >= nRF_TIME_DRIFT_MIN_MS * 1000UL)
+	{
+		float rate = (float)(samples[pick].offset - anchor.offset)
+					 / (float)(samples[pick].local_at - anchor.local_at);
+		new_drift = drift_known ? (3 * drift + rate) / 4 : rate;
+		measured = true;
+	}
+
+	portENTER_CRITICAL ();
+	best = samples[pick];
+	drift = new_drift;
+	if (measured || !synced)
+	{
+		anchor = samples[pick];
+	}
+	drift_known = drift_known || measured;
+	synced = true;
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method should be called every few milliseconds by the task which owns the
+ *  radio. At the server, it answers a request which has arrived. At the client, it
+ *  uses an answer which has arrived and sends a new request when it's time.
+ */
+
+void nRF24L01_time_sync::service (void)
+{
+	bool arrived, unanswered;
+
+	portENTER_CRITICAL ();
+	arrived = got_packet;
+	got_packet = false;
+	unanswered = awaiting;
+	portEXIT_CRITICAL ();
+
+	if (is_server)
+	{
+		if (arrived)
+		{
+			send (nRF_TIME_REPLY);
+		}
+		return;
+	}
+
+	if (arrived)
+	{
+		replies++;
+		add_sample ();
+	}
+
+	portTickType now = xTaskGetTickCount ();
+	if ((now - asked_at) < interval_ticks)
+	{
+		return;
+	}
+	if (unanswered)
+	{
+		lost++;
+	}
+
+	portENTER_CRITICAL ();
+	sequence++;
+	awaiting = true;
+	portEXIT_CRITICAL ();
+
+	asked_at = now;
+	send (nRF_TIME_REQUEST);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called by the radio's receiver interrupt when a time packet
+ *  arrives. It notes the time of arrival first, so that as little as possible
+ *  happens between the packet's arrival and the reading of the clock. At the server,
+ *  the request is answered later by \c service(); at the client, an answer is kept
+ *  only if it belongs to the last request. It must only be called from within an
+ *  interrupt service routine.
+ *  @param p_payload A pointer to the 32 byte payload, beginning with the mark
+ */
+
+void nRF24L01_time_sync::ISR_receive (const uint8_t* p_payload)
+{
+	uint32_t now = ISR_local_us ();
+
+	if (is_server)
+	{
+		if (p_payload[1] == nRF_TIME_REQUEST)
+		{
+			sequence = p_payload[2];
+			memcpy (&t1, p_payload + 3, 4);
+			t2 = now;
+			got_packet = true;
+		}
+	}
+	else if (p_payload[1] == nRF_TIME_REPLY && awaiting && p_payload[2] == sequence)
+	{
+		memcpy (&t1, p_payload + 3, 4);
+		memcpy (&t2, p_payload + 7, 4);
+		memcpy (&t3, p_payload + 11, 4);
+		t4 = now;
+		awaiting = false;
+		got_packet = true;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method converts a local time into the time which the server's clock showed
+ *  at the same moment. At the server, the time is returned unchanged.
+ *  @param local A local time in microseconds, as from \c local_us()
+ *  @return The server's time in microseconds at that moment
+ */
+
+uint32_t nRF24L01_time_sync::to_remote (uint32_t local)
+{
+	if (is_server)
+	{
+		return (local);
+	}
+	return (local + offset_at (local));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method converts a time on the server's clock into local time, so that an
+ *  event which the server has scheduled can be waited for. At the server, the time
+ *  is returned unchanged.
+ *  @param remote A time on the server's clock in microseconds
+ *  @return The local time in microseconds at that moment
+ */
+
+uint32_t nRF24L01_time_sync::to_local (uint32_t remote)
+{
+	if (is_server)
+	{
+		return (remote);
+	}
+
+	// The offset changes so slowly that each guess at the local time is much better
+	// than the last; the first may be far off if the clocks are far apart
+	uint32_t guess = remote - offset_at (remote);
+	guess = remote - offset_at (guess);
+	return (remote - offset_at (guess));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finds how far the server's time given by \c to_remote() may be from
+ *  the truth right now. It adds half the round trip of the best exchange, the clock
+ *  resolution at both ends, the scatter of recent exchanges about the estimate, and
+ *  the drift which may have built up since the best exchange: 100 ppm until the
+ *  drift has been measured, then 5 ppm.
+ *  @return The largest error in microseconds, or 0xFFFFFFFF if there's no estimate
+ */
+
+uint32_t nRF24L01_time_sync::get_error_us (void)
+{
+	sample base;
+	uint32_t scatter;
+	bool known;
+
+	if (is_server)
+	{
+		return (0);
+	}
+
+	portENTER_CRITICAL ();
+	if (!synced)
+	{
+		portEXIT_CRITICAL ();
+		return (0xFFFFFFFF);
+	}
+	base = best;
+	scatter = jitter;
+	known = drift_known;
+	portEXIT_CRITICAL ();
+
+	uint32_t age_ms = (local_us () - base.local_at) / 1000UL;
+	uint32_t ppm = known ? nRF_TIME_DRIFT_ERR_PPM : nRF_TIME_DRIFT_MAX_PPM;
+
+	return (base.delay / 2 + 2 * (1000000UL / HW_TICK_RATE_HZ) + scatter
+			+ age_ms * ppm / 1000UL);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the estimated difference between the clocks, the drift in parts
+ *  per billion, the error bound, and the numbers of exchanges.
+ *  @param ser_dev A pointer to the serial device on which to print
+ */
+
+void nRF24L01_time_sync::print_stats (emstream* ser_dev)
+{
+	if (is_server)
+	{
+		*ser_dev << PMS ("Time server: ") << requests << PMS (" requests answered, ")
+				 << send_failures << PMS (" failed") << endl;
+		return;
+	}
+
+	*ser_dev << PMS ("Time offset ") << offset_at (local_us ()) << PMS (" us, drift ")
+			 << (int32_t)(drift * 1.0e9) << PMS (" ppb, error ") << get_error_us ()
+			 << PMS (" us, delay ") << best.delay << PMS (" us; ") << requests
+			 << PMS (" requests, ") << replies << PMS (" replies, ") << lost
+			 << PMS (" lost, ") << send_failures << PMS (" failed") << endl;
+}
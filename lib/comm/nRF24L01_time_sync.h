@@ -0,0 +1,220 @@
+//*************************************************************************************
+/** \file nRF24L01_time_sync.h
+ *    This file contains a class which keeps track of the time on another computer
+ *    which can be reached through an nRF24L01 radio. Time stamps taken on different
+ *    boards can then be compared, so telemetry from a remote board can be lined up
+ *    with events at the base station and several boards can act at the same moment.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _NRF24L01_TIME_SYNC_H_
+#define _NRF24L01_TIME_SYNC_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For the RTOS tick count
+#include "emstream.h"                       // Header for base serial devices
+#include "time_stamp.h"                     // For the local microsecond clock
+#include "nRF24L01_base.h"                  // Header for base nRF24L01 radio driver
+
+
+/** This byte begins every time synchronization packet, so the radio's receiver
+ *  interrupt can tell these packets from the other kinds.
+ */
+#define nRF_TIME_MARK			0x04
+
+/// This code in a packet's second byte means the packet asks for the time.
+#define nRF_TIME_REQUEST		0x01
+
+/// This code in a packet's second byte means the packet answers a request.
+#define nRF_TIME_REPLY			0x02
+
+/// This is the number of recent exchanges from which the best one is chosen.
+#define nRF_TIME_FILTER_SIZE	8
+
+/// This is the shortest time in milliseconds over which the drift is measured.
+#define nRF_TIME_DRIFT_MIN_MS	10000
+
+/// This is how far apart two crystals may be assumed to drift before the drift has
+/// been measured, in parts per million.
+#define nRF_TIME_DRIFT_MAX_PPM	100
+
+/// This is how far off a measured drift may be assumed to be, in parts per million.
+#define nRF_TIME_DRIFT_ERR_PPM	5
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class keeps an estimate of the difference between this computer's
+ *  clock and the clock on another computer, in the way that NTP does.
+ *  \details One end is the server, usually the base station; its clock is the one
+ *  which the other end, the client, follows. Every so often the client sends a
+ *  request holding its own time \c t1. The server notes the time \c t2 at which the
+ *  request arrived and the time \c t3 at which it sends the answer, and the client
+ *  notes the time \c t4 at which the answer arrived. Then the server's clock is
+ *  ahead of the client's by about ((t2 - t1) + (t3 - t4)) / 2, and the packets spent
+ *  (t4 - t1) - (t3 - t2) in the air. Whatever the delays were in each direction,
+ *  the true difference can't be more than half the round trip delay away from the
+ *  estimate.
+ *
+ *  An exchange in which a packet was held up gives a poor estimate, so like NTP the
+ *  client keeps the last few exchanges and uses the one with the shortest round
+ *  trip. The difference between the clocks changes slowly because no two crystals
+ *  run at quite the same rate, so the rate of change, the drift, is measured over
+ *  tens of seconds and used to carry the estimate forward between exchanges.
+ *
+ *  Times are microseconds from the local \c time_stamp clock, kept in 32 bits. They
+ *  wrap around every 71 minutes, but all the arithmetic is done on differences, so
+ *  this does no harm. The resolution is that of the time stamp, 4 us with a 16 MHz
+ *  clock and the usual prescaler. The error bound given by \c get_error_us() adds
+ *  half the best round trip, the resolution at both ends, the scatter of recent
+ *  exchanges, and the drift which might have built up since the last exchange.
+ *  \code
+ *  nRF24L01_time_sync* p_clock = new nRF24L01_time_sync (p_radio, false, 1000);
+ *  ...
+ *  p_clock->service ();                         // Every few ms in the radio task
+ *  ...
+ *  uint32_t base_time = p_clock->to_remote (nRF24L01_time_sync::local_us ());
+ *  \endcode
+ */
+
+class nRF24L01_time_sync
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/** This structure holds the result of one exchange: the local time at which
+		 *  the answer arrived, the estimated difference between the clocks, and the
+		 *  round trip delay.
+		 */
+		struct sample
+		{
+			uint32_t local_at;              ///< Local time when the answer arrived
+			int32_t offset;                 ///< Server's clock minus this clock
+			uint32_t delay;                 ///< Time spent in the air, both ways
+		};
+
+		/// The radio through which the packets are sent.
+		nRF24L01_base* p_radio;
+
+		/// A serial device for debugging messages, or NULL for none.
+		emstream* p_serial;
+
+		/// True at the end whose clock is followed, false at the end which follows.
+		bool is_server;
+
+		/// The time in RTOS ticks between requests from the client.
+		portTickType interval_ticks;
+
+		/// The tick count when the client last sent a request.
+		portTickType asked_at;
+
+		/// The sequence number of the last request, so late answers can be ignored.
+		uint8_t sequence;
+
+		/// Set at the client from sending a request until its answer arrives.
+		bool awaiting;
+
+		/// Set by the receiver interrupt when a request or an answer has arrived.
+		bool got_packet;
+
+		/// The four times of the exchange which has just happened.
+		uint32_t t1, t2, t3, t4;
+
+		/// The results of the last few exchanges.
+		sample samples[nRF_TIME_FILTER_SIZE];
+
+		/// The number of samples held, up to \c nRF_TIME_FILTER_SIZE.
+		uint8_t sample_count;
+
+		/// The index at which the next sample will be put.
+		uint8_t next_sample;
+
+		/// The sample on which the estimate is now based.
+		sample best;
+
+		/// The sample from which the drift is being measured.
+		sample anchor;
+
+		/// True once there is an estimate at all.
+		bool synced;
+
+		/// True once the drift has been measured.
+		bool drift_known;
+
+		/// The drift: microseconds gained by the server's clock per local microsecond.
+		float drift;
+
+		/// A smoothed measure of how far each new sample is from the estimate, in us.
+		uint32_t jitter;
+
+		uint16_t requests;                  ///< Requests sent or answered
+		uint16_t replies;                   ///< Answers which arrived at the client
+		uint16_t lost;                      ///< Requests which weren't answered in time
+		uint16_t send_failures;             ///< Packets the radio couldn't send
+
+		// Send a request or an answer
+		void send (uint8_t);
+
+		// Add an exchange's result to the filter and update the estimate
+		void add_sample (void);
+
+		// Estimate the difference between the clocks at a given local time
+		int32_t offset_at (uint32_t);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor sets up the server or a client
+		nRF24L01_time_sync (nRF24L01_base*, bool, uint16_t = 1000, emstream* = NULL);
+
+		// Send a request if it's time, or answer one which has arrived
+		void service (void);
+
+		// Take a request or an answer which has arrived
+		void ISR_receive (const uint8_t*);
+
+		// Get the local time in microseconds
+		static uint32_t local_us (void);
+
+		// Get the local time in microseconds from within an interrupt
+		static uint32_t ISR_local_us (void);
+
+		// Convert a local time into the server's time
+		uint32_t to_remote (uint32_t);
+
+		// Convert a time on the server's clock into local time
+		uint32_t to_local (uint32_t);
+
+		// Find the largest amount by which the server's time may be wrong now
+		uint32_t get_error_us (void);
+
+		// Print the estimate, its error, and the numbers of exchanges
+		void print_stats (emstream*);
+
+		/** This method checks whether any exchange has yet given an estimate of the
+		 *  server's time. At the server, the answer is always yes.
+		 *  @return True if \c to_remote() and \c to_local() can be trusted
+		 */
+		bool is_synced (void)
+		{
+			return (is_server || synced);
+		}
+};
+
+
+/// This is the time keeper which gets packets from the radio's receiver interrupt.
+extern nRF24L01_time_sync* p_nRF24_time_sync;
+
+#endif // _NRF24L01_TIME_SYNC_H_
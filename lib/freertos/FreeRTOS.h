@@ -197,6 +197,18 @@ typedef portBASE_TYPE (*pdTASK_HOOK_CODE)( void * );
 	#error configMAX_TASK_NAME_LEN must be set to a minimum of 1 in FreeRTOSConfig.h
 #endif
 
+#ifndef configUSE_SUBTICK_TIMER
+	#define configUSE_SUBTICK_TIMER 0
+#endif
+
+#if (configUSE_SUBTICK_TIMER == 1) && (INCLUDE_vTaskSuspend != 1)
+	#error configUSE_SUBTICK_TIMER needs INCLUDE_vTaskSuspend to be set to 1
+#endif
+
+#ifndef configUSE_TASK_NOTIFICATIONS
+	#define configUSE_TASK_NOTIFICATIONS 0
+#endif
+
 #ifndef INCLUDE_xTaskResumeFromISR
 	#define INCLUDE_xTaskResumeFromISR 1
 #endif
@@ -162,6 +162,18 @@
  */
 #define configUSE_TICK_HOOK             0
 
+/** When this define is set to 1, the second compare channel of the tick timer is used
+ *  to wake tasks up between ticks, so that \c frt_delay_us() can put a task to sleep
+ *  for less than a tick. It needs \c INCLUDE_vTaskSuspend.
+ */
+#define configUSE_SUBTICK_TIMER         1
+
+/** When this define is set to 1, each task gets a notification word which other tasks
+ *  and interrupts can set, add to, or OR bits into, and on which the task can wait.
+ *  It's a quicker and smaller way to wake a task than a binary semaphore.
+ */
+#define configUSE_TASK_NOTIFICATIONS    1
+
 /** When this define is set to 1, the RTOS tick counter will only be 16 bits in size.
  *  This makes the RTOS tick interrupt a little quicker and saves some memory, but
  *  the tick counter overflows very quickly and isn't useful for measuring real time.
@@ -211,11 +223,12 @@
 #define INCLUDE_uxTaskPriorityGet                1
 #define INCLUDE_vTaskDelete                      0
 #define INCLUDE_vTaskCleanUpResources            0
-#define INCLUDE_vTaskSuspend                     0
+#define INCLUDE_vTaskSuspend                     1
 #define INCLUDE_vTaskDelayUntil                  1
 #define INCLUDE_vTaskDelay                       1
 #define INCLUDE_pcTaskGetTaskName                1
 #define INCLUDE_uxTaskGetStackHighWaterMark      1
 #define INCLUDE_xTaskGetIdleTaskHandle           1
+#define INCLUDE_xTaskGetSchedulerState           1
 
 #endif /* FREERTOS_CONFIG_H */
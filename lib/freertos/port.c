@@ -78,6 +78,7 @@ Changes from V2.6.0
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "isr_profile.h"
 
 /*-----------------------------------------------------------
  * Implementation of functions defined in portable.h for the AVR port.
@@ -532,8 +533,10 @@ void vPortYieldFromTick( void ) __attribute__ ( ( naked ) );
 void vPortYieldFromTick( void )
 {
 	portSAVE_CONTEXT();
+	ISR_PROFILE_START_TIMED( ISR_PROF_TICK );
 	vTaskIncrementTick();
 	vTaskSwitchContext();
+	ISR_PROFILE_END( ISR_PROF_TICK );
 	portRESTORE_CONTEXT();
 
 	asm volatile ( "ret" );
@@ -613,3 +616,28 @@ void RT_VECT (void)
 		vTaskIncrementTick ();
 	#endif
 }
+
+
+//-------------------------------------------------------------------------------------
+/*  This is the ISR which runs when the tick timer's second compare channel matches.
+ *  It's used to wake up tasks which sleep for less than a tick. The context is saved
+ *  as in the tick ISR, so if xPortSubTickMatch() wakes a task which should run, it 
+ *  runs now instead of after the next tick. 
+ */
+
+#if (configUSE_SUBTICK_TIMER == 1)
+	void portSUBTICK_VECT (void) __attribute__ ((signal, naked));
+	void portSUBTICK_VECT (void)
+	{
+		portSAVE_CONTEXT ();
+		ISR_PROFILE_START (ISR_PROF_SUBTICK);
+		if (xPortSubTickMatch () != pdFALSE)
+		{
+			vTaskSwitchContext ();
+		}
+		ISR_PROFILE_END (ISR_PROF_SUBTICK);
+		portRESTORE_CONTEXT ();
+
+		asm volatile ( "reti" );
+	}
+#endif
@@ -114,13 +114,32 @@ extern "C" {
 
 /*-----------------------------------------------------------*/	
 
-/* Critical section management. */
-#define portENTER_CRITICAL()		asm volatile ( "in		__tmp_reg__, __SREG__" :: );	\
+/* Critical section management. When CRITICAL_PROFILE is defined, the saved status
+register is also passed to the profiler in crit_profile.c, which times each section
+that masks interrupts and charges the time to the place where the section began. */
+#ifdef CRITICAL_PROFILE
+	#include "crit_profile.h"
+
+	#define portENTER_CRITICAL()	do { uint8_t crit_sreg;								\
+									asm volatile ( "in		%0, __SREG__"	"\n\t"		\
+												   "cli"					"\n\t"		\
+												   "push	%0" : "=r" (crit_sreg) :: "memory" ); \
+									crit_profile_enter (CRIT_PROFILE_HERE (), crit_sreg); \
+									} while (0)
+
+	#define portEXIT_CRITICAL()		do { uint8_t crit_sreg;								\
+									asm volatile ( "pop		%0" : "=r" (crit_sreg) :: "memory" ); \
+									crit_profile_exit (crit_sreg);						\
+									asm volatile ( "out		__SREG__, %0" :: "r" (crit_sreg) : "memory" ); \
+									} while (0)
+#else
+	#define portENTER_CRITICAL()	asm volatile ( "in		__tmp_reg__, __SREG__" :: );	\
 									asm volatile ( "cli" :: );								\
 									asm volatile ( "push	__tmp_reg__" :: )
 
-#define portEXIT_CRITICAL()			asm volatile ( "pop		__tmp_reg__" :: );				\
+	#define portEXIT_CRITICAL()		asm volatile ( "pop		__tmp_reg__" :: );				\
 									asm volatile ( "out		__SREG__, __tmp_reg__" :: )
+#endif
 
 #define portDISABLE_INTERRUPTS()	asm volatile ( "cli" :: );
 #define portENABLE_INTERRUPTS()		asm volatile ( "sei" :: );
@@ -159,6 +178,56 @@ extern void vPortYield( void ) __attribute__ ( ( naked ) );
 // Here's the header for the function which returns the run-time counter value
 uint32_t func_get_run_time_counter (void);
 
+//-------------------------------------------------------------------------------------
+/* These macros give the registers of the second compare channel (B) of the timer 
+ * which makes the RTOS tick. Channel A clears the timer once per tick; channel B is
+ * free, so it's used to wake tasks up between ticks. Its interrupt is handled in
+ * port.c, which calls xPortSubTickMatch() and switches tasks if that woke one up. */
+#if (configUSE_SUBTICK_TIMER == 1)
+	#if (defined TIMER5_COMPA_vect)
+		#define portSUBTICK_VECT			TIMER5_COMPB_vect
+		#define portSUBTICK_TCNT			TCNT5
+		#define portSUBTICK_OCR				OCR5B
+		#define portSUBTICK_TIMSK			TIMSK5
+		#define portSUBTICK_TIFR			TIFR5
+		#define portSUBTICK_OCIE			OCIE5B
+		#define portSUBTICK_OCF				OCF5B
+		#define portTICK_OCF				OCF5A
+	#elif (defined TIMER3_COMPA_vect)
+		#define portSUBTICK_VECT			TIMER3_COMPB_vect
+		#define portSUBTICK_TCNT			TCNT3
+		#define portSUBTICK_OCR				OCR3B
+		#ifdef TIMSK3
+			#define portSUBTICK_TIMSK		TIMSK3
+			#define portSUBTICK_TIFR		TIFR3
+		#else
+			#define portSUBTICK_TIMSK		ETIMSK
+			#define portSUBTICK_TIFR		ETIFR
+		#endif
+		#define portSUBTICK_OCIE			OCIE3B
+		#define portSUBTICK_OCF				OCF3B
+		#define portTICK_OCF				OCF3A
+	#else
+		#define portSUBTICK_VECT			TIMER1_COMPB_vect
+		#define portSUBTICK_TCNT			TCNT1
+		#define portSUBTICK_OCR				OCR1B
+		#ifdef TIMSK1
+			#define portSUBTICK_TIMSK		TIMSK1
+			#define portSUBTICK_TIFR		TIFR1
+		#else
+			#define portSUBTICK_TIMSK		TIMSK
+			#define portSUBTICK_TIFR		TIFR
+		#endif
+		#define portSUBTICK_OCIE			OCIE1B
+		#define portSUBTICK_OCF				OCF1B
+		#define portTICK_OCF				OCF1A
+	#endif
+
+	// This function is called by the channel B interrupt; it returns pdTRUE if a task
+	// was woken which should run right away
+	portBASE_TYPE xPortSubTickMatch (void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -201,6 +201,16 @@ typedef struct xTASK_PARAMTERS
 #define taskSCHEDULER_RUNNING		1
 #define taskSCHEDULER_SUSPENDED		2
 
+/* Actions which xTaskNotify() can take on the notification word of a task. */
+typedef enum
+{
+	eNoAction = 0,				/* Wake the task without changing its notification word. */
+	eSetBits,					/* OR the value into the word, as a set of event flags. */
+	eIncrement,					/* Add one to the word, as a counting semaphore does. */
+	eSetValueWithOverwrite,		/* Put the value into the word even if it hasn't been read. */
+	eSetValueWithoutOverwrite	/* Put the value into the word only if it has been read. */
+} eNotifyAction;
+
 /*-----------------------------------------------------------
  * TASK CREATION API
  *----------------------------------------------------------*/
@@ -763,6 +773,114 @@ void vTaskResume( xTaskHandle pxTaskToResume ) PRIVILEGED_FUNCTION;
  */
 portBASE_TYPE xTaskResumeFromISR( xTaskHandle pxTaskToResume ) PRIVILEGED_FUNCTION;
 
+/*-----------------------------------------------------------
+ * TASK NOTIFICATION API
+ *----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+/**
+ * task. h
+ * <pre>portBASE_TYPE xTaskNotify( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction );</pre>
+ *
+ * configUSE_TASK_NOTIFICATIONS must be defined as 1 for this function to be
+ * available.
+ *
+ * Each task has a 32 bit notification word, kept in its TCB, which starts at
+ * zero.  Sending a notification changes the word as eAction says and wakes
+ * the task if it is waiting in xTaskNotifyWait() or ulTaskNotifyTake().  A
+ * notification needs no object of its own, so it uses less RAM than a binary
+ * semaphore or a queue, and it is quicker because no event lists or item
+ * copies are involved.  Only one task can wait on a notification word, the
+ * task which owns it.
+ *
+ * @param xTaskToNotify Handle of the task being notified.
+ *
+ * @param ulValue The value used as eAction says; not used for eIncrement and
+ * eNoAction.
+ *
+ * @param eAction eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite or
+ * eSetValueWithoutOverwrite.
+ *
+ * @return pdFAIL if eAction is eSetValueWithoutOverwrite and the task still
+ * had a notification pending, so the word was not changed; otherwise pdPASS.
+ *
+ * \defgroup xTaskNotify xTaskNotify
+ * \ingroup TaskNotifications
+ */
+portBASE_TYPE xTaskNotify( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>portBASE_TYPE xTaskNotifyFromISR( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction, signed portBASE_TYPE *pxHigherPriorityTaskWoken );</pre>
+ *
+ * A version of xTaskNotify() that can be called from within an ISR.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if the notification woke a
+ * task of a higher priority than the task which was interrupted, so that a
+ * context switch should be done before the ISR returns.  It may be NULL.
+ *
+ * \defgroup xTaskNotifyFromISR xTaskNotifyFromISR
+ * \ingroup TaskNotifications
+ */
+portBASE_TYPE xTaskNotifyFromISR( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction, signed portBASE_TYPE *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>portBASE_TYPE xTaskNotifyWait( unsigned long ulBitsToClearOnEntry, unsigned long ulBitsToClearOnExit, unsigned long *pulNotificationValue, portTickType xTicksToWait );</pre>
+ *
+ * Waits for the calling task to be notified.  If a notification is already
+ * pending the function returns at once.
+ *
+ * @param ulBitsToClearOnEntry Bits cleared in the notification word before
+ * waiting, if no notification is pending.
+ *
+ * @param ulBitsToClearOnExit Bits cleared in the notification word after a
+ * notification has been received.  0xffffffffUL resets the word to zero.
+ *
+ * @param pulNotificationValue Where to put the notification word as it was
+ * before the ulBitsToClearOnExit bits were cleared.  It may be NULL.
+ *
+ * @param xTicksToWait The longest time to wait, in ticks.  portMAX_DELAY waits
+ * forever if INCLUDE_vTaskSuspend is 1.
+ *
+ * @return pdTRUE if a notification was received, pdFALSE if the time ran out.
+ *
+ * \defgroup xTaskNotifyWait xTaskNotifyWait
+ * \ingroup TaskNotifications
+ */
+portBASE_TYPE xTaskNotifyWait( unsigned long ulBitsToClearOnEntry, unsigned long ulBitsToClearOnExit, unsigned long *pulNotificationValue, portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>unsigned long ulTaskNotifyTake( portBASE_TYPE xClearCountOnExit, portTickType xTicksToWait );</pre>
+ *
+ * Uses the notification word as a binary or counting semaphore, given with
+ * xTaskNotifyGive().  Waits until the word is not zero, then either clears it
+ * (xClearCountOnExit pdTRUE, like a binary semaphore) or takes one from it
+ * (pdFALSE, like a counting semaphore).
+ *
+ * @return The notification word before it was cleared or decremented; zero
+ * if the time ran out.
+ *
+ * \defgroup ulTaskNotifyTake ulTaskNotifyTake
+ * \ingroup TaskNotifications
+ */
+unsigned long ulTaskNotifyTake( portBASE_TYPE xClearCountOnExit, portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>portBASE_TYPE xTaskNotifyGive( xTaskHandle xTaskToNotify );</pre>
+ *
+ * Adds one to a task's notification word, for use with ulTaskNotifyTake().
+ *
+ * \defgroup xTaskNotifyGive xTaskNotifyGive
+ * \ingroup TaskNotifications
+ */
+#define xTaskNotifyGive( xTaskToNotify ) xTaskNotify( ( xTaskToNotify ), 0UL, eIncrement )
+
+#endif /* configUSE_TASK_NOTIFICATIONS */
+
 /*-----------------------------------------------------------
  * SCHEDULER CONTROL
  *----------------------------------------------------------*/
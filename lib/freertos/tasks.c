@@ -86,6 +86,13 @@ task.h is included from an application file. */
  */
 #define tskIDLE_STACK_SIZE	configMINIMAL_STACK_SIZE
 
+/*
+ * Values of a task's ucNotifyState.
+ */
+#define taskNOT_WAITING_NOTIFICATION	( ( unsigned char ) 0 )
+#define taskWAITING_NOTIFICATION		( ( unsigned char ) 1 )
+#define taskNOTIFICATION_RECEIVED		( ( unsigned char ) 2 )
+
 /*
  * Task control block.  A task control block (TCB) is allocated to each task,
  * and stores the context of the task.
@@ -129,6 +136,11 @@ typedef struct tskTaskControlBlock
 		unsigned long ulRunTimeCounter;		/*< Used for calculating how much CPU time each task is utilising. */
 	#endif
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+		volatile unsigned long ulNotifiedValue;	/*< The notification word, changed by xTaskNotify(). */
+		volatile unsigned char ucNotifyState;	/*< Whether the task is waiting for a notification or has one it hasn't yet received. */
+	#endif
+
 } tskTCB;
 
 
@@ -358,6 +370,20 @@ static void prvAddCurrentTaskToDelayedList( portTickType xTimeToWake ) PRIVILEGE
  */
 static tskTCB *prvAllocateTCBAndStack( unsigned short usStackDepth, portSTACK_TYPE *puxStackBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Used by xTaskNotify() and xTaskNotifyFromISR() to change a task's
+ * notification word.  Returns the notification state the task was in before.
+ * Blocking the calling task until it is notified is done by
+ * prvBlockForNotification(), which must be called from within a critical
+ * section.
+ */
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	static unsigned char prvNotifyTCB( tskTCB *pxTCB, unsigned long ulValue, eNotifyAction eAction ) PRIVILEGED_FUNCTION;
+	static void prvBlockForNotification( portTickType xTicksToWait ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Called from vTaskList.  vListTasks details all the tasks currently under
  * control of the scheduler.  The tasks may be in one of a number of lists.
@@ -2002,6 +2028,13 @@ static void prvInitialiseTCBVariables( tskTCB *pxTCB, const signed char * const
 	}
 	#endif
 
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+	{
+		pxTCB->ulNotifiedValue = 0UL;
+		pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+	}
+	#endif
+
 	#if ( portUSING_MPU_WRAPPERS == 1 )
 	{
 		vPortStoreTaskMPUSettings( &( pxTCB->xMPUSettings ), xRegions, pxTCB->pxStack, usStackDepth );
@@ -2475,6 +2508,274 @@ void vTaskExitCritical( void )
 #endif
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	static unsigned char prvNotifyTCB( tskTCB *pxTCB, unsigned long ulValue, eNotifyAction eAction )
+	{
+	unsigned char ucOriginalNotifyState;
+
+		/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED. */
+		ucOriginalNotifyState = pxTCB->ucNotifyState;
+
+		switch( eAction )
+		{
+			case eSetBits :
+				pxTCB->ulNotifiedValue |= ulValue;
+				break;
+
+			case eIncrement :
+				( pxTCB->ulNotifiedValue )++;
+				break;
+
+			case eSetValueWithOverwrite :
+				pxTCB->ulNotifiedValue = ulValue;
+				break;
+
+			case eSetValueWithoutOverwrite :
+				/* A value which the task hasn't received yet is kept. */
+				if( ucOriginalNotifyState != taskNOTIFICATION_RECEIVED )
+				{
+					pxTCB->ulNotifiedValue = ulValue;
+				}
+				break;
+
+			default :
+				/* eNoAction just wakes the task. */
+				break;
+		}
+
+		pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+
+		return ucOriginalNotifyState;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	static void prvBlockForNotification( portTickType xTicksToWait )
+	{
+		/* THIS FUNCTION MUST BE CALLED FROM WITHIN A CRITICAL SECTION, so that
+		a notification cannot arrive between the caller's check and the task
+		being placed in the blocked list. */
+		pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+
+		if( xTicksToWait > ( portTickType ) 0U )
+		{
+			/* We must remove ourselves from the ready list before adding
+			ourselves to the blocked list as the same list item is used for
+			both lists.  No event list is used; xTaskNotify() finds the task
+			through its handle. */
+			vListRemove( ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+
+			#if ( INCLUDE_vTaskSuspend == 1 )
+			{
+				if( xTicksToWait == portMAX_DELAY )
+				{
+					/* Block indefinitely, out of reach of timing events. */
+					vListInsertEnd( ( xList * ) &xSuspendedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+				}
+				else
+				{
+					prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+				}
+			}
+			#else
+			{
+				prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+			}
+			#endif
+
+			/* The yield is performed within the critical section.  Each task
+			keeps its own interrupt status, so interrupts are enabled again as
+			soon as the next task runs. */
+			portYIELD_WITHIN_API();
+		}
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	portBASE_TYPE xTaskNotify( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction )
+	{
+	tskTCB *pxTCB;
+	unsigned char ucOriginalNotifyState;
+	portBASE_TYPE xReturn = pdPASS;
+
+		configASSERT( xTaskToNotify );
+		pxTCB = ( tskTCB * ) xTaskToNotify;
+
+		taskENTER_CRITICAL();
+		{
+			ucOriginalNotifyState = prvNotifyTCB( pxTCB, ulValue, eAction );
+
+			if( ( eAction == eSetValueWithoutOverwrite ) && ( ucOriginalNotifyState == taskNOTIFICATION_RECEIVED ) )
+			{
+				xReturn = pdFAIL;
+			}
+
+			/* If the task was waiting it is in a delayed list, or in the
+			suspended list if it was waiting indefinitely.  As we are in a
+			critical section we can access the ready lists even if the
+			scheduler is suspended. */
+			if( ucOriginalNotifyState == taskWAITING_NOTIFICATION )
+			{
+				vListRemove( &( pxTCB->xGenericListItem ) );
+				prvAddTaskToReadyQueue( pxTCB );
+
+				if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return xReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	portBASE_TYPE xTaskNotifyFromISR( xTaskHandle xTaskToNotify, unsigned long ulValue, eNotifyAction eAction, signed portBASE_TYPE *pxHigherPriorityTaskWoken )
+	{
+	tskTCB *pxTCB;
+	unsigned char ucOriginalNotifyState;
+	portBASE_TYPE xReturn = pdPASS;
+	unsigned portBASE_TYPE uxSavedInterruptStatus;
+
+		configASSERT( xTaskToNotify );
+		pxTCB = ( tskTCB * ) xTaskToNotify;
+
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			ucOriginalNotifyState = prvNotifyTCB( pxTCB, ulValue, eAction );
+
+			if( ( eAction == eSetValueWithoutOverwrite ) && ( ucOriginalNotifyState == taskNOTIFICATION_RECEIVED ) )
+			{
+				xReturn = pdFAIL;
+			}
+
+			if( ucOriginalNotifyState == taskWAITING_NOTIFICATION )
+			{
+				if( uxSchedulerSuspended == ( unsigned portBASE_TYPE ) pdFALSE )
+				{
+					vListRemove( &( pxTCB->xGenericListItem ) );
+					prvAddTaskToReadyQueue( pxTCB );
+				}
+				else
+				{
+					/* We cannot access the delayed or ready lists, so will hold
+					this task pending until the scheduler is resumed. */
+					vListInsertEnd( ( xList * ) &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+				}
+
+				if( ( pxTCB->uxPriority > pxCurrentTCB->uxPriority ) && ( pxHigherPriorityTaskWoken != NULL ) )
+				{
+					*pxHigherPriorityTaskWoken = pdTRUE;
+				}
+			}
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+		return xReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	portBASE_TYPE xTaskNotifyWait( unsigned long ulBitsToClearOnEntry, unsigned long ulBitsToClearOnExit, unsigned long *pulNotificationValue, portTickType xTicksToWait )
+	{
+	portBASE_TYPE xReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if a notification is not already pending. */
+			if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+				prvBlockForNotification( xTicksToWait );
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		taskENTER_CRITICAL();
+		{
+			if( pulNotificationValue != NULL )
+			{
+				*pulNotificationValue = pxCurrentTCB->ulNotifiedValue;
+			}
+
+			/* If the state is still waiting, the time ran out. */
+			if( pxCurrentTCB->ucNotifyState == taskNOTIFICATION_RECEIVED )
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnExit;
+				xReturn = pdTRUE;
+			}
+			else
+			{
+				xReturn = pdFALSE;
+			}
+
+			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return xReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+
+	unsigned long ulTaskNotifyTake( portBASE_TYPE xClearCountOnExit, portTickType xTicksToWait )
+	{
+	unsigned long ulReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if the count is not already non-zero. */
+			if( pxCurrentTCB->ulNotifiedValue == 0UL )
+			{
+				prvBlockForNotification( xTicksToWait );
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		taskENTER_CRITICAL();
+		{
+			ulReturn = pxCurrentTCB->ulNotifiedValue;
+
+			if( ulReturn != 0UL )
+			{
+				if( xClearCountOnExit != pdFALSE )
+				{
+					pxCurrentTCB->ulNotifiedValue = 0UL;
+				}
+				else
+				{
+					pxCurrentTCB->ulNotifiedValue = ulReturn - 1UL;
+				}
+			}
+
+			pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 
 
 
@@ -0,0 +1,262 @@
+//*************************************************************************************
+/** \file crit_profile.c
+ *    This file contains the functions which time critical sections when the
+ *    \c CRITICAL_PROFILE option is turned on. They're written in C because they are
+ *    called from the critical sections in the FreeRTOS kernel as well as from C++
+ *    code. They are always called with interrupts masked, so they need no protection
+ *    of their own, and they must never use a critical section themselves.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifdef CRITICAL_PROFILE
+
+#include <avr/io.h>                         // Timer and status register names
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "crit_profile.h"                   // Header for this file
+
+
+// The counter, flag register and flag of the timer which makes RTOS ticks; these must
+// match the timer chosen in port.c
+#if (defined TIMER5_COMPA_vect)
+	#define CRIT_TCNT		TCNT5
+	#define CRIT_TIFR		TIFR5
+	#define CRIT_OCF		OCF5A
+#elif (defined TIMER3_COMPA_vect)
+	#define CRIT_TCNT		TCNT3
+	#define CRIT_TIFR		TIFR3
+	#define CRIT_OCF		OCF3A
+#else
+	#define CRIT_TCNT		TCNT1
+	#define CRIT_TIFR		TIFR1
+	#define CRIT_OCF		OCF1A
+#endif
+
+/// The number of timer counts in one RTOS tick, after which the timer clears itself.
+#define CRIT_TICK_COUNTS	(configCPU_CLOCK_HZ / (configTICK_RATE_HZ * portCLOCK_PRESCALER))
+
+
+/// The statistics for each call site, kept in order of when the sites were first seen.
+static crit_site_stats crit_sites[CRIT_PROFILE_SITES];
+
+/// The statistics for all critical sections together; \c site is that of the longest.
+static crit_site_stats crit_all;
+
+/// The number of sections whose end couldn't be timed, as explained at the exit hook.
+static uint16_t crit_lost;
+
+/// The timer count when interrupts were last masked by an outermost critical section.
+static uint16_t crit_start_count;
+
+/// The call site which last masked interrupts.
+static uint16_t crit_start_site;
+
+/// This flag is set while an outermost critical section is being timed.
+static uint8_t crit_timing;
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called by \c portENTER_CRITICAL() just after it has masked
+ *  interrupts. Only outermost critical sections -- those entered with interrupts
+ *  enabled -- are timed; nested ones are part of the outer section's time, and those
+ *  inside interrupt service routines aren't masking anything which wasn't masked
+ *  already.
+ *  @param site The program address of the critical section
+ *  @param old_sreg The value which was in SREG before interrupts were masked
+ */
+
+void crit_profile_enter (uint16_t site, uint8_t old_sreg)
+{
+	if (old_sreg & (1 << SREG_I))
+	{
+		crit_start_count = CRIT_TCNT;
+		crit_start_site = site;
+		crit_timing = 1;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function saves the time of one critical section in the statistics for its
+ *  call site. If the site isn't in the table and the table is full, the site whose
+ *  longest time is the shortest is thrown out, unless this time is shorter still.
+ *  @param site The program address of the critical section
+ *  @param counts How long interrupts were masked, in timer counts
+ */
+
+static void crit_record (uint16_t site, uint16_t counts)
+{
+	crit_site_stats* p_entry = NULL;
+	crit_site_stats* p_least = &crit_sites[0];
+	uint8_t index;
+
+	for (index = 0; index < CRIT_PROFILE_SITES; index++)
+	{
+		if (crit_sites[index].site == site || crit_sites[index].count == 0)
+		{
+			p_entry = &crit_sites[index];
+			break;
+		}
+		if (crit_sites[index].max < p_least->max)
+		{
+			p_least = &crit_sites[index];
+		}
+	}
+
+	if (p_entry == NULL)
+	{
+		if (counts <= p_least->max)
+		{
+			return;
+		}
+		p_entry = p_least;
+		p_entry->count = 0;
+	}
+
+	if (p_entry->count == 0)
+	{
+		p_entry->site = site;
+		p_entry->max = 0;
+		p_entry->total = 0;
+	}
+	if (p_entry->count < 0xFFFF)
+	{
+		p_entry->count++;
+		p_entry->total += counts;
+	}
+	if (counts > p_entry->max)
+	{
+		p_entry->max = counts;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called by \c portEXIT_CRITICAL() just before it puts back the
+ *  saved status register. If that will turn interrupts back on, the time since they
+ *  were masked is found from the tick timer. The timer clears itself once per RTOS
+ *  tick, and the tick interrupt can't run while interrupts are masked, so a pending
+ *  compare match flag means the timer has cleared once during the section.
+ *
+ *  A section can also end somewhere other than here: if a task yields inside a
+ *  critical section and the next task resumes through a return from interrupt,
+ *  interrupts come back on without this function being called. Such a time would
+ *  come out too long, so if the timer count went backwards without the flag being
+ *  set, or a section ends without having been started, it's counted as lost instead.
+ *  @param old_sreg The value which is about to be put back into SREG
+ */
+
+void crit_profile_exit (uint8_t old_sreg)
+{
+	uint16_t now = CRIT_TCNT;
+	uint16_t counts;
+
+	if (!(old_sreg & (1 << SREG_I)))
+	{
+		return;
+	}
+	if (!crit_timing)
+	{
+		if (crit_lost < 0xFFFF)
+		{
+			crit_lost++;
+		}
+		return;
+	}
+	crit_timing = 0;
+
+	if (CRIT_TIFR & (1 << CRIT_OCF))
+	{
+		counts = now + CRIT_TICK_COUNTS - crit_start_count;
+	}
+	else if (now >= crit_start_count)
+	{
+		counts = now - crit_start_count;
+	}
+	else
+	{
+		if (crit_lost < 0xFFFF)
+		{
+			crit_lost++;
+		}
+		return;
+	}
+
+	if (crit_all.count < 0xFFFF)
+	{
+		crit_all.count++;
+		crit_all.total += counts;
+	}
+	if (counts > crit_all.max)
+	{
+		crit_all.max = counts;
+		crit_all.site = crit_start_site;
+	}
+	crit_record (crit_start_site, counts);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function copies the statistics so that they can be printed at leisure. It
+ *  must be called with interrupts masked, or the copies might be half updated.
+ *  @param p_sites An array of \c CRIT_PROFILE_SITES entries to hold the table
+ *  @param p_all A structure to hold the statistics for all sections together
+ *  @param p_lost A place to put the number of sections which couldn't be timed
+ *  @return The number of entries in the table which are in use
+ */
+
+uint8_t crit_profile_copy (crit_site_stats* p_sites, crit_site_stats* p_all,
+						   uint16_t* p_lost)
+{
+	uint8_t used = 0;
+	uint8_t index;
+
+	for (index = 0; index < CRIT_PROFILE_SITES; index++)
+	{
+		p_sites[index] = crit_sites[index];
+		if (crit_sites[index].count != 0)
+		{
+			used++;
+		}
+	}
+	*p_all = crit_all;
+	*p_lost = crit_lost;
+
+	return (used);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function clears all the statistics, for example so that a new measurement
+ *  can be started after the program has finished setting up. It must be called with
+ *  interrupts masked.
+ */
+
+void crit_profile_reset (void)
+{
+	uint8_t index;
+
+	for (index = 0; index < CRIT_PROFILE_SITES; index++)
+	{
+		crit_sites[index].count = 0;
+	}
+	crit_all.count = 0;
+	crit_all.max = 0;
+	crit_all.total = 0;
+	crit_lost = 0;
+}
+
+#endif // CRITICAL_PROFILE
@@ -0,0 +1,95 @@
+//*************************************************************************************
+/** \file crit_profile.h
+ *    This file contains the header for a profiler which measures how long interrupts
+ *    are kept masked by critical sections. When \c CRITICAL_PROFILE is defined in the
+ *    Makefile, \c portENTER_CRITICAL() and \c portEXIT_CRITICAL() in portmacro.h call
+ *    the functions here, so every critical section in the program -- those in the
+ *    kernel, \c shared_data, \c frt_queue, \c time_stamp and the application -- is
+ *    timed. When \c CRITICAL_PROFILE isn't defined, nothing in this file is compiled
+ *    and the critical section macros are the plain three-instruction versions.
+ *
+ *    Times are measured with the hardware timer which makes RTOS ticks, so they have
+ *    the resolution of that timer, 0.5 us with a 16 MHz clock. Each time is counted
+ *    from where interrupts were turned off to where they were turned back on, and is
+ *    charged to the call site where they were turned off. Sites are identified by
+ *    their address in program memory; the report prints byte addresses which can be
+ *    looked up in the \c .lst file made by the Makefile.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _CRIT_PROFILE_H_
+#define _CRIT_PROFILE_H_
+
+#ifdef CRITICAL_PROFILE
+
+#include <stdint.h>                         // Integer types such as uint16_t
+
+
+/** This is the number of call sites for which separate statistics are kept. When
+ *  more sites than this have been seen, the site with the shortest worst case is
+ *  dropped from the table to make room, so the worst offenders are always kept.
+ */
+#define CRIT_PROFILE_SITES		16
+
+/** This macro finds the address in program memory of the place where it is used.
+ *  It uses GCC's "labels as values" extension, so it works in both C and C++ files.
+ */
+#define CRIT_PROFILE_HERE()		({ __label__ crit_here; crit_here: ; \
+								   (uint16_t)&&crit_here; })
+
+
+/** This structure holds the statistics for the critical sections which begin at one
+ *  call site. All the times are in counts of the RTOS tick timer.
+ */
+typedef struct
+{
+	uint16_t site;                          ///< Program (word) address of the site
+	uint16_t count;                         ///< Sections timed, saturating at 0xFFFF
+	uint16_t max;                           ///< Longest time interrupts were masked
+	uint32_t total;                         ///< Sum of the times, used for the mean
+} crit_site_stats;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called just after interrupts have been masked with the state saved from SREG
+void crit_profile_enter (uint16_t site, uint8_t old_sreg);
+
+// Called just before the saved state is put back into SREG
+void crit_profile_exit (uint8_t old_sreg);
+
+// Copy the statistics out so they can be printed; returns the number of sites used
+uint8_t crit_profile_copy (crit_site_stats* p_sites, crit_site_stats* p_all,
+						   uint16_t* p_lost);
+
+// Clear all the statistics
+void crit_profile_reset (void);
+
+#ifdef __cplusplus
+}
+
+class emstream;
+
+// Print the worst critical sections in the program on a serial device
+void crit_profile_print (emstream* ser_dev);
+#endif
+
+#endif // CRITICAL_PROFILE
+
+#endif // _CRIT_PROFILE_H_
@@ -0,0 +1,106 @@
+//*************************************************************************************
+/** \file crit_profile_print.cpp
+ *    This file contains a function which prints the statistics kept by the critical
+ *    section profiler. It's in its own file, apart from the C code which does the
+ *    timing, because it uses the C++ serial stream classes.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifdef CRITICAL_PROFILE
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "emstream.h"                       // Base for text-type serial port objects
+#include "time_stamp.h"                     // For the hardware timer's tick rate
+#include "crit_profile.h"                   // Header for the profiler
+
+
+/** This is a copy of the profiler's table, made so the table can be printed without
+ *  keeping interrupts masked. It's static rather than on the stack because it's too
+ *  big for the stack of a typical user interface task.
+ */
+static crit_site_stats crit_copy[CRIT_PROFILE_SITES];
+
+
+//-------------------------------------------------------------------------------------
+/** This function converts a time in counts of the RTOS tick timer to microseconds.
+ *  @param counts The time in timer counts
+ *  @return The time in microseconds
+ */
+
+static uint32_t crit_counts_to_us (uint32_t counts)
+{
+	return (counts * 1000000UL / HW_TICK_RATE_HZ);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints the critical section statistics. The first line shows how
+ *  many sections have been timed, their mean and longest times, and where the longest
+ *  one began; then the call sites are listed, longest worst case first, in the same
+ *  sort of table as \c print_task_list() makes. The site addresses are byte addresses
+ *  in program memory, as they appear in the \c .lst file.
+ *  @param ser_dev The serial device on which to print the statistics
+ */
+
+void crit_profile_print (emstream* ser_dev)
+{
+	crit_site_stats all;
+	crit_site_stats temp;
+	uint16_t lost;
+	uint8_t used;
+
+	portENTER_CRITICAL ();
+	used = crit_profile_copy (crit_copy, &all, &lost);
+	portEXIT_CRITICAL ();
+
+	// Sort the sites which are in use so the longest worst case comes first
+	for (uint8_t index = 1; index < used; index++)
+	{
+		temp = crit_copy[index];
+		uint8_t place = index;
+		while (place > 0 && crit_copy[place - 1].max < temp.max)
+		{
+			crit_copy[place] = crit_copy[place - 1];
+			place--;
+		}
+		crit_copy[place] = temp;
+	}
+
+	*ser_dev << PMS ("Critical sections: ") << all.count << PMS (" timed, ")
+			 << lost << PMS (" lost, mean ");
+	if (all.count != 0)
+	{
+		*ser_dev << crit_counts_to_us (all.total / all.count);
+	}
+	else
+	{
+		*ser_dev << '-';
+	}
+	*ser_dev << PMS (" us, max ") << crit_counts_to_us (all.max) << PMS (" us at 0x")
+			 << hex << (all.site * 2UL) << dec << endl;
+
+	*ser_dev << PMS ("Site\t\tCount\tMean us\tMax us") << endl;
+	*ser_dev << PMS ("----\t\t-----\t-------\t------") << endl;
+	for (uint8_t index = 0; index < used; index++)
+	{
+		*ser_dev << PMS ("0x") << hex << (crit_copy[index].site * 2UL) << dec
+				 << PMS ("\t\t") << crit_copy[index].count << '\t'
+				 << crit_counts_to_us (crit_copy[index].total / crit_copy[index].count)
+				 << '\t' << crit_counts_to_us (crit_copy[index].max) << endl;
+	}
+}
+
+#endif // CRITICAL_PROFILE
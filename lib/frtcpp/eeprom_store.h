@@ -0,0 +1,472 @@
+//*************************************************************************************
+/** \file eeprom_store.h
+ *    This file contains a template class which keeps a structure full of settings in
+ *    EEPROM, with a copy in RAM from which the settings can be read quickly. Changes
+ *    are written to EEPROM some time after they're made, so that several changes in a
+ *    row cost only one write. They're written a byte at a time, so no task waits for 
+ *    the EEPROM, and each write goes to the next of several copies in EEPROM so that
+ *    the wear is spread out. Each copy has a sequence number and a CRC so that the 
+ *    newest good copy can be found when the power comes on, even if the power went 
+ *    off in the middle of a write. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _EEPROM_STORE_H_
+#define _EEPROM_STORE_H_
+
+#include <string.h>                         // For memcpy()
+#include <avr/eeprom.h>                     // AVR EEPROM read and write functions
+#include <avr/pgmspace.h>                   // For defaults kept in program memory
+#include <util/crc16.h>                     // Header for cyclic redundancy checks
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For xTaskGetTickCount()
+
+
+/** This is how long, in milliseconds, the settings must go unchanged before they're
+ *  written to EEPROM. Changes made closer together than this are written together.
+ */
+const uint16_t EESTORE_QUIET_MS = 2000;
+
+/** This sequence number is never used, because it's what blank EEPROM contains.
+ */
+const uint16_t EESTORE_BLANK = 0xFFFF;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class keeps a structure of settings in EEPROM, with a RAM copy for 
+ *  quick reading and wear levelling for writing.
+ *  \details The structure's type is given as \c data_type, and the number of copies 
+ *  kept in EEPROM as \c copies. Each copy is a \c page holding a sequence number, a 
+ *  CRC, and the data. When the program starts, \c load() finds the page with a good
+ *  CRC and the newest sequence number and copies its data into RAM; if there isn't a
+ *  good page, as when the EEPROM is blank, default values are used. 
+ *
+ *  Reading a setting just copies it from RAM inside a critical section, so it takes 
+ *  the same short time no matter how big the structure is. Changing a setting changes
+ *  the RAM copy and marks it as needing to be saved. Some task must call \c service()
+ *  now and then; once there have been no changes for \c EESTORE_QUIET_MS, it begins
+ *  writing the data into the page after the newest one, with the next sequence 
+ *  number. Each call writes at most one byte, and only if the EEPROM has finished the
+ *  previous one, so \c service() never waits the few milliseconds a byte takes. The
+ *  data is written first and the header last, so a write which is cut off by a power
+ *  failure leaves a page with a bad CRC and the previous page is used instead. 
+ *
+ *  \section Usage
+ *  \code
+ *  typedef struct { int16_t gain; int16_t limit; } my_settings;
+ *  const my_settings my_defaults PROGMEM = { 10, 45 };
+ *  eeprom_store<my_settings, 8>::page my_pages[8] EEMEM;
+ *  ...
+ *  eeprom_store<my_settings, 8>* p_store 
+ *      = new eeprom_store<my_settings, 8> (my_pages, &my_defaults);
+ *  p_store->load ();
+ *  ...
+ *  int16_t gain = p_store->get (&my_settings::gain);      // In any task
+ *  p_store->put (&my_settings::gain, (int16_t)12);        // Saved a bit later
+ *  ...
+ *  p_store->service ();                      // Called regularly by one task
+ *  \endcode
+ */
+
+template <class data_type, uint8_t copies> class eeprom_store
+{
+	public:
+		/// This is one copy of the data as it's kept in EEPROM.
+		typedef struct
+		{
+			uint16_t sequence;              ///< Higher numbers are newer copies
+			uint16_t crc;                   ///< CRC of the sequence number and data
+			data_type data;                 ///< The settings themselves
+		}
+		page;
+
+	protected:
+		/// This pointer holds the EEPROM address of the first page.
+		page* p_pages;
+
+		/// This pointer holds the program memory address of the default settings.
+		const data_type* p_defaults;
+
+		/// This is the RAM copy of the settings, from which all reading is done.
+		data_type cache;
+
+		/// This is the index of the newest good page in EEPROM.
+		uint8_t newest;
+
+		/// This is the sequence number of the newest good page in EEPROM.
+		uint16_t sequence;
+
+		/** This flag is set whenever the RAM copy is changed and cleared when a save
+		 *  begins, so a change made while a page is being written is seen.
+		 */
+		bool dirty;
+
+		/// This flag is set while a page is being written, a byte per \c service().
+		bool saving;
+
+		/// This is the index of the page being written.
+		uint8_t save_index;
+
+		/// This is the sequence number being given to the page being written.
+		uint16_t save_seq;
+
+		/// This is the number of bytes of the page being written which have been done.
+		size_t save_step;
+
+		/// This is the CRC of the page being written, found once its data is written.
+		uint16_t save_crc;
+
+		/// This is the time at which the RAM copy was last changed.
+		portTickType changed_ticks;
+
+		/// This counts the pages which have been written since the program started.
+		uint16_t writes;
+
+		// This method finds the CRC of a page in EEPROM
+		uint16_t page_crc (uint8_t);
+
+	public:
+		// The constructor saves the locations of the pages and the defaults
+		eeprom_store (page*, const data_type*);
+
+		// This method finds the newest good page and copies it into RAM
+		bool load (void);
+
+		// This method puts the default settings into the RAM copy
+		void set_defaults (void);
+
+		// This method writes a byte of the RAM copy to EEPROM if it's time to save it
+		bool service (uint16_t = EESTORE_QUIET_MS);
+
+		/** This method reads one item from the settings. The item is given as a 
+		 *  pointer to a member of the settings structure, as in \c &my_settings::gain.
+		 *  @param p_member A pointer to the member of \c data_type which is wanted
+		 *  @return A copy of the item from the RAM copy of the settings
+		 */
+		template <class item_type> item_type get (item_type data_type::* p_member)
+		{
+			item_type a_copy;
+
+			portENTER_CRITICAL ();
+			a_copy = cache.*p_member;
+			portEXIT_CRITICAL ();
+
+			return (a_copy);
+		}
+
+		/** This method changes one item in the settings. The change is made in RAM 
+		 *  right away and saved to EEPROM by \c service() later on. 
+		 *  @param p_member A pointer to the member of \c data_type to be changed
+		 *  @param value The new value for the item
+		 */
+		template <class item_type> void put (item_type data_type::* p_member, 
+											 item_type value)
+		{
+			portENTER_CRITICAL ();
+			cache.*p_member = value;
+			dirty = true;
+			changed_ticks = xTaskGetTickCount ();
+			portEXIT_CRITICAL ();
+		}
+
+		// This method copies bytes out of the settings, for items such as array parts
+		void read (size_t, void*, size_t);
+
+		// This method copies bytes into the settings
+		void write (size_t, const void*, size_t);
+
+		/** This method tells whether there are changes which haven't been saved yet.
+		 *  @return True if the RAM copy differs from the newest page in EEPROM
+		 */
+		bool is_dirty (void)
+		{
+			return (dirty || saving);
+		}
+
+		/** This method returns the sequence number of the newest page in EEPROM.
+		 *  @return The newest page's sequence number
+		 */
+		uint16_t get_sequence (void)
+		{
+			return (sequence);
+		}
+
+		/** This method returns the number of pages written since the program started.
+		 *  @return The number of EEPROM writes
+		 */
+		uint16_t get_writes (void)
+		{
+			return (writes);
+		}
+};
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor saves the EEPROM address of the pages and the program memory 
+ *  address of the defaults, and fills the RAM copy with the defaults. Call \c load()
+ *  to get saved settings from EEPROM.
+ *  @param p_eeprom_pages A pointer to an array of \c copies pages declared \c EEMEM
+ *  @param p_default_data A pointer to default settings declared \c PROGMEM
+ */
+
+template <class data_type, uint8_t copies>
+eeprom_store<data_type, copies>::eeprom_store (page* p_eeprom_pages, 
+											   const data_type* p_default_data)
+{
+	p_pages = p_eeprom_pages;
+	p_defaults = p_default_data;
+	newest = copies - 1;
+	sequence = 0;
+	changed_ticks = 0;
+	writes = 0;
+	saving = false;
+	save_index = 0;
+	save_seq = 0;
+	save_step = 0;
+	save_crc = 0;
+
+	set_defaults ();
+	dirty = false;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method computes the CRC of the sequence number and data in one page, reading
+ *  them straight from EEPROM a byte at a time so no RAM buffer is needed.
+ *  @param index The index of the page to check
+ *  @return The CRC of the page's sequence number and data
+ */
+
+template <class data_type, uint8_t copies>
+uint16_t eeprom_store<data_type, copies>::page_crc (uint8_t index)
+{
+	uint16_t crc = 0xFFFF;
+	const uint8_t* p_byte;
+
+	p_byte = (const uint8_t*)&(p_pages[index].sequence);
+	for (uint8_t byte_num = 0; byte_num < sizeof (uint16_t); byte_num++)
+	{
+		crc = _crc_ccitt_update (crc, eeprom_read_byte (p_byte++));
+	}
+	p_byte = (const uint8_t*)&(p_pages[index].data);
+	for (size_t byte_num = 0; byte_num < sizeof (data_type); byte_num++)
+	{
+		crc = _crc_ccitt_update (crc, eeprom_read_byte (p_byte++));
+	}
+
+	return (crc);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method looks through the pages in EEPROM for the newest one which has a good
+ *  CRC, and copies that page's data into RAM. Sequence numbers are compared in a way
+ *  which works when they wrap around from 0xFFFE to 0. 
+ *  @return True if a good page was found, false if the defaults are being used
+ */
+
+template <class data_type, uint8_t copies>
+bool eeprom_store<data_type, copies>::load (void)
+{
+	bool found = false;
+
+	for (uint8_t index = 0; index < copies; index++)
+	{
+		uint16_t page_seq = eeprom_read_word (&(p_pages[index].sequence));
+
+		if (page_seq == EESTORE_BLANK 
+			|| eeprom_read_word (&(p_pages[index].crc)) != page_crc (index))
+		{
+			continue;
+		}
+		if (!found || (int16_t)(page_seq - sequence) > 0)
+		{
+			found = true;
+			newest = index;
+			sequence = page_seq;
+		}
+	}
+
+	if (found)
+	{
+		data_type from_eeprom;
+		eeprom_read_block (&from_eeprom, &(p_pages[newest].data), sizeof (data_type));
+
+		portENTER_CRITICAL ();
+		memcpy (&cache, &from_eeprom, sizeof (data_type));
+		dirty = false;
+		saving = false;
+		portEXIT_CRITICAL ();
+	}
+
+	return (found);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts the default settings into the RAM copy. They'll be saved to 
+ *  EEPROM by \c service() like any other change. 
+ */
+
+template <class data_type, uint8_t copies>
+void eeprom_store<data_type, copies>::set_defaults (void)
+{
+	portENTER_CRITICAL ();
+	memcpy_P (&cache, p_defaults, sizeof (data_type));
+	dirty = true;
+	changed_ticks = xTaskGetTickCount ();
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method saves the RAM copy of the settings to EEPROM a byte at a time. Once 
+ *  the settings have changed and no more changes have been made for a while, a save
+ *  begins into the page after the newest one, so writes go around all the pages in 
+ *  turn. Each call then writes the next byte of the page, the data first and then the
+ *  sequence number and CRC, if the EEPROM has finished writing the previous byte; if 
+ *  it hasn't, the call returns right away, so the calling task never waits for the 
+ *  EEPROM. If the settings are changed before the page is done, the save is given up
+ *  without writing the CRC, so the half-changed page never looks good, and a new save
+ *  begins once the settings are quiet again. 
+ *  @param quiet_ms How long the settings must be unchanged before a save begins
+ *                  (default: \c EESTORE_QUIET_MS)
+ *  @return True if this call finished writing a page, false if not
+ */
+
+template <class data_type, uint8_t copies>
+bool eeprom_store<data_type, copies>::service (uint16_t quiet_ms)
+{
+	bool changed;
+	portTickType quiet_ticks;
+
+	portENTER_CRITICAL ();
+	changed = dirty;
+	quiet_ticks = xTaskGetTickCount () - changed_ticks;
+	portEXIT_CRITICAL ();
+
+	// A change made while a page is being written spoils that page
+	if (saving && changed)
+	{
+		saving = false;
+	}
+
+	if (!saving)
+	{
+		if (!changed || quiet_ticks < configMS_TO_TICKS ((portTickType)quiet_ms))
+		{
+			return (false);
+		}
+
+		portENTER_CRITICAL ();
+		dirty = false;
+		portEXIT_CRITICAL ();
+
+		saving = true;
+		save_index = (newest + 1) % copies;
+		save_seq = sequence + 1;
+		if (save_seq == EESTORE_BLANK)
+		{
+			save_seq = 0;
+		}
+		save_step = 0;
+	}
+
+	if (!eeprom_is_ready ())
+	{
+		return (false);
+	}
+
+	// Write the data and the sequence number; the CRC, written last, makes it good
+	if (save_step < sizeof (data_type))
+	{
+		uint8_t a_byte;
+
+		portENTER_CRITICAL ();
+		a_byte = ((uint8_t*)&cache)[save_step];
+		portEXIT_CRITICAL ();
+
+		eeprom_update_byte ((uint8_t*)&(p_pages[save_index].data) + save_step, a_byte);
+	}
+	else if (save_step < sizeof (data_type) + sizeof (uint16_t))
+	{
+		eeprom_update_byte ((uint8_t*)&(p_pages[save_index].sequence) 
+							+ (save_step - sizeof (data_type)), 
+							(uint8_t)(save_seq >> (8 * (save_step - sizeof (data_type)))));
+	}
+	else
+	{
+		size_t crc_byte = save_step - sizeof (data_type) - sizeof (uint16_t);
+		if (crc_byte == 0)
+		{
+			save_crc = page_crc (save_index);
+		}
+		eeprom_update_byte ((uint8_t*)&(p_pages[save_index].crc) + crc_byte, 
+							(uint8_t)(save_crc >> (8 * crc_byte)));
+	}
+
+	if (++save_step < sizeof (data_type) + 2 * sizeof (uint16_t))
+	{
+		return (false);
+	}
+
+	saving = false;
+	newest = save_index;
+	sequence = save_seq;
+	writes++;
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method copies bytes out of the RAM copy of the settings. It's used for items
+ *  which \c get() can't return, such as one element of an array. 
+ *  @param offset Where the bytes start in \c data_type, as found by \c offsetof()
+ *  @param p_dest A pointer to the place where the bytes are to be copied
+ *  @param size The number of bytes to copy
+ */
+
+template <class data_type, uint8_t copies>
+void eeprom_store<data_type, copies>::read (size_t offset, void* p_dest, size_t size)
+{
+	portENTER_CRITICAL ();
+	memcpy (p_dest, (uint8_t*)&cache + offset, size);
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method copies bytes into the RAM copy of the settings; they'll be saved to 
+ *  EEPROM later by \c service(). 
+ *  @param offset Where the bytes start in \c data_type, as found by \c offsetof()
+ *  @param p_src A pointer to the bytes which are to be copied
+ *  @param size The number of bytes to copy
+ */
+
+template <class data_type, uint8_t copies>
+void eeprom_store<data_type, copies>::write (size_t offset, const void* p_src, 
+											 size_t size)
+{
+	portENTER_CRITICAL ();
+	memcpy ((uint8_t*)&cache + offset, p_src, size);
+	dirty = true;
+	changed_ticks = xTaskGetTickCount ();
+	portEXIT_CRITICAL ();
+}
+
+#endif // _EEPROM_STORE_H_
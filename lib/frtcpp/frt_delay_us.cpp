@@ -0,0 +1,319 @@
+//*************************************************************************************
+/** \file frt_delay_us.cpp
+ *    This file contains functions which put a task to sleep for a time measured in
+ *    microseconds. Sleeping tasks are kept in a list sorted by the time at which they
+ *    are to wake up. The tick timer's second compare channel is set to the time of
+ *    the first one in the list; its interrupt wakes that task up and sets the channel
+ *    for the next. The hardware timer counts at 2 MHz, so a task can sleep for a time
+ *    measured to half a microsecond, though waking it takes a few more.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>                         // Port I/O for SFR's
+#include <avr/interrupt.h>                  // For using interrupt service routines
+#include <util/delay.h>                     // For waiting before the RTOS has started
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // The FreeRTOS task functions header
+#include "frt_delay_us.h"                   // Header for this file
+
+#if (configUSE_SUBTICK_TIMER != 1)
+	#error frt_delay_us.cpp needs configUSE_SUBTICK_TIMER set to 1 in FreeRTOSConfig.h
+#endif
+
+
+/** This structure holds one sleeping task in the list of tasks waiting to wake up.
+ *  It's kept on the sleeping task's stack, so the list needs no memory of its own.
+ */
+typedef struct us_waiter
+{
+	time_stamp wake_time;                   ///< When the task is to be woken up
+	xTaskHandle task;                       ///< The task which is sleeping
+	struct us_waiter* p_next;               ///< The task to wake up after this one
+}
+us_waiter;
+
+/// The first task in the list of sleeping tasks, the one which will wake up soonest.
+static us_waiter* p_first_waiter = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This function reads the time from the tick timer. It must be called with
+ *  interrupts disabled. If the hardware timer has just cleared itself at the end of
+ *  a tick but the tick interrupt hasn't run yet, the tick count is one behind; that
+ *  is noticed and fixed, so the time never appears to go backwards.
+ *  @param now A time stamp into which the time is put
+ */
+
+static void read_time (time_stamp& now)
+{
+	HW_CTR_TYPE count = portSUBTICK_TCNT;
+	portTickType ticks = xTaskGetTickCountFromISR ();
+
+	if ((portSUBTICK_TIFR & (1 << portTICK_OCF)) && count < TMR_MAX_CT / 2)
+	{
+		ticks++;
+	}
+	now = time_stamp (ticks, count);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function reads the time from the tick timer from a task, with interrupts
+ *  enabled.
+ *  @param now A time stamp into which the time is put
+ */
+
+static void time_now (time_stamp& now)
+{
+	portENTER_CRITICAL ();
+	read_time (now);
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function checks whether the first task in the list should already have been
+ *  woken up. It must be called with interrupts disabled.
+ *  @return True if there's a sleeping task whose time has come
+ */
+
+static bool first_is_due (void)
+{
+	time_stamp now;
+
+	if (p_first_waiter == NULL)
+	{
+		return (false);
+	}
+	read_time (now);
+	return (p_first_waiter->wake_time <= now);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function sets the compare channel to interrupt when the hardware count
+ *  reaches that of the first sleeping task's wakeup time. The interrupt happens at
+ *  that count during every tick until the right tick comes. If no task is sleeping,
+ *  the interrupt is turned off. It must be called with interrupts disabled.
+ */
+
+static void set_compare (void)
+{
+	if (p_first_waiter == NULL)
+	{
+		portSUBTICK_TIMSK &= ~(1 << portSUBTICK_OCIE);
+		return;
+	}
+	portSUBTICK_OCR = p_first_waiter->wake_time.get_hardware_count ();
+	portSUBTICK_TIFR = (1 << portSUBTICK_OCF);
+	portSUBTICK_TIMSK |= (1 << portSUBTICK_OCIE);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called by the compare channel's interrupt, which is in port.c.
+ *  It wakes up every task whose time has come and sets the compare channel for the
+ *  next one. If a wakeup time passes while this is being done, that task is woken
+ *  too, rather than a whole tick later.
+ *  @return \c pdTRUE if a task was woken which should run instead of the one which
+ *          was interrupted
+ */
+
+extern "C" portBASE_TYPE xPortSubTickMatch (void)
+{
+	portBASE_TYPE woke = pdFALSE;
+
+	do
+	{
+		while (first_is_due ())
+		{
+			us_waiter* p_due = p_first_waiter;
+			p_first_waiter = p_due->p_next;
+			if (xTaskResumeFromISR (p_due->task) != pdFALSE)
+			{
+				woke = pdTRUE;
+			}
+		}
+		set_compare ();
+	}
+	while (first_is_due ());
+
+	return (woke);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function makes a time stamp holding a duration given in microseconds, so it
+ *  can be added to the time now to find when something is to happen.
+ *  @param microseconds The duration in microseconds, up to about 35 minutes
+ *  @return A time stamp holding the duration
+ */
+
+time_stamp us_to_time_stamp (uint32_t microseconds)
+{
+	uint32_t counts;
+
+	// The compiler picks one of these; the first is much quicker on an AVR
+	if (HW_TICK_RATE_HZ % 1000000UL == 0)
+	{
+		counts = microseconds * (HW_TICK_RATE_HZ / 1000000UL);
+	}
+	else
+	{
+		counts = (uint32_t)(((uint64_t)microseconds * HW_TICK_RATE_HZ) / 1000000UL);
+	}
+
+	// Short delays, the usual case, don't need the slow long division
+	if (counts < TMR_MAX_CT)
+	{
+		return (time_stamp (0, counts));
+	}
+	return (time_stamp (counts / TMR_MAX_CT, counts % TMR_MAX_CT));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function puts the calling task to sleep until the given time. Whole ticks
+ *  are slept with \c vTaskDelay() as usual; the last part of a tick is slept in the
+ *  list of tasks which the compare channel wakes up. If the time is very soon, or
+ *  the scheduler has been suspended, the task watches the timer instead of sleeping.
+ *  This function can't be used before the scheduler has been started, as the timer
+ *  isn't running yet.
+ *  @param wake_time The time at which the task is to wake up
+ */
+
+void frt_delay_until_us (time_stamp& wake_time)
+{
+	time_stamp now;
+	us_waiter waiter;
+
+	// Sleep through the whole ticks first, waking up in the tick before the one in
+	// which the wakeup time falls
+	time_now (now);
+	if (wake_time.get_RTOS_ticks () > now.get_RTOS_ticks () + 1
+		&& xTaskGetSchedulerState () == taskSCHEDULER_RUNNING)
+	{
+		vTaskDelay (wake_time.get_RTOS_ticks () - now.get_RTOS_ticks () - 1);
+	}
+
+	portENTER_CRITICAL ();
+	read_time (now);
+
+	// If it's very soon, putting the task to sleep would take too long
+	if (wake_time <= now + us_to_time_stamp (DELAY_US_SPIN)
+		|| xTaskGetSchedulerState () != taskSCHEDULER_RUNNING)
+	{
+		while (now < wake_time)
+		{
+			portEXIT_CRITICAL ();
+			portENTER_CRITICAL ();
+			read_time (now);
+		}
+		portEXIT_CRITICAL ();
+		return;
+	}
+
+	// Put this task into the list, in order of wakeup time
+	waiter.wake_time = wake_time;
+	waiter.task = xTaskGetCurrentTaskHandle ();
+	us_waiter** pp_link = &p_first_waiter;
+	while (*pp_link != NULL && (*pp_link)->wake_time <= wake_time)
+	{
+		pp_link = &((*pp_link)->p_next);
+	}
+	waiter.p_next = *pp_link;
+	*pp_link = &waiter;
+	if (p_first_waiter == &waiter)
+	{
+		set_compare ();
+	}
+
+	// Interrupts stay off until this task has been switched out, so the interrupt
+	// can't try to wake it up before it's asleep. Each task keeps its own interrupt
+	// flag, so they come back on as soon as the next task runs
+	vTaskSuspend (NULL);
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function puts the calling task to sleep for a number of microseconds. Other
+ *  tasks run while it sleeps. Delays shorter than \c DELAY_US_SPIN are done by
+ *  watching the timer. Before the scheduler has started, as in \c main(), there's
+ *  nothing else to run, so the processor just counts the time away.
+ *  @param microseconds The time to sleep in microseconds, up to about 35 minutes
+ */
+
+void frt_delay_us (uint32_t microseconds)
+{
+	if (xTaskGetSchedulerState () == taskSCHEDULER_NOT_STARTED)
+	{
+		while (microseconds--)
+		{
+			_delay_us (1);
+		}
+		return;
+	}
+
+	time_stamp wake_time = us_to_time_stamp (microseconds);
+	time_stamp now;
+
+	time_now (now);
+	wake_time += now;
+	frt_delay_until_us (wake_time);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor starts a timeout which runs out after the given time.
+ *  @param microseconds The time from now until the timeout runs out
+ */
+
+frt_timeout::frt_timeout (uint32_t microseconds)
+{
+	restart (microseconds);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method starts the timeout again, so that it runs out after the given time
+ *  from now.
+ *  @param microseconds The time from now until the timeout runs out
+ */
+
+void frt_timeout::restart (uint32_t microseconds)
+{
+	time_stamp now;
+
+	deadline = us_to_time_stamp (microseconds);
+	time_now (now);
+	deadline += now;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the timeout has run out.
+ *  @return True if the time given when the timeout was started has passed
+ */
+
+bool frt_timeout::expired (void)
+{
+	time_stamp now;
+
+	time_now (now);
+	return (deadline <= now);
+}
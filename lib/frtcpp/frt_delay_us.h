@@ -0,0 +1,95 @@
+//*************************************************************************************
+/** \file frt_delay_us.h
+ *    This file contains functions which put a task to sleep for a time measured in
+ *    microseconds rather than RTOS ticks. The task is woken up by the second compare
+ *    channel of the tick timer, so other tasks run while it sleeps, even when the
+ *    sleep is much shorter than a tick.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _FRT_DELAY_US_H_
+#define _FRT_DELAY_US_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "emstream.h"                       // Time stamps can be printed to serial devices
+#include "time_stamp.h"                     // Times with sub-tick resolution
+
+
+/** Delays shorter than this many microseconds are done by watching the timer rather
+ *  than sleeping, as putting a task to sleep and waking it up again takes about as
+ *  long as this.
+ */
+#define DELAY_US_SPIN			40
+
+
+// Make a time stamp which holds a duration given in microseconds
+time_stamp us_to_time_stamp (uint32_t);
+
+// Put the calling task to sleep for a number of microseconds
+void frt_delay_us (uint32_t);
+
+// Put the calling task to sleep until a given time
+void frt_delay_until_us (time_stamp&);
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class is a deadline a number of microseconds in the future, for code
+ *  which waits for something to happen but mustn't wait forever.
+ *  \details A driver which polls hardware can check \c expired() each time around
+ *  its loop, sleeping briefly between checks so that other tasks can run:
+ *  \code
+ *  frt_timeout timeout (500);              // Give the sensor half a millisecond
+ *  while (!(PINE & (1 << PE6)))
+ *  {
+ *      if (timeout.expired ())
+ *      {
+ *          return (false);
+ *      }
+ *      frt_delay_us (50);
+ *  }
+ *  \endcode
+ */
+
+class frt_timeout
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The time at which the timeout runs out.
+		time_stamp deadline;
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor starts a timeout which runs out after the given time
+		frt_timeout (uint32_t);
+
+		// Start the timeout again, to run out after the given time from now
+		void restart (uint32_t);
+
+		// Check whether the timeout has run out
+		bool expired (void);
+
+		/** This method puts the calling task to sleep until the timeout runs out. It
+		 *  returns at once if it already has.
+		 */
+		void sleep (void)
+		{
+			frt_delay_until_us (deadline);
+		}
+};
+
+#endif  // _FRT_DELAY_US_H_
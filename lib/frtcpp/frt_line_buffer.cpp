@@ -0,0 +1,121 @@
+//*************************************************************************************
+/** \file frt_line_buffer.cpp
+ *    This file contains the methods of a class which saves what a task prints until
+ *    a line is finished, then sends the whole line to the console at once.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "frt_line_buffer.h"                // Header for this file
+
+
+// These are shared by all the line buffers
+xSemaphoreHandle frt_line_buffer::line_mutex = NULL;
+bool frt_line_buffer::console_running = false;
+uint16_t frt_line_buffer::lines_dropped = 0;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a line buffer. The first line buffer made also makes the 
+ *  mutex which all of them share, so line buffers should be made in \c main() before
+ *  the scheduler starts. 
+ *  @param p_console_queue The text queue which is emptied to the console by the user 
+ *                         interface task. It should hold at least one full line
+ *  @param p_ser_dev The serial device to which lines are written directly until the
+ *                   console task starts emptying the queue
+ *  @param a_size The number of characters in the line buffer (default 
+ *                \c LINE_BUFFER_SIZE); a longer line is sent in pieces this long
+ */
+
+frt_line_buffer::frt_line_buffer (frt_text_queue* p_console_queue, emstream* p_ser_dev,
+								  uint8_t a_size)
+{
+	p_queue = p_console_queue;
+	p_device = p_ser_dev;
+	size = a_size;
+	fill = 0;
+	buffer = new char[a_size];
+
+	if (line_mutex == NULL)
+	{
+		line_mutex = xSemaphoreCreateMutex ();
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method saves a character in the buffer. If the character ends a line or 
+ *  fills the buffer, the line is sent to the console. 
+ *  @param a_char The character to be printed
+ *  @return True if the character was saved, false if there's no buffer
+ */
+
+bool frt_line_buffer::putchar (char a_char)
+{
+	if (buffer == NULL)
+	{
+		return (false);
+	}
+
+	buffer[fill++] = a_char;
+	if (a_char == '\n' || fill >= size)
+	{
+		transmit_now ();
+	}
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends the characters in the buffer to the console as one line. Once
+ *  the console is running, the line is copied into the print queue if there's room 
+ *  for all of it; if there isn't, the line is dropped rather than making the task 
+ *  wait for the serial port to catch up. Before the console is running, the line is
+ *  written straight to the serial device. 
+ */
+
+void frt_line_buffer::transmit_now (void)
+{
+	if (fill == 0)
+	{
+		return;
+	}
+
+	if (!console_running)
+	{
+		for (uint8_t index = 0; index < fill; index++)
+		{
+			p_device->putchar (buffer[index]);
+		}
+	}
+	else if (xSemaphoreTake (line_mutex, portMAX_DELAY) == pdTRUE)
+	{
+		// Only the console takes characters out of the queue, so the room found
+		// here can only grow until the mutex is given back
+		if (p_queue->room () >= fill)
+		{
+			for (uint8_t index = 0; index < fill; index++)
+			{
+				p_queue->putchar (buffer[index]);
+			}
+		}
+		else
+		{
+			lines_dropped++;
+		}
+		xSemaphoreGive (line_mutex);
+	}
+	fill = 0;
+}
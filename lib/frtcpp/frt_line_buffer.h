@@ -0,0 +1,118 @@
+//*************************************************************************************
+/** \file frt_line_buffer.h
+ *    This file contains a class which lets a task print to the console a whole line 
+ *    at a time. Each task which prints gets its own small line buffer; characters
+ *    are saved there until the end of a line, and then the whole line is copied into
+ *    the print queue, which the user interface task empties to the serial port. Lines
+ *    from different tasks never get mixed together, and a task which prints never 
+ *    waits for the slow serial port; if the print queue hasn't room for a line, the 
+ *    line is dropped and counted.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _FRT_LINE_BUFFER_H_
+#define _FRT_LINE_BUFFER_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "semphr.h"                         // Header for FreeRTOS mutexes
+#include "emstream.h"                       // Pull in the base class header file
+#include "frt_text_queue.h"                 // Queue which carries lines to the console
+
+
+/// This is the number of characters a line buffer holds if no size is given.
+#define LINE_BUFFER_SIZE		32
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class is a serial device which saves what's printed to it until a line
+ *  is finished, then sends the whole line to the console through a text queue.
+ *  \details A line is finished when a newline is printed, when the buffer fills up, 
+ *  or when \c send_now is printed. The buffer is copied into the queue while holding
+ *  a mutex which all the line buffers share, so the characters of one line always 
+ *  arrive at the console together. The mutex is held only while characters are 
+ *  copied into the queue, never while they're sent out the serial port. 
+ *
+ *  Before the task which empties the queue has started, nothing would take lines 
+ *  out of the queue, so lines are written straight to the serial device instead. 
+ *  The console task calls \c start_console() when it begins emptying the queue. 
+ *  \code
+ *  frt_text_queue* print_ser_queue = new frt_text_queue (64, &ser_port, 10, "Print");
+ *  new task_P ("P1", task_priority (1), 240, 
+ *              new frt_line_buffer (print_ser_queue, &ser_port), p_motor);
+ *  \endcode
+ */
+
+class frt_line_buffer : public emstream
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The queue through which finished lines are sent to the console.
+		frt_text_queue* p_queue;
+
+		/// The serial device to which lines are written before the console starts.
+		emstream* p_device;
+
+		/// The characters of the line being printed.
+		char* buffer;
+
+		/// The number of characters the buffer can hold.
+		uint8_t size;
+
+		/// The number of characters now in the buffer.
+		uint8_t fill;
+
+		/// The mutex which keeps lines from different tasks from being mixed up.
+		static xSemaphoreHandle line_mutex;
+
+		/// This flag is set once the console task has started emptying the queue.
+		static bool console_running;
+
+		/// The number of lines which were dropped because the queue was too full.
+		static uint16_t lines_dropped;
+
+	// Public methods can be called from anywhere in the program where there is a 
+	// pointer or reference to an object of this class
+	public:
+		// The constructor makes a line buffer which sends lines to the given queue
+		frt_line_buffer (frt_text_queue*, emstream*, uint8_t = LINE_BUFFER_SIZE);
+
+		// Save a character in the buffer, sending the line if it's finished
+		bool putchar (char);
+
+		// Send whatever is in the buffer as a line right away
+		void transmit_now (void);
+
+		/** This method is called by the task which empties the print queue when it
+		 *  starts doing so. From then on, line buffers send their lines through the 
+		 *  queue rather than writing them straight to the serial device. 
+		 */
+		static void start_console (void)
+		{
+			console_running = true;
+		}
+
+		/** This method returns the number of lines which have been dropped by all the
+		 *  line buffers because the print queue hadn't room for them.
+		 *  @return The number of dropped lines
+		 */
+		static uint16_t get_lines_dropped (void)
+		{
+			return (lines_dropped);
+		}
+};
+
+#endif  // _FRT_LINE_BUFFER_H_
@@ -31,6 +31,7 @@
 #include "queue.h"                          // Header for FreeRTOS queues
 #include "emstream.h"                       // Header for streams using "<<" to print
 #include "frt_base_queue.h"                 // Pull in the base class header file
+#include "frt_queue_stats.h"                // Statistics on how full the queue gets
 
 
 //-------------------------------------------------------------------------------------
@@ -124,12 +125,17 @@ class frt_queue : public frt_base_queue<data_type>
 	protected:
 		xQueueHandle handle;                 ///< The handle for the queue we use
 		portTickType ticks_to_wait;          ///< RTOS ticks to wait for empty queue
+		frt_queue_stats stats;               ///< How full the queue has been, etc.
+
+		// Send an item to the back or front of the queue and count it in the stats
+		bool send (const data_type&, portBASE_TYPE);
 
 	// Public methods can be called from anywhere in the program where there is a 
 	// pointer or reference to an object of this class
 	public:
 		// The constructor creates a FreeRTOS queue
-		frt_queue (uint8_t, emstream* = NULL, portTickType = portMAX_DELAY);
+		frt_queue (uint8_t, emstream* = NULL, portTickType = portMAX_DELAY,
+				   const char* = NULL);
 
 		/** This method puts an item of data into the back of the queue, which is the 
 		 *  normal way to put something into a queue. If you want to be rude and put 
@@ -140,7 +146,7 @@ class frt_queue : public frt_base_queue<data_type>
 		 */
 		bool put (const data_type& item)
 		{
-			return ((bool)(xQueueSendToBack (handle, &item, ticks_to_wait)));
+			return (send (item, queueSEND_TO_BACK));
 		}
 
 		/*  This method puts an item of data into the back of the queue from within an
@@ -162,7 +168,7 @@ class frt_queue : public frt_base_queue<data_type>
 		 */
 		bool butt_in (const data_type& item)
 		{
-			return ((bool)(xQueueSendToFront (handle, &item, ticks_to_wait)));
+			return (send (item, queueSEND_TO_FRONT));
 		}
 
 		/*  This method puts an item into the front of the queue from within an ISR.
@@ -244,6 +250,15 @@ class frt_queue : public frt_base_queue<data_type>
 		{
 			return (handle);
 		}
+
+		/** This method gives access to the statistics which show how full the queue
+		 *  has been and how many puts have had to wait or have given up.
+		 *  @return A reference to the queue's statistics
+		 */
+		frt_queue_stats& get_stats (void)
+		{
+			return (stats);
+		}
 }; // class frt_queue 
 
 
@@ -256,15 +271,18 @@ class frt_queue : public frt_base_queue<data_type>
  *                   which causes a send to block until sending occurs)
  *  @param p_ser_dev Pointer to a serial device to be used for debugging printouts
  *                   (Default: NULL)
+ *  @param a_name A name under which the queue's statistics are printed by 
+ *                \c print_queue_list() (Default: NULL, for no name)
  */
 
 template <class data_type>
 frt_queue<data_type>::frt_queue (uint8_t queue_size, emstream* p_ser_dev,
-								portTickType wait_time)
-	: frt_base_queue<data_type> (p_ser_dev)
+								portTickType wait_time, const char* a_name)
+	: frt_base_queue<data_type> (p_ser_dev), stats (a_name, queue_size)
 {
 	// Create a FreeRTOS queue object with space for the data items
 	handle = xQueueCreate (queue_size, sizeof (data_type));
+	stats.set_handle (handle);
 
 	// Store the wait time; it will be used when writing to the queue
 	ticks_to_wait = wait_time;
@@ -278,6 +296,38 @@ frt_queue<data_type>::frt_queue (uint8_t queue_size, emstream* p_ser_dev,
 }
 
 
+//-------------------------------------------------------------------------------------
+/** This method sends an item to the queue for \c put() and \c butt_in(). It first 
+ *  tries without waiting, so that it can tell whether the queue was full; only if it
+ *  was does it wait up to the queue's wait time for space. Either way, the put is 
+ *  counted in the queue's statistics. 
+ *  @param item Reference to the item which is going to be put into the queue
+ *  @param position Where the item goes, \c queueSEND_TO_BACK or \c queueSEND_TO_FRONT
+ *  @return True if the item was successfully queued, false if not
+ */
+
+template <class data_type>
+bool frt_queue<data_type>::send (const data_type& item, portBASE_TYPE position)
+{
+	bool was_full = false;                  // Whether the item had to wait for space
+	bool got_in;                            // Whether the item made it into the queue
+
+	got_in = (bool)(xQueueGenericSend (handle, &item, 0, position));
+	if (!got_in)
+	{
+		was_full = true;
+		if (ticks_to_wait != 0)
+		{
+			got_in = (bool)(xQueueGenericSend (handle, &item, ticks_to_wait, 
+											   position));
+		}
+	}
+	stats.put_done (handle, was_full, got_in);
+
+	return (got_in);
+}
+
+
 //-------------------------------------------------------------------------------------
 /** This method puts an item of data into the back of the queue from within an
  *  interrupt service routine. It must \b not be used within non-ISR code. 
@@ -295,6 +345,7 @@ inline bool frt_queue<data_type>::ISR_put (const data_type& item)
 
 	// Call the FreeRTOS function and save its return value
 	return_value = (bool)(xQueueSendToBackFromISR (handle, &item, &shouldSwitch));
+	stats.ISR_put_done (handle, !return_value, return_value);
 
 	// If the queue said that putting something into it has un-blocked a higher
 	// priority task than the one currently running, ask for a context switch
@@ -328,6 +379,7 @@ bool frt_queue<data_type>::ISR_butt_in (const data_type& item)
 
 	// Call the FreeRTOS function and save its return value
 	return_value = (bool)(xQueueSendToFrontFromISR (handle, &item, &shouldSwitch));
+	stats.ISR_put_done (handle, !return_value, return_value);
 
 	// If the queue said that putting something into it has un-blocked a higher
 	// priority task than the one currently running, ask for a context switch
@@ -0,0 +1,250 @@
+//*************************************************************************************
+/** \file frt_queue_stats.cpp
+ *    This file contains the methods of a class which keeps statistics about how a
+ *    queue is used, and a function which prints the statistics of all the queues.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For strlen()
+
+#include "frt_queue_stats.h"                // Header for this file
+
+
+// This is the pointer to the statistics of the most recently created queue
+frt_queue_stats* last_created_queue_pointer = NULL;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets all the counts to zero and puts the statistics at the head
+ *  of the list of queues, so that \c print_queue_list() will find them.
+ *  @param a_name A name to print for the queue, or NULL for no name. The string is
+ *                not copied, so it must stay around as long as the queue does
+ *  @param a_size The number of items which the queue can hold
+ */
+
+frt_queue_stats::frt_queue_stats (const char* a_name, uint16_t a_size)
+{
+	name = a_name;
+	size = a_size;
+	queue = NULL;
+	peak = 0;
+	blocked = 0;
+	timeouts = 0;
+	total = 0;
+
+	prev_queue_pointer = last_created_queue_pointer;
+	last_created_queue_pointer = this;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method updates the counts after a put. It must be called from a critical
+ *  section or an ISR so that two puts can't update the counts at the same time.
+ *  @param handle The handle of the FreeRTOS queue, used to find how full it is
+ *  @param was_full True if the queue was full when the put began
+ *  @param got_in True if the item was put into the queue, false if it was lost
+ */
+
+void frt_queue_stats::count (xQueueHandle handle, bool was_full, bool got_in)
+{
+	if (was_full && blocked < 0xFFFF)
+	{
+		blocked++;
+	}
+	if (!got_in)
+	{
+		if (timeouts < 0xFFFF)
+		{
+			timeouts++;
+		}
+		return;
+	}
+
+	total++;
+	uint16_t depth = uxQueueMessagesWaitingFromISR (handle);
+	if (depth > peak)
+	{
+		peak = depth;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method records a put which was made from a task.
+ *  @param handle The handle of the FreeRTOS queue, used to find how full it is
+ *  @param was_full True if the queue was full when the put began
+ *  @param got_in True if the item was put into the queue, false if it was lost
+ */
+
+void frt_queue_stats::put_done (xQueueHandle handle, bool was_full, bool got_in)
+{
+	portENTER_CRITICAL ();
+	count (handle, was_full, got_in);
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method records a put which was made from within an interrupt service
+ *  routine. It must \b not be called from normal, non-ISR code.
+ *  @param handle The handle of the FreeRTOS queue, used to find how full it is
+ *  @param was_full True if the queue was full when the put began
+ *  @param got_in True if the item was put into the queue, false if it was lost
+ */
+
+void frt_queue_stats::ISR_put_done (xQueueHandle handle, bool was_full, bool got_in)
+{
+	count (handle, was_full, got_in);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints one line showing this queue's statistics, then asks the queue
+ *  which was created before this one to do the same.
+ *  @param ser_dev The serial device on which to print
+ */
+
+void frt_queue_stats::print_in_list (emstream* ser_dev)
+{
+	uint16_t a_peak, a_blocked, a_timeouts;
+	uint32_t a_total;
+
+	// Copy the counts all at once so the line shows one consistent set of them
+	portENTER_CRITICAL ();
+	a_peak = peak;
+	a_blocked = blocked;
+	a_timeouts = timeouts;
+	a_total = total;
+	portEXIT_CRITICAL ();
+
+	if (name != NULL)
+	{
+		*ser_dev << name;
+		ser_dev->putchar ('\t');
+		if (strlen (name) < 8)
+		{
+			ser_dev->putchar ('\t');
+		}
+	}
+	else
+	{
+		*ser_dev << PMS ("-\t\t");
+	}
+	*ser_dev << size << '\t' << a_peak << '\t' << a_total << '\t' << a_blocked
+			 << '\t' << a_timeouts << endl;
+
+	if (prev_queue_pointer != NULL)
+	{
+		prev_queue_pointer->print_in_list (ser_dev);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints a table of the statistics for every queue, in the same style
+ *  as the task table printed by \c print_task_list(). For each queue it shows the
+ *  size, the most items ever in it at once, the number of items put into it, the
+ *  number of puts which found it full, and the number of puts which gave up waiting
+ *  and lost their items.
+ *  @param ser_dev The serial device on which to print the table
+ */
+
+void print_queue_list (emstream* ser_dev)
+{
+	*ser_dev << PMS ("Queue\t\tSize\tPeak\tPuts\tBlocked\tTimeouts") << endl;
+	*ser_dev << PMS ("-----\t\t----\t----\t----\t-------\t--------") << endl;
+
+	if (last_created_queue_pointer != NULL)
+	{
+		last_created_queue_pointer->print_in_list (ser_dev);
+	}
+}
+
+
+// These are the columns of the queue table on the dashboard
+#define DASH_COL_SIZE			17          // Number of items the queue holds
+#define DASH_COL_NOW			23          // Number of items in the queue now
+#define DASH_COL_PEAK			29          // Most items ever in the queue
+#define DASH_COL_LOST			35          // Puts which gave up and lost their items
+
+
+//-------------------------------------------------------------------------------------
+/** This method shows one row of the queue table on a dashboard for this queue and
+ *  one for each queue which was created before it. The list is walked in a loop, so
+ *  the stack needed doesn't grow with the number of queues.
+ *  @param p_dash The dashboard on which the table is shown
+ *  @param row The screen row for this queue
+ *  @return The first screen row below the rows of this queue and those before it
+ */
+
+uint8_t frt_queue_stats::dashboard_in_list (ansi_dashboard* p_dash, uint8_t row)
+{
+	uint16_t a_peak, a_timeouts;
+
+	for (frt_queue_stats* p_stats = this; p_stats != NULL; 
+		 p_stats = p_stats->prev_queue_pointer)
+	{
+		portENTER_CRITICAL ();
+		a_peak = p_stats->peak;
+		a_timeouts = p_stats->timeouts;
+		portEXIT_CRITICAL ();
+
+		if (p_stats->name != NULL)
+		{
+			p_dash->label (row, 1, p_stats->name);
+		}
+		else
+		{
+			p_dash->label_P (row, 1, PSTR ("-"));
+		}
+		p_dash->show (row, DASH_COL_SIZE, 5, p_stats->size);
+		if (p_stats->queue != NULL)
+		{
+			p_dash->show (row, DASH_COL_NOW, 5, 
+						  uxQueueMessagesWaiting (p_stats->queue));
+		}
+		p_dash->show (row, DASH_COL_PEAK, 5, a_peak);
+		p_dash->show (row, DASH_COL_LOST, 5, a_timeouts);
+		row++;
+	}
+	return (row);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function shows a table of all the queues on a dashboard: each one's size, how
+ *  many items are in it now, the most which have been in it at once, and how many
+ *  items were lost because it stayed full. It's called each time the dashboard is
+ *  painted; after the first time, only the numbers which changed are printed.
+ *  @param p_dash The dashboard on which the table is shown
+ *  @param top_row The screen row for the table's headings
+ *  @return The first screen row below the table
+ */
+
+uint8_t dashboard_queue_list (ansi_dashboard* p_dash, uint8_t top_row)
+{
+	p_dash->label_P (top_row, 1, PSTR ("Queue"));
+	p_dash->label_P (top_row, DASH_COL_SIZE, PSTR (" Size"));
+	p_dash->label_P (top_row, DASH_COL_NOW, PSTR ("  Now"));
+	p_dash->label_P (top_row, DASH_COL_PEAK, PSTR (" Peak"));
+	p_dash->label_P (top_row, DASH_COL_LOST, PSTR (" Lost"));
+
+	if (last_created_queue_pointer == NULL)
+	{
+		return (top_row + 1);
+	}
+	return (last_created_queue_pointer->dashboard_in_list (p_dash, top_row + 1));
+}
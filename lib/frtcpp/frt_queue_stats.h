@@ -0,0 +1,162 @@
+//*************************************************************************************
+/** \file frt_queue_stats.h
+ *    This file contains a class which keeps statistics about how a queue is used:
+ *    how full it has ever been, how many items have been put into it, how many puts
+ *    found it full and had to wait, and how many gave up waiting. The queue classes
+ *    \c frt_queue and \c frt_text_queue each keep one of these, and all of them can
+ *    be printed in a table with \c print_queue_list() so that queue sizes can be set
+ *    from measurements rather than guesswork.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _FRT_QUEUE_STATS_H_
+#define _FRT_QUEUE_STATS_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "queue.h"                          // Header for FreeRTOS queues
+#include "emstream.h"                       // Header for streams using "<<" to print
+#include "ansi_dashboard.h"                 // Live display of the queues' numbers
+
+
+/* As with tasks, the statistics for all the queues are kept in a linked list which
+ * begins with the most recently created one, so that they can all be printed.
+ */
+class frt_queue_stats;
+
+// This is the pointer to the last created set of queue statistics
+extern frt_queue_stats* last_created_queue_pointer;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class holds the usage statistics for one queue.
+ *  \details A queue class calls \c put_done() after each put from a task and
+ *  \c ISR_put_done() after each put from an interrupt service routine, telling it
+ *  whether the queue was full when the put began and whether the item got in. The
+ *  statistics are only ever counted upwards; they stop at their largest values
+ *  rather than wrapping around.
+ */
+
+class frt_queue_stats
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The name printed for the queue, or NULL if it hasn't been given a name.
+		const char* name;
+
+		/// The number of items the queue can hold.
+		uint16_t size;
+
+		/// The handle of the FreeRTOS queue, used to find how full it is now.
+		xQueueHandle queue;
+
+		/// The largest number of items which have been in the queue at once.
+		uint16_t peak;
+
+		/// The number of puts which found the queue full and had to wait or give up.
+		uint16_t blocked;
+
+		/// The number of puts which gave up because the queue stayed full.
+		uint16_t timeouts;
+
+		/// The total number of items which have been put into the queue.
+		uint32_t total;
+
+		/// The statistics for the queue which was created before this one.
+		frt_queue_stats* prev_queue_pointer;
+
+		// Update the counts after an item has been put or failed to be put
+		void count (xQueueHandle, bool, bool);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor sets the counts to zero and adds the queue to the list
+		frt_queue_stats (const char*, uint16_t);
+
+		// Record a put from a task
+		void put_done (xQueueHandle, bool, bool);
+
+		// Record a put from an interrupt service routine
+		void ISR_put_done (xQueueHandle, bool, bool);
+
+		// Print this queue's statistics and then those of the queues before it
+		void print_in_list (emstream*);
+
+		// Show the numbers of this queue and the queues before it on a dashboard
+		uint8_t dashboard_in_list (ansi_dashboard*, uint8_t);
+
+		/** This method tells the statistics which FreeRTOS queue they belong to, so
+		 *  that the number of items in it now can be shown. The queue classes call
+		 *  it from their constructors.
+		 *  @param handle The handle of the FreeRTOS queue
+		 */
+		void set_handle (xQueueHandle handle)
+		{
+			queue = handle;
+		}
+
+		/** This method returns the number of items the queue can hold.
+		 *  @return The size of the queue
+		 */
+		uint16_t get_size (void)
+		{
+			return (size);
+		}
+
+		/** This method returns the largest number of items which have been in the
+		 *  queue at once.
+		 *  @return The queue's high-water mark
+		 */
+		uint16_t get_peak (void)
+		{
+			return (peak);
+		}
+
+		/** This method returns the number of puts which found the queue full.
+		 *  @return The number of puts which had to wait for space
+		 */
+		uint16_t get_blocked (void)
+		{
+			return (blocked);
+		}
+
+		/** This method returns the number of puts which gave up waiting for space,
+		 *  so that their items were lost.
+		 *  @return The number of puts which timed out
+		 */
+		uint16_t get_timeouts (void)
+		{
+			return (timeouts);
+		}
+
+		/** This method returns the number of items which have been put into the
+		 *  queue since it was created.
+		 *  @return The number of items put into the queue
+		 */
+		uint32_t get_total (void)
+		{
+			return (total);
+		}
+};
+
+// Print the statistics for all the queues in a table
+void print_queue_list (emstream*);
+
+// Show a table of the queues on a dashboard, updating only what changed
+uint8_t dashboard_queue_list (ansi_dashboard*, uint8_t);
+
+#endif  // _FRT_QUEUE_STATS_H_
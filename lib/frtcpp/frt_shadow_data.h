@@ -0,0 +1,189 @@
+//*************************************************************************************
+/** \file frt_shadow_data.h
+ *    This file contains a template class for settings which one task changes and 
+ *    another task uses in a control loop. New settings are kept in a shadow copy 
+ *    until the control task is ready for them at the start of its next period, when 
+ *    the whole set is swapped in at once. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _FRT_SHADOW_DATA_H_
+#define _FRT_SHADOW_DATA_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class holds a set of settings which can be changed by one task while
+ *  another task is using them, without the user ever seeing a half-changed set.
+ *  \details A task such as the user interface calls \c stage() with a complete new 
+ *  set of settings; the set is copied into a shadow copy. The control task calls 
+ *  \c apply() at the start of each of its periods. If a new set is waiting, 
+ *  \c apply() copies it into the active copy inside a critical section and records 
+ *  the number of the period in which it took effect, which the staging task can read
+ *  with \c get_applied_period() as an acknowledgement. Between calls to \c apply(),
+ *  the control task reads the active copy with \c active(), which needs no critical 
+ *  section because only the control task ever touches the active copy. If several 
+ *  sets are staged before the control task gets to them, only the last one is used.
+ *
+ *  \section Usage
+ *  \code
+ *  shadow_data<my_gains>* p_gains = new shadow_data<my_gains> (starting_gains);
+ *  ...
+ *  p_gains->stage (new_gains);               // In the user interface task
+ *  ...
+ *  for (;;)                                  // In the control task
+ *  {
+ *      if (p_gains->apply (period)) { ... }  // Start of each control period
+ *      power = error * p_gains->active ().kp;
+ *      ...
+ *      period++;
+ *  }
+ *  \endcode
+ */
+
+template <class data_type> class shadow_data
+{
+	protected:
+		data_type active_copy;              ///< The settings the control task is using
+		data_type shadow_copy;              ///< New settings waiting to be applied
+		bool pending;                       ///< True if the shadow copy is waiting
+		uint32_t applied_period;            ///< Period in which the last set took effect
+		uint16_t staged_count;              ///< How many sets have been staged
+		uint16_t applied_count;             ///< How many sets have been applied
+
+	public:
+		/** This constructor sets up a shadowed data item with its first settings, 
+		 *  which are active right away.
+		 *  @param initial The settings to use until others are staged and applied
+		 */
+		shadow_data<data_type> (const data_type& initial)
+		{
+			active_copy = initial;
+			shadow_copy = initial;
+			pending = false;
+			applied_period = 0;
+			staged_count = 0;
+			applied_count = 0;
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method puts a whole new set of settings into the shadow copy, where it
+		 *  waits for the control task to apply it. It must not be called from an ISR.
+		 *  @param new_data The new settings
+		 */
+		void stage (const data_type& new_data)
+		{
+			portENTER_CRITICAL ();
+			shadow_copy = new_data;
+			pending = true;
+			staged_count++;
+			portEXIT_CRITICAL ();
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method is called by the control task at the start of each period. If
+		 *  new settings have been staged, they become the active settings.
+		 *  @param period The number of the control period which is starting
+		 *  @return True if new settings were applied, false if nothing changed
+		 */
+		bool apply (uint32_t period)
+		{
+			// Checking the flag outside the critical section is safe, as the worst 
+			// that can happen is that a set staged right now waits one more period
+			if (!pending)
+			{
+				return (false);
+			}
+			portENTER_CRITICAL ();
+			active_copy = shadow_copy;
+			pending = false;
+			applied_period = period;
+			applied_count++;
+			portEXIT_CRITICAL ();
+
+			return (true);
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method gives the control task the settings it's using. It must only 
+		 *  be called by the task which calls \c apply().
+		 *  @return A reference to the active settings
+		 */
+		const data_type& active (void)
+		{
+			return (active_copy);
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method tells whether staged settings are still waiting to be applied.
+		 *  @return True if a staged set hasn't been applied yet
+		 */
+		bool is_pending (void)
+		{
+			return (pending);
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method returns the number of the control period in which the latest 
+		 *  set of settings took effect. 
+		 *  @return The period number given to \c apply() when the settings were swapped
+		 */
+		uint32_t get_applied_period (void)
+		{
+			uint32_t a_copy;
+
+			portENTER_CRITICAL ();
+			a_copy = applied_period;
+			portEXIT_CRITICAL ();
+
+			return (a_copy);
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method returns how many sets of settings have been applied. If it's
+		 *  less than the number staged, some sets were replaced before being used.
+		 *  @return The number of sets which have been swapped in
+		 */
+		uint16_t get_applied_count (void)
+		{
+			uint16_t a_copy;
+
+			portENTER_CRITICAL ();
+			a_copy = applied_count;
+			portEXIT_CRITICAL ();
+
+			return (a_copy);
+		}
+
+		//-----------------------------------------------------------------------------
+		/** This method returns how many sets of settings have been staged.
+		 *  @return The number of calls to \c stage()
+		 */
+		uint16_t get_staged_count (void)
+		{
+			uint16_t a_copy;
+
+			portENTER_CRITICAL ();
+			a_copy = staged_count;
+			portEXIT_CRITICAL ();
+
+			return (a_copy);
+		}
+}; // class shadow_data<data_type>
+
+#endif  // _FRT_SHADOW_DATA_H_
@@ -225,6 +225,14 @@ frt_task::frt_task (const char* a_name,
 	// Initialize the run counter
 	runs = 0;
 
+	// If task timing is being measured, nothing has been measured yet
+	#ifdef TASK_PROFILE
+		has_woken = false;
+		max_busy_us = 0;
+		min_period_us = SCHED_UNBOUNDED;
+		deadline_us = 0;
+	#endif
+
 	// If the serial port is being used, let the user know if the task was created
 	// successfully
 	if (p_serial != NULL)
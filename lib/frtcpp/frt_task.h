@@ -45,6 +45,11 @@
 #include "mechutil.h"                        // Utility functions for the ME405 code
 #include "emstream.h"                        // Pull in the base class header file
 #include "time_stamp.h"                      // Header for timekeeping class
+#include "ansi_dashboard.h"                  // Live display of the tasks' numbers
+#include "frt_delay_us.h"                    // Sleeping for less than an RTOS tick
+#ifdef TASK_PROFILE
+	#include "sched_analysis.h"               // Response time analysis of the tasks
+#endif
 
 
 /* The forward declaration is needed so we can make last_created_task_pointer usable
@@ -276,6 +281,43 @@ class frt_task
 			return (runs);
 		}
 
+		#ifdef TASK_PROFILE
+			/// This is the time at which the task last woke up from a delay.
+			time_stamp woke_at;
+
+			/// This flag is set once the task has woken up for the first time.
+			bool has_woken;
+
+			/** This is the longest time, in microseconds, which the task has spent
+			 *  between waking up and asking to sleep again. It includes any time 
+			 *  taken by other tasks and interrupts meanwhile, so it's an upper bound
+			 *  on the task's own worst-case execution time.
+			 */
+			uint32_t max_busy_us;
+
+			/// This is the shortest time in microseconds between two wakeups.
+			uint32_t min_period_us;
+
+			/// This is the task's deadline in microseconds, or 0 if it's the period.
+			uint32_t deadline_us;
+
+			// Note that the task is about to sleep, measuring how long it was busy
+			void profile_sleep (void);
+
+			// Note that the task has just woken up, measuring the time between wakeups
+			void profile_wake (void);
+		#else
+			/** This method does nothing unless \c TASK_PROFILE is defined, in which
+			 *  case it notes that the task is about to sleep.
+			 */
+			void profile_sleep (void) { }
+
+			/** This method does nothing unless \c TASK_PROFILE is defined, in which
+			 *  case it notes that the task has just woken up.
+			 */
+			void profile_wake (void) { }
+		#endif
+
 	// Public methods can be called from anywhere in the program where there is a 
 	// pointer or reference to an object of this class
 	public:
@@ -392,7 +434,9 @@ class frt_task
 		 */
 		void delay (portTickType duration)
 		{
+			profile_sleep ();
 			vTaskDelay (duration);
+			profile_wake ();
 		}
 
 		/** This method causes the task to delay for the given number of milliseconds.
@@ -410,7 +454,23 @@ class frt_task
 		void delay_ms (portTickType milliseconds)
 		{
 			portTickType duration = configMS_TO_TICKS (milliseconds);
+			profile_sleep ();
 			vTaskDelay (duration);
+			profile_wake ();
+		}
+
+		/** This method causes the task to delay for the given number of 
+		 *  microseconds. Unlike \c delay_ms(), the time isn't rounded to a whole
+		 *  number of RTOS ticks; the task is woken up between ticks by the tick
+		 *  timer's second compare channel, and other tasks run while it sleeps. 
+		 *  Very short delays are done by watching the timer; see \c frt_delay_us().
+		 *  @param microseconds The number of microseconds to delay
+		 */
+		void delay_us (uint32_t microseconds)
+		{
+			profile_sleep ();
+			frt_delay_us (microseconds);
+			profile_wake ();
 		}
 
 		/** This method causes the task to delay from a given time for a specified 
@@ -436,7 +496,9 @@ class frt_task
 		 */
 		void delay_from_to (portTickType& from_ticks, portTickType interval)
 		{
+			profile_sleep ();
 			vTaskDelayUntil (&from_ticks, interval);
+			profile_wake ();
 		}
 
 		/** This method causes the task to delay from a given time for a specified 
@@ -465,7 +527,9 @@ class frt_task
 		void delay_from_to_ms (portTickType& from_ticks, portTickType milliseconds)
 		{
 			portTickType interval = configMS_TO_TICKS (milliseconds);
+			profile_sleep ();
 			vTaskDelayUntil (&from_ticks, interval);
+			profile_wake ();
 		}
 
 		/** This method returns the number of RTOS ticks until the time the method
@@ -485,6 +549,93 @@ class frt_task
 			taskYIELD ();
 		}
 
+		#if (configUSE_TASK_NOTIFICATIONS == 1)
+			/** This method sends this task a notification. The task's notification
+			 *  word is changed as \c action says, and if the task is waiting in 
+			 *  \c wait_for_notify() or \c take_notify(), it wakes up. This is much
+			 *  quicker than giving a semaphore or putting an item in a queue, and
+			 *  it needs no RAM beyond a few bytes which each task already has. It's
+			 *  called by other tasks; interrupts use \c notify_from_ISR().
+			 *  @param value The bits to set or the value to put in the word
+			 *  @param action \c eSetBits, \c eIncrement, \c eSetValueWithOverwrite,
+			 *                \c eSetValueWithoutOverwrite, or \c eNoAction
+			 *  @return False if the value wasn't put in the word because the task
+			 *          hadn't yet received the one before; true otherwise
+			 */
+			bool notify (uint32_t value, eNotifyAction action = eSetBits)
+			{
+				return (xTaskNotify (handle, value, action) == pdPASS);
+			}
+
+			/** This method adds one to this task's notification word, waking the 
+			 *  task if it's waiting. Used with \c take_notify(), the word works as
+			 *  a counting or binary semaphore which only this task can take.
+			 */
+			void notify_give (void)
+			{
+				xTaskNotifyGive (handle);
+			}
+
+			/** This method sends this task a notification from within an interrupt
+			 *  service routine. 
+			 *  @param value The bits to set or the value to put in the word
+			 *  @param action What to do with the value, as for \c notify()
+			 *  @param p_woken Set to \c pdTRUE if a task of higher priority than
+			 *                 the one interrupted was woken, so the ISR should switch
+			 *                 tasks; it may be \c NULL
+			 *  @return False if the value wasn't put in the word because the task
+			 *          hadn't yet received the one before; true otherwise
+			 */
+			bool notify_from_ISR (uint32_t value, eNotifyAction action = eSetBits,
+								  signed portBASE_TYPE* p_woken = NULL)
+			{
+				return (xTaskNotifyFromISR (handle, value, action, p_woken) == pdPASS);
+			}
+
+			/** This method makes the task wait until it's notified or the time runs
+			 *  out. It must only be called by this task itself, usually in \c run().
+			 *  If a notification came while the task was busy, it returns at once.
+			 *  @param value A variable into which the notification word is put
+			 *  @param ticks The longest time to wait in RTOS ticks; by default the
+			 *               task waits as long as it takes
+			 *  @param clear_on_exit Bits cleared in the word after it has been read;
+			 *                       by default, all of them
+			 *  @return True if the task was notified, false if the time ran out
+			 */
+			bool wait_for_notify (uint32_t& value, portTickType ticks = portMAX_DELAY,
+								  uint32_t clear_on_exit = 0xFFFFFFFFUL)
+			{
+				unsigned long word;
+				portBASE_TYPE got_it;
+
+				profile_sleep ();
+				got_it = xTaskNotifyWait (0UL, clear_on_exit, &word, ticks);
+				profile_wake ();
+				value = word;
+				return (got_it == pdTRUE);
+			}
+
+			/** This method waits until the notification word isn't zero, as when
+			 *  taking a semaphore which was given with \c notify_give(). It must
+			 *  only be called by this task itself.
+			 *  @param ticks The longest time to wait in RTOS ticks; by default the
+			 *               task waits as long as it takes
+			 *  @param clear True to clear the word, as a binary semaphore does, or
+			 *               false to take one from it, as a counting semaphore does
+			 *  @return The word before it was cleared or taken from; zero if the
+			 *          time ran out
+			 */
+			uint32_t take_notify (portTickType ticks = portMAX_DELAY, bool clear = true)
+			{
+				uint32_t count;
+
+				profile_sleep ();
+				count = ulTaskNotifyTake (clear ? pdTRUE : pdFALSE, ticks);
+				profile_wake ();
+				return (count);
+			}
+		#endif
+
 		/** This method returns the task's current priority.
 		 *  @return The priority at which the task is currently running
 		 */
@@ -571,6 +722,27 @@ class frt_task
 		// list to do so
 		void print_status_in_list (emstream*);
 
+		// This method shows the numbers of this task and the tasks made before it on 
+		// a dashboard, one row each
+		uint8_t dashboard_in_list (ansi_dashboard*, uint8_t);
+
+		#ifdef TASK_PROFILE
+			/** This method sets the task's deadline, the longest time it may take from
+			 *  waking up until it asks to sleep again. It's only used for deadline-
+			 *  monotonic analysis; the deadline of a task which hasn't been given one
+			 *  is its period. 
+			 *  @param milliseconds The deadline in milliseconds, or 0 for the period
+			 */
+			void set_deadline_ms (uint16_t milliseconds)
+			{
+				deadline_us = (uint32_t)milliseconds * 1000UL;
+			}
+
+			// This method puts this task's timing in a table for the schedule check,
+			// then asks the next task in the list to do so
+			void schedule_in_list (sched_task*, uint8_t&);
+		#endif
+
 		/** This method returns a pointer to the most recently created task. This 
 		 *  pointer is the head of a linked list of tasks; the list is maintained by
 		 *  the task objects themselves. This pointer to the most recently created
@@ -615,4 +787,18 @@ void print_task_list (emstream* ser_dev);
 // This function has all the tasks print their stacks
 void print_task_stacks (emstream* ser_dev);
 
+// This function shows a table of the tasks on a dashboard, updating only what changed
+uint8_t dashboard_task_list (ansi_dashboard* p_dash, uint8_t top_row);
+
+#if (configUSE_TASK_NOTIFICATIONS == 1)
+	// This function times task notifications against a semaphore and a queue
+	void notify_benchmark (emstream* ser_dev, uint16_t rounds);
+#endif
+
+#ifdef TASK_PROFILE
+	// This function checks whether the tasks can meet their deadlines and prints
+	// the priorities which rate- or deadline-monotonic scheduling would give them
+	void print_schedule (emstream* ser_dev);
+#endif
+
 #endif  // _FRT_TASK_H_
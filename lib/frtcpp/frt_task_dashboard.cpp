@@ -0,0 +1,95 @@
+//*************************************************************************************
+/** \file frt_task_dashboard.cpp
+ *    This file contains functions which show the tasks' priorities, states, free stack
+ *    space and loop counts on a live dashboard, printing only the numbers which have
+ *    changed since the dashboard was last painted.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "frt_task.h"                       // Pull in the base class header file
+
+
+// These are the columns of the task table on the dashboard
+#define DASH_COL_PRI			17          // Priority
+#define DASH_COL_STATE			22          // State of the task's state machine
+#define DASH_COL_STACK			28          // Free stack space
+#define DASH_COL_RUNS			35          // Times through the task loop
+
+
+//-------------------------------------------------------------------------------------
+/** This method shows one row of the task table on a dashboard for this task and one
+ *  for each task which was created before it. The list is walked in a loop, not by 
+ *  each task calling the one before it, so the user interface task's stack doesn't
+ *  have to grow with the number of tasks. A task's name is only printed when the 
+ *  whole dashboard is drawn.
+ *  @param p_dash The dashboard on which the table is shown
+ *  @param row The screen row for this task
+ *  @return The first screen row below the rows of this task and those before it
+ */
+
+uint8_t frt_task::dashboard_in_list (ansi_dashboard* p_dash, uint8_t row)
+{
+	for (frt_task* p_task = this; p_task != NULL; p_task = p_task->prev_task_pointer)
+	{
+		p_dash->label (row, 1, p_task->get_name ());
+		p_dash->show (row, DASH_COL_PRI, 4, uxTaskPriorityGet (p_task->handle));
+		p_dash->show (row, DASH_COL_STATE, 5, p_task->state);
+		#if (INCLUDE_uxTaskGetStackHighWaterMark == 1)
+			p_dash->show (row, DASH_COL_STACK, 6, 
+						  uxTaskGetStackHighWaterMark (p_task->handle));
+		#endif
+		p_dash->show (row, DASH_COL_RUNS, 10, p_task->runs);
+		row++;
+	}
+	return (row);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function shows a table of all the tasks on a dashboard, with the same columns
+ *  as the table printed by \c print_task_list(). It's called each time the dashboard
+ *  is painted; after the first time, only the numbers which changed are printed.
+ *  @param p_dash The dashboard on which the table is shown
+ *  @param top_row The screen row for the table's headings
+ *  @return The first screen row below the table
+ */
+
+uint8_t dashboard_task_list (ansi_dashboard* p_dash, uint8_t top_row)
+{
+	uint8_t row = top_row + 1;
+
+	p_dash->label_P (top_row, 1, PSTR ("Task"));
+	p_dash->label_P (top_row, DASH_COL_PRI, PSTR ("Pri."));
+	p_dash->label_P (top_row, DASH_COL_STATE, PSTR ("State"));
+	#if (INCLUDE_uxTaskGetStackHighWaterMark == 1)
+		p_dash->label_P (top_row, DASH_COL_STACK, PSTR (" Stack"));
+	#endif
+	p_dash->label_P (top_row, DASH_COL_RUNS, PSTR ("      Runs"));
+
+	if (last_created_task_pointer != NULL)
+	{
+		row = last_created_task_pointer->dashboard_in_list (p_dash, row);
+	}
+
+	// The idle task isn't in the list, but its stack is worth watching too
+	p_dash->label_P (row, 1, PSTR ("IDLE"));
+	#if (INCLUDE_uxTaskGetStackHighWaterMark == 1)
+		p_dash->show (row, DASH_COL_STACK, 6, 
+					  uxTaskGetStackHighWaterMark (xTaskGetIdleTaskHandle ()));
+	#endif
+
+	return (row + 1);
+}
@@ -0,0 +1,155 @@
+//*************************************************************************************
+/** \file frt_task_notify_bench.cpp
+ *    This file contains a function which measures how long it takes to signal a task
+ *    with a task notification, with a binary semaphore, and with a queue, and how
+ *    much RAM each way needs, so the three can be compared on the real hardware.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // The FreeRTOS task functions header
+#include "queue.h"                          // For the queue which is timed
+#include "semphr.h"                         // For the semaphore which is timed
+#include "frt_task.h"                       // Pull in the base class header file
+
+#if (configUSE_TASK_NOTIFICATIONS == 1)
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds the whole length of a time stamp in microseconds. The time
+ *  stamp's \c get_microsec() gives only the part after the whole seconds, and a long
+ *  run of the benchmark can take more than a second.
+ *  @param duration The time stamp holding the time taken
+ *  @return The time taken in microseconds
+ */
+
+static uint32_t bench_total_us (time_stamp& duration)
+{
+	return (duration.get_seconds () * 1000000UL + duration.get_microsec ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints one line of the benchmark's results: the time taken for each
+ *  signal, to a tenth of a microsecond, and the RAM used.
+ *  @param ser_dev The serial device on which to print
+ *  @param p_name The name of the way of signalling, as made with \c PSTR()
+ *  @param total_us The time taken for all the rounds in microseconds
+ *  @param rounds The number of signals which were sent and received
+ *  @param bytes The number of bytes of RAM used
+ */
+
+static void bench_print_row (emstream* ser_dev, const char* p_name, uint32_t total_us,
+							 uint16_t rounds, size_t bytes)
+{
+	uint32_t tenths = total_us * 10UL / rounds;
+
+	*ser_dev << _p_str << p_name << tenths / 10 << '.' << tenths % 10
+			 << PMS (" us\t") << bytes << PMS (" bytes") << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function times the three ways of signalling a task. The calling task signals
+ *  itself and then takes the signal, as many times as asked, using its notification
+ *  word, a binary semaphore, and a queue holding one number. As the signal is always
+ *  there to be taken, no task switches are timed, only the work done by the RTOS,
+ *  which is where the three ways differ. The semaphore and queue are made the first
+ *  time the benchmark is run and kept for later runs, as they can't be freed; the
+ *  RAM each took from the heap is measured then. A notification needs no RAM of its
+ *  own, only the few bytes which are in every task's control block.
+ *  @param ser_dev The serial device on which to print the results
+ *  @param rounds The number of signals to send and take with each way
+ */
+
+void notify_benchmark (emstream* ser_dev, uint16_t rounds)
+{
+	static xSemaphoreHandle semaphore = NULL;
+	static xQueueHandle queue = NULL;
+	static size_t semaphore_bytes;
+	static size_t queue_bytes;
+
+	if (semaphore == NULL)
+	{
+		size_t heap_before = xPortGetFreeHeapSize ();
+		vSemaphoreCreateBinary (semaphore);
+		semaphore_bytes = heap_before - xPortGetFreeHeapSize ();
+
+		heap_before = xPortGetFreeHeapSize ();
+		queue = xQueueCreate (1, sizeof (uint32_t));
+		queue_bytes = heap_before - xPortGetFreeHeapSize ();
+	}
+	if (semaphore == NULL || queue == NULL || rounds == 0)
+	{
+		*ser_dev << PMS ("Can't run the benchmark") << endl;
+		return;
+	}
+
+	// A new binary semaphore has already been given, so take it to start empty
+	xSemaphoreTake (semaphore, 0);
+
+	xTaskHandle self = xTaskGetCurrentTaskHandle ();
+	uint32_t item = 0;
+	time_stamp start;
+	time_stamp notify_time, semaphore_time, queue_time;
+
+	start.set_to_now ();
+	for (uint16_t count = 0; count < rounds; count++)
+	{
+		xTaskNotifyGive (self);
+		ulTaskNotifyTake (pdTRUE, 0);
+	}
+	notify_time.set_to_now ();
+	notify_time -= start;
+
+	start.set_to_now ();
+	for (uint16_t count = 0; count < rounds; count++)
+	{
+		xSemaphoreGive (semaphore);
+		xSemaphoreTake (semaphore, 0);
+	}
+	semaphore_time.set_to_now ();
+	semaphore_time -= start;
+
+	start.set_to_now ();
+	for (uint16_t count = 0; count < rounds; count++)
+	{
+		xQueueSendToBack (queue, &item, 0);
+		xQueueReceive (queue, &item, 0);
+	}
+	queue_time.set_to_now ();
+	queue_time -= start;
+
+	uint32_t notify_us = bench_total_us (notify_time);
+	uint32_t semaphore_us = bench_total_us (semaphore_time);
+
+	*ser_dev << PMS ("Signal and take, ") << rounds << PMS (" rounds each:") << endl;
+	bench_print_row (ser_dev, PSTR ("Notification\t"), notify_us, rounds,
+					 sizeof (unsigned long) + sizeof (unsigned char));
+	bench_print_row (ser_dev, PSTR ("Semaphore\t"), semaphore_us, rounds,
+					 semaphore_bytes);
+	bench_print_row (ser_dev, PSTR ("Queue\t\t"), bench_total_us (queue_time), rounds,
+					 queue_bytes);
+
+	if (notify_us != 0)
+	{
+		uint32_t tenths = semaphore_us * 10UL / notify_us;
+		*ser_dev << PMS ("Notifications are ") << tenths / 10 << '.' << tenths % 10
+				 << PMS (" times as fast as the semaphore") << endl;
+	}
+}
+
+#endif // configUSE_TASK_NOTIFICATIONS
@@ -0,0 +1,235 @@
+//*************************************************************************************
+/** \file frt_task_schedule.cpp
+ *    This file contains methods which measure how long each task is busy each time
+ *    it wakes up and how often it wakes up, and a function which uses those times to
+ *    check whether the tasks can meet their deadlines. It's only compiled into the 
+ *    program if \c TASK_PROFILE is defined in the Makefile.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifdef TASK_PROFILE
+
+#include <string.h>                         // For strlen()
+
+#include "frt_task.h"                       // Pull in the base class header file
+#include "sched_analysis.h"                 // Response time analysis of the tasks
+#ifdef ISR_PROFILE
+	#include "isr_profile.h"                // For the tick interrupt's run time
+#endif
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds the time between two time stamps in microseconds. Times of
+ *  more than an hour or so are cut off at about an hour so they don't overflow.
+ *  @param p_earlier A pointer to the earlier time stamp
+ *  @param p_later A pointer to the later time stamp
+ *  @return The number of microseconds from the earlier to the later time
+ */
+
+static uint32_t stamp_diff_us (time_stamp* p_earlier, time_stamp* p_later)
+{
+	time_stamp diff = *p_later - *p_earlier;
+	uint32_t seconds = diff.get_seconds ();
+
+	if (seconds > 4000)
+	{
+		seconds = 4000;
+	}
+	return (seconds * 1000000UL + diff.get_microsec ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called just before the task goes to sleep in one of the delay
+ *  methods. It saves the time since the task woke up if that's the longest yet.
+ */
+
+void frt_task::profile_sleep (void)
+{
+	time_stamp now;
+
+	if (has_woken)
+	{
+		now.set_to_now ();
+		uint32_t busy = stamp_diff_us (&woke_at, &now);
+		if (busy > max_busy_us)
+		{
+			max_busy_us = busy;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called just after the task wakes up in one of the delay methods.
+ *  It saves the time since the task last woke up if that's the shortest yet. A task
+ *  which sleeps by waiting for something other than a delay, such as a character 
+ *  from a serial port, can call \c profile_sleep() and \c profile_wake() around the 
+ *  wait so that its timing is measured too.
+ */
+
+void frt_task::profile_wake (void)
+{
+	time_stamp now;
+
+	now.set_to_now ();
+	if (has_woken)
+	{
+		uint32_t period = stamp_diff_us (&woke_at, &now);
+		if (period < min_period_us)
+		{
+			min_period_us = period;
+		}
+	}
+	woke_at = now;
+	has_woken = true;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method fills in the next row of a table of task timings with this task's
+ *  name, priority, measured timing and deadline, then asks the task which was 
+ *  created before this one to do the same. Tasks which don't fit in the table are 
+ *  left out. A task which hasn't yet woken up twice gets a period of zero, which 
+ *  the analysis takes to mean the task hasn't been measured.
+ *  @param p_tasks A pointer to the table
+ *  @param count The number of rows filled in so far, which is increased by one
+ */
+
+void frt_task::schedule_in_list (sched_task* p_tasks, uint8_t& count)
+{
+	if (count < SCHED_MAX_TASKS)
+	{
+		sched_task* p_row = p_tasks + count++;
+
+		p_row->name = get_name ();
+		p_row->priority = uxTaskPriorityGet (handle);
+		portENTER_CRITICAL ();
+		p_row->period = (min_period_us == SCHED_UNBOUNDED) ? 0 : min_period_us;
+		p_row->wcet = max_busy_us;
+		p_row->deadline = deadline_us;
+		portEXIT_CRITICAL ();
+	}
+
+	if (prev_task_pointer != NULL)
+	{
+		prev_task_pointer->schedule_in_list (p_tasks, count);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints a time in microseconds in a table column. Zero means that 
+ *  nothing was measured and is shown as a dash; \c SCHED_UNBOUNDED means a missed 
+ *  deadline.
+ *  @param ser_dev The serial device on which to print
+ *  @param time The time to print in microseconds
+ */
+
+static void print_sched_time (emstream* ser_dev, uint32_t time)
+{
+	ser_dev->putchar ('\t');
+	if (time == SCHED_UNBOUNDED)
+	{
+		*ser_dev << PMS ("miss");
+	}
+	else if (time == 0)
+	{
+		ser_dev->putchar ('-');
+	}
+	else
+	{
+		*ser_dev << time;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function checks whether the tasks can always meet their deadlines, first at 
+ *  the priorities they have now and then at deadline-monotonic priorities, which are
+ *  the same as rate-monotonic priorities for tasks which haven't been given their 
+ *  own deadlines. It prints a table with each task's measured period and execution
+ *  time, its deadline, and its worst-case response time at each set of priorities. 
+ *  The periods and execution times come from the delay methods, so they're only 
+ *  right for tasks which sleep in those methods once per run. The first four columns
+ *  can be copied into a file for the PC program \c tools/sched_check.cpp in order to
+ *  try other deadlines or priority schemes. If \c ISR_PROFILE is also defined, the 
+ *  tick interrupt's longest run time is counted as well.
+ *  @param ser_dev Pointer to a serial device on which the table will be printed
+ */
+
+void print_schedule (emstream* ser_dev)
+{
+	static sched_task tasks[SCHED_MAX_TASKS];
+	static uint32_t responses_now[SCHED_MAX_TASKS];
+	uint8_t count = 0;
+	uint32_t tick_us = 0;
+
+	if (last_created_task_pointer != NULL)
+	{
+		last_created_task_pointer->schedule_in_list (tasks, count);
+	}
+
+	#ifdef ISR_PROFILE
+		isr_prof_stats tick_stats;
+		portENTER_CRITICAL ();
+		isr_profile_copy (ISR_PROF_TICK, &tick_stats);
+		portEXIT_CRITICAL ();
+		tick_us = (uint32_t)tick_stats.max_run * 1000000UL / HW_TICK_RATE_HZ;
+	#endif
+
+	// Check the priorities in use now, then find and check the recommended ones
+	for (uint8_t index = 0; index < count; index++)
+	{
+		tasks[index].new_priority = tasks[index].priority;
+	}
+	bool ok_now = sched_find_responses (tasks, count, tick_us);
+	for (uint8_t index = 0; index < count; index++)
+	{
+		responses_now[index] = tasks[index].response;
+	}
+	sched_assign_priorities (tasks, count, true, configMAX_PRIORITIES - 1);
+	bool ok_new = sched_find_responses (tasks, count, tick_us);
+
+	*ser_dev << PMS ("Task\t\tPeriod\tWCET\tDeadln\tPri.\tResp.\tNew Pri\tResp.") 
+			 << endl;
+	*ser_dev << PMS ("----\t\t------\t----\t------\t----\t-----\t-------\t-----") 
+			 << endl;
+	for (uint8_t index = 0; index < count; index++)
+	{
+		sched_task* p_task = tasks + index;
+
+		*ser_dev << p_task->name;
+		ser_dev->putchar ('\t');
+		if (strlen (p_task->name) < 8)
+		{
+			ser_dev->putchar ('\t');
+		}
+		*ser_dev << p_task->period << '\t' << p_task->wcet << '\t'
+				 << sched_deadline (p_task) << '\t' << p_task->priority;
+		print_sched_time (ser_dev, responses_now[index]);
+		*ser_dev << '\t' << p_task->new_priority;
+		print_sched_time (ser_dev, p_task->response);
+		*ser_dev << endl;
+	}
+
+	uint16_t used = sched_utilisation (tasks, count, tick_us);
+	*ser_dev << PMS ("Times in us; tick ISR ") << tick_us << PMS (" us. Utilisation ") 
+			 << used / 10 << '.' << used % 10 << PMS ("%. Deadlines met now: ")
+			 << ok_now << PMS (", with new priorities: ") << ok_new << endl;
+}
+
+#endif // TASK_PROFILE
@@ -38,16 +38,20 @@
  *                     portMAX_DELAY causes a send to block indefinitely
  *  @param p_ser_dev A pointer which points to a serial device which can be used for
  *                   diagnostic logging or printing
+ *  @param a_name A name under which the queue's statistics are printed by 
+ *                \c print_queue_list() (Default: NULL, for no name)
  */
 
 frt_text_queue::frt_text_queue (uint16_t queue_size, emstream* p_ser_dev,
-							   portTickType a_wait_time)
+							   portTickType a_wait_time, const char* a_name)
+	: stats (a_name, queue_size)
 {
 	// Save the pointer to the serial device which is used for debugging
 	p_serial = p_ser_dev;
 
 	// Create a FreeRTOS queue object which holds the given number of characters
 	the_queue = xQueueCreate (queue_size, sizeof (char));
+	stats.set_handle (the_queue);
 
 	// Store the wait time; it will be used when writing to the queue
 	ticks_to_wait = a_wait_time;
@@ -55,25 +59,36 @@ frt_text_queue::frt_text_queue (uint16_t queue_size, emstream* p_ser_dev,
 
 
 //-------------------------------------------------------------------------------------
-/** This method writes one character to the queue. If the second constructor parameter
+/** This method writes one character to the queue. If the third constructor parameter
  *  wasn't given, the write operation will block until there is room in the queue for
  *  the character being written. Otherwise, the write will block for the given number
  *  of RTOS ticks waiting for an empty space in the queue, then if the queue has not
- *  become empty, give up in frustration and return false. 
+ *  become empty, give up in frustration and return false. The character is first 
+ *  tried without waiting so that the queue's statistics can count the times it was
+ *  full.
  *  @param a_char The character to be sent to the queue
  *  @return True if the character was successfully sent, false if something went wrong
  */
 
 inline bool frt_text_queue::putchar (char a_char)
 {
-	// If the data is successfully put in the queue, return true
-	if (xQueueSendToBack (the_queue, &a_char, ticks_to_wait))
+	// If the data is successfully put in the queue right away, return true
+	if (xQueueSendToBack (the_queue, &a_char, 0))
 	{
+		stats.put_done (the_queue, false, true);
 		return (true);
 	}
 
-	// If we get here, something went wrong (probably a timeout), so return false
-	return (false);
+	// The queue was full, so wait for space if we're allowed to
+	bool got_in = false;
+	if (ticks_to_wait != 0)
+	{
+		got_in = (bool)(xQueueSendToBack (the_queue, &a_char, ticks_to_wait));
+	}
+	stats.put_done (the_queue, true, got_in);
+
+	// If the character didn't get in, something went wrong (probably a timeout)
+	return (got_in);
 }
 
 
@@ -29,6 +29,7 @@
 #include "FreeRTOS.h"                       // Main header for FreeRTOS
 #include "queue.h"                          // Header for FreeRTOS queues
 #include "emstream.h"                       // Pull in the base class header file
+#include "frt_queue_stats.h"                // Statistics on how full the queue gets
 
 
 //-------------------------------------------------------------------------------------
@@ -96,12 +97,14 @@ class frt_text_queue : public emstream
 		xQueueHandle the_queue;             ///< The handle for the queue we use
 		portTickType ticks_to_wait;         ///< RTOS ticks to wait for empty queue
 		emstream* p_serial;                 ///< Serial device used for debugging
+		frt_queue_stats stats;              ///< How full the queue has been, etc.
 
 	// Public methods can be called from anywhere in the program where there is a 
 	// pointer or reference to an object of this class
 	public:
 		// The constructor creates a FreeRTOS queue
-		frt_text_queue (uint16_t, emstream* = NULL, portTickType = portMAX_DELAY);
+		frt_text_queue (uint16_t, emstream* = NULL, portTickType = portMAX_DELAY,
+						const char* = NULL);
 
 		bool putchar (char);					// Write one character to the queue
 		void puts (char const*);				// Write a string constant to queue
@@ -117,6 +120,15 @@ class frt_text_queue : public emstream
 			return (uxQueueMessagesWaiting (the_queue) != 0);
 		}
 
+		/** This method returns the number of characters which can be put into the 
+		 *  queue before it's full. 
+		 *  @return The number of empty places in the queue
+		 */
+		uint16_t room (void)
+		{
+			return (stats.get_size () - uxQueueMessagesWaiting (the_queue));
+		}
+
 		/** If somebody wants to do something which FreeRTOS queues can do but this
 		 *  class doesn't support, a handle for the queue inside this class can be
 		 *  used to access the queue directly. This isn't normally done.
@@ -127,6 +139,15 @@ class frt_text_queue : public emstream
 		{
 			return (the_queue);
 		}
+
+		/** This method gives access to the statistics which show how full the queue
+		 *  has been and how many characters have had to wait or have been dropped.
+		 *  @return A reference to the queue's statistics
+		 */
+		frt_queue_stats& get_stats (void)
+		{
+			return (stats);
+		}
 };
 
 #endif  // _FRT_TEXT_QUEUE_H_
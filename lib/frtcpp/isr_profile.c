@@ -0,0 +1,196 @@
+//*************************************************************************************
+/** \file isr_profile.c
+ *    This file contains the functions which time interrupt service routines when the
+ *    \c ISR_PROFILE option is turned on. They're written in C because the RTOS tick
+ *    ISR in port.c uses them as well as the C++ drivers. They are only called from
+ *    inside ISRs, where interrupts are masked, so they need no protection of their
+ *    own.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifdef ISR_PROFILE
+
+#include <string.h>                         // For memset()
+#include <avr/io.h>                         // Timer register names
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "isr_profile.h"                    // Header for this file
+
+
+// The counter, flag register and flag of the timer which makes RTOS ticks; these must
+// match the timer chosen in port.c
+#if (defined TIMER5_COMPA_vect)
+	#define ISR_TCNT		TCNT5
+	#define ISR_TIFR		TIFR5
+	#define ISR_OCF			OCF5A
+#elif (defined TIMER3_COMPA_vect)
+	#define ISR_TCNT		TCNT3
+	#define ISR_TIFR		TIFR3
+	#define ISR_OCF			OCF3A
+#else
+	#define ISR_TCNT		TCNT1
+	#define ISR_TIFR		TIFR1
+	#define ISR_OCF			OCF1A
+#endif
+
+/// The number of timer counts in one RTOS tick, after which the timer clears itself.
+#define ISR_TICK_COUNTS		(configCPU_CLOCK_HZ / (configTICK_RATE_HZ * portCLOCK_PRESCALER))
+
+
+/// The statistics for each interrupt.
+static isr_prof_stats isr_stats[ISR_PROF_COUNT];
+
+/// The timer count when each interrupt's ISR started.
+static uint16_t isr_start_count[ISR_PROF_COUNT];
+
+/// Whether the tick compare match flag was already set when each ISR started.
+static uint8_t isr_start_flag[ISR_PROF_COUNT];
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds the histogram bin for a time. Bin 0 is for times under 2 us,
+ *  that is 4 timer counts; each bin after that covers twice the time of the one
+ *  before, and the last bin holds all the longer times.
+ *  @param counts The time in timer counts
+ *  @return The number of the bin in which to count the time
+ */
+
+static uint8_t isr_bin (uint16_t counts)
+{
+	uint8_t bin = 0;
+
+	counts >>= 2;
+	while (counts != 0 && bin < ISR_PROF_BINS - 1)
+	{
+		counts >>= 1;
+		bin++;
+	}
+	return (bin);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function adds one to a histogram bin, stopping at the largest count which
+ *  fits so that a busy interrupt doesn't make its histogram wrap around to zero.
+ *  @param p_bin A pointer to the bin
+ */
+
+static void isr_count_up (uint16_t* p_bin)
+{
+	if (*p_bin < 0xFFFF)
+	{
+		(*p_bin)++;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called at the beginning of an ISR whose latency can't be
+ *  measured. It saves the time so the run time can be found at the end.
+ *  @param vector The number of the interrupt, from \c isr_prof_vector
+ */
+
+void isr_profile_start (uint8_t vector)
+{
+	isr_start_count[vector] = ISR_TCNT;
+	isr_start_flag[vector] = ISR_TIFR & (1 << ISR_OCF);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called at the beginning of the ISR for the compare match which
+ *  clears the tick timer. The timer started again from zero at the compare match, so
+ *  its count now is the time since the match. If the timer has already reached
+ *  another match, the tick is more than a whole tick late; that's put in the last
+ *  bin with the longest possible count.
+ *  @param vector The number of the interrupt, from \c isr_prof_vector
+ */
+
+void isr_profile_start_timed (uint8_t vector)
+{
+	uint16_t latency = ISR_TCNT;
+
+	isr_start_count[vector] = latency;
+	isr_start_flag[vector] = ISR_TIFR & (1 << ISR_OCF);
+	if (isr_start_flag[vector])
+	{
+		latency = 0xFFFF;
+	}
+
+	isr_count_up (&isr_stats[vector].latency[isr_bin (latency)]);
+	if (latency > isr_stats[vector].max_latency)
+	{
+		isr_stats[vector].max_latency = latency;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function is called at the end of an ISR. It finds how long the ISR has run
+ *  and counts the time in the run time histogram. If the tick timer's compare match
+ *  flag was set during the ISR, the timer has cleared itself once in the meantime.
+ *  @param vector The number of the interrupt, from \c isr_prof_vector
+ */
+
+void isr_profile_end (uint8_t vector)
+{
+	uint16_t now = ISR_TCNT;
+	uint16_t counts;
+
+	if ((now < isr_start_count[vector])
+		|| ((ISR_TIFR & (1 << ISR_OCF)) && !isr_start_flag[vector]))
+	{
+		counts = now + ISR_TICK_COUNTS - isr_start_count[vector];
+	}
+	else
+	{
+		counts = now - isr_start_count[vector];
+	}
+
+	isr_count_up (&isr_stats[vector].count);
+	isr_count_up (&isr_stats[vector].run[isr_bin (counts)]);
+	if (counts > isr_stats[vector].max_run)
+	{
+		isr_stats[vector].max_run = counts;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function copies one interrupt's statistics so that they can be printed at
+ *  leisure. It must be called with interrupts masked, or the copy might be half
+ *  updated.
+ *  @param vector The number of the interrupt, from \c isr_prof_vector
+ *  @param p_copy A pointer to a structure into which the statistics are copied
+ */
+
+void isr_profile_copy (uint8_t vector, isr_prof_stats* p_copy)
+{
+	*p_copy = isr_stats[vector];
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function clears all the statistics. It must be called with interrupts
+ *  masked.
+ */
+
+void isr_profile_reset (void)
+{
+	memset (isr_stats, 0, sizeof (isr_stats));
+}
+
+#endif // ISR_PROFILE
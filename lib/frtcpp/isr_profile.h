@@ -0,0 +1,116 @@
+//*************************************************************************************
+/** \file isr_profile.h
+ *    This file contains the header for a profiler which measures how long interrupt
+ *    service routines take to run and, for the RTOS tick, how late they start. The
+ *    times are sorted into small histograms which can be printed from the user
+ *    interface. The numbers show how much headroom there is before encoder edges
+ *    start getting lost at higher motor speeds.
+ *
+ *    Profiling is turned on by defining \c ISR_PROFILE in the Makefile. ISRs mark
+ *    their beginning and end with \c ISR_PROFILE_START() and \c ISR_PROFILE_END();
+ *    when \c ISR_PROFILE isn't defined those macros are empty and nothing else in
+ *    this file or in isr_profile.c is compiled.
+ *
+ *    Latency -- the time from the event to the ISR's first instruction -- can only be
+ *    measured when the event is marked by a timer. The RTOS tick is such an event:
+ *    the tick timer clears itself at the compare match, so its count when the tick
+ *    ISR starts is the latency. The encoder, serial and radio interrupts come from
+ *    pins with no timer capture, so only their run times are measured. The tick's
+ *    latency is a good measure for them too, because whatever delays the tick (other
+ *    ISRs and critical sections) delays them in the same way.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _ISR_PROFILE_H_
+#define _ISR_PROFILE_H_
+
+#include <stdint.h>                         // Integer types such as uint16_t
+
+
+/// These are the interrupts which can be profiled.
+typedef enum
+{
+	ISR_PROF_TICK,                          ///< The RTOS tick timer compare match
+	ISR_PROF_ENCODER,                       ///< Encoder edges on INT4 and INT5
+	ISR_PROF_SERIAL_0,                      ///< Characters received by USART 0
+	ISR_PROF_SERIAL_1,                      ///< Characters received by USART 1
+	ISR_PROF_RADIO,                         ///< The nRF24L01 radio's IRQ pin
+	ISR_PROF_SUBTICK,                       ///< Wakeups between RTOS ticks
+	ISR_PROF_COUNT                          ///< How many interrupts are profiled
+} isr_prof_vector;
+
+
+#ifdef ISR_PROFILE
+
+/** This is the number of bins in each histogram. Bin 0 holds times under 2 us, and
+ *  each bin after that holds times up to twice as long as the one before, so the
+ *  last bin holds everything of 128 us or more.
+ */
+#define ISR_PROF_BINS			8
+
+/// This structure holds the statistics for one interrupt.
+typedef struct
+{
+	uint16_t count;                         ///< Number of times the ISR has run
+	uint16_t max_run;                       ///< Longest run time in timer counts
+	uint16_t max_latency;                   ///< Longest latency in timer counts
+	uint16_t run[ISR_PROF_BINS];            ///< Histogram of run times
+	uint16_t latency[ISR_PROF_BINS];        ///< Histogram of latencies, if measured
+} isr_prof_stats;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called first thing in an ISR whose latency can't be measured
+void isr_profile_start (uint8_t vector);
+
+// Called first thing in the ISR for the compare match which clears the tick timer
+void isr_profile_start_timed (uint8_t vector);
+
+// Called last thing in an ISR
+void isr_profile_end (uint8_t vector);
+
+// Copy one interrupt's statistics so they can be printed
+void isr_profile_copy (uint8_t vector, isr_prof_stats* p_copy);
+
+// Clear all the statistics
+void isr_profile_reset (void);
+
+#ifdef __cplusplus
+}
+
+class emstream;
+
+// Print the histograms for all the profiled interrupts on a serial device
+void isr_profile_print (emstream* ser_dev);
+#endif
+
+#define ISR_PROFILE_START(v)		isr_profile_start (v)
+#define ISR_PROFILE_START_TIMED(v)	isr_profile_start_timed (v)
+#define ISR_PROFILE_END(v)			isr_profile_end (v)
+
+#else  // ISR_PROFILE isn't defined, so the macros do nothing
+
+#define ISR_PROFILE_START(v)
+#define ISR_PROFILE_START_TIMED(v)
+#define ISR_PROFILE_END(v)
+
+#endif // ISR_PROFILE
+
+#endif // _ISR_PROFILE_H_
@@ -0,0 +1,101 @@
+//*************************************************************************************
+/** \file isr_profile_print.cpp
+ *    This file contains a function which prints the histograms kept by the interrupt
+ *    profiler. It's in its own file, apart from the C code which does the timing,
+ *    because it uses the C++ serial stream classes.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifdef ISR_PROFILE
+
+#include <avr/pgmspace.h>                   // For the names kept in flash memory
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "emstream.h"                       // Base for text-type serial port objects
+#include "time_stamp.h"                     // For the hardware timer's tick rate
+#include "isr_profile.h"                    // Header for the profiler
+
+
+/// The names printed for the interrupts, in the order of \c isr_prof_vector.
+static const char isr_names[ISR_PROF_COUNT][10] PROGMEM =
+{
+	"tick",
+	"encoder",
+	"serial 0",
+	"serial 1",
+	"radio",
+	"sub-tick"
+};
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints one row of the table: the longest time in microseconds and
+ *  then the number of times in each bin of a histogram.
+ *  @param ser_dev The serial device on which to print
+ *  @param max The longest time, in counts of the tick timer
+ *  @param p_bins A pointer to the histogram's bins
+ */
+
+static void isr_print_row (emstream* ser_dev, uint16_t max, uint16_t* p_bins)
+{
+	*ser_dev << (uint32_t)max * 1000000UL / HW_TICK_RATE_HZ;
+	for (uint8_t bin = 0; bin < ISR_PROF_BINS; bin++)
+	{
+		*ser_dev << '\t' << p_bins[bin];
+	}
+	*ser_dev << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints the statistics for each profiled interrupt which has run.
+ *  Each one gets a row showing how many times it ran, its longest run time, and how
+ *  many of its run times fell in each histogram bin. The tick also gets a row for
+ *  its latency. The headings show the upper limit of each bin in microseconds.
+ *  @param ser_dev The serial device on which to print the statistics
+ */
+
+void isr_profile_print (emstream* ser_dev)
+{
+	isr_prof_stats stats;
+
+	*ser_dev << PMS ("ISR\t\tRuns\tMax us\t<2\t<4\t<8\t<16\t<32\t<64\t<128\tmore")
+			 << endl;
+	*ser_dev << PMS ("---\t\t----\t------\t--\t--\t--\t---\t---\t---\t----\t----")
+			 << endl;
+
+	for (uint8_t vector = 0; vector < ISR_PROF_COUNT; vector++)
+	{
+		portENTER_CRITICAL ();
+		isr_profile_copy (vector, &stats);
+		portEXIT_CRITICAL ();
+
+		if (stats.count == 0)
+		{
+			continue;
+		}
+		*ser_dev << _p_str << isr_names[vector] << PMS ("\t\t") << stats.count << '\t';
+		isr_print_row (ser_dev, stats.max_run, stats.run);
+
+		if (vector == ISR_PROF_TICK)
+		{
+			*ser_dev << PMS (" latency\t\t\t");
+			isr_print_row (ser_dev, stats.max_latency, stats.latency);
+		}
+	}
+}
+
+#endif // ISR_PROFILE
@@ -0,0 +1,208 @@
+//*************************************************************************************
+/** \file sched_analysis.cpp
+ *    This file contains functions which assign rate-monotonic or deadline-monotonic
+ *    priorities to a set of tasks and work out the tasks' worst-case response times.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "sched_analysis.h"                 // Header for this file
+
+
+//-------------------------------------------------------------------------------------
+/** This function adds two times, stopping at \c SCHED_UNBOUNDED rather than wrapping
+ *  around if the sum is too large to hold.
+ *  @param first One of the times to add
+ *  @param second The other time to add
+ *  @return The sum, or \c SCHED_UNBOUNDED if it's too large
+ */
+
+static uint32_t sched_add (uint32_t first, uint32_t second)
+{
+	return ((first > SCHED_UNBOUNDED - second) ? SCHED_UNBOUNDED : first + second);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds how much time a task which runs every \c period microseconds
+ *  for up to \c wcet microseconds can take from a lower priority task in a window of
+ *  \c window microseconds. The task can be released at the start of the window and
+ *  again every period until the window ends.
+ *  @param window The length of the window in microseconds
+ *  @param period The period of the interfering task in microseconds
+ *  @param wcet The longest run time of the interfering task in microseconds
+ *  @return The time taken, or \c SCHED_UNBOUNDED if it's too large to hold
+ */
+
+static uint32_t sched_interference (uint32_t window, uint32_t period, uint32_t wcet)
+{
+	uint32_t releases = window / period + ((window % period) ? 1 : 0);
+
+	if (wcet != 0 && releases > SCHED_UNBOUNDED / wcet)
+	{
+		return (SCHED_UNBOUNDED);
+	}
+	return (releases * wcet);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function gives each task a new priority. The tasks are ranked by period for
+ *  rate-monotonic priorities or by deadline for deadline-monotonic priorities, the
+ *  shortest getting the highest priority; deadline-monotonic is the same as rate-
+ *  monotonic when no task has a deadline different from its period. FreeRTOS has
+ *  only a few priority levels, so when there are more tasks than levels, the ranked
+ *  tasks are split into as many groups as there are levels and each group shares 
+ *  one level, the less urgent groups being the larger ones. Tasks which share a level
+ *  take turns by time slicing.
+ *  @param p_tasks A pointer to the array of tasks
+ *  @param count The number of tasks in the array
+ *  @param deadline_monotonic True to rank by deadline, false to rank by period
+ *  @param levels The number of priorities above the idle task's which can be used;
+ *                the priorities given run from 1 to \c levels
+ */
+
+void sched_assign_priorities (sched_task* p_tasks, uint8_t count,
+							  bool deadline_monotonic, uint8_t levels)
+{
+	uint8_t order[SCHED_MAX_TASKS];
+
+	if (count > SCHED_MAX_TASKS)
+	{
+		count = SCHED_MAX_TASKS;
+	}
+
+	// Sort the task numbers so the most urgent task comes first
+	for (uint8_t index = 0; index < count; index++)
+	{
+		const sched_task* p_task = p_tasks + index;
+		uint32_t key = deadline_monotonic ? sched_deadline (p_task) : p_task->period;
+		uint8_t place = index;
+
+		while (place > 0)
+		{
+			const sched_task* p_other = p_tasks + order[place - 1];
+			uint32_t other_key = deadline_monotonic ? sched_deadline (p_other) 
+													: p_other->period;
+			if (other_key <= key)
+			{
+				break;
+			}
+			order[place] = order[place - 1];
+			place--;
+		}
+		order[place] = index;
+	}
+
+	// Hand out the levels from the bottom up, so that if the groups can't all be the
+	// same size, the smaller groups get the higher levels
+	for (uint8_t rank = 0; rank < count; rank++)
+	{
+		p_tasks[order[rank]].new_priority 
+			= 1 + (uint8_t)((uint16_t)(count - 1 - rank) * levels / count);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function works out the worst-case response time of each task at its new 
+ *  priority. A task's response time is its own run time plus the time taken by 
+ *  every task at the same or a higher priority which can be released while it's 
+ *  waiting, plus the time taken by the RTOS tick interrupt. Tasks at the same level 
+ *  are counted as if they were at a higher one, which is right for time slicing. 
+ *  The response time is found by repeating the sum until it stops growing; if it 
+ *  grows past the task's deadline, the task can miss its deadline and its response
+ *  time is set to \c SCHED_UNBOUNDED. A task whose period is zero hasn't been 
+ *  measured; it's skipped and doesn't count as interference. To check the 
+ *  priorities which are in use now, copy them into \c new_priority first. 
+ *  @param p_tasks A pointer to the array of tasks
+ *  @param count The number of tasks in the array
+ *  @param tick_us The longest run time of the RTOS tick interrupt in microseconds
+ *  @return True if every task always meets its deadline, false if any can miss it
+ */
+
+bool sched_find_responses (sched_task* p_tasks, uint8_t count, uint32_t tick_us)
+{
+	bool all_met = true;
+
+	for (uint8_t index = 0; index < count; index++)
+	{
+		sched_task* p_task = p_tasks + index;
+		uint32_t deadline = sched_deadline (p_task);
+		uint32_t response = p_task->wcet;
+		uint32_t previous = 0;
+
+		if (p_task->period == 0)
+		{
+			p_task->response = 0;
+			continue;
+		}
+
+		while (response != previous && response <= deadline)
+		{
+			previous = response;
+			response = sched_add (p_task->wcet, 
+					sched_interference (previous, SCHED_TICK_PERIOD_US, tick_us));
+
+			for (uint8_t other = 0; other < count; other++)
+			{
+				const sched_task* p_other = p_tasks + other;
+				if (other != index && p_other->period != 0
+					&& p_other->new_priority >= p_task->new_priority)
+				{
+					response = sched_add (response, sched_interference (previous, 
+										  p_other->period, p_other->wcet));
+				}
+			}
+		}
+
+		if (response > deadline)
+		{
+			p_task->response = SCHED_UNBOUNDED;
+			all_met = false;
+		}
+		else
+		{
+			p_task->response = response;
+		}
+	}
+	return (all_met);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function works out how much of the processor's time the tasks and the RTOS 
+ *  tick interrupt need in the worst case. If the result is over 1000, no choice of 
+ *  priorities can make the tasks meet their deadlines.
+ *  @param p_tasks A pointer to the array of tasks
+ *  @param count The number of tasks in the array
+ *  @param tick_us The longest run time of the RTOS tick interrupt in microseconds
+ *  @return The fraction of the time used, in tenths of a percent, up to 0xFFFF
+ */
+
+uint16_t sched_utilisation (const sched_task* p_tasks, uint8_t count, uint32_t tick_us)
+{
+	uint32_t total = tick_us * 1000UL / SCHED_TICK_PERIOD_US;
+
+	for (uint8_t index = 0; index < count && total < 0xFFFF; index++)
+	{
+		if (p_tasks[index].period != 0)
+		{
+			total += (p_tasks[index].wcet > SCHED_UNBOUNDED / 1000UL) ? 0xFFFFUL
+					 : p_tasks[index].wcet * 1000UL / p_tasks[index].period;
+		}
+	}
+	return ((total > 0xFFFF) ? 0xFFFF : (uint16_t)total);
+}
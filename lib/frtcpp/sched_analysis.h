@@ -0,0 +1,83 @@
+//*************************************************************************************
+/** \file sched_analysis.h
+ *    This file contains functions which check whether a set of periodic tasks can
+ *    always meet their deadlines. Each task's period, worst-case execution time and
+ *    deadline are given, as measured on the target with \c TASK_PROFILE or taken
+ *    from a file by the PC program in \c tools/sched_check.cpp. Priorities are
+ *    assigned rate-monotonic (shortest period highest) or deadline-monotonic
+ *    (shortest deadline highest), then response-time analysis finds the longest time
+ *    each task can take from being released until it finishes. 
+ *
+ *    These functions use only plain integer arithmetic and don't call FreeRTOS, so
+ *    the same code runs on the AVR and on a PC.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _SCHED_ANALYSIS_H_
+#define _SCHED_ANALYSIS_H_
+
+#include <stdint.h>                         // Integer types such as uint32_t
+
+
+/** This is the largest number of tasks which can be analysed at once. It limits the
+ *  size of the tables which have to be kept in RAM on the AVR.
+ */
+#define SCHED_MAX_TASKS			12
+
+/// This response time means that the task can miss its deadline.
+#define SCHED_UNBOUNDED			0xFFFFFFFFUL
+
+/** This is the period of the RTOS tick interrupt in microseconds. The tick interrupts
+ *  every task, so its run time is counted as interference for all of them.
+ */
+#define SCHED_TICK_PERIOD_US	1000UL
+
+
+/// This structure holds the timing of one task and the results of analysing it.
+typedef struct
+{
+	const char* name;                       ///< The task's name, for printing
+	uint32_t period;                        ///< Shortest time between runs in us
+	uint32_t wcet;                          ///< Longest time for one run in us
+	uint32_t deadline;                      ///< Deadline in us; 0 means the period
+	uint8_t priority;                       ///< Priority now in use, for printing
+	uint8_t new_priority;                   ///< Priority given by the analysis
+	uint32_t response;                      ///< Worst-case response time in us
+} sched_task;
+
+
+// Give the tasks rate-monotonic or deadline-monotonic priorities
+void sched_assign_priorities (sched_task* p_tasks, uint8_t count,
+							  bool deadline_monotonic, uint8_t levels);
+
+// Find each task's worst-case response time; return true if all meet deadlines
+bool sched_find_responses (sched_task* p_tasks, uint8_t count, uint32_t tick_us);
+
+// Find the fraction of the processor's time the tasks need, in tenths of a percent
+uint16_t sched_utilisation (const sched_task* p_tasks, uint8_t count, uint32_t tick_us);
+
+/** This function returns the deadline of a task, which is its period unless a 
+ *  shorter or longer deadline has been given.
+ *  @param p_task A pointer to the task
+ *  @return The task's deadline in microseconds
+ */
+inline uint32_t sched_deadline (const sched_task* p_task)
+{
+	return (p_task->deadline ? p_task->deadline : p_task->period);
+}
+
+#endif  // _SCHED_ANALYSIS_H_
@@ -142,6 +142,15 @@ class time_stamp
 			return tick_count;
 		}
 
+		/** This method returns the count of the hardware timer in the time stamp,
+		 *  the part of the time which is less than one RTOS tick.
+		 *  @return The number of hardware timer counts since the last RTOS tick
+		 */
+		HW_CTR_TYPE get_hardware_count (void)
+		{
+			return hardware_count;
+		}
+
 		/** This method returns the number of seconds in the time stamp. It is assumed
 		 *  that the hardware counter is ticking at an integer number of ticks per 
 		 *  second so that the hardware timer count does not need to be used in 
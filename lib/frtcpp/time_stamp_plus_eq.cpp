@@ -44,7 +44,7 @@ void time_stamp::operator += (const time_stamp& addend)
 	hardware_count += addend.hardware_count;
 
 	// If the hardware count would overflow, carry it to the RTOS tick count
-	if (hardware_count > TMR_MAX_CT)
+	if (hardware_count >= TMR_MAX_CT)
 	{
 		hardware_count -= TMR_MAX_CT;
 		tick_count++;
@@ -0,0 +1,90 @@
+//*************************************************************************************
+/** \file block_device.h
+ *    This file contains a base class for storage devices which are read and written
+ *    in 512-byte sectors, such as SD cards. Code which stores data, such as a data 
+ *    logger, talks to this interface so that it works the same way with an SD card on
+ *    the AVR or with a file on a PC when the code is being tested. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _BLOCK_DEVICE_H_
+#define _BLOCK_DEVICE_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+
+
+/// This is the size of one sector, the smallest amount which can be read or written.
+const uint16_t BLOCK_SIZE = 512;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This is the base class for storage devices made of 512-byte sectors.
+ *  \details Each descendent must implement \c init(), \c read_sector(), 
+ *  \c write_sector(), and \c get_sector_count(). The methods return true for success
+ *  and false for failure, and they may take a long time (an SD card can take many
+ *  milliseconds to write a sector), so they should be called from a low priority task
+ *  rather than from a control loop or an interrupt service routine. 
+ */
+
+class block_device
+{
+	protected:
+		/// This counts the reads and writes which have failed.
+		uint16_t errors;
+
+	public:
+		/** The constructor just clears the error count; descendents do the real setup.
+		 */
+		block_device (void)
+		{
+			errors = 0;
+		}
+
+		/** This method gets the device ready to be read and written.
+		 *  @return True if the device is ready, false if not
+		 */
+		virtual bool init (void) = 0;
+
+		/** This method reads one sector from the device.
+		 *  @param sector The number of the sector, counting from zero
+		 *  @param p_buffer A pointer to a buffer of \c BLOCK_SIZE bytes for the data
+		 *  @return True if the sector was read, false if not
+		 */
+		virtual bool read_sector (uint32_t sector, uint8_t* p_buffer) = 0;
+
+		/** This method writes one sector to the device.
+		 *  @param sector The number of the sector, counting from zero
+		 *  @param p_buffer A pointer to the \c BLOCK_SIZE bytes to be written
+		 *  @return True if the sector was written, false if not
+		 */
+		virtual bool write_sector (uint32_t sector, const uint8_t* p_buffer) = 0;
+
+		/** This method finds how many sectors the device holds.
+		 *  @return The number of sectors, or 0 if the device isn't ready
+		 */
+		virtual uint32_t get_sector_count (void) = 0;
+
+		/** This method returns the number of reads and writes which have failed.
+		 *  @return The error count
+		 */
+		uint16_t get_errors (void)
+		{
+			return (errors);
+		}
+};
+
+#endif // _BLOCK_DEVICE_H_
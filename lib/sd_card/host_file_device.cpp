@@ -0,0 +1,150 @@
+//*************************************************************************************
+/** \file host_file_device.cpp
+ *    This file contains a block device which keeps its sectors in a file on a PC, for
+ *    testing code which logs to an SD card. It isn't compiled for the AVR.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef __AVR__                             // Only for programs which run on a PC
+
+#include <string.h>                         // For memset()
+
+#include "host_file_device.h"               // Header for this class
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor saves the name of the file and the size of the device. The file
+ *  isn't opened until \c init() is called.
+ *  @param a_file_name The name of the file which holds the sectors
+ *  @param num_sectors How many sectors the device is to hold
+ */
+
+host_file_device::host_file_device (const char* a_file_name, uint32_t num_sectors)
+	: block_device ()
+{
+	file_name = a_file_name;
+	sectors = num_sectors;
+	p_file = NULL;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** The destructor closes the file so that everything written is saved.
+ */
+
+host_file_device::~host_file_device (void)
+{
+	if (p_file != NULL)
+	{
+		fclose (p_file);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method opens the file for reading and writing, creating it if needed.
+ *  @return True if the file is open, false if it couldn't be opened
+ */
+
+bool host_file_device::init (void)
+{
+	if (p_file != NULL)
+	{
+		return (true);
+	}
+	p_file = fopen (file_name, "r+b");
+	if (p_file == NULL)
+	{
+		p_file = fopen (file_name, "w+b");
+	}
+	if (p_file == NULL)
+	{
+		errors++;
+		return (false);
+	}
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads one sector from the file. Parts of the sector past the end of 
+ *  the file read as 0xFF. 
+ *  @param sector The number of the sector, counting from zero
+ *  @param p_buffer A pointer to a buffer of \c BLOCK_SIZE bytes for the data
+ *  @return True if the sector was read, false if it's past the end of the device
+ */
+
+bool host_file_device::read_sector (uint32_t sector, uint8_t* p_buffer)
+{
+	if (p_file == NULL || sector >= sectors
+		|| fseek (p_file, (long)sector * BLOCK_SIZE, SEEK_SET) != 0)
+	{
+		errors++;
+		return (false);
+	}
+	size_t got = fread (p_buffer, 1, BLOCK_SIZE, p_file);
+	memset (p_buffer + got, 0xFF, BLOCK_SIZE - got);
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method writes one sector to the file. If the sector is past the end of the
+ *  file, the gap is filled with 0xFF first.
+ *  @param sector The number of the sector, counting from zero
+ *  @param p_buffer A pointer to the \c BLOCK_SIZE bytes to be written
+ *  @return True if the sector was written, false if not
+ */
+
+bool host_file_device::write_sector (uint32_t sector, const uint8_t* p_buffer)
+{
+	if (p_file == NULL || sector >= sectors || fseek (p_file, 0, SEEK_END) != 0)
+	{
+		errors++;
+		return (false);
+	}
+
+	// Fill any gap between the end of the file and this sector like erased flash
+	long file_end = ftell (p_file);
+	for (long place = file_end; place < (long)sector * BLOCK_SIZE; place++)
+	{
+		fputc (0xFF, p_file);
+	}
+
+	if (fseek (p_file, (long)sector * BLOCK_SIZE, SEEK_SET) != 0
+		|| fwrite (p_buffer, 1, BLOCK_SIZE, p_file) != BLOCK_SIZE)
+	{
+		errors++;
+		return (false);
+	}
+	fflush (p_file);
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method returns the number of sectors given to the constructor.
+ *  @return The number of sectors the device holds
+ */
+
+uint32_t host_file_device::get_sector_count (void)
+{
+	return (sectors);
+}
+
+#endif // __AVR__
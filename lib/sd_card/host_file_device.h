@@ -0,0 +1,83 @@
+//*************************************************************************************
+/** \file host_file_device.h
+ *    This file contains a block device which keeps its sectors in a file on a PC. It
+ *    stands in for an SD card so that code which logs data to a block device can be
+ *    compiled and tested on a PC, and so that card images copied with a tool such as
+ *    \c dd can be read back. It isn't compiled for the AVR.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _HOST_FILE_DEVICE_H_
+#define _HOST_FILE_DEVICE_H_
+
+#ifndef __AVR__                             // Only for programs which run on a PC
+
+#include <stdio.h>                          // For standard file functions
+
+#include "block_device.h"                   // Base class for sector storage devices
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class is a block device kept in a file on a PC.
+ *  \details The file is opened by \c init(), and created if it doesn't exist. It 
+ *  grows as sectors are written past its end; sectors which haven't been written read
+ *  back as 0xFF, as erased flash memory does. The device's size is set when it's 
+ *  created, so a test can find out what happens when a logger fills a card. 
+ *
+ *  \section Usage
+ *  \code
+ *  host_file_device card ("card.img", 2048);   // A 1 MB card
+ *  card.init ();
+ *  card.write_sector (0, my_512_bytes);
+ *  \endcode
+ */
+
+class host_file_device : public block_device
+{
+	protected:
+		/// The name of the file which holds the sectors.
+		const char* file_name;
+
+		/// The file, or NULL if it hasn't been opened.
+		FILE* p_file;
+
+		/// The number of sectors the device pretends to hold.
+		uint32_t sectors;
+
+	public:
+		// The constructor saves the file name and size
+		host_file_device (const char*, uint32_t);
+
+		// The destructor closes the file
+		~host_file_device (void);
+
+		// Open or create the file
+		bool init (void);
+
+		// Read one 512-byte sector from the file
+		bool read_sector (uint32_t, uint8_t*);
+
+		// Write one 512-byte sector to the file
+		bool write_sector (uint32_t, const uint8_t*);
+
+		// Find how many sectors the device holds
+		uint32_t get_sector_count (void);
+};
+
+#endif // __AVR__
+
+#endif // _HOST_FILE_DEVICE_H_
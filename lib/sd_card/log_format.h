@@ -0,0 +1,142 @@
+//*************************************************************************************
+/** \file log_format.h
+ *    This file describes how the data log is laid out on a block device, so that the
+ *    logger which writes it and the reader which reads it back agree. The log is a 
+ *    series of 512-byte blocks, each with its own header and CRC, so a write cut off
+ *    by a power failure spoils only the block being written. Every 32nd block is an 
+ *    index block listing the start times of the 31 data blocks before it, so a reader
+ *    can find a given time without reading the whole log. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _LOG_FORMAT_H_
+#define _LOG_FORMAT_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+
+#ifdef __AVR__
+	#include <util/crc16.h>                 // Header for cyclic redundancy checks
+#endif
+
+#include "block_device.h"                   // Base class for sector storage devices
+
+
+/// This is the magic number at the start of every data block.
+const uint16_t LOG_MAGIC_DATA = 0x444C;     // "LD" in little-endian byte order
+
+/// This is the magic number at the start of every index block.
+const uint16_t LOG_MAGIC_INDEX = 0x494C;    // "LI" in little-endian byte order
+
+/// This is how many blocks there are in a group: data blocks followed by an index.
+const uint8_t LOG_GROUP_BLOCKS = 32;
+
+/// This is how many data blocks are in each group, before the group's index block.
+const uint8_t LOG_INDEX_SPAN = LOG_GROUP_BLOCKS - 1;
+
+/// This record type marks the unused space at the end of a data block.
+const uint8_t LOG_TYPE_EMPTY = 0xFF;
+
+
+/** This is the header at the start of every block. The session number is different
+ *  each time logging starts, so blocks left on the card by an earlier, longer log 
+ *  aren't mistaken for part of the current one. The items are in this order so the
+ *  structure has no padding on the AVR or on a PC.
+ */
+typedef struct
+{
+	uint32_t sequence;                      ///< The block's number, counting from 0
+	uint32_t session;                       ///< Which logging session wrote the block
+	uint32_t start_time;                    ///< Time of the first record, in ms
+	uint16_t magic;                         ///< \c LOG_MAGIC_DATA or \c LOG_MAGIC_INDEX
+	uint16_t used;                          ///< Bytes used, including this header
+}
+log_block_header;
+
+/// This is where the records in a data block start.
+const uint16_t LOG_DATA_START = sizeof (log_block_header);
+
+/// This is where the CRC of a block is kept, in the last two bytes.
+const uint16_t LOG_CRC_PLACE = BLOCK_SIZE - sizeof (uint16_t);
+
+/** This is the header of each record in a data block. The record's data follows it.
+ *  The time is how long after the block's \c start_time the record was logged.
+ */
+typedef struct
+{
+	uint8_t type;                           ///< What kind of record; never 0xFF
+	uint8_t size;                           ///< Bytes of data after this header
+	uint16_t time_offset;                   ///< Milliseconds after the block started
+}
+log_record_header;
+
+/** This is an index block. It lists the start time of each data block in the group
+ *  it ends; blocks which were never written are listed as 0xFFFFFFFF.
+ */
+typedef struct
+{
+	log_block_header header;                ///< The header, with \c LOG_MAGIC_INDEX
+	uint32_t block_times[LOG_INDEX_SPAN];   ///< Start times of the group's data blocks
+}
+log_index_block;
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds the CRC-CCITT of a block of bytes, the same way on the AVR 
+ *  (where a fast library routine is used) and on a PC.
+ *  @param p_bytes A pointer to the bytes to be checked
+ *  @param num_bytes How many bytes there are
+ *  @return The CRC, computed with a starting value of 0xFFFF
+ */
+
+inline uint16_t log_crc (const uint8_t* p_bytes, uint16_t num_bytes)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (num_bytes--)
+	{
+		#ifdef __AVR__
+			crc = _crc_ccitt_update (crc, *p_bytes++);
+		#else
+			// This is the C equivalent given in the avr-libc documentation
+			uint8_t data = *p_bytes++ ^ (uint8_t)crc;
+			data ^= data << 4;
+			crc = ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) 
+				   ^ ((uint16_t)data << 3));
+		#endif
+	}
+	return (crc);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function checks whether a block read from the log is whole and good. 
+ *  @param p_block A pointer to the \c BLOCK_SIZE bytes of the block
+ *  @param magic The magic number the block should have
+ *  @return True if the block has the right magic number and a good CRC
+ */
+
+inline bool log_block_ok (const uint8_t* p_block, uint16_t magic)
+{
+	const log_block_header* p_header = (const log_block_header*)p_block;
+	uint16_t stored_crc = p_block[LOG_CRC_PLACE] 
+						  | ((uint16_t)p_block[LOG_CRC_PLACE + 1] << 8);
+
+	return (p_header->magic == magic && p_header->used <= LOG_CRC_PLACE 
+			&& log_crc (p_block, LOG_CRC_PLACE) == stored_crc);
+}
+
+#endif // _LOG_FORMAT_H_
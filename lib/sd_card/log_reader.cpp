@@ -0,0 +1,280 @@
+//*************************************************************************************
+/** \file log_reader.cpp
+ *    This file contains a class which reads back a data log written by a 
+ *    sector_logger, using the log's index blocks to find records by time.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "log_reader.h"                     // Header for this class
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor saves the device and the place where the log starts. The device
+ *  must be set up with its \c init() method before records are read.
+ *  @param p_a_device A pointer to the device on which the log is kept
+ *  @param a_first_sector The sector where the log starts (default: 0)
+ */
+
+log_reader::log_reader (block_device* p_a_device, uint32_t a_first_sector)
+{
+	p_device = p_a_device;
+	first_sector = a_first_sector;
+	session = 0;
+	block_num = LOG_NO_BLOCK;
+	block_good = false;
+	place = LOG_DATA_START;
+	skip_before = 0;
+	bad_blocks = 0;
+	reads = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads a block of the log into the buffer and checks that it's whole,
+ *  of the right kind, in the right place, and from this log's session.
+ *  @param number The number of the block, counting from the start of the log
+ *  @param magic \c LOG_MAGIC_DATA for a data block or \c LOG_MAGIC_INDEX for an index
+ *  @return True if the block is good, false if it couldn't be read or isn't good
+ */
+
+bool log_reader::load (uint32_t number, uint16_t magic)
+{
+	block_num = LOG_NO_BLOCK;
+	block_good = false;
+	reads++;
+	if (!p_device->read_sector (first_sector + number, block))
+	{
+		return (false);
+	}
+	block_num = number;
+
+	const log_block_header* p_header = (const log_block_header*)block;
+	block_good = (log_block_ok (block, magic) && p_header->sequence == number 
+				  && p_header->session == session);
+	return (block_good);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the block in the buffer is blank, meaning the log ended
+ *  before it. A block from another session also counts as blank, since it was left
+ *  on the card by an earlier log.
+ *  @return True if the block marks the end of the log
+ */
+
+bool log_reader::is_blank (void)
+{
+	const log_block_header* p_header = (const log_block_header*)block;
+
+	if (block_num == LOG_NO_BLOCK)
+	{
+		return (true);
+	}
+	if ((p_header->magic == LOG_MAGIC_DATA || p_header->magic == LOG_MAGIC_INDEX)
+		&& p_header->session != session && log_block_ok (block, p_header->magic))
+	{
+		return (true);
+	}
+	for (uint16_t index = 0; index < BLOCK_SIZE; index++)
+	{
+		if (block[index] != 0xFF)
+		{
+			return (false);
+		}
+	}
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method goes back to the first record in the log. It reads the first block to
+ *  find the log's session number.
+ *  @return True if there's a log, false if the first block isn't a good data block
+ */
+
+bool log_reader::rewind (void)
+{
+	skip_before = 0;
+	place = LOG_DATA_START;
+
+	reads++;
+	if (!p_device->read_sector (first_sector, block) 
+		|| !log_block_ok (block, LOG_MAGIC_DATA)
+		|| ((const log_block_header*)block)->sequence != 0)
+	{
+		block_num = LOG_NO_BLOCK;
+		return (false);
+	}
+	session = ((const log_block_header*)block)->session;
+	block_num = 0;
+	block_good = true;
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method goes to the first record logged at or after the given time. Only a 
+ *  few blocks are read: one per step of a binary search over the groups, then the 
+ *  group's index block, then the data block it points to. 
+ *  @param time The time to look for, in milliseconds
+ *  @return True if the log was found, false if there's no log on the device
+ */
+
+bool log_reader::seek_time (uint32_t time)
+{
+	if (!rewind ())
+	{
+		return (false);
+	}
+	skip_before = time;
+	if (((const log_block_header*)block)->start_time >= time)
+	{
+		return (true);
+	}
+
+	// Find the last group whose first data block is good and started by this time
+	uint32_t sectors = p_device->get_sector_count ();
+	uint32_t span = (sectors > first_sector) ? sectors - first_sector : 0;
+	uint32_t groups = span / LOG_GROUP_BLOCKS + ((span % LOG_GROUP_BLOCKS) ? 1 : 0);
+	uint32_t low = 0;                       // This group is known to be early enough
+	uint32_t high = groups;                 // Groups from here on are too late
+	while (high - low > 1)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		if (load (middle * LOG_GROUP_BLOCKS, LOG_MAGIC_DATA)
+			&& ((const log_block_header*)block)->start_time <= time)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	// Use the group's index to find the last data block started by this time; if 
+	// there's no index, read the data blocks' headers one after another
+	uint32_t group_start = low * LOG_GROUP_BLOCKS;
+	uint32_t found = group_start;
+	if (load (group_start + LOG_INDEX_SPAN, LOG_MAGIC_INDEX))
+	{
+		const log_index_block* p_index = (const log_index_block*)block;
+		for (uint8_t index = 1; index < LOG_INDEX_SPAN; index++)
+		{
+			if (p_index->block_times[index] == 0xFFFFFFFF 
+				|| p_index->block_times[index] > time)
+			{
+				break;
+			}
+			found = group_start + index;
+		}
+	}
+	else
+	{
+		for (uint8_t index = 1; index < LOG_INDEX_SPAN; index++)
+		{
+			if (!load (group_start + index, LOG_MAGIC_DATA))
+			{
+				if (is_blank ())
+				{
+					break;
+				}
+				continue;                   // A spoiled block; try the next one
+			}
+			if (((const log_block_header*)block)->start_time > time)
+			{
+				break;
+			}
+			found = group_start + index;
+		}
+	}
+
+	// Load the block so next() starts with it; if it's bad, next() will move on
+	load (found, LOG_MAGIC_DATA);
+	block_num = found;
+	place = LOG_DATA_START;
+	if (!block_good)
+	{
+		place = BLOCK_SIZE;
+	}
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the next record from the log. Index blocks and spoiled blocks 
+ *  are skipped; after \c seek_time(), records from before the time are skipped too.
+ *  @param p_entry A pointer to a structure which is filled in with the record
+ *  @return True if a record was read, false at the end of the log
+ */
+
+bool log_reader::next (log_entry* p_entry)
+{
+	for (;;)
+	{
+		if (block_num == LOG_NO_BLOCK)
+		{
+			return (false);
+		}
+
+		// If the block in the buffer is good and has more records, take the next one
+		const log_block_header* p_header = (const log_block_header*)block;
+		if (block_good && place + sizeof (log_record_header) <= p_header->used)
+		{
+			const log_record_header* p_record 
+				= (const log_record_header*)(block + place);
+			place += sizeof (log_record_header) + p_record->size;
+			if (place > p_header->used)
+			{
+				bad_blocks++;               // A record runs off the end of the block
+				place = BLOCK_SIZE;
+				continue;
+			}
+
+			p_entry->type = p_record->type;
+			p_entry->size = p_record->size;
+			p_entry->time = p_header->start_time + p_record->time_offset;
+			p_entry->block = block_num;
+			p_entry->p_data = (const uint8_t*)(p_record + 1);
+			if (p_entry->time < skip_before)
+			{
+				continue;
+			}
+			return (true);
+		}
+
+		// Move on to the next data block, stepping over the index blocks
+		uint32_t number = block_num + 1;
+		if (number % LOG_GROUP_BLOCKS == LOG_INDEX_SPAN)
+		{
+			number++;
+		}
+		place = LOG_DATA_START;
+		if (!load (number, LOG_MAGIC_DATA))
+		{
+			if (is_blank ())
+			{
+				block_num = LOG_NO_BLOCK;
+				return (false);
+			}
+			bad_blocks++;
+			block_num = number;             // Skip the spoiled block and go on
+			place = BLOCK_SIZE;
+		}
+	}
+}
@@ -0,0 +1,150 @@
+//*************************************************************************************
+/** \file log_reader.h
+ *    This file contains a class which reads back a data log written by a 
+ *    sector_logger. It's meant mainly for programs which run on a PC and read a card
+ *    image through a host_file_device, but it works with any block device. It can 
+ *    jump to the records logged at a given time by reading a handful of blocks, 
+ *    rather than reading the whole log from the start. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _LOG_READER_H_
+#define _LOG_READER_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+
+#include "block_device.h"                   // Base class for sector storage devices
+#include "log_format.h"                     // Layout of blocks and records in the log
+
+
+/// This value of \c block_num means no block has been loaded.
+const uint32_t LOG_NO_BLOCK = 0xFFFFFFFF;
+
+
+/** This structure describes one record which has been read from the log. The data
+ *  pointer points into the reader's buffer, so it's good only until the next record
+ *  is read.
+ */
+typedef struct
+{
+	uint8_t type;                           ///< What kind of record it is
+	uint8_t size;                           ///< How many bytes of data it has
+	uint32_t time;                          ///< When it was logged, in milliseconds
+	uint32_t block;                         ///< The number of the block it's in
+	const uint8_t* p_data;                  ///< A pointer to the record's data
+}
+log_entry;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class reads records back from a data log on a block device.
+ *  \details The reader checks each block's magic number, CRC, sequence number, and 
+ *  session number. A block spoiled by a power failure is skipped and counted; the 
+ *  first blank block, or the first block from a different session, is taken as the
+ *  end of the log. 
+ *
+ *  To find a time, \c seek_time() does a binary search over the groups of blocks, 
+ *  reading just the first data block of each group it looks at, and then reads the 
+ *  group's index block to go straight to the right data block. If the index block 
+ *  is missing, as it is for the last group of a log, the data blocks' headers are 
+ *  read instead. 
+ *
+ *  \section Usage
+ *  \code
+ *  host_file_device card ("card.img", 2000000);
+ *  log_reader reader (&card, 0);
+ *  log_entry entry;
+ *  card.init ();
+ *  reader.seek_time (60000);                   // Start one minute into the run
+ *  while (reader.next (&entry) && entry.time < 120000)
+ *  {
+ *      ...
+ *  }
+ *  \endcode
+ */
+
+class log_reader
+{
+	protected:
+		/// The device from which the log is read.
+		block_device* p_device;
+
+		/// The sector where the log starts.
+		uint32_t first_sector;
+
+		/// The session number of the log, found in its first block.
+		uint32_t session;
+
+		/// This buffer holds the block being read.
+		uint8_t block[BLOCK_SIZE];
+
+		/// The number of the block in the buffer, or \c LOG_NO_BLOCK.
+		uint32_t block_num;
+
+		/// This flag is true if the block in the buffer is a good data block.
+		bool block_good;
+
+		/// Where the next record starts in the block in the buffer.
+		uint16_t place;
+
+		/// Records logged before this time are skipped after \c seek_time().
+		uint32_t skip_before;
+
+		/// The number of spoiled blocks which have been skipped.
+		uint32_t bad_blocks;
+
+		/// The number of blocks which have been read from the device.
+		uint32_t reads;
+
+		// Read a block into the buffer and check it
+		bool load (uint32_t, uint16_t);
+
+		// Find whether a block is blank, as it is past the end of the log
+		bool is_blank (void);
+
+	public:
+		// The constructor saves the device and where the log starts
+		log_reader (block_device*, uint32_t = 0);
+
+		// Go back to the start of the log
+		bool rewind (void);
+
+		// Go to the first record logged at or after a given time
+		bool seek_time (uint32_t);
+
+		// Read the next record from the log
+		bool next (log_entry*);
+
+		/** This method returns the number of spoiled blocks which have been skipped.
+		 *  @return The count of bad blocks
+		 */
+		uint32_t get_bad_blocks (void)
+		{
+			return (bad_blocks);
+		}
+
+		/** This method returns the number of blocks read from the device, which shows
+		 *  how much work finding and reading records took.
+		 *  @return The count of blocks read
+		 */
+		uint32_t get_reads (void)
+		{
+			return (reads);
+		}
+};
+
+#endif // _LOG_READER_H_
@@ -0,0 +1,501 @@
+//*************************************************************************************
+/** \file sd_spi.cpp
+ *    This file contains a driver for an SD or SDHC card connected to the AVR's SPI 
+ *    port, used as a plain block device of 512-byte sectors.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <util/delay.h>                     // For the delay while the card wakes up
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For vTaskDelay()
+#include "sd_spi.h"                         // Header for this driver
+
+
+// These are the SD card commands used by this driver, in SPI mode
+#define SD_CMD0         0                   ///< GO_IDLE_STATE: reset the card
+#define SD_CMD8         8                   ///< SEND_IF_COND: check the voltage range
+#define SD_CMD9         9                   ///< SEND_CSD: read the card's size and such
+#define SD_CMD16        16                  ///< SET_BLOCKLEN: use 512-byte blocks
+#define SD_CMD17        17                  ///< READ_SINGLE_BLOCK
+#define SD_CMD24        24                  ///< WRITE_BLOCK
+#define SD_CMD55        55                  ///< APP_CMD: next command is an ACMD
+#define SD_CMD58        58                  ///< READ_OCR: find the card's capacity type
+#define SD_ACMD41       41                  ///< SD_SEND_OP_COND: start initialization
+
+#define SD_R1_IDLE      0x01                ///< Response bit: card is in the idle state
+#define SD_R1_ILLEGAL   0x04                ///< Response bit: the command isn't known
+#define SD_START_TOKEN  0xFE                ///< Token which comes before a data block
+#define SD_DATA_OK      0x05                ///< Data response meaning a block was taken
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor saves the location of the card's chip select line and sets up 
+ *  the SPI pins. It doesn't talk to the card; \c init() does that, as it takes a 
+ *  while and should be done by a task.
+ *  @param p_ser_dev A serial device for debugging messages (may be NULL)
+ *  @param p_ddr A pointer to the data direction register for the chip select pin
+ *  @param p_port A pointer to the port register for the chip select pin
+ *  @param mask A bitmask with a one in the bit for the chip select pin
+ *  @param p_irq_reg A pointer to the interrupt mask register of another device which
+ *                   uses the SPI port from an ISR, such as \c EIMSK for the nRF24L01
+ *                   radio, or NULL if there's no such device (default: NULL)
+ *  @param irq_bits A bitmask with a one in the bit for that device's interrupt
+ *                  (default: 0)
+ */
+
+sd_spi::sd_spi (emstream* p_ser_dev, volatile uint8_t* p_ddr, volatile uint8_t* p_port,
+				uint8_t mask, volatile uint8_t* p_irq_reg, uint8_t irq_bits)
+	: block_device ()
+{
+	p_serial = p_ser_dev;
+	p_cs_port = p_port;
+	cs_mask = mask;
+	p_irq_mask_reg = p_irq_reg;
+	irq_mask = irq_bits;
+	saved_irq = 0;
+	spi_stuck = false;
+	block_addressing = false;
+	ready = false;
+
+	// Chip select is an output, high so the card ignores the bus until it's selected
+	*p_ddr |= cs_mask;
+	*p_cs_port |= cs_mask;
+
+	// The AVR's own SS pin must be an output, or the SPI port may drop out of master
+	// mode; MOSI and SCK are outputs and MISO an input
+	SD_DDR_SPI |= SD_MASK_MOSI | SD_MASK_SCK | SD_MASK_SS;
+	SD_DDR_SPI &= ~SD_MASK_MISO;
+	SD_PORT_SPI |= SD_MASK_MISO;
+
+	// The card must be set up with a clock under 400 kHz, so use f_osc / 128 for now
+	card_spcr = (1 << SPE) | (1 << MSTR) | (1 << SPR1) | (1 << SPR0);
+	card_spsr = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method holds off the interrupt of any other device which uses the SPI port 
+ *  from an ISR, saves whatever SPI settings other devices are using, puts in the 
+ *  card's settings, and selects the card.
+ */
+
+void sd_spi::select (void)
+{
+	if (p_irq_mask_reg != NULL)
+	{
+		portENTER_CRITICAL ();
+		saved_irq = *p_irq_mask_reg & irq_mask;
+		*p_irq_mask_reg &= ~irq_mask;
+		portEXIT_CRITICAL ();
+	}
+	spi_stuck = false;
+
+	saved_spcr = SPCR;
+	saved_spsr = SPSR;
+	SPCR = card_spcr;
+	SPSR = card_spsr;
+
+	*p_cs_port &= ~cs_mask;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method deselects the card, clocks out one more byte so the card lets go of 
+ *  the MISO line, and puts back the SPI settings which were there before. Only then
+ *  is the other device's interrupt let through again, so its ISR finds the SPI port
+ *  set up the way it left it.
+ */
+
+void sd_spi::deselect (void)
+{
+	*p_cs_port |= cs_mask;
+	transfer (0xFF);
+
+	SPCR = saved_spcr;
+	SPSR = saved_spsr;
+
+	if (spi_stuck)
+	{
+		errors++;
+		DBG (p_serial, PMS ("SD: SPI stuck") << endl);
+	}
+
+	if (p_irq_mask_reg != NULL)
+	{
+		portENTER_CRITICAL ();
+		*p_irq_mask_reg |= saved_irq;
+		portEXIT_CRITICAL ();
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends one byte through the SPI port and returns the byte which came
+ *  back at the same time. If the byte doesn't finish, as when something else has 
+ *  taken the SPI port out of master mode, the port is taken to be stuck and this and
+ *  the rest of the command's transfers return 0xFF, which the card never sends as a
+ *  response, so the command fails quickly instead of hanging.
+ *  @param data The byte to send; 0xFF is sent when only reading
+ *  @return The byte which the card sent, or 0xFF if the SPI port is stuck
+ */
+
+uint8_t sd_spi::transfer (uint8_t data)
+{
+	if (spi_stuck)
+	{
+		return (0xFF);
+	}
+
+	SPDR = data;
+	for (uint16_t spins = 0; !(SPSR & (1 << SPIF)); spins++)
+	{
+		if (spins >= SD_SPI_SPINS)
+		{
+			spi_stuck = true;
+			return (0xFF);
+		}
+	}
+	return (SPDR);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method waits for the card to stop being busy, which it shows by holding its
+ *  data line low. 
+ *  @return True if the card is ready, false if it stayed busy too long
+ */
+
+bool sd_spi::wait_ready (void)
+{
+	for (uint16_t count = 0; count < SD_WAIT_BYTES; count++)
+	{
+		if (transfer (0xFF) == 0xFF)
+		{
+			return (true);
+		}
+	}
+	return (false);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends a command to the card, which must already be selected, and 
+ *  returns the first byte of the card's response. Only CMD0 and CMD8 need a correct
+ *  CRC in SPI mode, so those two CRC's are put in and a dummy is sent otherwise. 
+ *  @param cmd The command number
+ *  @param arg The 32-bit argument for the command
+ *  @return The card's R1 response; 0xFF means the card didn't answer
+ */
+
+uint8_t sd_spi::command (uint8_t cmd, uint32_t arg)
+{
+	uint8_t response;
+
+	wait_ready ();
+
+	transfer (0x40 | cmd);
+	transfer ((uint8_t)(arg >> 24));
+	transfer ((uint8_t)(arg >> 16));
+	transfer ((uint8_t)(arg >> 8));
+	transfer ((uint8_t)arg);
+	transfer ((cmd == SD_CMD0) ? 0x95 : ((cmd == SD_CMD8) ? 0x87 : 0x01));
+
+	// The response comes within 8 bytes and always has its top bit clear
+	for (uint8_t count = 0; count < 10; count++)
+	{
+		if (!((response = transfer (0xFF)) & 0x80))
+		{
+			break;
+		}
+	}
+	return (response);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends an application-specific command, which is CMD55 followed by the
+ *  command itself.
+ *  @param cmd The application command number, such as 41 for ACMD41
+ *  @param arg The 32-bit argument for the command
+ *  @return The card's R1 response to the application command
+ */
+
+uint8_t sd_spi::app_command (uint8_t cmd, uint32_t arg)
+{
+	command (SD_CMD55, 0);
+	return (command (cmd, arg));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method wakes up the card and puts it into SPI mode. The card is reset, asked
+ *  which version of the SD standard it follows, and told to start up; this can take
+ *  up to a second. Then the SPI clock is sped up to f_osc / 2. 
+ *  @return True if the card is ready for use, false if it couldn't be set up
+ */
+
+bool sd_spi::init (void)
+{
+	uint8_t response;
+	uint8_t ocr[4];
+	bool version_2 = false;
+
+	ready = false;
+	block_addressing = false;
+	card_spcr = (1 << SPE) | (1 << MSTR) | (1 << SPR1) | (1 << SPR0);
+	card_spsr = 0;
+
+	// With chip select high, send at least 74 clocks so the card wakes up
+	select ();
+	*p_cs_port |= cs_mask;
+	for (uint8_t count = 0; count < 10; count++)
+	{
+		transfer (0xFF);
+	}
+	*p_cs_port &= ~cs_mask;
+
+	// Reset the card; with chip select low, this puts it in SPI mode
+	if (command (SD_CMD0, 0) != SD_R1_IDLE)
+	{
+		deselect ();
+		errors++;
+		DBG (p_serial, PMS ("SD: no card") << endl);
+		return (false);
+	}
+
+	// Version 2 cards answer CMD8 and echo the check pattern; older ones don't know it
+	if (!(command (SD_CMD8, 0x000001AA) & SD_R1_ILLEGAL))
+	{
+		for (uint8_t count = 0; count < 4; count++)
+		{
+			ocr[count] = transfer (0xFF);
+		}
+		if (ocr[2] != 0x01 || ocr[3] != 0xAA)
+		{
+			deselect ();
+			errors++;
+			DBG (p_serial, PMS ("SD: bad voltage") << endl);
+			return (false);
+		}
+		version_2 = true;
+	}
+
+	// Tell the card to start up, saying that high capacity cards are OK, until it 
+	// leaves the idle state
+	for (uint16_t tries = 0; ; tries++)
+	{
+		response = app_command (SD_ACMD41, version_2 ? 0x40000000UL : 0);
+		if (response == 0x00)
+		{
+			break;
+		}
+		if (tries >= SD_INIT_TRIES || (response & ~SD_R1_IDLE))
+		{
+			deselect ();
+			errors++;
+			DBG (p_serial, PMS ("SD: init timeout") << endl);
+			return (false);
+		}
+		#ifdef FREERTOS_CONFIG_H
+			deselect ();
+			vTaskDelay (configMS_TO_TICKS (1));
+			select ();
+		#else
+			_delay_ms (1);
+		#endif
+	}
+
+	// A version 2 card says in its OCR register whether it's high capacity
+	if (version_2 && command (SD_CMD58, 0) == 0x00)
+	{
+		for (uint8_t count = 0; count < 4; count++)
+		{
+			ocr[count] = transfer (0xFF);
+		}
+		block_addressing = (ocr[0] & 0x40) ? true : false;
+	}
+
+	// Standard capacity cards must be told to use 512-byte blocks
+	if (!block_addressing && command (SD_CMD16, BLOCK_SIZE) != 0x00)
+	{
+		deselect ();
+		errors++;
+		return (false);
+	}
+	deselect ();
+
+	// The card is running, so the clock can go up to f_osc / 2
+	card_spcr = (1 << SPE) | (1 << MSTR);
+	card_spsr = (1 << SPI2X);
+	ready = true;
+
+	DBG (p_serial, PMS ("SD card ready, high capacity: ") << block_addressing << endl);
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads one sector from the card.
+ *  @param sector The number of the sector, counting from zero
+ *  @param p_buffer A pointer to a buffer of \c BLOCK_SIZE bytes for the data
+ *  @return True if the sector was read, false if not
+ */
+
+bool sd_spi::read_sector (uint32_t sector, uint8_t* p_buffer)
+{
+	if (!ready)
+	{
+		return (false);
+	}
+
+	select ();
+	if (command (SD_CMD17, block_addressing ? sector : sector * BLOCK_SIZE) != 0x00)
+	{
+		deselect ();
+		errors++;
+		return (false);
+	}
+
+	// Wait for the token which means the data is coming
+	uint8_t token = 0xFF;
+	for (uint16_t count = 0; count < SD_WAIT_BYTES && token == 0xFF; count++)
+	{
+		token = transfer (0xFF);
+	}
+	if (token != SD_START_TOKEN)
+	{
+		deselect ();
+		errors++;
+		return (false);
+	}
+
+	for (uint16_t index = 0; index < BLOCK_SIZE; index++)
+	{
+		p_buffer[index] = transfer (0xFF);
+	}
+	transfer (0xFF);                        // Skip the CRC, which isn't checked
+	transfer (0xFF);
+	deselect ();
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method writes one sector to the card. It returns once the card has taken the
+ *  data; the card then writes it into flash memory while the next command waits.
+ *  @param sector The number of the sector, counting from zero
+ *  @param p_buffer A pointer to the \c BLOCK_SIZE bytes to be written
+ *  @return True if the sector was written, false if not
+ */
+
+bool sd_spi::write_sector (uint32_t sector, const uint8_t* p_buffer)
+{
+	if (!ready)
+	{
+		return (false);
+	}
+
+	select ();
+	if (command (SD_CMD24, block_addressing ? sector : sector * BLOCK_SIZE) != 0x00)
+	{
+		deselect ();
+		errors++;
+		return (false);
+	}
+
+	transfer (0xFF);                        // One byte gap before the data
+	transfer (SD_START_TOKEN);
+	for (uint16_t index = 0; index < BLOCK_SIZE; index++)
+	{
+		transfer (p_buffer[index]);
+	}
+	transfer (0xFF);                        // Dummy CRC
+	transfer (0xFF);
+
+	// The card says whether it accepted the data, then stays busy while writing it
+	if ((transfer (0xFF) & 0x1F) != SD_DATA_OK)
+	{
+		deselect ();
+		errors++;
+		return (false);
+	}
+	deselect ();
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the card's CSD register to find how many sectors it holds. The 
+ *  register is laid out differently for standard and high capacity cards.
+ *  @return The number of 512-byte sectors, or 0 if the card couldn't be read
+ */
+
+uint32_t sd_spi::get_sector_count (void)
+{
+	uint8_t csd[16];
+	uint8_t token = 0xFF;
+
+	if (!ready)
+	{
+		return (0);
+	}
+
+	select ();
+	if (command (SD_CMD9, 0) != 0x00)
+	{
+		deselect ();
+		errors++;
+		return (0);
+	}
+	for (uint16_t count = 0; count < SD_WAIT_BYTES && token == 0xFF; count++)
+	{
+		token = transfer (0xFF);
+	}
+	if (token != SD_START_TOKEN)
+	{
+		deselect ();
+		errors++;
+		return (0);
+	}
+	for (uint8_t index = 0; index < 16; index++)
+	{
+		csd[index] = transfer (0xFF);
+	}
+	transfer (0xFF);
+	transfer (0xFF);
+	deselect ();
+
+	// CSD version 2: the size is (C_SIZE + 1) * 512 KB
+	if ((csd[0] >> 6) == 1)
+	{
+		uint32_t c_size = ((uint32_t)(csd[7] & 0x3F) << 16) 
+						  | ((uint16_t)csd[8] << 8) | csd[9];
+		return ((c_size + 1) << 10);
+	}
+
+	// CSD version 1: the size is (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+	uint16_t c_size = ((uint16_t)(csd[6] & 0x03) << 10) | ((uint16_t)csd[7] << 2) 
+					  | (csd[8] >> 6);
+	uint8_t c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+	uint8_t read_bl_len = csd[5] & 0x0F;
+	return ((uint32_t)(c_size + 1) << (c_size_mult + 2 + read_bl_len - 9));
+}
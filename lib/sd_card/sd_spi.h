@@ -0,0 +1,157 @@
+//*************************************************************************************
+/** \file sd_spi.h
+ *    This file contains a driver for an SD or SDHC card connected to the AVR's SPI 
+ *    port. The card is used as a plain block device: sectors are read and written by
+ *    number, with no file system. The SPI port may be shared with other devices such
+ *    as the nRF24L01 radio, as each device has its own chip select line and this 
+ *    driver puts the SPI clock settings back the way it found them after each use.
+ *    The interrupt of a device whose ISR uses the SPI port can be held off while the
+ *    card has the port.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _SD_SPI_H_
+#define _SD_SPI_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+#include <avr/io.h>                         // Port I/O for SFR's
+
+#include "emstream.h"                       // Header for serial ports and devices
+#include "block_device.h"                   // Base class for sector storage devices
+
+
+// These defines give the SPI pins, which are the same on the ATmega128x and ATmega644
+#define SD_PORT_SPI     PORTB               ///< Port which holds the SPI pins
+#define SD_DDR_SPI      DDRB                ///< Data direction register for SPI pins
+#define SD_MASK_MISO    (1 << 3)            ///< Bitmask for the MISO pin
+#define SD_MASK_MOSI    (1 << 2)            ///< Bitmask for the MOSI pin
+#define SD_MASK_SCK     (1 << 1)            ///< Bitmask for the SCK pin
+#define SD_MASK_SS      (1 << 0)            ///< Bitmask for the AVR's own SS pin
+
+/// This is how many times the card is asked to finish starting up before giving up.
+const uint16_t SD_INIT_TRIES = 1000;
+
+/// This is how many bytes are read while waiting for a data token or for busy to end.
+const uint16_t SD_WAIT_BYTES = 50000;
+
+/** This is how many times the SPI port is checked for the end of one byte before it's
+ *  taken to be stuck. A byte takes 1024 CPU cycles at the slowest clock, which is 
+ *  about 200 checks.
+ */
+const uint16_t SD_SPI_SPINS = 1000;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class drives an SD card through the SPI port as a block device.
+ *  \details The card's chip select line can be on any port pin; it's given to the 
+ *  constructor. Call \c init() once, from a task, before reading or writing. Version
+ *  1 cards, version 2 standard capacity cards, and SDHC/SDXC cards are supported; 
+ *  the driver takes care of the different ways they number their sectors. 
+ *
+ *  If another device on the SPI port is used from an interrupt, as the nRF24L01 
+ *  radio is, its interrupt mask register and bit are given to the constructor. That
+ *  interrupt is masked from the start of each card command to the end, so the ISR 
+ *  can't change the SPI settings or drive the bus in the middle; an edge-triggered 
+ *  interrupt which comes meanwhile is kept by the AVR and runs once it's unmasked. 
+ *  The radio's other SPI transfers, made by a task, must not be made while the card
+ *  is in use, so they should be made by the same task as the card's.
+ *
+ *  \section Usage
+ *  \code
+ *  sd_spi* p_card = new sd_spi (&ser_port, &DDRB, &PORTB, (1 << 4), 
+ *                               &EIMSK, (1 << INT0));    // Radio's IRQ on INT0
+ *  ...
+ *  if (p_card->init ()) 
+ *  {
+ *      p_card->write_sector (1000, my_512_bytes);
+ *  }
+ *  \endcode
+ */
+
+class sd_spi : public block_device
+{
+	protected:
+		/// This pointer is used to print debugging messages.
+		emstream* p_serial;
+
+		/// This is the port register for the card's chip select line.
+		volatile uint8_t* p_cs_port;
+
+		/// This is the bitmask for the card's chip select line.
+		uint8_t cs_mask;
+
+		/// This flag is true for SDHC and SDXC cards, which number sectors, not bytes.
+		bool block_addressing;
+
+		/// This flag is set once the card has been successfully set up.
+		bool ready;
+
+		/// These save other devices' SPI settings while the card has the port.
+		uint8_t saved_spcr, saved_spsr;
+
+		/// These hold the SPI settings for the card, slow during setup and fast after.
+		uint8_t card_spcr, card_spsr;
+
+		/// This points to the mask register of another SPI device's interrupt, or NULL.
+		volatile uint8_t* p_irq_mask_reg;
+
+		/// This is the bit for that interrupt in its mask register.
+		uint8_t irq_mask;
+
+		/// This saves whether that interrupt was enabled when the card took the port.
+		uint8_t saved_irq;
+
+		/// This flag is set if the SPI port got stuck during the current command.
+		bool spi_stuck;
+
+		// Take the SPI port and select the card
+		void select (void);
+
+		// Deselect the card and give the SPI port back
+		void deselect (void);
+
+		// Send one byte to the card and return the byte it sends back
+		uint8_t transfer (uint8_t);
+
+		// Wait for the card to finish being busy
+		bool wait_ready (void);
+
+		// Send a command to the card and return its first response byte
+		uint8_t command (uint8_t, uint32_t);
+
+		// Send an application-specific command (CMD55 then the command)
+		uint8_t app_command (uint8_t, uint32_t);
+
+	public:
+		// The constructor saves the chip select pin and sets up the SPI pins
+		sd_spi (emstream*, volatile uint8_t*, volatile uint8_t*, uint8_t, 
+				volatile uint8_t* = NULL, uint8_t = 0);
+
+		// Wake the card up and get it ready to be read and written
+		bool init (void);
+
+		// Read one 512-byte sector
+		bool read_sector (uint32_t, uint8_t*);
+
+		// Write one 512-byte sector
+		bool write_sector (uint32_t, const uint8_t*);
+
+		// Find how many sectors the card holds
+		uint32_t get_sector_count (void);
+};
+
+#endif // _SD_SPI_H_
@@ -0,0 +1,372 @@
+//*************************************************************************************
+/** \file sector_logger.cpp
+ *    This file contains a data logger which saves binary records to a block device 
+ *    through two sector buffers, so the tasks which log data never wait for the 
+ *    device to finish writing. Each block gets a header and CRC, and an index block
+ *    is written after each group of data blocks, as described in log_format.h.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // For memcpy() and memset()
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "task.h"                           // For xTaskGetTickCount()
+#include "sector_logger.h"                  // Header for this class
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor sets up the logger. Both buffers are filled with 0xFF so that the
+ *  unused end of each block reads as empty. The device isn't touched until 
+ *  \c start() is called. 
+ *  @param p_a_device A pointer to the device on which the log is kept
+ *  @param a_first_sector The first sector to be used for the log
+ *  @param a_num_sectors How many sectors may be used, or 0 for the rest of the device
+ */
+
+sector_logger::sector_logger (block_device* p_a_device, uint32_t a_first_sector,
+							  uint32_t a_num_sectors)
+{
+	p_device = p_a_device;
+	first_sector = a_first_sector;
+	num_sectors = a_num_sectors;
+	next_sector = first_sector;
+	end_sector = first_sector;
+	session = 0;
+
+	memset (buffer, LOG_TYPE_EMPTY, sizeof (buffer));
+	filling = 0;
+	fill_count = LOG_DATA_START;
+	fill_start = 0;
+	full_buffer = LOG_NO_BUFFER;
+	running = false;
+	memset (block_times, 0xFF, sizeof (block_times));
+
+	records = 0;
+	dropped = 0;
+	sectors_written = 0;
+	write_errors = 0;
+
+	vSemaphoreCreateBinary (sector_ready);
+	xSemaphoreTake (sector_ready, 0);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method gets the device ready, works out how much space the log may use, and
+ *  starts accepting records. The first block of any log already there is read to 
+ *  find its session number, and this log gets the next one. This may take a while, 
+ *  so it should be called by the logging task rather than in \c main().
+ *  @return True if logging has started, false if the device couldn't be used
+ */
+
+bool sector_logger::start (void)
+{
+	if (!p_device->init ())
+	{
+		return (false);
+	}
+
+	uint32_t device_sectors = p_device->get_sector_count ();
+	if (num_sectors == 0 || first_sector + num_sectors > device_sectors)
+	{
+		end_sector = device_sectors;
+	}
+	else
+	{
+		end_sector = first_sector + num_sectors;
+	}
+	if (first_sector >= end_sector)
+	{
+		return (false);
+	}
+
+	// Nothing is logged until this method finishes, so a buffer can be borrowed
+	if (p_device->read_sector (first_sector, buffer[1]) 
+		&& log_block_ok (buffer[1], LOG_MAGIC_DATA))
+	{
+		session = ((log_block_header*)buffer[1])->session + 1;
+	}
+	memset (buffer[1], LOG_TYPE_EMPTY, BLOCK_SIZE);
+
+	portENTER_CRITICAL ();
+	next_sector = first_sector;
+	running = true;
+	portEXIT_CRITICAL ();
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method stops the logger from taking any more records and writes whatever is
+ *  still in the buffers to the device.
+ */
+
+void sector_logger::stop (void)
+{
+	flush ();
+	while (full_buffer != LOG_NO_BUFFER && service (0))
+	{
+	}
+
+	portENTER_CRITICAL ();
+	running = false;
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method hands the buffer which is being filled over to the writing task and 
+ *  starts filling the other buffer. The parts of the block header which are known
+ *  now are filled in; the writing task does the rest. It must be called from inside
+ *  a critical section.
+ *  @return True if the buffers were swapped, false if the other buffer is still full
+ */
+
+bool sector_logger::close_buffer (void)
+{
+	if (full_buffer != LOG_NO_BUFFER)
+	{
+		return (false);
+	}
+	log_block_header* p_header = (log_block_header*)buffer[filling];
+	p_header->start_time = fill_start;
+	p_header->magic = LOG_MAGIC_DATA;
+	p_header->used = fill_count;
+
+	full_buffer = filling;
+	filling ^= 1;
+	fill_count = LOG_DATA_START;
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts one record into the log, stamped with the time in milliseconds. 
+ *  The record is copied into the buffer being filled; if it doesn't fit, that buffer
+ *  is handed to the writing task first. If the writing task hasn't finished with the
+ *  other buffer yet, the record is dropped, as waiting would stall the task which is
+ *  logging. This method must not be called from an interrupt service routine. 
+ *  @param type A number which says what kind of record this is; not \c LOG_TYPE_EMPTY
+ *  @param p_data A pointer to the record's data
+ *  @param size The number of bytes of data, up to \c LOG_MAX_PAYLOAD
+ *  @return True if the record was saved in a buffer, false if it was dropped
+ */
+
+bool sector_logger::log_record (uint8_t type, const void* p_data, uint8_t size)
+{
+	bool wake_writer = false;
+
+	if (size > LOG_MAX_PAYLOAD || type == LOG_TYPE_EMPTY)
+	{
+		return (false);
+	}
+
+	portENTER_CRITICAL ();
+	if (!running)
+	{
+		portEXIT_CRITICAL ();
+		return (false);
+	}
+	portTickType now = xTaskGetTickCount ();
+
+	// A full block, or one whose first record is too old for this record's time to
+	// fit in its time offset, is closed and the other buffer is used
+	if (fill_count > LOG_DATA_START 
+		&& (fill_count + sizeof (log_record_header) + size > LOG_CRC_PLACE
+			|| now - fill_start > 0xFFFF))
+	{
+		if (!close_buffer ())
+		{
+			dropped++;
+			portEXIT_CRITICAL ();
+			return (false);
+		}
+		wake_writer = true;
+	}
+	if (fill_count == LOG_DATA_START)
+	{
+		fill_start = now;
+	}
+
+	log_record_header* p_record = (log_record_header*)(buffer[filling] + fill_count);
+	p_record->type = type;
+	p_record->size = size;
+	p_record->time_offset = (uint16_t)(now - fill_start);
+	memcpy (p_record + 1, p_data, size);
+	fill_count += sizeof (log_record_header) + size;
+	records++;
+	portEXIT_CRITICAL ();
+
+	if (wake_writer)
+	{
+		xSemaphoreGive (sector_ready);
+	}
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called in the logging task's loop. It waits until a buffer is full,
+ *  writes it to the next sector of the device, and then refills the buffer with 0xFF
+ *  bytes so it's ready to be used again. When a group of data blocks is finished, 
+ *  the group's index block is built in the same buffer and written after it. When the
+ *  space for the log runs out, the logger stops taking records. 
+ *  @param ticks_to_wait The longest time to wait for a full buffer, in RTOS ticks
+ *  @return True if a block was written, false if none was ready or writing failed
+ */
+
+bool sector_logger::service (portTickType ticks_to_wait)
+{
+	if (full_buffer == LOG_NO_BUFFER)
+	{
+		xSemaphoreTake (sector_ready, ticks_to_wait);
+	}
+	if (full_buffer == LOG_NO_BUFFER)
+	{
+		return (false);
+	}
+
+	// Nothing else touches a full buffer, so it's written outside a critical section
+	uint8_t* p_block = buffer[full_buffer];
+	uint8_t place = (next_sector - first_sector) % LOG_GROUP_BLOCKS;
+	block_times[place] = ((log_block_header*)p_block)->start_time;
+	bool written = write_block (p_block);
+
+	if (place == LOG_INDEX_SPAN - 1 && next_sector < end_sector)
+	{
+		written = write_index (p_block) && written;
+	}
+	memset (p_block, LOG_TYPE_EMPTY, BLOCK_SIZE);
+
+	portENTER_CRITICAL ();
+	full_buffer = LOG_NO_BUFFER;
+	if (next_sector >= end_sector)
+	{
+		running = false;
+	}
+	portEXIT_CRITICAL ();
+
+	return (written);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts a block's sequence number and CRC into it and writes it to the 
+ *  next sector. The CRC covers everything but itself, so a block which is only 
+ *  partly written when the power fails will fail its check when read back.
+ *  @param p_block A pointer to the block, whose other header items are filled in
+ *  @return True if the block was written, false if not
+ */
+
+bool sector_logger::write_block (uint8_t* p_block)
+{
+	((log_block_header*)p_block)->sequence = next_sector - first_sector;
+	((log_block_header*)p_block)->session = session;
+
+	uint16_t crc = log_crc (p_block, LOG_CRC_PLACE);
+	p_block[LOG_CRC_PLACE] = (uint8_t)crc;
+	p_block[LOG_CRC_PLACE + 1] = (uint8_t)(crc >> 8);
+
+	bool written = p_device->write_sector (next_sector, p_block);
+
+	portENTER_CRITICAL ();
+	next_sector++;
+	if (written)
+	{
+		sectors_written++;
+	}
+	else
+	{
+		write_errors++;
+	}
+	portEXIT_CRITICAL ();
+
+	return (written);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method builds the index block for the group of data blocks which has just 
+ *  been finished and writes it. The index lists each data block's start time, so a 
+ *  reader can find the block holding a given time by reading the index alone. 
+ *  @param p_block A pointer to a free buffer in which to build the index block
+ *  @return True if the index block was written, false if not
+ */
+
+bool sector_logger::write_index (uint8_t* p_block)
+{
+	log_index_block* p_index = (log_index_block*)p_block;
+
+	memset (p_block, LOG_TYPE_EMPTY, BLOCK_SIZE);
+	p_index->header.start_time = block_times[0];
+	p_index->header.magic = LOG_MAGIC_INDEX;
+	p_index->header.used = sizeof (log_index_block);
+	memcpy (p_index->block_times, block_times, sizeof (block_times));
+	memset (block_times, 0xFF, sizeof (block_times));
+
+	return (write_block (p_block));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method hands a partly filled buffer to the writing task, so the records in it
+ *  get saved even if no more records come along to fill it. The rest of that block 
+ *  is left empty. 
+ */
+
+void sector_logger::flush (void)
+{
+	bool wake_writer = false;
+
+	portENTER_CRITICAL ();
+	if (fill_count > LOG_DATA_START)
+	{
+		wake_writer = close_buffer ();
+	}
+	portEXIT_CRITICAL ();
+
+	if (wake_writer)
+	{
+		xSemaphoreGive (sector_ready);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the logger's counters: records logged and dropped, and sectors
+ *  written, failed, and left. 
+ *  @param ser_dev The serial device on which to print
+ */
+
+void sector_logger::print_status (emstream& ser_dev)
+{
+	uint32_t records_copy, dropped_copy, written_copy, next_copy;
+	uint16_t errors_copy;
+
+	portENTER_CRITICAL ();
+	records_copy = records;
+	dropped_copy = dropped;
+	written_copy = sectors_written;
+	errors_copy = write_errors;
+	next_copy = next_sector;
+	portEXIT_CRITICAL ();
+
+	ser_dev << PMS ("log: ") << records_copy << PMS (" records, ") << dropped_copy
+			<< PMS (" dropped, ") << written_copy << PMS (" sectors, ") << errors_copy
+			<< PMS (" errors, ") << (end_sector - next_copy) << PMS (" left");
+}
@@ -0,0 +1,185 @@
+//*************************************************************************************
+/** \file sector_logger.h
+ *    This file contains a data logger which saves binary records to a block device 
+ *    such as an SD card. Records are packed into one of two 512-byte sector buffers;
+ *    while one buffer is being filled by the tasks which log data, the other is 
+ *    written to the device by a low priority task, so logging never has to wait for 
+ *    the device. The layout of the log is described in log_format.h.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _SECTOR_LOGGER_H_
+#define _SECTOR_LOGGER_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "semphr.h"                         // Header for FreeRTOS semaphores
+#include "emstream.h"                       // Header for serial ports and devices
+#include "block_device.h"                   // Base class for sector storage devices
+#include "log_format.h"                     // Layout of blocks and records in the log
+
+
+/// This is the largest payload one record can hold.
+const uint8_t LOG_MAX_PAYLOAD = 250;
+
+/// This value of \c full_buffer means neither buffer is waiting to be written.
+const uint8_t LOG_NO_BUFFER = 0xFF;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class logs binary records to a block device through two sector buffers.
+ *  \details Each record is a \c log_record_header, which holds the record's type, 
+ *  size, and time, followed by up to \c LOG_MAX_PAYLOAD bytes of data. Records are 
+ *  never split between blocks; when a record won't fit in the rest of the block 
+ *  being filled, or is too long after the block's first record for its time to fit,
+ *  that block is handed to the writing task and the record goes into the other 
+ *  buffer. The unused end of each block holds 0xFF bytes. The writing task puts in 
+ *  each block's sequence number and CRC, and after every \c LOG_INDEX_SPAN data 
+ *  blocks it writes an index block listing their start times. 
+ *
+ *  Any task may call \c log_record(); it copies the record inside a short critical 
+ *  section and never waits for the device. If both buffers are full because the 
+ *  device is slow, the record is dropped and counted instead. One low priority task
+ *  must call \c service() in its loop; it sleeps until a sector is full and then 
+ *  writes it to the device. Sectors are written one after another, starting at the 
+ *  sector given to the constructor, until the end of the space given for logging.
+ *
+ *  \section Usage
+ *  \code
+ *  sector_logger* p_log = new sector_logger (p_card, 0, 0);    // The whole card
+ *  ...
+ *  p_log->start ();                            // In the logging task, then
+ *  for (;;) { p_log->service (1000); }         // loop writing full sectors
+ *  ...
+ *  p_log->log_record (MY_TYPE, &my_data, sizeof (my_data));   // In any task
+ *  \endcode
+ */
+
+class sector_logger
+{
+	protected:
+		/// The device to which sectors are written.
+		block_device* p_device;
+
+		/// The two sector buffers; one is filled while the other is written.
+		uint8_t buffer[2][BLOCK_SIZE];
+
+		/// The index of the buffer being filled.
+		uint8_t filling;
+
+		/// The number of bytes in the buffer being filled, including its header.
+		uint16_t fill_count;
+
+		/// The time at which the first record in the buffer being filled was logged.
+		portTickType fill_start;
+
+		/// The start times of the data blocks in the current group, for its index.
+		uint32_t block_times[LOG_INDEX_SPAN];
+
+		/// The index of a buffer which is full and waiting to be written, if any.
+		uint8_t full_buffer;
+
+		/// The first sector to be used for logging.
+		uint32_t first_sector;
+
+		/// The number of sectors to be used, or 0 to use the rest of the device.
+		uint32_t num_sectors;
+
+		/// The sector to which the next full buffer will be written.
+		uint32_t next_sector;
+
+		/// The sector after the last one which may be used.
+		uint32_t end_sector;
+
+		/// The session number put in every block, one more than the previous log's.
+		uint32_t session;
+
+		/// This flag is true while records are being accepted.
+		bool running;
+
+		/// This semaphore wakes the writing task when a buffer is full.
+		xSemaphoreHandle sector_ready;
+
+		/// The number of records which have been put into buffers.
+		uint32_t records;
+
+		/// The number of records dropped because both buffers were full.
+		uint32_t dropped;
+
+		/// The number of sectors written to the device.
+		uint32_t sectors_written;
+
+		/// The number of sectors which couldn't be written.
+		uint16_t write_errors;
+
+		// Hand the buffer being filled to the writing task; called in a critical section
+		bool close_buffer (void);
+
+		// Put in a block's sequence number and CRC and write it to the device
+		bool write_block (uint8_t*);
+
+		// Build the index block for the group just finished in a buffer and write it
+		bool write_index (uint8_t*);
+
+	public:
+		// The constructor sets up the buffers and the space on the device
+		sector_logger (block_device*, uint32_t, uint32_t);
+
+		// Get the device ready and start accepting records
+		bool start (void);
+
+		// Stop accepting records, then save any which are in the buffers
+		void stop (void);
+
+		// Put one record into the log
+		bool log_record (uint8_t, const void*, uint8_t);
+
+		// Wait for a full buffer and write it to the device
+		bool service (portTickType);
+
+		// Hand a partly filled buffer to the writing task so its records are saved
+		void flush (void);
+
+		/** This method tells whether records are being accepted. 
+		 *  @return True if the logger is running
+		 */
+		bool is_running (void)
+		{
+			return (running);
+		}
+
+		/** This method returns how many records have been dropped because the device
+		 *  couldn't keep up. 
+		 *  @return The number of dropped records
+		 */
+		uint32_t get_dropped (void)
+		{
+			uint32_t a_copy;
+
+			portENTER_CRITICAL ();
+			a_copy = dropped;
+			portEXIT_CRITICAL ();
+
+			return (a_copy);
+		}
+
+		// Print the logger's counters
+		void print_status (emstream&);
+};
+
+#endif // _SECTOR_LOGGER_H_
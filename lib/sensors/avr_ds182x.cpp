@@ -227,22 +227,120 @@ int16_t avr_ds182x::temperature (void)
 
 int16_t avr_ds182x::celsius (void)
 {
-	// Get a binary temperature reading
-	int16_t temptemp;
-	temptemp = temperature ();
+	return (raw_to_celsius (temperature ()));
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method converts a raw reading, as returned by \c temperature() or 
+ *  \c read_conversion(), into an integer which contains the temperature in degrees 
+ *  Celsius times ten. 
+ *  @param raw_data The raw temperature data from the sensor's scratchpad
+ *  @return The temperature in tenths of a degree Celsius
+ */
 
+int16_t avr_ds182x::raw_to_celsius (int16_t raw_data)
+{
 	// Convert it into Celsius degrees, with a resolution of about half a degree
-	if (temptemp > -100)
+	if (raw_data > -100)
 	{
 		// If this is a DS1822, shift 3 bits of resolution-not-accuracy stuff out
 		if (type_ID == 0x22)
 		{
-			temptemp >>= 3;
+			raw_data >>= 3;
 		}
-		temptemp *= 5;
+		raw_data *= 5;
 	}
 
-	return (temptemp);
+	return (raw_data);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method tells the DS182X to begin a temperature conversion, then returns 
+ *  without waiting for the conversion to finish. The caller should check 
+ *  \c conversion_done() every so often and call \c read_conversion() when it returns
+ *  true. 
+ *  @return True if the sensor answered the reset pulse, false if it didn't
+ */
+
+bool avr_ds182x::start_conversion (void)
+{
+	if (!(the_bus->reset ()))               // Begin with a reset pulse, making sure
+	{                                       // a presence pulse comes back from device
+		return (false);
+	}
+
+	if (ID_index != 0xFF)                   // If the device ID number is valid,
+	{                                       // this device must be selected
+		the_bus->match_ROM (ID_index);
+	}
+	else                                    // If this is the only device on the bus,
+	{                                       // skip ROM selection command
+		the_bus->write_byte (0xCC);
+	}
+
+	the_bus->write_byte (0x44);             // Send the convert temperature code
+
+	return (true);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method checks whether a conversion begun by \c start_conversion() has 
+ *  finished. While converting, the DS182X answers read slots with zeros; it answers 
+ *  with a one when the conversion is done. 
+ *  @return True if the conversion is finished, false if it's still going
+ */
+
+bool avr_ds182x::conversion_done (void)
+{
+	return (the_bus->read_bit ());
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method reads the result of a finished conversion from the "scratchpad" memory
+ *  in the DS182X. The result is checked against the same range of reasonable values 
+ *  used by \c temperature(), but no retry is done; the caller can just start another
+ *  conversion. 
+ *  @param p_raw A pointer to the place where the raw 16-bit reading will be put
+ *  @return True if the reading looks valid, false if something's amiss
+ */
+
+bool avr_ds182x::read_conversion (int16_t* p_raw)
+{
+	union                                   // Union holds integer to be returned
+	{
+		int16_t word;                       // The whole 16 bits
+		uint8_t bytes[2];                   // Array of two eight-bit parts
+	} data;
+
+	if (!(the_bus->reset ()))               // The sensor has to answer a reset before
+	{                                       // it will send out its scratchpad
+		return (false);
+	}
+
+	if (ID_index != 0xFF)                   // Do another match ROM command
+	{
+		the_bus->match_ROM (ID_index);
+	}
+	else
+	{
+		the_bus->write_byte (0xCC);
+	}
+
+	the_bus->write_byte (0xBE);             // Read scratchpad command
+	the_bus->read_byte (&data.bytes[0]);    // Get the first byte out
+	the_bus->read_byte (&data.bytes[1]);    // Get the second byte
+
+	if (!(the_bus->reset ()))               // And another reset pulse
+	{
+		return (false);
+	}
+
+	*p_raw = data.word;
+	return ((data.word >= -80) && (data.word <= 260));
 }
 
 
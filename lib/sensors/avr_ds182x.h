@@ -105,6 +105,11 @@ const uint8_t DS182X_MAX_TOUT = 3;
  *  \code
  *  *p_serial << "The temperature is: " << *my_ds182x << endl;
  *  \endcode
+ *  Because a conversion takes up to 3/4 of a second, \c temperature() spends a long 
+ *  time waiting. A task which has other things to do can instead call 
+ *  \c start_conversion(), then check \c conversion_done() now and then, and finally 
+ *  get the result with \c read_conversion(); each of these calls takes only as long
+ *  as a few bytes' worth of 1-wire bus traffic. 
  */
 
 class avr_ds182x
@@ -125,6 +130,12 @@ class avr_ds182x
 		int16_t temperature (void);         // Reads raw temperature data
 		int16_t fahrenheit (void);          // Returns temperature in 0.1 deg F
 		int16_t celsius (void);             // Returns temperature in 0.1 deg C
+
+		// These methods run a conversion in steps so that the caller needn't block
+		bool start_conversion (void);       // Tell the sensor to begin converting
+		bool conversion_done (void);        // Check if the conversion has finished
+		bool read_conversion (int16_t*);    // Read the raw result of a conversion
+		int16_t raw_to_celsius (int16_t);   // Convert raw data to 0.1 deg C
 };
 
 // This operator conveniently prints the temperature found by a DS182X sensor
@@ -318,7 +318,20 @@ int16_t avr_sht15::fahrenheit (void)
 
 int16_t avr_sht15::celsius (void)
 {
-	return ((int16_t)(temperature () / 10) - 400);
+	return (raw_to_celsius (temperature ()));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method converts a raw temperature reading, as returned by \c temperature() or
+ *  \c read_measurement(), into degrees Celsius times ten. 
+ *  @param raw_data The 14-bit raw temperature reading from the sensor
+ *  @return The temperature in tenths of a degree Celsius (so 253 is 25.3 degrees)
+ */
+
+int16_t avr_sht15::raw_to_celsius (uint16_t raw_data)
+{
+	return ((int16_t)(raw_data / 10) - 400);
 }
 
 
@@ -339,7 +352,6 @@ uint8_t avr_sht15::humidity (void)
 
 // 	uint8_t bytes[2];                       // Bytes read in from the sensor
 // 	int32_t raw;                            // Raw reading from RH sensor
-	uint32_t rel_humid;                     // Humidity converted from raw data
 
 	start ();                               // Send transmission start code
 	write (0x05);                           // Send the "measure humidity" code
@@ -362,9 +374,25 @@ uint8_t avr_sht15::humidity (void)
 
 // 	raw = (int32_t)(((uint16_t)(bytes[0]) << 8) | bytes[1]);
 
+	return (raw_to_humidity (raw_data.all));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method converts a raw humidity reading, as returned by \c read_measurement(),
+ *  into a corrected relative humidity in percent.
+ *  @param raw_data The 12-bit raw humidity reading from the sensor
+ *  @return The relative humidity in percent
+ */
+
+uint8_t avr_sht15::raw_to_humidity (uint16_t raw_data)
+{
+	uint32_t raw = raw_data;                // Use 32 bits to do the math without 
+	uint32_t rel_humid;                     // risk of overflow
+
 	// Formula: RH = 0.0405 * raw - 2.8E-6 * raw^2 - 4
-	rel_humid = raw_data.all * 405 / 10000;
-	rel_humid -= raw_data.all * raw_data.all * 28 / 10000000L;
+	rel_humid = raw * 405 / 10000;
+	rel_humid -= raw * raw * 28 / 10000000L;
 	rel_humid -= 4;
 
 	if (rel_humid > 99)
@@ -376,6 +404,62 @@ uint8_t avr_sht15::humidity (void)
 }
 
 
+//-------------------------------------------------------------------------------------
+/** This method tells the SHT15 to begin measuring temperature, then returns without
+ *  waiting for the measurement, which can take up to 320 ms at 14 bits resolution. 
+ *  The caller should check \c measurement_ready() every so often and call 
+ *  \c read_measurement() when it returns true. 
+ */
+
+void avr_sht15::start_temperature (void)
+{
+	start ();                               // Send transmission start code
+	write (0x03);                           // Send the "measure temperature" code
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method tells the SHT15 to begin measuring humidity, then returns without
+ *  waiting for the measurement to finish. 
+ */
+
+void avr_sht15::start_humidity (void)
+{
+	start ();                               // Send transmission start code
+	write (0x05);                           // Send the "measure humidity" code
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether a measurement begun by \c start_temperature() or 
+ *  \c start_humidity() has finished. The sensor signals completion by pulling the 
+ *  data line low. 
+ *  @return True if the measurement is ready to be read, false if not
+ */
+
+bool avr_sht15::measurement_ready (void)
+{
+	return ((ATWI_INPORT & ATWI_DATA_MASK) == 0);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the raw result of a finished measurement from the SHT15. 
+ *  @return The raw 16-bit measurement, to be converted with \c raw_to_celsius() or
+ *          \c raw_to_humidity()
+ */
+
+uint16_t avr_sht15::read_measurement (void)
+{
+	uint16_t raw_data;
+
+	raw_data = (uint16_t)read (true) << 8;  // The MSB comes first (true = send ACK)
+	raw_data |= read (false);               // then the LSB (false = don't send ACK)
+
+	return (raw_data);
+}
+
+
 //-------------------------------------------------------------------------------------
 /** \cond NO_DOXY This simple function finds a number's absolute value. It's here as
  *  a quick, easy solution for the "<<" operator below.
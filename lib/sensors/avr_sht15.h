@@ -179,6 +179,14 @@ class avr_sht15
 		int16_t fahrenheit (void);          // Returns temperature in 0.1 deg F
 		int16_t celsius (void);             // Returns temperature in 0.1 deg C
 		uint8_t humidity (void);            // Returns relative humidity in percent
+
+		// These methods run a measurement in steps so that the caller needn't block
+		void start_temperature (void);      // Tell the sensor to measure temperature
+		void start_humidity (void);         // Tell the sensor to measure humidity
+		bool measurement_ready (void);      // Check if the measurement is finished
+		uint16_t read_measurement (void);   // Read the raw result of a measurement
+		int16_t raw_to_celsius (uint16_t);  // Convert raw temperature to 0.1 deg C
+		uint8_t raw_to_humidity (uint16_t); // Convert raw humidity to percent
 };
 
 // This operator "prints" a SHT15 sensor by showing its current measured outputs
@@ -49,6 +49,13 @@ const uint8_t HMC6352_READ_ADDRESS = 0x43;
 hmc6352::hmc6352 (emstream* p_debug_port)
 	: i2c_master (p_debug_port)
 {
+	continuous = false;
+	rate_code = HMC6352_RATE_1HZ;
+	sample_index = 0;
+	num_samples = 0;
+	filtered_heading = 0;
+	read_errors = 0;
+
 	DBG (p_serial, PMS ("HMC6352 constructor") << endl);
 }
 
@@ -86,15 +93,153 @@ void hmc6352::set_mode (uint8_t mode_byte)
 
 	// Send a stop condition
 	stop ();
+
+	// Keep track of the operational mode and rate, and start the filter over
+	continuous = ((mode_byte & 0b00000011) == 0b00000010);
+	rate_code = (mode_byte >> 5) & 0b00000011;
+	sample_index = 0;
+	num_samples = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method reads the two bytes of the HMC6352's output register. In continuous 
+ *  mode the register always holds the most recent measurement, so no 'A' command and
+ *  no waiting are needed; the whole transaction takes well under a millisecond. 
+ *  @param p_result A pointer to the place where the heading is to be put
+ *  @return True if the sensor answered properly, false if there was a bus error
+ */
+
+bool hmc6352::read_output (uint16_t* p_result)
+{
+	uint8_t high_byte;                      // The first byte read is the MSB
+
+	start ();                               // Send an I2C start condition
+	if (!send (HMC6352_READ_ADDRESS, 0x40)) // Send the read address; if the sensor
+	{                                       // doesn't answer, give up
+		stop ();
+		return (false);
+	}
+	high_byte = receive (true);             // Read the first byte (true = send ACK)
+	*p_result = ((uint16_t)high_byte << 8)  // Read the second byte (false = NACK)
+				| receive (false);
+	stop ();                                // Cause an I2C stop condition
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finds the average of the headings in the filter buffer. A plain average
+ *  won't work near north, where readings of 3599 and 0 would average to about 180 
+ *  degrees; so each reading's difference from the newest reading is folded into the 
+ *  range -1800 to +1799 before the differences are averaged, and the result is then
+ *  folded back into the range 0 to 3599. 
+ *  @return The average heading in tenths of a degree
+ */
+
+uint16_t hmc6352::average_heading (void)
+{
+	// The newest sample is the one just before the write index
+	uint8_t newest = (sample_index == 0) ? (HMC6352_AVG_SAMPLES - 1) 
+										 : (sample_index - 1);
+	int16_t reference = samples[newest];
+	int16_t sum_of_diffs = 0;
+
+	for (uint8_t index = 0; index < num_samples; index++)
+	{
+		int16_t diff = (int16_t)samples[index] - reference;
+		if (diff >= HMC6352_FULL_CIRCLE / 2)
+		{
+			diff -= HMC6352_FULL_CIRCLE;
+		}
+		else if (diff < -HMC6352_FULL_CIRCLE / 2)
+		{
+			diff += HMC6352_FULL_CIRCLE;
+		}
+		sum_of_diffs += diff;
+	}
+
+	int16_t average = reference + sum_of_diffs / (int16_t)num_samples;
+	if (average < 0)
+	{
+		average += HMC6352_FULL_CIRCLE;
+	}
+	else if (average >= HMC6352_FULL_CIRCLE)
+	{
+		average -= HMC6352_FULL_CIRCLE;
+	}
+
+	return ((uint16_t)average);
 }
 
 
 //-------------------------------------------------------------------------------------
-/** This method gets a heading from the HMC6352 compass. It assumes that the sensor is
- *  in standby mode; this means that it is necessary to send an "A" command, then wait
- *  until the sensor has measured and computed its heading, then read the heading. All
- *  this means that the \c heading() method takes quite some time to run. 
- *  @return The measured heading, in tenths of a degree of angle...eventually
+/** This method reads a new heading from the HMC6352's output register, puts it into 
+ *  the averaging filter, and saves the filtered heading with a time stamp so that 
+ *  other tasks can get it quickly with \c cached_heading(). It should be called by
+ *  one task, about once every \c get_update_period_ms() milliseconds, while the 
+ *  compass is in continuous mode. If the compass isn't in continuous mode, a heading
+ *  is measured the slow way with \c heading() instead. 
+ *  @return True if a new heading was read, false if there was a bus error
+ */
+
+bool hmc6352::update (void)
+{
+	uint16_t new_reading;
+
+	if (continuous)
+	{
+		if (!read_output (&new_reading))
+		{
+			read_errors++;
+			return (false);
+		}
+	}
+	else
+	{
+		new_reading = heading ();
+	}
+
+	// Readings outside the range of a circle mean something went wrong on the bus
+	if (new_reading >= (uint16_t)HMC6352_FULL_CIRCLE)
+	{
+		read_errors++;
+		return (false);
+	}
+
+	samples[sample_index] = new_reading;
+	if (++sample_index >= HMC6352_AVG_SAMPLES)
+	{
+		sample_index = 0;
+	}
+	if (num_samples < HMC6352_AVG_SAMPLES)
+	{
+		num_samples++;
+	}
+
+	uint16_t new_heading = average_heading ();
+	time_stamp now;
+	now.set_to_now ();
+
+	// Other tasks read the cache, so it's changed only inside a critical section
+	portENTER_CRITICAL ();
+	filtered_heading = new_heading;
+	heading_time = now;
+	portEXIT_CRITICAL ();
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method gets a heading from the HMC6352 compass. If the sensor is in standby 
+ *  mode, it is necessary to send an "A" command, then wait until the sensor has 
+ *  measured and computed its heading, then read the heading. All this means that the 
+ *  \c heading() method takes quite some time to run. In continuous mode the output 
+ *  register is just read, which is much quicker. 
+ *  @return The measured heading, in tenths of a degree of angle...eventually; in 
+ *          continuous mode, \c HMC6352_FULL_CIRCLE if the output couldn't be read
  */
 
 uint16_t hmc6352::heading (void)
@@ -106,6 +251,21 @@ uint16_t hmc6352::heading (void)
 	}
 	raw_data;
 
+	// In continuous mode there's a fresh measurement waiting in the output register
+	if (continuous)
+	{
+		uint16_t a_reading;
+
+		// A reading of 0 is north, so a failed read must give an impossible heading
+		if (!read_output (&a_reading))
+		{
+			return ((uint16_t)HMC6352_FULL_CIRCLE);
+		}
+		return (a_reading);
+	}
+
+	raw_data.word = 0;                      // Clear the bytes we won't be reading
+
 	start ();                               // Send an I2C start condition
 	send (HMC6352_WRITE_ADDRESS, 0x18);     // Now send the write address thingy
 	send ('A', 0x28);                       // Send an 'A' (read a heading) command
@@ -127,10 +287,10 @@ uint16_t hmc6352::heading (void)
 //-------------------------------------------------------------------------------------
 /** This overloaded operator writes information about the status of an HMC6352 sensor 
  *  to the serial port. The printout shows the current heading as text, with the 
- *  integer part of the heading, a decimal point, and the fractional part. It is 
- *  assumed that the sensor is in standby mode, so the "A" command is sent to the 
- *  sensor, then the driver waits for the sensor to compute and make available the 
- *  heading. This process means that this \c << operator is quite slow to run. 
+ *  integer part of the heading, a decimal point, and the fractional part. If the 
+ *  sensor is in standby mode, the "A" command is sent to the sensor, then the driver 
+ *  waits for the sensor to compute and make available the heading; this process means
+ *  that this \c << operator is quite slow to run. In continuous mode it's quick. 
  *  @param ser_dev A reference to the serial device on which we're writing information
  *  @param sensor A reference to the sensor object whose status is being written
  *  @return A reference to the same serial device on which we write information.
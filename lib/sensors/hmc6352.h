@@ -26,8 +26,36 @@
 #define _HMC6352_H_
 
 #include <stdlib.h>                         // Standard C/C++ library stuff
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
 #include "i2c_master.h"                     // Header for I2C (AKA TWI) bus driver
 #include "emstream.h"                       // Header for base serial devices
+#include "time_stamp.h"                     // Time stamps for cached headings
+
+
+/** This is the number of heading samples which are averaged together by the filter 
+ *  used in continuous mode. More samples mean a smoother heading but a slower response
+ *  to real changes in direction; at the 20 Hz output rate, 4 samples span 0.2 s.
+ */
+const uint8_t HMC6352_AVG_SAMPLES = 4;
+
+/** This is the number of tenths of a degree in a full circle. Headings from the sensor
+ *  run from 0 to 3599, and averaging must take the wrap from 3599 to 0 into account.
+ */
+const int16_t HMC6352_FULL_CIRCLE = 3600;
+
+
+/** This enumeration holds the measurement rates which can be used in continuous mode.
+ *  The values are the codes put in bits 5 and 6 of the HMC6352's operational mode 
+ *  control byte. 
+ */
+typedef enum
+{
+	HMC6352_RATE_1HZ = 0,                   ///< One measurement per second (default)
+	HMC6352_RATE_5HZ = 1,                   ///< Five measurements per second
+	HMC6352_RATE_10HZ = 2,                  ///< Ten measurements per second
+	HMC6352_RATE_20HZ = 3                   ///< Twenty measurements per second
+}
+hmc6352_rate;
 
 
 //-------------------------------------------------------------------------------------
@@ -46,11 +74,57 @@
  *  ...
  *  *p_serial << PMS ("HMC6352: ") << p_honey->get_heading () << endl;
  *  \endcode
+ * 
+ *  In continuous mode, one task owns the compass and calls \c update() once per 
+ *  output period; \c update() reads the output register (no 'A' command, no 6 ms 
+ *  wait), runs the new reading through a small averaging filter, and caches the 
+ *  result with a time stamp. Any other task can then call \c cached_heading(), which
+ *  doesn't touch the I2C bus at all: 
+ *  \code
+ *  p_honey->continuous_mode (HMC6352_RATE_20HZ);
+ *  ...
+ *  for (;;)                            // In the task which owns the compass
+ *  {
+ *      p_honey->update ();
+ *      delay_from_to_ms (previousTicks, p_honey->get_update_period_ms ());
+ *  }
+ *  ...
+ *  uint16_t where_am_i = p_honey->cached_heading ();    // In any other task
+ *  \endcode
  */
 
 class hmc6352 : public i2c_master
 {
 protected:
+	/// This flag is true when the compass has been put into continuous mode.
+	bool continuous;
+
+	/// This is the continuous mode measurement rate code, from 0 (1 Hz) to 3 (20 Hz).
+	uint8_t rate_code;
+
+	/// This array holds the most recent raw headings for the averaging filter.
+	uint16_t samples[HMC6352_AVG_SAMPLES];
+
+	/// This is the index in \c samples[] where the next reading will be written.
+	uint8_t sample_index;
+
+	/// This is the number of valid readings in \c samples[], up to the array size.
+	uint8_t num_samples;
+
+	/// This is the filtered heading computed by the most recent call to \c update().
+	uint16_t filtered_heading;
+
+	/// This time stamp holds the time at which the cached heading was measured.
+	time_stamp heading_time;
+
+	/// This counts readings which couldn't be gotten because of I2C bus errors.
+	uint16_t read_errors;
+
+	// This method reads the 16-bit output register without sending an 'A' command
+	bool read_output (uint16_t*);
+
+	// This method finds the average of the headings in the filter buffer
+	uint16_t average_heading (void);
 
 public:
 	// This constructor sets up the driver
@@ -61,16 +135,20 @@ public:
 	// This method reads the current heading
 	uint16_t heading (void);
 
-	/** This method puts the HMC6352 in continuous mode, which means that once per
-	 *  second, the compass takes a reading and updates its output register. The
+	// This method reads a new heading in continuous mode and updates the cache
+	bool update (void);
+
+	/** This method puts the HMC6352 in continuous mode, which means that at the given 
+	 *  rate, the compass takes a reading and updates its output register. The
 	 *  heading can then be read quickly, as it will be 16 bits just waiting to be
 	 *  read. The mode is not stored in EEPROM, so unless a command to store the
 	 *  mode is called elsewhere, the mode will be reset to standby mode when the 
 	 *  power is next turned off and on. 
+	 *  @param rate The measurement rate to use (default: \c HMC6352_RATE_1HZ)
 	 */
-	void continuous_mode (void)
+	void continuous_mode (hmc6352_rate rate = HMC6352_RATE_1HZ)
 	{
-		set_mode (0x12);
+		set_mode (0x12 | ((uint8_t)rate << 5));
 	}
 
 	/** This method puts the HMC6352 in standby mode, where it's pretty much asleep.
@@ -86,6 +164,73 @@ public:
 	 *  unless saved in EEPROM elsewhere.
 	 */
 	void set_mode (uint8_t);
+
+	/** This method returns the filtered heading which was cached by the most recent
+	 *  call to \c update(). It doesn't use the I2C bus, so it's quick enough to call
+	 *  from any task as often as one likes. 
+	 *  @return The filtered heading in tenths of a degree, from 0 to 3599
+	 */
+	uint16_t cached_heading (void)
+	{
+		uint16_t a_copy;
+
+		portENTER_CRITICAL ();
+		a_copy = filtered_heading;
+		portEXIT_CRITICAL ();
+
+		return (a_copy);
+	}
+
+	/** This method returns the time at which the cached heading was measured, so that
+	 *  users of the heading can tell how old it is. 
+	 *  @return A time stamp holding the time of the most recent successful update
+	 */
+	time_stamp cache_time (void)
+	{
+		time_stamp a_copy;
+
+		portENTER_CRITICAL ();
+		a_copy = heading_time;
+		portEXIT_CRITICAL ();
+
+		return (a_copy);
+	}
+
+	/** This method returns the time between measurements in continuous mode. The task
+	 *  which owns the compass should call \c update() about this often; calling it 
+	 *  more often just reads the same measurement again. 
+	 *  @return The measurement period in milliseconds
+	 */
+	uint16_t get_update_period_ms (void)
+	{
+		switch (rate_code)
+		{
+			case HMC6352_RATE_5HZ:
+				return (200);
+			case HMC6352_RATE_10HZ:
+				return (100);
+			case HMC6352_RATE_20HZ:
+				return (50);
+			default:
+				return (1000);
+		}
+	}
+
+	/** This method returns the number of times \c update() failed to read the sensor.
+	 *  @return The number of failed reads since the driver was created
+	 */
+	uint16_t get_read_errors (void)
+	{
+		return (read_errors);
+	}
+
+	/** This method tells whether the compass has been put into continuous mode.
+	 *  @return True if the compass is measuring continuously, false if not
+	 */
+	bool is_continuous (void)
+	{
+		return (continuous);
+	}
 };
 
 // This operator "prints" a SHT15 sensor by showing its current measured outputs
@@ -0,0 +1,237 @@
+//*************************************************************************************
+/** \file ansi_dashboard.cpp
+ *    This file contains a class which keeps a screen full of numbers up to date on an
+ *    ANSI terminal, printing only the numbers which have changed.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>                         // For ltoa()
+#include <string.h>                         // For strlen()
+
+#include "ansi_terminal.h"                  // Escape codes which move the cursor
+#include "ansi_dashboard.h"                 // Header for this file
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a dashboard with room for a given number of fields. Nothing
+ *  is printed until the dashboard is first painted. If there's no memory for the 
+ *  fields, the dashboard has room for none; \c is_ready() tells whether it worked.
+ *  @param p_ser_dev The terminal on which the dashboard is shown
+ *  @param how_many The largest number of fields; fields beyond this aren't shown
+ */
+
+ansi_dashboard::ansi_dashboard (emstream* p_ser_dev, uint8_t how_many)
+{
+	p_term = p_ser_dev;
+	fields = new dash_field[how_many];
+	max_fields = (fields != NULL) ? how_many : 0;
+	num_fields = 0;
+	redraw_needed = true;
+	drawing = false;
+	cursor_saved = false;
+	bottom_row = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method asks for the whole screen to be cleared and drawn the next time the
+ *  dashboard is painted, as when the dashboard is shown again after being stopped.
+ */
+
+void ansi_dashboard::redraw (void)
+{
+	redraw_needed = true;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method starts painting the dashboard. If the whole screen is to be drawn, the
+ *  screen is cleared and every field is forgotten, so each is printed again.
+ */
+
+void ansi_dashboard::begin (void)
+{
+	drawing = redraw_needed;
+	cursor_saved = false;
+
+	if (drawing)
+	{
+		num_fields = 0;
+		bottom_row = 0;
+		*p_term << ATERM_SCROLL_ALL << ATERM_RESET_SCREEN;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method moves the cursor to a place on the dashboard. During an update, the
+ *  cursor's place in the scrolling part of the screen is saved first, so \c end()
+ *  can put it back; this is only done if something is printed at all.
+ *  @param row The screen row, 1 at the top
+ *  @param column The screen column, 1 at the left
+ */
+
+void ansi_dashboard::move_to (uint8_t row, uint8_t column)
+{
+	if (!drawing && !cursor_saved)
+	{
+		*p_term << ATERM_SAVE_CURSOR;
+		cursor_saved = true;
+	}
+	*p_term << ATERM_CURSOR_TO_YX (row, column);
+
+	if (row > bottom_row)
+	{
+		bottom_row = row;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a label which is kept in program (flash) memory. It's printed
+ *  only when the whole screen is being drawn.
+ *  @param row The screen row, 1 at the top
+ *  @param column The screen column at which the label starts
+ *  @param p_text The label, as made with \c PSTR()
+ */
+
+void ansi_dashboard::label_P (uint8_t row, uint8_t column, const char* p_text)
+{
+	if (drawing)
+	{
+		move_to (row, column);
+		*p_term << _p_str << p_text;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a label which is kept in RAM, such as a task's name. It's
+ *  printed only when the whole screen is being drawn.
+ *  @param row The screen row, 1 at the top
+ *  @param column The screen column at which the label starts
+ *  @param p_text The label
+ */
+
+void ansi_dashboard::label (uint8_t row, uint8_t column, const char* p_text)
+{
+	if (drawing)
+	{
+		move_to (row, column);
+		*p_term << p_text;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a number at its place on the screen, unless the same number is
+ *  already there. The number is right justified in its field; if it doesn't fit, the
+ *  field is filled with stars.
+ *  @param row The screen row, 1 at the top
+ *  @param column The column of the field's left end
+ *  @param width The number of columns in the field
+ *  @param value The number to be shown
+ */
+
+void ansi_dashboard::show (uint8_t row, uint8_t column, uint8_t width, int32_t value)
+{
+	dash_field* p_field = NULL;
+
+	for (uint8_t index = 0; index < num_fields; index++)
+	{
+		if (fields[index].row == row && fields[index].column == column)
+		{
+			p_field = &fields[index];
+			break;
+		}
+	}
+
+	if (p_field == NULL)
+	{
+		// A field which doesn't fit in the table couldn't be kept up to date
+		if (num_fields >= max_fields)
+		{
+			return;
+		}
+		p_field = &fields[num_fields++];
+		p_field->row = row;
+		p_field->column = column;
+	}
+	else if (p_field->value == value && p_field->width == width)
+	{
+		return;
+	}
+	p_field->width = width;
+	p_field->value = value;
+
+	char digits[12];
+	ltoa (value, digits, 10);
+	uint8_t length = strlen (digits);
+
+	move_to (row, column);
+	for (uint8_t count = length; count < width; count++)
+	{
+		p_term->putchar (' ');
+	}
+	if (length <= width)
+	{
+		*p_term << digits;
+	}
+	else
+	{
+		for (uint8_t count = 0; count < width; count++)
+		{
+			p_term->putchar ('*');
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finishes painting the dashboard. After the whole screen has been
+ *  drawn, the lines below the dashboard are made to scroll by themselves and the
+ *  cursor is left at the top of them; after an update, the cursor is put back where
+ *  it was before the update.
+ */
+
+void ansi_dashboard::end (void)
+{
+	if (drawing)
+	{
+		*p_term << ATERM_SCROLL_BELOW (bottom_row + 2)
+				<< ATERM_CURSOR_TO_YX (bottom_row + 2, 1);
+		redraw_needed = false;
+		drawing = false;
+	}
+	else if (cursor_saved)
+	{
+		*p_term << ATERM_RESTORE_CURSOR;
+		cursor_saved = false;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts the terminal back the way it was before the dashboard was shown:
+ *  the whole screen scrolls again and it's cleared. The dashboard will be drawn in
+ *  full if it's painted again.
+ */
+
+void ansi_dashboard::stop (void)
+{
+	*p_term << ATERM_SCROLL_ALL << ATERM_RESET_SCREEN;
+	redraw_needed = true;
+}
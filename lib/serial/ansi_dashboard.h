@@ -0,0 +1,145 @@
+//*************************************************************************************
+/** \file ansi_dashboard.h
+ *    This file contains a class which keeps a screen full of numbers up to date on an
+ *    ANSI terminal. The layout is drawn once; after that, only the numbers which have
+ *    changed are printed, each at its own place on the screen, so a live display
+ *    costs a few characters per second instead of a whole table each time.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _ANSI_DASHBOARD_H_
+#define _ANSI_DASHBOARD_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+#include "emstream.h"                       // Header for serial device base class
+
+
+//-------------------------------------------------------------------------------------
+/** This structure holds one number on the dashboard: where it goes on the screen and
+ *  the value which was last printed there.
+ */
+
+typedef struct
+{
+	uint8_t row;                            ///< The screen row, 1 at the top
+	uint8_t column;                         ///< The column of the field's left end
+	uint8_t width;                          ///< How many columns the number fills
+	int32_t value;                          ///< The value which is on the screen
+}
+dash_field;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class draws a live display of numbers on an ANSI terminal, printing
+ *  each number again only when it has changed.
+ *  \details The display is painted by one method of the program which calls
+ *  \c begin(), then \c label() and \c show() for everything on the screen, then
+ *  \c end(). The same method is called for the first drawing and for every update.
+ *  Labels are printed only when the whole screen is being drawn; numbers are
+ *  printed when they're new or when they differ from what's on the screen. Each
+ *  field is found by its row and column, so the painting method needn't keep track
+ *  of any field numbers.
+ *
+ *  Below the dashboard, the rest of the screen scrolls as usual, so the user
+ *  interface and other tasks can go on printing there. The cursor is put back where
+ *  it was after each update.
+ *  \code
+ *  ansi_dashboard* p_dash = new ansi_dashboard (p_serial, 40);
+ *  ...
+ *  // Called once a second or so
+ *  p_dash->begin ();
+ *  p_dash->label_P (1, 1, PSTR ("Encoder"));
+ *  p_dash->show (1, 10, 7, count->get ());
+ *  p_dash->end ();
+ *  \endcode
+ */
+
+class ansi_dashboard
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The terminal on which the dashboard is shown.
+		emstream* p_term;
+
+		/// The fields, in the order in which they were first shown.
+		dash_field* fields;
+
+		/// The largest number of fields the dashboard can have.
+		uint8_t max_fields;
+
+		/// The number of fields which have been shown so far.
+		uint8_t num_fields;
+
+		/// True if the whole screen is to be drawn the next time it's painted.
+		bool redraw_needed;
+
+		/// True between \c begin() and \c end() when the whole screen is being drawn.
+		bool drawing;
+
+		/// True if the cursor's place has been saved during this update.
+		bool cursor_saved;
+
+		/// The lowest row used by any label or field.
+		uint8_t bottom_row;
+
+		// Move the cursor to a place on the screen, saving its place first if needed
+		void move_to (uint8_t, uint8_t);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor makes a dashboard which will be drawn when first painted
+		ansi_dashboard (emstream*, uint8_t);
+
+		// Ask for the whole screen to be drawn the next time it's painted
+		void redraw (void);
+
+		// Start painting the screen
+		void begin (void);
+
+		// Print text which doesn't change, from flash memory or from RAM
+		void label_P (uint8_t, uint8_t, const char*);
+		void label (uint8_t, uint8_t, const char*);
+
+		// Print a number if it has changed since it was last printed
+		void show (uint8_t, uint8_t, uint8_t, int32_t);
+
+		// Finish painting the screen
+		void end (void);
+
+		// Let the whole screen scroll again and clear it
+		void stop (void);
+
+		/** This method tells whether the whole screen is being drawn, so that a
+		 *  painting method can skip work needed only for labels.
+		 *  @return True between \c begin() and \c end() when labels are printed
+		 */
+		bool is_drawing (void)
+		{
+			return (drawing);
+		}
+
+		/** This method tells whether the memory for the dashboard's fields was found.
+		 *  @return True if the dashboard can be used, false if it has no fields
+		 */
+		bool is_ready (void)
+		{
+			return (fields != NULL);
+		}
+};
+
+#endif  // _ANSI_DASHBOARD_H_
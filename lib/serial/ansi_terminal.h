@@ -150,6 +150,22 @@
  */
 #define ATERM_RESET_SCREEN       PMS ("\x1b[2J\x1b[1;1H\x1b[0m")
 
+/** This escape sequence makes the terminal remember where the cursor is, so that it
+ *  can be moved back there with \c ATERM_RESTORE_CURSOR.
+ */
+#define ATERM_SAVE_CURSOR        PMS ("\x1b" "7")
+
+/// This escape sequence moves the cursor back to where \c ATERM_SAVE_CURSOR left it.
+#define ATERM_RESTORE_CURSOR     PMS ("\x1b" "8")
+
+/** This escape sequence makes only the lines from row \c y to the bottom of the 
+ *  screen scroll when text runs off the bottom; the lines above stay where they are.
+ */
+#define ATERM_SCROLL_BELOW(y)    PMS ("\x1b[") << (uint8_t)(y) << PMS ("r")
+
+/// This escape sequence makes the whole screen scroll again.
+#define ATERM_SCROLL_ALL         PMS ("\x1b[r")
+
 
 // These aren't being used...just an idea that probably won't work out...
 // enum ansi_term_commands {ATERM_NORMAL,
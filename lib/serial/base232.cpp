@@ -52,8 +52,11 @@
 
 // This section compiles for the AVR microcontroller
 #ifdef __AVR
-base232::base232 (unsigned int baud_rate, unsigned char port_number)
+base232::base232 (unsigned long baud_rate, unsigned char port_number)
 {
+	// The divisor needs more than 8 bits at low baud rates
+	uint16_t divisor = calc_baud_div (baud_rate);
+
 	// If we're compiling for a chip with UCSR0A defined, it has dual serial ports
 	// (examples are ATmega324P and ATmega128). Set up Port 0 or Port 1
 	#if defined UCSR0A
@@ -64,10 +67,10 @@ base232::base232 (unsigned int baud_rate, unsigned char port_number)
 			p_UCR = &UCSR0B;
 			UCSR0B = (1 << RXEN0) | (1 << TXEN0);
 			UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); // | (1 << USBS0);
-			UBRR0H = 0x00;
-			UBRR0L = calc_baud_div (baud_rate);
+			UBRR0H = (uint8_t)(divisor >> 8);
+			UBRR0L = (uint8_t)divisor;
 			#ifdef UART_DOUBLE_SPEED					// Activate double speed mode
-				UCSR0A |= U2X0;							// if required
+				UCSR0A |= (1 << U2X0);					// if required
 			#endif
 			mask_UDRE = (1 << UDRE0);
 			mask_RXC = (1 << RXC0);
@@ -81,10 +84,10 @@ base232::base232 (unsigned int baud_rate, unsigned char port_number)
 			p_UCR = &UCSR1B;
 			UCSR1B = (1 << RXEN1) | (1 << TXEN1);
 			UCSR1C = (1 << UCSZ11) | (1 << UCSZ10); // | (1 << USBS1);
-			UBRR1H = 0x00;
-			UBRR1L = calc_baud_div (baud_rate);
+			UBRR1H = (uint8_t)(divisor >> 8);
+			UBRR1L = (uint8_t)divisor;
 			#ifdef UART_DOUBLE_SPEED		// If double-speed macro has been defined,
-				UCSR1A |= U2X1;				// turn on double-speed operation
+				UCSR1A |= (1 << U2X1);		// turn on double-speed operation
 			#endif
 			mask_UDRE = (1 << UDRE1);
 			mask_RXC = (1 << RXC1);
@@ -102,10 +105,10 @@ base232::base232 (unsigned int baud_rate, unsigned char port_number)
 			p_UCR = &UCSRB;
 			UCSRB = (1 << RXEN) | (1 << TXEN);
 			UCSRC = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);		// | (1 << USBS0);
-			UBRRH = 0x00;
-			UBRRL = calc_baud_div (baud_rate);
+			UBRRH = (uint8_t)(divisor >> 8);
+			UBRRL = (uint8_t)divisor;
 			#ifdef UART_DOUBLE_SPEED				// Activate double speed mode
-				UCSRA |= U2X;						// if required
+				UCSRA |= (1 << U2X);				// if required
 			#endif
 			mask_UDRE = (1 << UDRE);
 			mask_RXC = (1 << RXC);
@@ -116,7 +119,7 @@ base232::base232 (unsigned int baud_rate, unsigned char port_number)
 			p_USR = &USR;
 			p_UCR = &UCR;
 			UCR = (1 << RXEN) | (1 << TXEN);		// 0x18 for mode N81
-			UBRR = calc_baud_div (baud_rate);
+			UBRR = (uint8_t)divisor;
 			mask_UDRE = (1 << UDRE);
 			mask_RXC = (1 << RXC);
 			mask_TXC = (1 << TXC);
@@ -54,14 +54,18 @@
 /** This macro computes a value for the baud rate divisor from the desired baud rate 
  *  and the CPU clock frequency. The CPU clock frequency should have been set in the 
  *  macro F_CPU, which is normally configured in the Makefile. The divisor is
- *  calculated as (frequency, MHz / (16 * baudrate)), unless the USART is running in
- *  double-speed mode, in which case the baud rate divisor is twice as big. 
+ *  calculated as (frequency / (16 * baudrate)) - 1, rounded to the nearest whole
+ *  number, unless the USART is running in double-speed mode, in which case the baud
+ *  rate divisor is about twice as big. With a 16 MHz clock in double-speed mode, 
+ *  115200 baud comes out 2.1% fast, while 250000, 500000 and 1000000 baud are exact.
  */
 
 #ifdef UART_DOUBLE_SPEED
-	#define calc_baud_div(baud_rate) ((F_CPU) / (16UL * (baud_rate)))
+	#define calc_baud_div(baud_rate) \
+		(((F_CPU) + 4UL * (baud_rate)) / (8UL * (baud_rate)) - 1)
 #else
-	#define calc_baud_div(baud_rate) ((F_CPU) / (8UL * (baud_rate)))
+	#define calc_baud_div(baud_rate) \
+		(((F_CPU) + 8UL * (baud_rate)) / (16UL * (baud_rate)) - 1)
 #endif
 
 
@@ -108,7 +112,7 @@ class base232
 	public:
 	#ifdef __AVR
 		/// The constructor sets up the port with the given baud rate and port number.
-		base232 (unsigned int = 9600, unsigned char = 0);
+		base232 (unsigned long = 9600, unsigned char = 0);
 	#else
 		/// The constructor sets up the port with the given name.
 		base232 (char*);
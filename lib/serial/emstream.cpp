@@ -113,6 +113,23 @@ bool emstream::check_for_char (void)
 }
 
 
+//-------------------------------------------------------------------------------------
+/** This method waits for a character to arrive, sleeping rather than spinning while it
+ *  waits. Devices which can't block just check whether a character is waiting, as this
+ *  base method does; descendents which have a receiver interrupt override it so that 
+ *  the calling task uses no processor time until a character comes in or the time is 
+ *  up. 
+ *  @param timeout The longest time to wait, in RTOS ticks
+ *  @return True if a character is ready to be read, false if there isn't one
+ */
+
+bool emstream::wait_for_char (uint16_t timeout)
+{
+	(void)timeout;
+	return (check_for_char ());
+}
+
+
 //-------------------------------------------------------------------------------------
 /** This is a base method for causing immediate transmission of a buffer full of data.
  *  The base method doesn't do anything, because it will be implemented in descendent
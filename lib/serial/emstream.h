@@ -473,6 +473,7 @@ class emstream
 
 		virtual bool check_for_char (void); // Check if a character is in the buffer
 		virtual int16_t getchar (void);     // Get a character; wait if none is ready
+		virtual bool wait_for_char (uint16_t); // Sleep until a character arrives
 		virtual void transmit_now (void);   // Immediately transmit any buffered data
 		virtual void clear_screen (void);   // Clear a display screen if there is one
 
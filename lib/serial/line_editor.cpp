@@ -0,0 +1,224 @@
+//*************************************************************************************
+/** \file line_editor.cpp
+ *    This file contains a small line editor which is fed one character at a time, 
+ *    with backspace, a length limit, and a history of previous lines. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>                         // Functions for C string handling
+#include "line_editor.h"                    // Header for this file
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor creates a line editor with an empty line and an empty history.
+ *  @param p_echo_dev A serial device to which typed characters are echoed, or \c NULL
+ *                    if they're not to be echoed (default: NULL)
+ */
+
+line_editor::line_editor (emstream* p_echo_dev)
+{
+	p_echo = p_echo_dev;
+	history_newest = 0;
+	history_count = 0;
+
+	start ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method clears the line so that a new one can be typed. 
+ *  @param max_len The longest line which will be accepted, up to \c LINE_EDIT_LEN
+ *                 (default: \c LINE_EDIT_LEN)
+ */
+
+void line_editor::start (uint8_t max_len)
+{
+	max_length = (max_len < LINE_EDIT_LEN) ? max_len : LINE_EDIT_LEN;
+	length = 0;
+	line[0] = '\0';
+	recall_depth = 0;
+	escape_state = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method deals with one character typed by the user. Printable characters are 
+ *  added to the line and echoed; Backspace and Delete remove the last character; 
+ *  Enter finishes the line; Escape cancels it; and the up and down arrows bring back
+ *  lines from the history. 
+ *  @param ch The character which was typed
+ *  @return \c LINE_DONE if the line is finished, \c LINE_CANCELLED if it was thrown
+ *          away, or \c LINE_EDITING if more characters are needed
+ */
+
+line_status line_editor::feed (char ch)
+{
+	// Characters which follow an Escape may be part of an arrow key sequence
+	if (escape_state == 1)
+	{
+		if (ch == '[')
+		{
+			escape_state = 2;
+			return (LINE_EDITING);
+		}
+		escape_state = 0;
+		return (LINE_CANCELLED);
+	}
+	if (escape_state == 2)
+	{
+		escape_state = 0;
+		if (ch == 'A' && recall_depth < history_count)
+		{
+			recall (recall_depth + 1);
+		}
+		else if (ch == 'B' && recall_depth > 0)
+		{
+			recall (recall_depth - 1);
+		}
+		return (LINE_EDITING);
+	}
+
+	switch (ch)
+	{
+		case '\r':                          // Enter finishes the line
+			save_in_history ();
+			return (LINE_DONE);
+
+		case 27:                            // Escape, or the start of an arrow key
+			escape_state = 1;
+			break;
+
+		case '\b':                          // Backspace and Delete both remove the 
+		case 127:                           // last character, if there is one
+			if (length > 0)
+			{
+				line[--length] = '\0';
+				if (p_echo)
+				{
+					*p_echo << '\b' << ' ' << '\b';
+				}
+			}
+			break;
+
+		default:
+			if (ch < ' ' || ch > '~')       // Other control characters are ignored
+			{
+				break;
+			}
+			if (length >= max_length)       // A full line refuses more characters
+			{
+				if (p_echo)
+				{
+					*p_echo << '\a';
+				}
+				break;
+			}
+			line[length++] = ch;
+			line[length] = '\0';
+			if (p_echo)
+			{
+				*p_echo << ch;
+			}
+			break;
+	}
+
+	return (LINE_EDITING);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method should be called when no character has been typed for a while. If the
+ *  last character was an Escape, no arrow key sequence is coming, so the Escape was
+ *  pressed by itself and the line is cancelled. 
+ *  @return \c LINE_CANCELLED if a lone Escape cancelled the line, \c LINE_EDITING if 
+ *          not
+ */
+
+line_status line_editor::idle (void)
+{
+	if (escape_state == 1)
+	{
+		escape_state = 0;
+		return (LINE_CANCELLED);
+	}
+	return (LINE_EDITING);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method erases the line on the screen and replaces it with a line from the 
+ *  history, which can then be edited or entered. 
+ *  @param depth How many lines back to go; 1 is the most recent line, and 0 brings
+ *               back an empty line
+ */
+
+void line_editor::recall (uint8_t depth)
+{
+	if (p_echo)
+	{
+		for (uint8_t count = 0; count < length; count++)
+		{
+			*p_echo << '\b' << ' ' << '\b';
+		}
+	}
+
+	recall_depth = depth;
+	if (depth == 0)
+	{
+		line[0] = '\0';
+	}
+	else
+	{
+		uint8_t index = (history_newest + LINE_HISTORY_DEPTH - (depth - 1)) 
+						% LINE_HISTORY_DEPTH;
+		strncpy (line, history[index], max_length);
+		line[max_length] = '\0';
+	}
+	length = strlen (line);
+
+	if (p_echo)
+	{
+		*p_echo << line;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method saves a finished line in the history, unless it's empty or the same as
+ *  the line saved just before it. 
+ */
+
+void line_editor::save_in_history (void)
+{
+	if (length == 0)
+	{
+		return;
+	}
+	if (history_count > 0 && strcmp (line, history[history_newest]) == 0)
+	{
+		return;
+	}
+
+	if (history_count > 0)
+	{
+		history_newest = (history_newest + 1) % LINE_HISTORY_DEPTH;
+	}
+	strcpy (history[history_newest], line);
+	if (history_count < LINE_HISTORY_DEPTH)
+	{
+		history_count++;
+	}
+}
@@ -0,0 +1,150 @@
+//*************************************************************************************
+/** \file line_editor.h
+ *    This file contains a small line editor which is fed one character at a time. It
+ *    collects a line of text typed by a user, echoing it back, and handles backspace,
+ *    a length limit, and a short history of previous lines which can be brought back 
+ *    with the up and down arrow keys. Because it never waits for characters itself,
+ *    the task which owns it can sleep between keystrokes. 
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is 
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _LINE_EDITOR_H_
+#define _LINE_EDITOR_H_
+
+#include <stdint.h>                         // Integer types such as uint8_t
+#include "emstream.h"                       // Header for serial device base class
+
+
+/// This is the longest line, not counting the null at its end, which can be edited.
+const uint8_t LINE_EDIT_LEN = 24;
+
+/// This is the number of previous lines which are kept for recall with the arrow keys.
+const uint8_t LINE_HISTORY_DEPTH = 4;
+
+
+/// These values are returned by \c line_editor::feed() to say what has happened.
+typedef enum
+{
+	LINE_EDITING,                           ///< The line isn't finished yet
+	LINE_DONE,                              ///< Enter was pressed; the line is ready
+	LINE_CANCELLED                          ///< Escape was pressed; forget the line
+}
+line_status;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class edits one line of text which is typed in a character at a time.
+ *  \details Each character the user types is given to \c feed(), which returns 
+ *  \c LINE_DONE when Enter is pressed. Backspace (or Delete) removes the last 
+ *  character; characters typed when the line is full are refused with a bell. The up
+ *  and down arrow keys, which terminals send as the sequences ESC [ A and ESC [ B, 
+ *  step back and forth through the last few lines which were entered. An Escape 
+ *  which isn't the start of an arrow key cancels the line; since a lone Escape can't
+ *  be told apart from the start of an arrow key until the next character comes, the
+ *  owner should call \c idle() when no character has come in for a while. 
+ *
+ *  \section Usage
+ *  \code
+ *  line_editor editor (p_serial);
+ *  ...
+ *  editor.start ();
+ *  for (;;)
+ *  {
+ *      if (p_serial->wait_for_char (10))
+ *      {
+ *          if (editor.feed (p_serial->getchar ()) == LINE_DONE)
+ *          {
+ *              do_something_with (editor.get_line ());
+ *              editor.start ();
+ *          }
+ *      }
+ *      else
+ *      {
+ *          editor.idle ();
+ *      }
+ *  }
+ *  \endcode
+ */
+
+class line_editor
+{
+	protected:
+		/// This is the serial device to which typed characters are echoed.
+		emstream* p_echo;
+
+		/// This buffer holds the line being edited, with a null at its end.
+		char line[LINE_EDIT_LEN + 1];
+
+		/// This is the number of characters in the line.
+		uint8_t length;
+
+		/// This is the longest line allowed for the current entry.
+		uint8_t max_length;
+
+		/// This array holds the most recently entered lines.
+		char history[LINE_HISTORY_DEPTH][LINE_EDIT_LEN + 1];
+
+		/// This is the index in \c history[] of the most recently entered line.
+		uint8_t history_newest;
+
+		/// This is the number of lines which have been saved in the history.
+		uint8_t history_count;
+
+		/// How far back in the history the user has gone; 0 means the new line.
+		uint8_t recall_depth;
+
+		/// This is where we are in an escape sequence: 0 for none, 1 after ESC, 2 
+		/// after ESC [.
+		uint8_t escape_state;
+
+		// This method replaces the line with one from the history and shows it
+		void recall (uint8_t);
+
+		// This method saves a finished line in the history
+		void save_in_history (void);
+
+	public:
+		// The constructor sets up an empty editor and history
+		line_editor (emstream* = NULL);
+
+		// This method starts editing a new, empty line
+		void start (uint8_t = LINE_EDIT_LEN);
+
+		// This method deals with one character which has been typed
+		line_status feed (char);
+
+		// This method is called when no character has come in for a while
+		line_status idle (void);
+
+		/** This method returns a pointer to the line which has been typed.
+		 *  @return A pointer to the line, which ends with a null character
+		 */
+		const char* get_line (void)
+		{
+			return (line);
+		}
+
+		/** This method returns the number of characters in the line.
+		 *  @return The length of the line
+		 */
+		uint8_t get_length (void)
+		{
+			return (length);
+		}
+};
+
+#endif // _LINE_EDITOR_H_
@@ -0,0 +1,186 @@
+//*************************************************************************************
+/** \file mux_frame.cpp
+ *    This file contains the code which packs bytes into frames and unpacks them
+ *    again, so that several logical channels can share one serial line.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "mux_frame.h"                      // Header for this file
+
+
+// These are the parts of a frame, in the order in which they arrive
+#define MUX_WAIT_FLAG			0           // Between frames
+#define MUX_GET_CHANNEL			1           // The channel number is next
+#define MUX_GET_LENGTH			2           // The number of data bytes is next
+#define MUX_GET_DATA			3           // A data byte is next
+#define MUX_GET_CRC				4           // The CRC is next
+
+
+//-------------------------------------------------------------------------------------
+/** This function puts one byte of a frame into a buffer, escaping it if it looks like
+ *  a flag, an escape, or one of the XON and XOFF characters which a serial port using
+ *  software flow control would take for itself.
+ *  @param p_out A pointer to the place in the buffer where the byte goes
+ *  @param a_byte The byte to be put there
+ *  @return The number of bytes used, 1 or 2
+ */
+
+static uint8_t put_escaped (uint8_t* p_out, uint8_t a_byte)
+{
+	if (a_byte == MUX_FLAG || a_byte == MUX_ESCAPE || a_byte == MUX_XON
+		|| a_byte == MUX_XOFF)
+	{
+		p_out[0] = MUX_ESCAPE;
+		p_out[1] = a_byte ^ MUX_ESCAPE_BITS;
+		return (2);
+	}
+	p_out[0] = a_byte;
+	return (1);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function packs some bytes into a frame which is ready to be sent.
+ *  @param channel The channel number, less than \c MUX_MAX_CHANNELS
+ *  @param p_data A pointer to the bytes to be sent
+ *  @param length The number of bytes, from 1 to \c MUX_FRAME_SIZE
+ *  @param p_out A buffer of at least \c MUX_WIRE_SIZE bytes for the frame
+ *  @return The number of bytes in the frame
+ */
+
+uint8_t mux_frame_encode (uint8_t channel, const uint8_t* p_data, uint8_t length,
+						  uint8_t* p_out)
+{
+	uint8_t size = 0;
+	uint8_t crc = mux_crc_update (0, channel);
+
+	p_out[size++] = MUX_FLAG;
+	size += put_escaped (p_out + size, channel);
+	size += put_escaped (p_out + size, length);
+	crc = mux_crc_update (crc, length);
+	for (uint8_t index = 0; index < length; index++)
+	{
+		size += put_escaped (p_out + size, p_data[index]);
+		crc = mux_crc_update (crc, p_data[index]);
+	}
+	size += put_escaped (p_out + size, crc);
+
+	return (size);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a frame decoder which waits for the start of a frame.
+ */
+
+mux_frame_decoder::mux_frame_decoder (void)
+{
+	state = MUX_WAIT_FLAG;
+	escaped = false;
+	length = 0;
+	good_frames = 0;
+	bad_frames = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method takes the next byte which came over the line. A flag always starts a
+ *  new frame; if it comes in the middle of a frame, that frame is thrown away.
+ *  @param a_byte The byte from the line
+ *  @return \c MUX_RAW if the byte came between frames, \c MUX_BUSY if it was part of
+ *          a frame, \c MUX_GOOD if it finished a good frame (whose contents can now
+ *          be read), or \c MUX_BAD if a frame was spoiled
+ */
+
+mux_result mux_frame_decoder::take (uint8_t a_byte)
+{
+	if (a_byte == MUX_FLAG)
+	{
+		bool cut_off = (state != MUX_WAIT_FLAG);
+
+		state = MUX_GET_CHANNEL;
+		escaped = false;
+		if (cut_off)
+		{
+			bad_frames++;
+			return (MUX_BAD);
+		}
+		return (MUX_BUSY);
+	}
+
+	if (state == MUX_WAIT_FLAG)
+	{
+		return (MUX_RAW);
+	}
+
+	if (a_byte == MUX_ESCAPE)
+	{
+		escaped = true;
+		return (MUX_BUSY);
+	}
+	if (escaped)
+	{
+		a_byte ^= MUX_ESCAPE_BITS;
+		escaped = false;
+	}
+
+	switch (state)
+	{
+		case (MUX_GET_CHANNEL):
+			channel = a_byte;
+			crc = mux_crc_update (0, a_byte);
+			state = MUX_GET_LENGTH;
+			if (channel >= MUX_MAX_CHANNELS)
+			{
+				break;
+			}
+			return (MUX_BUSY);
+
+		case (MUX_GET_LENGTH):
+			length = a_byte;
+			crc = mux_crc_update (crc, a_byte);
+			count = 0;
+			state = MUX_GET_DATA;
+			if (length == 0 || length > MUX_FRAME_SIZE)
+			{
+				break;
+			}
+			return (MUX_BUSY);
+
+		case (MUX_GET_DATA):
+			data[count++] = a_byte;
+			crc = mux_crc_update (crc, a_byte);
+			if (count >= length)
+			{
+				state = MUX_GET_CRC;
+			}
+			return (MUX_BUSY);
+
+		default:
+			state = MUX_WAIT_FLAG;
+			if (a_byte == crc)
+			{
+				good_frames++;
+				return (MUX_GOOD);
+			}
+			break;
+	}
+
+	// Something was wrong with the frame, so wait for the next one
+	state = MUX_WAIT_FLAG;
+	bad_frames++;
+	return (MUX_BAD);
+}
@@ -0,0 +1,216 @@
+//*************************************************************************************
+/** \file mux_frame.h
+ *    This file contains the framing used to carry several logical channels, such as
+ *    the console, telemetry, commands and a log, over one serial line. It's used by
+ *    the \c uart_mux on the AVR and by the demultiplexer program on the PC, so both
+ *    ends pack and unpack frames with the same code.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _MUX_FRAME_H_
+#define _MUX_FRAME_H_
+
+#include <stdint.h>                         // Integer types of specific sizes
+
+#ifdef __AVR__
+	#include <util/crc16.h>                 // Header for cyclic redundancy checks
+#endif
+
+
+/// This byte starts every frame. It never appears anywhere else in a frame.
+#define MUX_FLAG				0x7E
+
+/// This byte means that the next byte has been changed so it isn't a flag.
+#define MUX_ESCAPE				0x7D
+
+/// This flow control character is always escaped, so it can't be lost to XON/XOFF.
+#define MUX_XON					0x11
+
+/// This flow control character is always escaped, so it can't be lost to XON/XOFF.
+#define MUX_XOFF				0x13
+
+/// An escaped byte is sent with these bits flipped.
+#define MUX_ESCAPE_BITS			0x20
+
+/// This is the largest number of data bytes in one frame.
+#define MUX_FRAME_SIZE			32
+
+/// This is the number of channels which a frame's channel number can pick.
+#define MUX_MAX_CHANNELS		8
+
+/// This is the most bytes a frame can take on the line, if every byte is escaped.
+#define MUX_WIRE_SIZE			(1 + 2 * (MUX_FRAME_SIZE + 3))
+
+/// The channel on which the user interface talks; unframed characters go here.
+#define MUX_CONSOLE				0
+
+/// The channel on which streams of measurements are sent.
+#define MUX_TELEMETRY			1
+
+/// The channel which carries commands from the PC and their answers.
+#define MUX_COMMAND				2
+
+/// The channel which carries messages to be logged on the PC.
+#define MUX_LOG					3
+
+
+/** These are the results of giving one byte from the line to a frame decoder.
+ */
+typedef enum
+{
+	MUX_RAW,                                ///< The byte wasn't part of any frame
+	MUX_BUSY,                               ///< The byte was part of a frame
+	MUX_GOOD,                               ///< The byte finished a good frame
+	MUX_BAD                                 ///< A frame was spoiled and thrown away
+}
+mux_result;
+
+
+//-------------------------------------------------------------------------------------
+/** This function adds a byte to a CRC-8 (polynomial 0x07), the same way on the AVR
+ *  (where a fast library routine is used) and on a PC.
+ *  @param crc The CRC of the bytes before this one, or 0 for the first byte
+ *  @param data The byte to be added
+ *  @return The CRC including the new byte
+ */
+
+inline uint8_t mux_crc_update (uint8_t crc, uint8_t data)
+{
+	#ifdef __AVR__
+		return (_crc8_ccitt_update (crc, data));
+	#else
+		// This is the C equivalent given in the avr-libc documentation
+		data ^= crc;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			data = (data & 0x80) ? ((data << 1) ^ 0x07) : (data << 1);
+		}
+		return (data);
+	#endif
+}
+
+
+// Pack some bytes into a frame ready to be sent
+uint8_t mux_frame_encode (uint8_t, const uint8_t*, uint8_t, uint8_t*);
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class unpacks frames from a stream of bytes which came over a serial
+ *  line.
+ *  \details A frame is the flag byte \c MUX_FLAG, then the channel number, the number
+ *  of data bytes, the data, and a CRC-8 of the channel, length and data. Any of the
+ *  bytes after the flag which happens to equal \c MUX_FLAG, \c MUX_ESCAPE, XON or
+ *  XOFF is sent as \c MUX_ESCAPE followed by the byte with \c MUX_ESCAPE_BITS 
+ *  flipped, so a flag always marks the start of a frame and frames can cross a link
+ *  which uses XON/XOFF flow control. A receiver which starts listening part way
+ *  through a frame, or loses a byte, finds its place again at the next flag.
+ *
+ *  Bytes which come between frames aren't part of any frame; \c take() says so, and
+ *  they can be handed to the console. This lets a person type at an ordinary
+ *  terminal program while the PC's demultiplexer isn't running.
+ *  \code
+ *  mux_frame_decoder decoder;
+ *  ...
+ *  if (decoder.take (a_byte) == MUX_GOOD)
+ *  {
+ *      save (decoder.get_channel (), decoder.get_data (), decoder.get_length ());
+ *  }
+ *  \endcode
+ */
+
+class mux_frame_decoder
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// Which part of a frame the next byte will be.
+		uint8_t state;
+
+		/// Set when the last byte was \c MUX_ESCAPE.
+		bool escaped;
+
+		/// The channel of the frame being received.
+		uint8_t channel;
+
+		/// The number of data bytes in the frame being received.
+		uint8_t length;
+
+		/// The number of data bytes received so far.
+		uint8_t count;
+
+		/// The CRC of the bytes received so far.
+		uint8_t crc;
+
+		/// The data bytes of the frame.
+		uint8_t data[MUX_FRAME_SIZE];
+
+		uint16_t good_frames;               ///< Frames which arrived whole
+		uint16_t bad_frames;                ///< Frames which were spoiled
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor sets the decoder up to look for a flag
+		mux_frame_decoder (void);
+
+		// Take the next byte from the line
+		mux_result take (uint8_t);
+
+		/** This method returns the channel of the frame which was just finished.
+		 *  @return The frame's channel number
+		 */
+		uint8_t get_channel (void)
+		{
+			return (channel);
+		}
+
+		/** This method returns the data of the frame which was just finished. It's
+		 *  good only until the next byte is taken.
+		 *  @return A pointer to the frame's data bytes
+		 */
+		const uint8_t* get_data (void)
+		{
+			return (data);
+		}
+
+		/** This method returns the number of data bytes in the frame which was just
+		 *  finished.
+		 *  @return The number of data bytes
+		 */
+		uint8_t get_length (void)
+		{
+			return (length);
+		}
+
+		/** This method returns the number of frames which have arrived whole.
+		 *  @return The number of good frames
+		 */
+		uint16_t get_good_frames (void)
+		{
+			return (good_frames);
+		}
+
+		/** This method returns the number of frames which were spoiled by a bad CRC,
+		 *  a bad length, or a flag in the middle.
+		 *  @return The number of bad frames
+		 */
+		uint16_t get_bad_frames (void)
+		{
+			return (bad_frames);
+		}
+};
+
+#endif  // _MUX_FRAME_H_
@@ -43,7 +43,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <avr/io.h>
+#include "FreeRTOS.h"						// FreeRTOS, for the receive semaphores
+#include "task.h"							// For waiting while the sender is held
+#include "semphr.h"							// Header for FreeRTOS semaphores
 #include "rs232int.h"
+#include "isr_profile.h"					// For timing the receiver ISRs
 
 
 // Every AVR has at least one serial port, so enable at least one receiver buffer
@@ -56,6 +60,12 @@ uint16_t rcv0_read_index;
 /// This index is used to read from serial character receiver buffer 0. 
 uint16_t rcv0_write_index;
 
+/// This semaphore is given by the ISR each time a character arrives at port 0.
+xSemaphoreHandle rcv0_signal = NULL;
+
+/// This holds the flow control settings and receiver statistics for port 0.
+rs232_flow rcv0_flow;
+
 // If there's a UCSR0A register, there are 2 serial ports, so enable another buffer
 #ifdef UCSR1A
 	/// This buffer holds characters received through serial port 1 by the ISR. 
@@ -66,6 +76,12 @@ uint16_t rcv0_write_index;
 
 	/// This index is used to read from serial character receiver buffer 1. 
 	uint16_t rcv1_write_index;
+
+	/// This semaphore is given by the ISR each time a character arrives at port 1.
+	xSemaphoreHandle rcv1_signal = NULL;
+
+	/// This holds the flow control settings and receiver statistics for port 1.
+	rs232_flow rcv1_flow;
 #endif
 
 
@@ -82,11 +98,18 @@ uint16_t rcv0_write_index;
  *                     1 only exists on some processors). The default is port 0 
  */
 
-rs232::rs232 (uint16_t baud_rate, uint8_t port_number)
+rs232::rs232 (uint32_t baud_rate, uint8_t port_number)
 	: emstream (), base232 (baud_rate, port_number)
 {
 	// Save the number of the serial port, 0 or 1
 	port_num = port_number;
+	p_flow = &rcv0_flow;
+	#ifdef UCSR1A
+		if (port_number != 0)
+		{
+			p_flow = &rcv1_flow;
+		}
+	#endif
 
 	// If we're compiling for a chip with UCSR0A defined, it has dual serial ports
 	// (examples are ATmega324P and ATmega128). Set up Port 0 or Port 1
@@ -99,6 +122,7 @@ rs232::rs232 (uint16_t baud_rate, uint8_t port_number)
 			rcv0_buffer = new uint8_t[RSINT_BUF_SIZE];
 			rcv0_read_index = 0;
 			rcv0_write_index = 0;
+			vSemaphoreCreateBinary (rcv0_signal);
 		}
 		else  // Serial port number 1
 		{
@@ -109,6 +133,7 @@ rs232::rs232 (uint16_t baud_rate, uint8_t port_number)
 			rcv1_buffer = new uint8_t[RSINT_BUF_SIZE];
 			rcv1_read_index = 0;
 			rcv1_write_index = 0;
+			vSemaphoreCreateBinary (rcv1_signal);
 		#endif // UCSR1A
 		}
 	// We're compiling for a chip which doesn't define UCSR0A; assume it has only one
@@ -120,6 +145,7 @@ rs232::rs232 (uint16_t baud_rate, uint8_t port_number)
 		rcv0_buffer = new uint8_t[RSINT_BUF_SIZE];
 		rcv0_read_index = 0;
 		rcv0_write_index = 0;
+		vSemaphoreCreateBinary (rcv0_signal);
 	#endif
 
 	// The Xiphos 1.0 board may need the pullup activated on the RXD1 line in order to
@@ -146,21 +172,195 @@ rs232::rs232 (uint16_t baud_rate, uint8_t port_number)
 
 bool rs232::putchar (char chout)
 {
-	// Now wait for the serial port transmitter buffer to be empty	 
-	for (uint16_t count = 0; ((*p_USR & mask_UDRE) == 0); count++)
+	// If the other end has asked us to pause, wait; then send any XON or XOFF first
+	if (p_flow->mode != RS232_FLOW_NONE)
 	{
+		wait_while_held ();
+		send_pending ();
+	}
+
+	// Now wait for the serial port transmitter buffer to be empty. The receiver ISR
+	// may send an XOFF too, so the buffer is checked and filled with interrupts off
+	for (uint16_t count = 0; ; count++)
+	{
+		portENTER_CRITICAL ();
+		if (*p_USR & mask_UDRE)
+		{
+			// Clear the TXCn bit so it can be used to check if the serial port is 
+			// busy. This check needs to be done prior to putting the processor into
+			// sleep mode.  Oddly, the TXCn bit is cleared by writing a one to its bit
+			// location
+			*p_USR |= mask_TXC;
+
+			// The CTS line is 0 and the transmitter buffer is empty, so send it
+			*p_UDR = chout;
+			portEXIT_CRITICAL ();
+			return (true);
+		}
+		portEXIT_CRITICAL ();
+
 		if (count > UART_TX_TOUT)
 			return (false);
 	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sets the port up to use XON/XOFF flow control. Characters XON and XOFF
+ *  which arrive are taken by the receiver ISR and aren't put in the buffer. 
+ */
+
+void rs232::use_xon_xoff (void)
+{
+	p_flow->held = false;
+	p_flow->mode = RS232_FLOW_XON_XOFF;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sets the port up to use RTS/CTS flow control. The lines are active 
+ *  low, as on the logic side of an FT232 or similar USB serial converter: this board
+ *  holds RTS low while it can take more characters, and sends while CTS is low. The
+ *  RTS output of the board goes to the converter's CTS input and vice versa.
+ *  @param p_rts_ddr The data direction register of the port with the RTS line
+ *  @param p_rts_port The output register of the port with the RTS line
+ *  @param rts_mask A bit mask with a one for the RTS line
+ *  @param p_cts_pin The input pin register of the port with the CTS line, which must
+ *                   be set as an input (it is by default)
+ *  @param cts_mask A bit mask with a one for the CTS line
+ */
+
+void rs232::use_rts_cts (volatile uint8_t* p_rts_ddr, volatile uint8_t* p_rts_port,
+						 uint8_t rts_mask, volatile uint8_t* p_cts_pin, 
+						 uint8_t cts_mask)
+{
+	*p_rts_port &= ~rts_mask;
+	*p_rts_ddr |= rts_mask;
+
+	portENTER_CRITICAL ();
+	p_flow->p_rts_port = p_rts_port;
+	p_flow->rts_mask = rts_mask;
+	p_flow->p_cts_pin = p_cts_pin;
+	p_flow->cts_mask = cts_mask;
+	p_flow->stopped = false;
+	p_flow->mode = RS232_FLOW_RTS_CTS;
+	portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method waits while the other end has asked this port not to send. Once the 
+ *  scheduler is running, the calling task sleeps a tick at a time, so other tasks 
+ *  can run. If the other end doesn't let go within \c RS232_HOLD_TOUT_MS, its XON 
+ *  is taken to have been lost and sending starts again. Before the scheduler starts,
+ *  nothing waits. 
+ */
+
+void rs232::wait_while_held (void)
+{
+	if (xTaskGetSchedulerState () != taskSCHEDULER_RUNNING)
+	{
+		return;
+	}
+
+	portTickType started = xTaskGetTickCount ();
+	for (;;)
+	{
+		bool held = (p_flow->mode == RS232_FLOW_XON_XOFF) ? p_flow->held
+					: ((*(p_flow->p_cts_pin) & p_flow->cts_mask) != 0);
+		if (!held)
+		{
+			return;
+		}
+		if ((xTaskGetTickCount () - started) 
+			>= (portTickType)(RS232_HOLD_TOUT_MS * configTICK_RATE_HZ / 1000))
+		{
+			p_flow->held = false;
+			p_flow->hold_timeouts++;
+			return;
+		}
+		vTaskDelay (1);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends an XON or XOFF which is waiting to go out. The receiver ISR 
+ *  sends XOFF itself if the transmitter is free; if it isn't, the XOFF waits here 
+ *  for the next character to be sent or read. 
+ */
+
+void rs232::send_pending (void)
+{
+	for (uint16_t count = 0; p_flow->pending != 0; count++)
+	{
+		portENTER_CRITICAL ();
+		if (p_flow->pending != 0 && (*p_USR & mask_UDRE))
+		{
+			*p_USR |= mask_TXC;
+			*p_UDR = p_flow->pending;
+			p_flow->pending = 0;
+		}
+		portEXIT_CRITICAL ();
+
+		if (count > UART_TX_TOUT)
+			return;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finds how many characters are waiting in the receiver buffer.
+ *  @return The number of characters which can be read
+ */
+
+uint16_t rs232::chars_waiting (void)
+{
+	uint16_t read_index = rcv0_read_index;
+	uint16_t write_index = rcv0_write_index;
+
+	#ifdef UCSR1A
+		if (port_num != 0)
+		{
+			read_index = rcv1_read_index;
+			write_index = rcv1_write_index;
+		}
+	#endif
+
+	if (write_index >= read_index)
+	{
+		return (write_index - read_index);
+	}
+	return (write_index + RSINT_BUF_SIZE - read_index);
+}
+
 
-	// Clear the TXCn bit so it can be used to check if the serial port is busy.  This
-	// check needs to be done prior to putting the processor into sleep mode.  Oddly,
-	// the TXCn bit is cleared by writing a one to its bit location
-	*p_USR |= mask_TXC;
+//-------------------------------------------------------------------------------------
+/** This method is called after a character has been read. If the other end was asked
+ *  to stop and the buffer is now nearly empty, it's told to go ahead. 
+ */
 
-	// The CTS line is 0 and the transmitter buffer is empty, so send the character
-	*p_UDR = chout;
-	return (true);
+void rs232::check_low_water (void)
+{
+	if (!p_flow->stopped || chars_waiting () > RSINT_LOW_WATER)
+	{
+		return;
+	}
+
+	portENTER_CRITICAL ();
+	p_flow->stopped = false;
+	if (p_flow->mode == RS232_FLOW_RTS_CTS)
+	{
+		*(p_flow->p_rts_port) &= ~(p_flow->rts_mask);
+	}
+	else
+	{
+		// If the XOFF hasn't gone out yet, the other end never stopped
+		p_flow->pending = (p_flow->pending == RS232_XOFF) ? 0 : RS232_XON;
+	}
+	portEXIT_CRITICAL ();
+
+	send_pending ();
 }
 
 
@@ -201,6 +401,8 @@ int16_t rs232::getchar (void)
 			rcv0_read_index = 0;
 	#endif
 
+	check_low_water ();
+
 	return (recv_char);
 }
 
@@ -225,6 +427,40 @@ bool rs232::check_for_char (void)
 }
 
 
+//-------------------------------------------------------------------------------------
+/** This method waits for a character to arrive in the receiver buffer. Rather than 
+ *  checking the buffer over and over, the calling task sleeps on a semaphore which 
+ *  the receiver ISR gives, so it uses no processor time while it waits. 
+ *  @param timeout The longest time to wait, in RTOS ticks
+ *  @return True if a character is ready to be read, false if the time ran out
+ */
+
+bool rs232::wait_for_char (uint16_t timeout)
+{
+	#ifdef UCSR1A							// If this is a dual-port chip
+		xSemaphoreHandle signal = (port_num == 0) ? rcv0_signal : rcv1_signal;
+	#else									// This chip has only one serial port
+		xSemaphoreHandle signal = rcv0_signal;
+	#endif
+
+	if (signal == NULL)						// If the semaphore couldn't be made,
+	{										// all we can do is look
+		return (check_for_char ());
+	}
+
+	// Clear any signal left from characters which have already been read, then look
+	// for a character; one which arrives after the look will give the semaphore again
+	xSemaphoreTake (signal, 0);
+	if (check_for_char ())
+	{
+		return (true);
+	}
+	xSemaphoreTake (signal, (portTickType)timeout);
+
+	return (check_for_char ());
+}
+
+
 //-------------------------------------------------------------------------------------
 /** This method sends the ASCII code to clear a display screen. It is called when the
  *  format modifier 'clrscr' is inserted in a line of "<<" stuff.
@@ -237,56 +473,188 @@ void rs232::clear_screen (void)
 
 
 //-------------------------------------------------------------------------------------
-/** \cond NOT_ENABLED  (This ISR is not to be documented by Doxygen)
- *  This interrupt service routine runs whenever a character has been received by the
+/** This function prints the receiver statistics of each serial port which has been
+ *  set up: the most characters which have been waiting in its buffer, how many times
+ *  the other end has been asked to stop, how many characters were lost because the
+ *  buffer was full or the UART overran, and how many times the other end kept this
+ *  port from sending for too long. 
+ *  @param p_ser_dev The serial device to which the statistics are printed
+ */
+
+void rs232_print_stats (emstream* p_ser_dev)
+{
+	rs232_flow* flows[2] = { &rcv0_flow, NULL };
+	uint8_t* buffers[2] = { rcv0_buffer, NULL };
+	#ifdef UCSR1A
+		flows[1] = &rcv1_flow;
+		buffers[1] = rcv1_buffer;
+	#endif
+
+	for (uint8_t port = 0; port < 2; port++)
+	{
+		rs232_flow* p_stats = flows[port];
+		if (buffers[port] == NULL)
+		{
+			continue;
+		}
+		*p_ser_dev << PMS ("Serial ") << port << PMS (": peak ") << p_stats->peak_fill
+				   << '/' << (uint16_t)RSINT_BUF_SIZE << PMS (", stopped ") 
+				   << p_stats->stops << PMS (", dropped ") << p_stats->dropped 
+				   << PMS (", overruns ") << p_stats->overruns 
+				   << PMS (", hold timeouts ") << p_stats->hold_timeouts << endl;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** \cond NOT_ENABLED  (This function is not to be documented by Doxygen)
+ *  This function is called by the receiver ISRs to put a character into a receiver
+ *  buffer and do the flow control. If the buffer is full, the character is dropped 
+ *  and counted; the read index belongs to the task which reads, so it's never moved
+ *  here. When the buffer fills to the high water mark, the other end is asked to 
+ *  stop by raising RTS or sending XOFF. If the transmitter is busy, the XOFF is left
+ *  for the next call or the next character sent by the driver.
+ */
+
+static inline void ISR_store_char (uint8_t a_char, uint8_t* p_buffer, 
+								   uint16_t* p_write_index, uint16_t read_index,
+								   rs232_flow* p_flow, volatile uint8_t* p_status,
+								   volatile uint8_t* p_data, uint8_t udre_mask)
+{
+	// XON and XOFF which arrive are orders for our transmitter, not data
+	if (p_flow->mode == RS232_FLOW_XON_XOFF 
+		&& (a_char == RS232_XON || a_char == RS232_XOFF))
+	{
+		p_flow->held = (a_char == RS232_XOFF);
+		return;
+	}
+
+	uint16_t next_index = *p_write_index + 1;
+	if (next_index >= RSINT_BUF_SIZE)
+	{
+		next_index = 0;
+	}
+	if (next_index == read_index)
+	{
+		p_flow->dropped++;
+	}
+	else
+	{
+		p_buffer[*p_write_index] = a_char;
+		*p_write_index = next_index;
+	}
+
+	uint16_t fill = (*p_write_index >= read_index) ? (*p_write_index - read_index)
+					: (*p_write_index + RSINT_BUF_SIZE - read_index);
+	if (fill > p_flow->peak_fill)
+	{
+		p_flow->peak_fill = fill;
+	}
+
+	if (p_flow->mode != RS232_FLOW_NONE && !p_flow->stopped && fill >= RSINT_HIGH_WATER)
+	{
+		p_flow->stopped = true;
+		p_flow->stops++;
+		if (p_flow->mode == RS232_FLOW_RTS_CTS)
+		{
+			*(p_flow->p_rts_port) |= p_flow->rts_mask;
+		}
+		else
+		{
+			p_flow->pending = RS232_XOFF;
+		}
+	}
+
+	if (p_flow->pending != 0 && (*p_status & udre_mask))
+	{
+		*p_data = p_flow->pending;
+		p_flow->pending = 0;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/*  This interrupt service routine runs whenever a character has been received by the
  *  first serial port (number 0).  It saves that character into the receiver buffer.
+ *  If giving the semaphore woke a task which should run instead of the one which was
+ *  interrupted, the switch is made here rather than at the next tick. The AVR port
+ *  has no taskYIELD_FROM_ISR(), but taskYIELD() saves the interrupted task's context,
+ *  with this ISR's return on its stack, so the rest of the ISR runs when that task
+ *  is next resumed.
  */
 
 ISR (RSI_CHAR_RECV_INT_0)
 {
-	// When this ISR is triggered, there's a character waiting in the USART data reg-
-	// ister, and the write index indexes the place where that character should go
+	ISR_PROFILE_START (ISR_PROF_SERIAL_0);
 
+	// When this ISR is triggered, there's a character waiting in the USART data reg-
+	// ister. The status must be read first, as reading the data clears the overrun 
+	// flag, which means characters were lost before this ISR could get to them
 	#if defined UCSR0A  // If this is a dual-serial-port chip (ATmega324P, 128, etc.)
-		rcv0_buffer[rcv0_write_index] = UDR0;
+		if (UCSR0A & (1 << DOR0))
+		{
+			rcv0_flow.overruns++;
+		}
+		ISR_store_char (UDR0, rcv0_buffer, &rcv0_write_index, rcv0_read_index, 
+						&rcv0_flow, &UCSR0A, &UDR0, (1 << UDRE0));
 	#else  // If this chip has only a single serial port (ATmega8, 32, etc.)
-		rcv0_buffer[rcv0_write_index] = UDR;
+		if (UCSRA & (1 << DOR))
+		{
+			rcv0_flow.overruns++;
+		}
+		ISR_store_char (UDR, rcv0_buffer, &rcv0_write_index, rcv0_read_index, 
+						&rcv0_flow, &UCSRA, &UDR, (1 << UDRE));
 	#endif
 
-	// Increment the write pointer
-	if (++rcv0_write_index >= RSINT_BUF_SIZE)
-		rcv0_write_index = 0;
+	// Wake up any task which is waiting for a character
+	signed portBASE_TYPE task_woken = pdFALSE;
+	if (rcv0_signal != NULL)
+	{
+		xSemaphoreGiveFromISR (rcv0_signal, &task_woken);
+	}
 
-	// If the write pointer is now equal to the read pointer, that means we've just
-	// overwritten the oldest data. Increment the read pointer so that it doesn't seem
-	// as if the buffer is empty
-	if (rcv0_write_index == rcv0_read_index)
-		if (++rcv0_read_index >= RSINT_BUF_SIZE)
-			rcv0_read_index = 0;
+	ISR_PROFILE_END (ISR_PROF_SERIAL_0);
+
+	// Switch to the woken task now if it should run instead of the interrupted one
+	if (task_woken != pdFALSE)
+	{
+		taskYIELD ();
+	}
 }
 
 
 #ifdef UCSR1A // The second ISR is only compiled for processors with dual serial ports
 	//-------------------------------------------------------------------------------------
-	/** This interrupt service routine runs whenever a character has been received by the
-	*  first serial port (number 0).  It saves that character into the receiver buffer.
+	/*  This interrupt service routine runs whenever a character has been received by the
+	*  second serial port (number 1).  It saves that character into the receiver buffer,
+	*  then switches to a woken task as the first port's ISR does.
 	*/
 
 	ISR (RSI_CHAR_RECV_INT_1)
 	{
-		// Read the character from the serial port receiver buffer
-		rcv1_buffer[rcv1_write_index] = UDR1;
+		ISR_PROFILE_START (ISR_PROF_SERIAL_1);
 
-		// Increment the write pointer
-		if (++rcv1_write_index >= RSINT_BUF_SIZE)
-			rcv1_write_index = 0;
+		// Check for an overrun, then read the character from the serial port
+		if (UCSR1A & (1 << DOR1))
+		{
+			rcv1_flow.overruns++;
+		}
+		ISR_store_char (UDR1, rcv1_buffer, &rcv1_write_index, rcv1_read_index, 
+						&rcv1_flow, &UCSR1A, &UDR1, (1 << UDRE1));
 
-		// If the write pointer is now equal to the read pointer, that means we've just
-		// overwritten the oldest data. Increment the read pointer so that it doesn't seem
-		// as if the buffer is empty
-		if (rcv1_write_index == rcv1_read_index)
-			if (++rcv1_read_index >= RSINT_BUF_SIZE)
-				rcv1_read_index = 0;
+		// Wake up any task which is waiting for a character
+		signed portBASE_TYPE task_woken = pdFALSE;
+		if (rcv1_signal != NULL)
+		{
+			xSemaphoreGiveFromISR (rcv1_signal, &task_woken);
+		}
+
+		ISR_PROFILE_END (ISR_PROF_SERIAL_1);
+
+		if (task_woken != pdFALSE)
+		{
+			taskYIELD ();
+		}
 	}
 #endif // Dual serial ports
 /** \endcond  (End of section which is not to be documented by Doxygen) */
@@ -45,6 +45,7 @@
 #define _RS232_H_
 
 #include <avr/interrupt.h>					// Header for AVR interrupt programming
+#include "FreeRTOS.h"						// FreeRTOS, for the flow control timeout
 #include "base232.h"						// Grab the base RS232-style header file
 #include "emstream.h"				// Pull in the base class header file
 
@@ -79,7 +80,63 @@
  *  ATmega8, ATmega32, ATmega324P or similar, it should usually be set smaller, for
  *  example 20 ~ 30 bytes or so. 
  */
-#define RSINT_BUF_SIZE		32
+#define RSINT_BUF_SIZE		64
+
+/** When flow control is on, the sender is asked to stop when this many characters are
+ *  waiting in the receiver buffer. The rest of the buffer holds characters which were
+ *  already on their way; a USB serial converter may send a dozen or so after it's
+ *  been asked to stop.
+ */
+#define RSINT_HIGH_WATER	(RSINT_BUF_SIZE - 16)
+
+/** When flow control has stopped the sender, it's asked to start again once no more
+ *  than this many characters are waiting in the receiver buffer.
+ */
+#define RSINT_LOW_WATER		(RSINT_BUF_SIZE / 4)
+
+/// This character asks the other end to start sending again (Ctrl-Q).
+#define RS232_XON			0x11
+
+/// This character asks the other end to stop sending (Ctrl-S).
+#define RS232_XOFF			0x13
+
+/** This is the longest time in milliseconds for which \c putchar() waits for the other
+ *  end to let it send. If the other end's XON was lost, sending starts again anyway.
+ */
+#define RS232_HOLD_TOUT_MS	500
+
+
+/** These are the kinds of flow control which a serial port can use.
+ */
+typedef enum
+{
+	RS232_FLOW_NONE,						///< Characters are sent whenever ready
+	RS232_FLOW_XON_XOFF,					///< XON and XOFF characters start and stop
+	RS232_FLOW_RTS_CTS						///< RTS and CTS wires start and stop
+}
+rs232_flow_mode;
+
+
+/** This structure holds the flow control settings and the receiver statistics of one
+ *  serial port. It's shared between the receiver interrupt and the driver.
+ */
+typedef struct
+{
+	rs232_flow_mode mode;					///< Which kind of flow control is used
+	volatile bool stopped;					///< The other end has been asked to stop
+	volatile bool held;						///< The other end has sent XOFF
+	volatile char pending;					///< XON or XOFF waiting to go out, or 0
+	volatile uint8_t* p_rts_port;			///< Output port with the RTS line
+	uint8_t rts_mask;						///< Bit mask for the RTS line
+	volatile uint8_t* p_cts_pin;			///< Input pin register with the CTS line
+	uint8_t cts_mask;						///< Bit mask for the CTS line
+	uint16_t peak_fill;						///< Most characters ever in the buffer
+	uint16_t stops;							///< Times the other end was asked to stop
+	uint16_t dropped;						///< Characters lost to a full buffer
+	uint16_t overruns;						///< Characters lost in the UART itself
+	uint16_t hold_timeouts;					///< Times the other end held us too long
+}
+rs232_flow;
 
 
 //-------------------------------------------------------------------------------------
@@ -97,8 +154,21 @@
  *  are placed in a buffer whose size is configurable with the macro \c RSINT_BUF_SIZE.
  *  Calls to \c getchar() will check the buffer for received characters. This method,
  *  as opposed to polling the receiver without using interrupts, allows much higher
- *  data rates to be reliably supported in a multitasking program. Sending of 
- *  characters is currently not interrupt based. 
+ *  data rates to be reliably supported in a multitasking program. The receiver ISR
+ *  also gives a semaphore, so a task can call \c wait_for_char() to sleep until a 
+ *  character arrives instead of checking over and over. Sending of characters is 
+ *  currently not interrupt based. 
+ *
+ *  At high baud rates a busy program can fall behind the characters coming in. Flow
+ *  control lets the receiver ask the other end to pause: when the buffer is filled
+ *  to \c RSINT_HIGH_WATER, the ISR sends XOFF or raises the RTS line, and when the
+ *  program has read the buffer down to \c RSINT_LOW_WATER, XON is sent or RTS is
+ *  lowered. In the other direction, \c putchar() waits while the other end has sent
+ *  XOFF or holds the CTS line high. Without flow control, characters which come
+ *  when the buffer is full are dropped. Either way, dropped characters and UART
+ *  overruns are counted and can be printed with \c rs232_print_stats(). XON/XOFF
+ *  needs no extra wires, but the characters 0x11 and 0x13 can then only be sent in
+ *  escaped form, as the \c uart_mux does; RTS/CTS passes all characters.
  * 
  *  \section Usage
  *  To create and use a serial port driver object requires only code such as the
@@ -113,6 +183,13 @@
  *  possible to have two \c rs232 objects, one on USART 0 and one on USART 1. 
  *  The third USART on some AVR's is currently not supported until the author gets a
  *  three-USART chip on which to test new code. 
+ *
+ *  To run at a high baud rate with flow control, the terminal program on the PC must
+ *  be set up for the same kind of flow control:
+ *  \code
+ *  rs232 ser_port (115200, 1);
+ *  ser_port.use_xon_xoff ();
+ *  \endcode
  */
 
 class rs232 : public emstream, public base232
@@ -120,19 +197,37 @@ class rs232 : public emstream, public base232
 	// This protected data can only be accessed from this class or its descendents
 	protected:
 		uint8_t port_num;					///< The USART number, 0 or 1
+		rs232_flow* p_flow;					///< Flow control for this port
+
+		uint16_t chars_waiting (void);		// Count characters in the buffer
+		void check_low_water (void);		// Let the other end send again if able
+		void send_pending (void);			// Send a waiting XON or XOFF
+		void wait_while_held (void);		// Wait until the other end lets us send
 
 	// Public methods can be called from anywhere in the program where there is a 
 	// pointer or reference to an object of this class
 	public:
 		// The constructor sets up the UART, saving its baud rate and port number
-		rs232 (uint16_t = 9600, uint8_t = 0);
+		rs232 (uint32_t = 9600, uint8_t = 0);
+
+		// Use XON and XOFF characters for flow control
+		void use_xon_xoff (void);
+
+		// Use RTS and CTS lines for flow control
+		void use_rts_cts (volatile uint8_t*, volatile uint8_t*, uint8_t,
+						  volatile uint8_t*, uint8_t);
 
 		// This method writes one character to the serial port.
 		bool putchar (char);
 
 		bool check_for_char (void);			// Check if a character is in the buffer
 		int16_t getchar (void);				// Get a character; wait if none is ready
+		bool wait_for_char (uint16_t);		// Sleep until a character arrives
 		void clear_screen (void);			// Send the 'clear display screen' code
 };
 
+
+// Print the receiver statistics of the serial ports
+void rs232_print_stats (emstream*);
+
 #endif  // _RS232_H_
@@ -0,0 +1,309 @@
+//*************************************************************************************
+/** \file uart_mux.cpp
+ *    This file contains classes which carry several logical channels over one serial
+ *    port, each channel with its own priority and buffers.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include "uart_mux.h"                       // Header for this file
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a channel and adds it to a multiplexer. The buffers are
+ *  text queues, so they appear with the other queues in the queue statistics.
+ *  @param p_mux The multiplexer which carries this channel
+ *  @param a_number The channel number, less than \c MUX_MAX_CHANNELS and different
+ *                  from the numbers of the multiplexer's other channels
+ *  @param a_priority The channel's priority; a higher number is more urgent
+ *  @param out_size The number of characters which can wait to be sent
+ *  @param in_size The number of characters from the PC which can wait to be read,
+ *                 or 0 if nothing is to be read from this channel (default 0)
+ *  @param wait The number of RTOS ticks a task which prints waits for room in the
+ *              outgoing buffer before the character is dropped (default: forever)
+ *  @param p_name A name under which the outgoing buffer's statistics are printed by
+ *                \c print_queue_list() (default: NULL, for no name)
+ */
+
+uart_mux_channel::uart_mux_channel (uart_mux* p_mux, uint8_t a_number,
+									uint8_t a_priority, uint16_t out_size,
+									uint16_t in_size, portTickType wait,
+									const char* p_name)
+{
+	number = a_number;
+	priority = a_priority;
+	frames_sent = 0;
+	bytes_sent = 0;
+
+	p_out = new frt_text_queue (out_size, NULL, wait, p_name);
+	p_in = NULL;
+	if (in_size > 0)
+	{
+		// The multiplexer's task must never wait for a reader, so it doesn't wait
+		p_in = new frt_text_queue (in_size, NULL, 0);
+	}
+
+	p_mux->add_channel (this);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts a character into the channel's outgoing buffer, from which the
+ *  multiplexer will send it in a frame.
+ *  @param a_char The character to be sent
+ *  @return True if the character was put into the buffer, false if there wasn't room
+ */
+
+bool uart_mux_channel::putchar (char a_char)
+{
+	return (p_out->putchar (a_char));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether any character has come from the PC on this channel.
+ *  @return True if a character is waiting to be read
+ */
+
+bool uart_mux_channel::check_for_char (void)
+{
+	return (p_in != NULL && p_in->check_for_char ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method gets a character which came from the PC on this channel. If none has
+ *  come, it waits until one does.
+ *  @return The character, or -1 if this channel doesn't receive anything
+ */
+
+int16_t uart_mux_channel::getchar (void)
+{
+	if (p_in == NULL)
+	{
+		return (-1);
+	}
+	return (p_in->getchar ());
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts the calling task to sleep until a character comes from the PC
+ *  on this channel or the given time runs out. The character isn't taken out of the
+ *  buffer, so \c getchar() will then return it at once.
+ *  @param timeout The largest number of RTOS ticks to wait
+ *  @return True if a character is waiting to be read
+ */
+
+bool uart_mux_channel::wait_for_char (uint16_t timeout)
+{
+	char a_char;
+
+	if (p_in == NULL)
+	{
+		return (false);
+	}
+	return (xQueuePeek (p_in->get_handle (), &a_char, (portTickType)timeout) == pdTRUE);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor makes a multiplexer which doesn't yet have any channels.
+ *  @param p_ser_dev The serial port over which the channels are carried. Nothing
+ *                   else should read from or write to it
+ */
+
+uart_mux::uart_mux (emstream* p_ser_dev)
+{
+	p_device = p_ser_dev;
+	last_sent = 0;
+	in_dropped = 0;
+
+	for (uint8_t index = 0; index < MUX_MAX_CHANNELS; index++)
+	{
+		channels[index] = NULL;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method adds a channel to the multiplexer. It's called by the channel's
+ *  constructor, so it needn't be called by anything else.
+ *  @param p_channel The channel to be added; its number must be less than
+ *                   \c MUX_MAX_CHANNELS
+ */
+
+void uart_mux::add_channel (uart_mux_channel* p_channel)
+{
+	if (p_channel->number < MUX_MAX_CHANNELS)
+	{
+		channels[p_channel->number] = p_channel;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method moves characters between the channels and the serial port. Characters
+ *  from the PC are read between frames, so a long burst of telemetry doesn't keep
+ *  a command from being heard. Frames are sent until no channel has anything left to
+ *  send; then the calling task sleeps until a character comes from the PC or the
+ *  given time has passed.
+ *  @param wait The longest time in RTOS ticks to sleep when there's nothing to send.
+ *              Characters printed while the task sleeps wait this long to be sent
+ */
+
+void uart_mux::service (portTickType wait)
+{
+	do
+	{
+		while (p_device->check_for_char ())
+		{
+			receive ((uint8_t)(p_device->getchar ()));
+		}
+	}
+	while (send_frame ());
+
+	// Characters which arrive during the wait are read the next time around
+	p_device->wait_for_char (wait);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method sends one frame from the channel with the highest priority which has
+ *  characters waiting. Channels of the same priority are looked at in turn, starting
+ *  after the one which sent the last frame, so they share the line fairly.
+ *  @return True if a frame was sent, false if no channel had anything to send
+ */
+
+bool uart_mux::send_frame (void)
+{
+	uart_mux_channel* p_best = NULL;
+
+	for (uint8_t step = 1; step <= MUX_MAX_CHANNELS; step++)
+	{
+		uart_mux_channel* p_channel = channels[(last_sent + step) % MUX_MAX_CHANNELS];
+
+		if (p_channel != NULL && p_channel->p_out->check_for_char ()
+			&& (p_best == NULL || p_channel->priority > p_best->priority))
+		{
+			p_best = p_channel;
+		}
+	}
+	if (p_best == NULL)
+	{
+		return (false);
+	}
+
+	// Only this task takes characters out of the buffer, so getchar() won't wait
+	uint8_t length = 0;
+	while (length < MUX_FRAME_SIZE && p_best->p_out->check_for_char ())
+	{
+		frame_data[length++] = (uint8_t)(p_best->p_out->getchar ());
+	}
+
+	uint8_t size = mux_frame_encode (p_best->number, frame_data, length, wire);
+	for (uint8_t index = 0; index < size; index++)
+	{
+		p_device->putchar (wire[index]);
+	}
+
+	last_sent = p_best->number;
+	p_best->frames_sent++;
+	p_best->bytes_sent += length;
+
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method takes a character from the serial port. Characters outside of any
+ *  frame are typed by a person at a terminal and go to the console; the contents of
+ *  a good frame go to the frame's channel.
+ *  @param a_byte The character from the serial port
+ */
+
+void uart_mux::receive (uint8_t a_byte)
+{
+	switch (decoder.take (a_byte))
+	{
+		case (MUX_RAW):
+			deliver (MUX_CONSOLE, &a_byte, 1);
+			break;
+		case (MUX_GOOD):
+			deliver (decoder.get_channel (), decoder.get_data (),
+					 decoder.get_length ());
+			break;
+		default:
+			break;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts characters which came from the PC into a channel's incoming
+ *  buffer. Characters for a channel which doesn't exist or doesn't receive, or which
+ *  don't fit in the buffer, are counted and dropped.
+ *  @param channel The number of the channel
+ *  @param p_data A pointer to the characters
+ *  @param length The number of characters
+ */
+
+void uart_mux::deliver (uint8_t channel, const uint8_t* p_data, uint8_t length)
+{
+	uart_mux_channel* p_channel = channels[channel];
+
+	if (p_channel == NULL || p_channel->p_in == NULL)
+	{
+		in_dropped += length;
+		return;
+	}
+	for (uint8_t index = 0; index < length; index++)
+	{
+		if (!p_channel->p_in->putchar ((char)(p_data[index])))
+		{
+			in_dropped++;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a table showing how many frames and characters each channel
+ *  has sent, then the numbers of good and bad frames which came from the PC.
+ *  @param ser_dev The serial device to which the table is printed
+ */
+
+void uart_mux::print_stats (emstream* ser_dev)
+{
+	*ser_dev << PMS ("Channel\tPri\tFrames\tBytes\tWaiting") << endl;
+	*ser_dev << PMS ("-------\t---\t------\t-----\t-------") << endl;
+
+	for (uint8_t number = 0; number < MUX_MAX_CHANNELS; number++)
+	{
+		uart_mux_channel* p_channel = channels[number];
+		if (p_channel == NULL)
+		{
+			continue;
+		}
+
+		*ser_dev << number << '\t' << p_channel->priority << '\t'
+				 << p_channel->frames_sent << '\t' << p_channel->bytes_sent << '\t'
+				 << (uint16_t)(uxQueueMessagesWaiting (p_channel->p_out->get_handle ()))
+				 << endl;
+	}
+	*ser_dev << PMS ("Frames received: ") << decoder.get_good_frames ()
+			 << PMS (" good, ") << decoder.get_bad_frames ()
+			 << PMS (" bad; characters dropped: ") << in_dropped << endl;
+}
@@ -0,0 +1,175 @@
+//*************************************************************************************
+/** \file uart_mux.h
+ *    This file contains classes which carry several logical channels over one serial
+ *    port: the console, a stream of telemetry, commands from the PC and their
+ *    answers, and a log. Each channel is a serial device with its own buffers, so a
+ *    task prints to its channel just as it would print to a serial port. The channels
+ *    have priorities; a short answer to a command goes out ahead of a long stream of
+ *    telemetry, waiting at most for one frame. On the PC, the \c uart_demux program
+ *    sorts the frames back into separate streams.
+ *
+ *  License:
+ *    This file is released under the Lesser GNU Public License, version 2. It is
+ *    intended for educational use only, but its use is not limited thereto. */
+/*    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ *    TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *    OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+// This define prevents this .h file from being included more than once in a .cpp file
+#ifndef _UART_MUX_H_
+#define _UART_MUX_H_
+
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "queue.h"                          // Header for FreeRTOS queues
+#include "emstream.h"                       // Pull in the base class header file
+#include "frt_text_queue.h"                 // Queues which buffer each channel
+#include "mux_frame.h"                      // Packing and unpacking of frames
+
+
+class uart_mux;
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class is one logical channel of a \c uart_mux. It's a serial device,
+ *  so anything can be printed to it with the \c << operator, and characters which
+ *  came from the PC on this channel can be read from it.
+ *  \details Characters printed to the channel wait in its outgoing buffer until the
+ *  multiplexer sends them. The third constructor parameter says what happens when
+ *  the buffer is full: the console should wait for room, so nothing typed at it is
+ *  lost, while telemetry usually shouldn't wait, so a slow serial line can't hold up
+ *  the task which measures things; the characters which didn't fit are counted in
+ *  the queue statistics. A channel which receives nothing from the PC can be made
+ *  without an incoming buffer.
+ */
+
+class uart_mux_channel : public emstream
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The channel number which is put in this channel's frames.
+		uint8_t number;
+
+		/// The channel's priority; when several channels have characters waiting,
+		/// the one with the highest priority is sent first.
+		uint8_t priority;
+
+		/// The buffer which holds characters waiting to be sent.
+		frt_text_queue* p_out;
+
+		/// The buffer which holds characters which came from the PC, or NULL.
+		frt_text_queue* p_in;
+
+		uint16_t frames_sent;               ///< Frames sent from this channel
+		uint32_t bytes_sent;                ///< Characters sent from this channel
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor makes a channel and adds it to a multiplexer
+		uart_mux_channel (uart_mux*, uint8_t, uint8_t, uint16_t, uint16_t = 0,
+						  portTickType = portMAX_DELAY, const char* = NULL);
+
+		// Put a character into the outgoing buffer
+		bool putchar (char);
+
+		// Check if a character has come from the PC on this channel
+		bool check_for_char (void);
+
+		// Get a character which came from the PC, waiting if none has come
+		int16_t getchar (void);
+
+		// Sleep until a character comes from the PC or the time runs out
+		bool wait_for_char (uint16_t);
+
+	// The multiplexer empties and fills the channel's buffers directly
+	friend class uart_mux;
+};
+
+
+//-------------------------------------------------------------------------------------
+/** \brief This class sends the characters printed to several channels over one
+ *  serial port in frames, and sorts the frames which come back into the channels.
+ *  \details The frame format is described in \c mux_frame.h. Each frame carries up
+ *  to \c MUX_FRAME_SIZE characters from one channel. Whenever a frame can be sent,
+ *  the waiting channel with the highest priority is chosen; channels of equal
+ *  priority take turns. Characters which arrive from the PC outside any frame go to
+ *  the console channel, so the console still works from an ordinary terminal.
+ *
+ *  The multiplexer is run by one task which calls \c service() over and over. It
+ *  should have a low priority, so that the tasks which print fill a few characters
+ *  into their buffers before a frame is sent; a frame costs five bytes of overhead
+ *  whether it carries one character or thirty-two.
+ *  \code
+ *  uart_mux* p_mux = new uart_mux (&ser_port);
+ *  uart_mux_channel* p_console = new uart_mux_channel (p_mux, MUX_CONSOLE, 2, 64, 16,
+ *                                                      portMAX_DELAY, "Console");
+ *  uart_mux_channel* p_telemetry = new uart_mux_channel (p_mux, MUX_TELEMETRY, 1,
+ *                                                        128, 0, 0, "Telemetry");
+ *  ...
+ *  // In the run() method of the multiplexer's task
+ *  for (;;)
+ *  {
+ *      p_mux->service (1);
+ *  }
+ *  \endcode
+ */
+
+class uart_mux
+{
+	// This protected data can only be accessed from this class or its descendents
+	protected:
+		/// The serial port over which all the channels are carried.
+		emstream* p_device;
+
+		/// The channels, indexed by channel number; unused numbers are NULL.
+		uart_mux_channel* channels[MUX_MAX_CHANNELS];
+
+		/// The number of the channel from which the last frame was sent.
+		uint8_t last_sent;
+
+		/// The characters being put into a frame.
+		uint8_t frame_data[MUX_FRAME_SIZE];
+
+		/// The frame as it's sent over the line.
+		uint8_t wire[MUX_WIRE_SIZE];
+
+		/// The decoder which finds frames in the characters from the PC.
+		mux_frame_decoder decoder;
+
+		/// Characters from the PC for a missing channel or a full buffer.
+		uint16_t in_dropped;
+
+		// Send one frame from the most urgent channel which has characters waiting
+		bool send_frame (void);
+
+		// Take a character from the serial port
+		void receive (uint8_t);
+
+		// Put characters from the PC into a channel's incoming buffer
+		void deliver (uint8_t, const uint8_t*, uint8_t);
+
+	// Public methods can be called from anywhere in the program where there is a
+	// pointer or reference to an object of this class
+	public:
+		// The constructor makes a multiplexer with no channels
+		uart_mux (emstream*);
+
+		// Add a channel; this is done by the channel's constructor
+		void add_channel (uart_mux_channel*);
+
+		// Move characters between the channels and the serial port
+		void service (portTickType);
+
+		// Print the numbers of frames and characters carried by each channel
+		void print_stats (emstream*);
+};
+
+#endif  // _UART_MUX_H_
@@ -0,0 +1,193 @@
+//**************************************************************************************
+/** \file params.cpp
+ *    This file contains the default settings for the launcher, the EEPROM pages in 
+ *    which the settings are saved, and functions which let the user interface get and
+ *    change the settings by number. */
+//**************************************************************************************
+
+#include <stddef.h>                         // For offsetof()
+#include <avr/pgmspace.h>                   // For the tables kept in flash memory
+
+#include "params.h"                         // Header for this file
+
+
+/** These are the default settings. The proportional control numbers and the stepper
+ *  speed are the ones which used to be hard coded; only two target squares had been
+ *  worked out when the aiming table was moved here.
+ */
+const machine_params param_defaults PROGMEM =
+{
+   { 10, 30, 45 },                          // gains: divisor, min and max power
+   80,                                      // stepper_rpm
+   200,                                     // fire_pulse_ms
+   {
+      { 1000, -10 }, { 3000, -20 }, { 0, 0 }, { 0, 0 },
+      { 0, 0 },      { 0, 0 },      { 0, 0 }, { 0, 0 },
+      { 0, 0 },      { 0, 0 },      { 0, 0 }, { 0, 0 },
+      { 0, 0 },      { 0, 0 },      { 0, 0 }, { 0, 0 }
+   }
+};
+
+/** These are the copies of the settings in EEPROM. The compiler decides where in 
+ *  EEPROM they go, so they won't run into the macros or anything else kept there.
+ */
+param_store::page param_pages[PARAM_COPIES] EEMEM;
+
+
+/// This structure holds the name and limits of one of the settings before the table.
+typedef struct
+{
+   char name[14];                           ///< Name printed for the setting
+   int16_t min;                             ///< Smallest value allowed
+   int16_t max;                             ///< Largest value allowed
+}
+param_info;
+
+/// This table describes the settings which come before the aiming table, in order.
+const param_info param_table[] PROGMEM =
+{
+   { "P divisor",     1,    1000 },
+   { "min power",     0,    255 },
+   { "max power",     0,    255 },
+   { "stepper RPM",   1,    300 },
+   { "fire pulse ms", 10,   2000 }
+};
+
+/// This is how many settings come before the aiming table.
+const uint8_t PARAM_SCALARS = sizeof (param_table) / sizeof (param_table[0]);
+
+/// This is how many numbered settings there are, two for each target square.
+const uint8_t PARAM_TOTAL = sizeof (machine_params) / sizeof (int16_t);
+
+/// These are the numbers of the smallest and largest motor power settings.
+const uint8_t PARAM_MIN_POWER = (offsetof (machine_params, gains) 
+                                 + offsetof (control_gains, min_power)) / sizeof (int16_t);
+const uint8_t PARAM_MAX_POWER = (offsetof (machine_params, gains) 
+                                 + offsetof (control_gains, max_power)) / sizeof (int16_t);
+
+/// This is how far the encoded motor may be sent, as for the 'm' command.
+const int16_t PARAM_POSITION_LIMIT = 4000;
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds how many numbered settings there are. 
+ *  @return The number of settings, including two for each target square
+ */
+
+uint8_t param_count (void) {
+   return (PARAM_TOTAL);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function gets one numbered setting from the RAM copy of the settings.
+ *  @param index The number of the setting, from 0 to param_count() - 1
+ *  @return The setting's value, or 0 if there's no such setting
+ */
+
+int16_t param_get (uint8_t index) {
+   int16_t value = 0;
+
+   if (index < PARAM_TOTAL) {
+      p_params->read (index * sizeof (int16_t), &value, sizeof (int16_t));
+   }
+   return (value);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function changes one numbered setting if the new value is within that 
+ *  setting's limits. The smallest motor power can't be set above the largest, nor 
+ *  the largest below the smallest, as the control loop would then clamp every power
+ *  to the wrong one. The change is saved to EEPROM a little while later.
+ *  @param index The number of the setting, from 0 to param_count() - 1
+ *  @param value The new value for the setting
+ *  @return True if the setting was changed, false if the number or value was bad
+ */
+
+bool param_set (uint8_t index, int16_t value) {
+   if (index >= PARAM_TOTAL) {
+      return (false);
+   }
+   if (index < PARAM_SCALARS) {
+      if (value < (int16_t)pgm_read_word (&param_table[index].min)
+          || value > (int16_t)pgm_read_word (&param_table[index].max)) {
+         return (false);
+      }
+      if ((index == PARAM_MIN_POWER && value > param_get (PARAM_MAX_POWER))
+          || (index == PARAM_MAX_POWER && value < param_get (PARAM_MIN_POWER))) {
+         return (false);
+      }
+   }
+   else if (((index - PARAM_SCALARS) & 1) == 0) {
+      if (value < -PARAM_POSITION_LIMIT || value > PARAM_POSITION_LIMIT) {
+         return (false);
+      }
+   }
+   p_params->write (index * sizeof (int16_t), &value, sizeof (int16_t));
+   return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds whether a numbered setting is one of the control gains, which
+ *  must be staged in \c p_gains when changed so the control task will use them.
+ *  @param index The number of the setting
+ *  @return True if the setting is a control gain
+ */
+
+bool param_is_gain (uint8_t index) {
+   return (index < sizeof (control_gains) / sizeof (int16_t));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function copies the control gains out of the settings as one set.
+ *  @param p_gains_out A pointer to the structure into which the gains are copied
+ */
+
+void param_get_gains (control_gains* p_gains_out) {
+   *p_gains_out = p_params->get (&machine_params::gains);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function finds where a target square is in the aiming table. 
+ *  @param square The square's row and column, as in 11 through 44
+ *  @return The index into \c machine_params::targets, or PARAM_SQUARES if the row or
+ *          column isn't 1 through 4
+ */
+
+uint8_t param_square_index (int32_t square) {
+   int32_t row = square / 10;
+   int32_t col = square % 10;
+
+   if (row < 1 || row > 4 || col < 1 || col > 4) {
+      return (PARAM_SQUARES);
+   }
+   return ((row - 1) * 4 + (col - 1));
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This function prints the name of a numbered setting. The aiming table's settings
+ *  are named by square, as in "square 23 steps".
+ *  @param ser_dev The serial device on which to print
+ *  @param index The number of the setting
+ */
+
+void param_print_name (emstream& ser_dev, uint8_t index) {
+   if (index < PARAM_SCALARS) {
+      ser_dev << _p_str << param_table[index].name;
+   }
+   else if (index < PARAM_TOTAL) {
+      uint8_t square = (index - PARAM_SCALARS) / 2;
+      ser_dev << PMS ("square ") << (uint8_t)(square / 4 + 1)
+              << (uint8_t)(square % 4 + 1);
+      if (((index - PARAM_SCALARS) & 1) == 0) {
+         ser_dev << PMS (" position");
+      } else {
+         ser_dev << PMS (" steps");
+      }
+   }
+}
@@ -0,0 +1,99 @@
+//**************************************************************************************
+/** \file params.h
+ *    This file contains the tunable settings for the launcher: the proportional 
+ *    control numbers used by task_P, the stepper speed, the solenoid pulse width, and
+ *    the aiming table for the target grid. They are kept in EEPROM by an eeprom_store
+ *    so they can be changed from the user interface without rebuilding the program. */
+//**************************************************************************************
+
+// This define prevents this .h file from being included multiple times in a .cpp file
+#ifndef _PARAMS_H_
+#define _PARAMS_H_
+
+#include <stdlib.h>                    // Prototype declarations for I/O functions
+
+#include "emstream.h"                  // Header for serial ports and devices
+#include "eeprom_store.h"              // Wear-levelled settings kept in EEPROM
+#include "frt_shadow_data.h"           // Settings swapped in at control periods
+
+
+/// How many copies of the settings are kept in EEPROM to spread out the wear.
+const uint8_t PARAM_COPIES = 8;
+
+/// How many squares there are in the target grid, which is 4 rows by 4 columns.
+const uint8_t PARAM_SQUARES = 16;
+
+
+/// This structure holds the motor positions which aim at one square of the target.
+typedef struct
+{
+   int16_t position;                   ///< Position for the encoded motor
+   int16_t steps;                      ///< Steps for the stepper motor
+}
+aim_point;
+
+
+/** This structure holds the gains used by task_P's control loop. They're copied out
+ *  of the settings as a set and swapped in by the control task between periods.
+ */
+typedef struct
+{
+   int16_t p_divisor;                  ///< Power is the position error / this
+   int16_t min_power;                  ///< Smallest power used while moving
+   int16_t max_power;                  ///< Largest power used while moving
+}
+control_gains;
+
+
+/** This structure holds all the tunable settings. It's made only of \c int16_t's so 
+ *  the user interface can treat it as a numbered list of settings; see
+ *  param_get() and param_set().
+ */
+typedef struct
+{
+   control_gains gains;                ///< Gains for task_P's control loop
+   int16_t stepper_rpm;                ///< Stepper motor speed in RPM
+   int16_t fire_pulse_ms;              ///< How long the solenoid is held open
+   aim_point targets[PARAM_SQUARES];   ///< Aim for squares 11, 12, ... 44 in order
+}
+machine_params;
+
+
+/// This is the type of the store which keeps the settings in EEPROM.
+typedef eeprom_store<machine_params, PARAM_COPIES> param_store;
+
+/// This is the settings store; it's created in main() and used by all the tasks.
+extern param_store* p_params;
+
+/// These are the control gains, staged by the user interface and applied by task_P.
+extern shadow_data<control_gains>* p_gains;
+
+/// These are the default settings, used when the EEPROM holds no good copy.
+extern const machine_params param_defaults;
+
+/// These are the pages in EEPROM where the copies of the settings are kept.
+extern param_store::page param_pages[PARAM_COPIES];
+
+
+// Find how many numbered settings there are
+uint8_t param_count (void);
+
+// Get one numbered setting
+int16_t param_get (uint8_t);
+
+// Change one numbered setting, checking it against that setting's limits
+bool param_set (uint8_t, int16_t);
+
+// Find whether a numbered setting is one of the control gains
+bool param_is_gain (uint8_t);
+
+// Copy the control gains out of the settings
+void param_get_gains (control_gains*);
+
+// Find the index into the aiming table of a target square such as 11 or 44
+uint8_t param_square_index (int32_t);
+
+// Print the name of a numbered setting
+void param_print_name (emstream&, uint8_t);
+
+#endif
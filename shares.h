@@ -35,6 +35,12 @@
 // will also be declared exactly once, without the keyword 'extern', in one .cpp file
 // as well as being declared extern here. 
 
+/** This is the control period in milliseconds. The motor controller works out the
+ *  motor's power once per period, and the sensor service task's slots are lined up
+ *  with the same period so that slow sensor work is done between control deadlines.
+ */
+const uint8_t CONTROL_PERIOD_MS = 10;
+
 // This queue allows tasks to send characters to the user interface task for display.
 extern frt_text_queue* print_ser_queue;
 
@@ -0,0 +1,210 @@
+//**************************************************************************************
+/** \file shot_trace.cpp
+ *    This file contains the methods of the class which times the stages of each
+ *    aim-and-fire cycle. */
+//**************************************************************************************
+
+#include <avr/pgmspace.h>                   // For the tables kept in flash memory
+
+#include "shot_trace.h"                     // Header for this file
+
+
+/** This table gives the stage after which each stage is timed. The two axes start
+ *  moving at the same time, so both first moves are timed from the setpoints being
+ *  published. The first stage has no stage before it; its row in the window holds
+ *  the time of the whole shot instead.
+ */
+const uint8_t shot_after[SHOT_STAGES] PROGMEM =
+{
+   SHOT_RECEIVED,                           // SHOT_RECEIVED (whole shot)
+   SHOT_RECEIVED,                           // SHOT_PARSED
+   SHOT_PARSED,                             // SHOT_PUBLISHED
+   SHOT_PUBLISHED,                          // SHOT_FIRST_PWM
+   SHOT_PUBLISHED,                          // SHOT_FIRST_STEP
+   SHOT_PUBLISHED,                          // SHOT_ON_TARGET
+   SHOT_ON_TARGET,                          // SHOT_ENERGISED
+   SHOT_ENERGISED,                          // SHOT_RELEASED
+   SHOT_RELEASED                            // SHOT_HOMED
+};
+
+/// The names printed for the stages; the first row is the time of the whole shot.
+const char shot_names[SHOT_STAGES][10] PROGMEM =
+{
+   "total",
+   "parse",
+   "publish",
+   "first PWM",
+   "1st step",
+   "on target",
+   "energise",
+   "release",
+   "home"
+};
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor clears the window of shot times, marking every time as missing
+ *  so that shots which haven't happened yet aren't counted.
+ */
+
+shot_trace::shot_trace (void) {
+   for (uint8_t stage = 0; stage < SHOT_STAGES; stage++) {
+      for (uint8_t slot = 0; slot < SHOT_WINDOW; slot++) {
+         window[stage][slot] = SHOT_MISSING;
+      }
+   }
+   reached = 0;
+   axes_done = 0;
+   active = false;
+   next_slot = 0;
+   shots = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method starts timing a shot. The command may have arrived a little while
+ *  before the shot begins, so its arrival time is given by the caller; the command
+ *  is marked as parsed now.
+ *  @param received_ticks The RTOS tick count when the command's last key arrived
+ */
+
+void shot_trace::begin (portTickType received_ticks) {
+   portENTER_CRITICAL ();
+   stamps[SHOT_RECEIVED] = received_ticks;
+   reached = 1 << SHOT_RECEIVED;
+   axes_done = 0;
+   active = true;
+   portEXIT_CRITICAL ();
+
+   mark (SHOT_PARSED);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method records the time at which a stage of the shot in progress was
+ *  reached. If the stage has been reached already in this shot, or no shot is in
+ *  progress, nothing is recorded.
+ *  @param stage The stage which has just been reached
+ */
+
+void shot_trace::mark (shot_stage stage) {
+   portTickType now = xTaskGetTickCount ();
+
+   portENTER_CRITICAL ();
+   if (active && !(reached & (1 << stage))) {
+      stamps[stage] = now;
+      reached |= 1 << stage;
+   }
+   portEXIT_CRITICAL ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method records that one axis has finished moving. When every axis has, the
+ *  shot is marked as being on target.
+ *  @param axis The bit for the axis, \c SHOT_AXIS_MOTOR or \c SHOT_AXIS_STEPPER
+ */
+
+void shot_trace::mark_axis (uint8_t axis) {
+   bool all_done;
+
+   portENTER_CRITICAL ();
+   axes_done |= axis;
+   all_done = (axes_done == SHOT_AXES_ALL);
+   portEXIT_CRITICAL ();
+
+   if (all_done) {
+      mark (SHOT_ON_TARGET);
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method marks the last stage of the shot in progress, then works out how long
+ *  each stage took after the stage it follows and saves the times in the window,
+ *  replacing those of the oldest shot there. A stage which wasn't reached, or which
+ *  follows a stage that wasn't, is saved as missing.
+ */
+
+void shot_trace::finish (void) {
+   mark (SHOT_HOMED);
+
+   portENTER_CRITICAL ();
+   if (!active) {
+      portEXIT_CRITICAL ();
+      return;
+   }
+   active = false;
+   portEXIT_CRITICAL ();
+
+   for (uint8_t stage = 0; stage < SHOT_STAGES; stage++) {
+      uint8_t after = pgm_read_byte (&shot_after[stage]);
+      uint8_t end = (stage == SHOT_RECEIVED) ? (uint8_t)SHOT_HOMED : stage;
+      uint16_t time_ms = SHOT_MISSING;
+
+      if ((reached & (1 << end)) && (reached & (1 << after))) {
+         uint32_t ms = (uint32_t)(stamps[end] - stamps[after]) * 1000UL
+                       / configTICK_RATE_HZ;
+         time_ms = (ms < SHOT_MISSING) ? (uint16_t)ms : SHOT_MISSING - 1;
+      }
+      window[stage][next_slot] = time_ms;
+   }
+
+   if (++next_slot >= SHOT_WINDOW) {
+      next_slot = 0;
+   }
+   shots++;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints one row of the table for one stage: how many shots in the
+ *  window reached it, then the median, 90th percentile and longest of their times.
+ *  The times are sorted in a copy so the window keeps its order.
+ *  @param ser_dev The serial device on which to print
+ *  @param stage The stage whose row is printed
+ */
+
+void shot_trace::print_row (emstream& ser_dev, uint8_t stage) {
+   uint16_t sorted[SHOT_WINDOW];
+   uint8_t have = 0;
+
+   for (uint8_t slot = 0; slot < SHOT_WINDOW; slot++) {
+      uint16_t time_ms = window[stage][slot];
+      if (time_ms == SHOT_MISSING) {
+         continue;
+      }
+      uint8_t place = have++;
+      while (place > 0 && sorted[place - 1] > time_ms) {
+         sorted[place] = sorted[place - 1];
+         place--;
+      }
+      sorted[place] = time_ms;
+   }
+
+   ser_dev << _p_str << shot_names[stage] << PMS ("\t\t") << have;
+   if (have == 0) {
+      ser_dev << PMS ("\t-\t-\t-") << endl;
+      return;
+   }
+   ser_dev << '\t' << sorted[(have - 1) / 2] << '\t' << sorted[(have * 9 - 1) / 10]
+           << '\t' << sorted[have - 1] << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints a table of the stage times for the shots in the window: the
+ *  time of the whole shot first, then each stage in order. All the times are in
+ *  milliseconds, timed from the stage each one follows.
+ *  @param ser_dev The serial device on which to print
+ */
+
+void shot_trace::print (emstream& ser_dev) {
+   ser_dev << PMS ("Shots timed: ") << shots << endl;
+   ser_dev << PMS ("Stage\t\tShots\t50% ms\t90% ms\tMax ms") << endl;
+   ser_dev << PMS ("-----\t\t-----\t------\t------\t------") << endl;
+
+   for (uint8_t stage = 0; stage < SHOT_STAGES; stage++) {
+      print_row (ser_dev, stage);
+   }
+}
@@ -0,0 +1,113 @@
+//**************************************************************************************
+/** \file shot_trace.h
+ *    This file contains a class which times the stages of each aim-and-fire cycle,
+ *    from the moment the command arrives until the stepper is back home. The times
+ *    of the last few shots are kept for each stage so that the user interface can
+ *    show which stage takes the longest and how much it varies. */
+//**************************************************************************************
+
+// This define prevents this .h file from being included multiple times in a .cpp file
+#ifndef _SHOT_TRACE_H_
+#define _SHOT_TRACE_H_
+
+#include <stdlib.h>                    // Prototype declarations for I/O functions
+
+#include "FreeRTOS.h"                  // Primary header for FreeRTOS
+#include "task.h"                      // Header for FreeRTOS task functions
+#include "emstream.h"                  // Header for serial ports and devices
+
+
+/// These are the stages of a shot, in the order in which they usually happen.
+typedef enum
+{
+   SHOT_RECEIVED,                      ///< The last key of the command was typed
+   SHOT_PARSED,                        ///< The command and its argument were checked
+   SHOT_PUBLISHED,                     ///< The aiming setpoints were sent to the tasks
+   SHOT_FIRST_PWM,                     ///< task_P first changed the motor's power
+   SHOT_FIRST_STEP,                    ///< The stepper took its first step
+   SHOT_ON_TARGET,                     ///< Both axes finished moving
+   SHOT_ENERGISED,                     ///< The solenoid was turned on
+   SHOT_RELEASED,                      ///< The solenoid was turned off
+   SHOT_HOMED,                         ///< The stepper reached its limit switch
+   SHOT_STAGES                         ///< How many stages there are
+}
+shot_stage;
+
+/// These bits mark the axes which must finish moving before a shot is on target.
+const uint8_t SHOT_AXIS_MOTOR = 0x01;
+const uint8_t SHOT_AXIS_STEPPER = 0x02;
+const uint8_t SHOT_AXES_ALL = SHOT_AXIS_MOTOR | SHOT_AXIS_STEPPER;
+
+/// How many of the most recent shots are kept for working out the percentiles.
+const uint8_t SHOT_WINDOW = 8;
+
+/// This value in a stage's time means the stage wasn't reached in that shot.
+const uint16_t SHOT_MISSING = 0xFFFF;
+
+
+//-------------------------------------------------------------------------------------
+/** This class times the stages of each shot. The task which runs the shot calls
+ *  \c begin(), then each task marks its stages with \c mark() as it gets to them;
+ *  only the first mark of each stage in a shot counts, so a task can mark a stage
+ *  every time through a loop. When the shot is over, \c finish() works out how long
+ *  each stage took after the stage it follows, and saves those times in a window of
+ *  the last \c SHOT_WINDOW shots. The \c print() method shows the median, 90th
+ *  percentile and longest time of each stage in the window.
+ *
+ *  Marks can come from any task, so the times of the shot in progress are changed
+ *  only in critical sections. When no shot is in progress, \c mark() does nothing.
+ */
+
+class shot_trace
+{
+protected:
+   /// The tick count at which each stage of the shot in progress was reached.
+   portTickType stamps[SHOT_STAGES];
+
+   /// One bit for each stage of the shot in progress which has been reached.
+   uint16_t reached;
+
+   /// One bit for each axis which has finished moving in the shot in progress.
+   uint8_t axes_done;
+
+   /// This flag is set while a shot is in progress.
+   bool active;
+
+   /// The times in milliseconds of each stage, after the stage it follows, for the
+   /// last few shots; row \c SHOT_RECEIVED holds the time of the whole shot.
+   uint16_t window[SHOT_STAGES][SHOT_WINDOW];
+
+   /// Where the next shot's times go in the window.
+   uint8_t next_slot;
+
+   /// How many shots have been timed since the program started.
+   uint16_t shots;
+
+   // Print one stage's count, median, 90th percentile and longest time
+   void print_row (emstream&, uint8_t);
+
+public:
+   // The constructor clears the window of shot times
+   shot_trace (void);
+
+   // Start timing a shot whose command arrived at the given tick count
+   void begin (portTickType);
+
+   // Mark the time at which a stage of the shot in progress was reached
+   void mark (shot_stage);
+
+   // Mark that one axis has finished moving; when all have, the shot is on target
+   void mark_axis (uint8_t);
+
+   // Mark the last stage and save the shot's times in the window
+   void finish (void);
+
+   // Print the stage times of the shots in the window
+   void print (emstream&);
+};
+
+
+/// This is the timer for aim-and-fire cycles, which is created in the main file.
+extern shot_trace* p_shots;
+
+#endif // _SHOT_TRACE_H_
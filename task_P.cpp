@@ -33,37 +33,94 @@ task_P::task_P (const char* a_name,
                         )
    : frt_task (a_name, a_priority, a_stack_size, p_ser_dev) {
 	motor = mDriver;
+	period = 0;
 }
 
 
 //-------------------------------------------------------------------------------------
-/**  This is the main function of task_p. Every iteration it checks if the motor is 
- *	where it is saposed to be. If it's not, it tries to get there. The speeds are 
- *	relative to the distance to travel, with a hardcoded lower and upper bound specific
- *	to the PittMan motor. 
+/**  This is the main function of task_p. Once every control period, \c CONTROL_PERIOD_MS,
+ *	it checks if the motor is where it is saposed to be. If it's not, it works out one
+ *	power to get there and holds it until the next period. The speeds are relative to
+ *	the distance to travel, with a lower and upper bound specific to the PittMan motor.
+ *	The divisor and bounds are the control gains in \c p_gains; new gains from the 
+ *	user interface are swapped in only at the start of a period. Periods start at tick
+ *	counts which are multiples of the period, which the sensor task's slots rely on.
  */
 
 void task_P::run (void) {
 
    uint32_t speed, offset;
+   bool moving = false;
+
+   portTickType period_ticks = configMS_TO_TICKS (CONTROL_PERIOD_MS);
+   portTickType previousTicks = xTaskGetTickCount ();
+   previousTicks -= previousTicks % period_ticks;
+
    for (;;) {
-   		if(!isCorrectPos->get()){
-   			while((offset = abs(correctPos->get() - count->get())) > 0){
-   				speed = offset / 10;
-   				if (speed > 45)
-   					speed = 45;
-   				if(speed < 30)
-   					speed = 30;
-   				if(correctPos->get() < count->get()){
-   					motor->set_power(-speed);
-   				} else {
-   					motor->set_power(speed);
-   				}
-
-   			}
-   			motor->set_power(0);
-   			isCorrectPos->put(true);
-   		}
-   		delay (100);
+      start_period ();
+      if (moving || !isCorrectPos->get ()) {
+         offset = abs (correctPos->get () - count->get ());
+         if (offset > 0) {
+            const control_gains& gains = p_gains->active ();
+            speed = offset / gains.p_divisor;
+            if (speed > (uint32_t)gains.max_power)
+               speed = gains.max_power;
+            if (speed < (uint32_t)gains.min_power)
+               speed = gains.min_power;
+            if (correctPos->get () < count->get ()) {
+               motor->set_power (-speed);
+               log_period (-(int16_t)speed);
+            } else {
+               motor->set_power (speed);
+               log_period (speed);
+            }
+            // Only the first power of a move is the one a shot's timing wants
+            if (!moving) {
+               p_shots->mark (SHOT_FIRST_PWM);
+            }
+            moving = true;
+         } else {
+            motor->set_power (0);
+            isCorrectPos->put (true);
+            p_shots->mark_axis (SHOT_AXIS_MOTOR);
+            moving = false;
+         }
+      }
+      delay_from_to (previousTicks, period_ticks);
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called at the start of each control period, whether or not the 
+ *  motor is moving. If new gains have been staged, they're swapped in here, where no
+ *  power calculation is half done, and the period number is sent to the user as an 
+ *  acknowledgement.
+ */
+
+void task_P::start_period (void) {
+   if (p_gains->apply (period)) {
+      *p_serial << PMS ("Gains applied in period ") << period << endl;
+   }
+   period++;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method puts a record of one control period into the data log, if there is 
+ *  one. Logging only copies the record into a buffer, so it doesn't slow the loop 
+ *  down; if the card falls behind, records are dropped rather than waited for.
+ *  @param power The power which was sent to the motor in this period
+ */
+
+void task_P::log_period (int16_t power) {
+   if (p_logger == NULL) {
+      return;
    }
+   control_record record;
+   record.period = period;
+   record.position = count->get ();
+   record.target = correctPos->get ();
+   record.power = power;
+   p_logger->log_record (LOG_CONTROL, &record, sizeof (control_record));
 }
@@ -1,8 +1,8 @@
 //**************************************************************************************
 /** \file task_P.h
  *    This file contains the header for the logic that gives a perportional control to 
- *    one specific motor. The values are hardCoded to work with the PittMan motor using
- *    no more then one full rotation*/
+ *    one specific motor. The default values are set to work with the PittMan motor 
+ *    using no more then one full rotation, and can be tuned in params.h*/
 //**************************************************************************************
 
 // This define prevents this .h file from being included multiple times in a .cpp file
@@ -23,6 +23,9 @@
 #include "frt_text_queue.h"            // Header for text queue class
 #include "shares.h"                         // Shared inter-task communications
 #include "task_motor.h"               //motor driver wrapper
+#include "params.h"                    // Tunable settings kept in EEPROM
+#include "task_logger.h"               // Data log and its record types
+#include "shot_trace.h"                // Stage timing of aim-and-fire cycles
 
 //-------------------------------------------------------------------------------------
 /** \brief Starts up a new task and grabs the pointer to the motor it will be manipulating
@@ -35,6 +38,15 @@ private:
 protected:
 	motor_driver* motor;
 
+	/// The number of the current control period, counting up from zero.
+	uint32_t period;
+
+	// Apply any newly staged gains at the start of a control period
+	void start_period (void);
+
+	// Put a record of the current control period into the data log
+	void log_period (int16_t);
+
 public:
 
    // This constructor creates a generic task of which many copies can be made
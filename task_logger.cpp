@@ -0,0 +1,69 @@
+//**************************************************************************************
+/** \file task_logger.cpp
+ *    This file contains the task which writes the data log to the SD card. */
+//**************************************************************************************
+
+#include "frt_text_queue.h"                 // Header for text queue class
+#include "frt_queue.h"                      // Header of wrapper for FreeRTOS queues
+#include "frt_shared_data.h"                // Header for thread-safe shared data
+#include "task_logger.h"                    // Header for this logging task
+#include "shares.h"                         // Shared inter-task communications
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor creates the logging task. 
+ *  @param a_name A character string which will be the name of this task
+ *  @param a_priority The priority at which this task will initially run
+ *  @param a_stack_size The size of this task's stack in bytes
+ *  @param p_ser_dev Pointer to a serial device which can be used for printouts
+ *  @param p_a_log Pointer to the logger whose sectors this task writes
+ */
+
+task_logger::task_logger (const char* a_name,
+                          unsigned portBASE_TYPE a_priority,
+                          size_t a_stack_size,
+                          emstream* p_ser_dev,
+                          sector_logger* p_a_log
+                         )
+   : frt_task (a_name, a_priority, a_stack_size, p_ser_dev) {
+   p_log = p_a_log;
+   runs = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called once by the RTOS scheduler. It starts the logger, which gets
+ *  the card ready, and then loops writing sectors as they fill. If the card can't be
+ *  used, the task says so and then just sleeps.
+ */
+
+void task_logger::run (void) {
+   if (!p_log->start ()) {
+      *p_serial << PMS ("No card; data log is off") << endl;
+      for (;;) {
+         delay_ms (60000);
+      }
+   }
+
+   for (;;) {
+      if (!p_log->service (configMS_TO_TICKS (LOGGER_FLUSH_MS))) {
+         p_log->flush ();
+      }
+      runs++;
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the usual task status and then the logger's counters.
+ *  @param ser_thing The serial device on which to print
+ */
+
+void task_logger::print_status (emstream& ser_thing) {
+   // Call the parent task's printing function first
+   frt_task::print_status (ser_thing);
+
+   // Now add the additional data
+   ser_thing << "\t " << runs << PMS (" runs") << endl << PMS ("   ");
+   p_log->print_status (ser_thing);
+}
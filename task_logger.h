@@ -0,0 +1,82 @@
+//**************************************************************************************
+/** \file task_logger.h
+ *    This file contains the header for a low priority task which writes the data log
+ *    to the SD card. Other tasks put records into the log's sector buffers as they 
+ *    run; this task sleeps until a sector is full and then writes it, so the time the
+ *    card takes to write never holds up the control tasks. */
+//**************************************************************************************
+
+// This define prevents this .h file from being included multiple times in a .cpp file
+#ifndef _TASK_LOGGER_H_
+#define _TASK_LOGGER_H_
+
+#include <stdlib.h>                    // Prototype declarations for I/O functions
+
+#include "FreeRTOS.h"                  // Primary header for FreeRTOS
+#include "task.h"                      // Header for FreeRTOS task functions
+
+#include "frt_task.h"                  // ME405/507 base task class
+#include "sector_logger.h"             // Double buffered logger for block devices
+
+
+/// How long the task waits for a full sector before saving a partly full one.
+const uint16_t LOGGER_FLUSH_MS = 1000;
+
+/// These are the kinds of records which the tasks in this program put in the log.
+typedef enum
+{
+   LOG_CONTROL = 1                     ///< One period of task_P's control loop
+}
+log_type;
+
+
+/// This structure is the record which task_P logs for each control period.
+typedef struct
+{
+   uint32_t period;                    ///< The number of the control period
+   int32_t position;                   ///< The encoder count
+   int32_t target;                     ///< The position task_P is driving toward
+   int16_t power;                      ///< The power sent to the motor
+}
+control_record;
+
+
+/// This is the data log; it's NULL if there's no card to log to.
+extern sector_logger* p_logger;
+
+
+//-------------------------------------------------------------------------------------
+/** This task gets the card ready and then writes full sectors of the log to it. If no
+ *  sector fills up for a while, the records which are waiting are saved anyway, so 
+ *  that little is lost if the power goes off. 
+ */
+
+class task_logger : public frt_task
+{
+private:
+
+protected:
+   /// The logger whose sectors this task writes.
+   sector_logger* p_log;
+
+public:
+   uint32_t runs;                   ///< How many times through the task loop
+
+   // This constructor creates the logging task
+   task_logger (const char* a_name,
+                unsigned portBASE_TYPE a_priority,
+                size_t a_stack_size,
+                emstream* p_ser_dev,
+                sector_logger* p_a_log
+               );
+
+   /** This run method is called by the RTOS and contains a loop which writes sectors
+    *  to the card as they fill up.
+    */
+   void run (void);
+
+   // Print how this task is doing on its tests
+   void print_status (emstream&);
+};
+
+#endif
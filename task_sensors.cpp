@@ -0,0 +1,384 @@
+//**************************************************************************************
+/** \file task_sensors.cpp
+ *    This file contains the sensor service task, which owns the slow sensors and runs
+ *    their conversions on a staggered schedule of slots, one per control period. */
+//**************************************************************************************
+
+#include "frt_text_queue.h"                 // Header for text queue class
+#include "task_sensors.h"                   // Header for this sensor service task
+
+
+/** The slot counter wraps around at this number, which is a multiple of every period
+ *  used in the schedule so the phases stay the same after it wraps.
+ */
+const uint16_t SENSOR_SLOT_WRAP = 60000;
+
+
+//-------------------------------------------------------------------------------------
+/** This constructor creates the sensor service task and sets up each sensor's schedule.
+ *  The compass is read every output period of the HMC6352, the DS182X is started once
+ *  a second (a 12-bit conversion takes up to 750 ms), and the SHT15 once every two
+ *  seconds (it heats itself if measured more often). The phases are chosen so that
+ *  no two sensors are ever started in the same slot.
+ *  @param a_name A character string which will be the name of this task
+ *  @param a_priority The priority at which this task will initially run
+ *  @param a_stack_size The size of this task's stack in bytes
+ *  @param p_ser_dev Pointer to a serial device which can be used for printouts
+ *  @param p_a_compass Pointer to the compass driver, or NULL if there's no compass
+ *  @param p_a_thermo Pointer to the DS182X driver, or NULL if there's no DS182X
+ *  @param p_a_humid Pointer to the SHT15 driver, or NULL if there's no SHT15
+ */
+
+task_sensors::task_sensors (const char* a_name,
+                            unsigned portBASE_TYPE a_priority,
+                            size_t a_stack_size,
+                            emstream* p_ser_dev,
+                            hmc6352* p_a_compass,
+                            avr_ds182x* p_a_thermo,
+                            avr_sht15* p_a_humid
+                           )
+   : frt_task (a_name, a_priority, a_stack_size, p_ser_dev) {
+   p_compass = p_a_compass;
+   p_thermo = p_a_thermo;
+   p_humid = p_a_humid;
+
+   for (uint8_t index = 0; index < SENSOR_COUNT; index++) {
+      sensors[index].state = SNS_IDLE;
+      sensors[index].wait_slots = 0;
+      sensors[index].good_reads = 0;
+      sensors[index].errors = 0;
+      sensors[index].timeouts = 0;
+      sensors[index].deferrals = 0;
+      readings[index] = 0;
+   }
+   humid_temperature = 0;
+
+   sensors[SENSOR_COMPASS].period = 1000 / SENSOR_SLOT_MS;  // Set when the task starts
+   sensors[SENSOR_COMPASS].phase = 1;
+   sensors[SENSOR_THERMO].period = 1000 / SENSOR_SLOT_MS;
+   sensors[SENSOR_THERMO].phase = 3;
+   sensors[SENSOR_HUMID].period = 2000 / SENSOR_SLOT_MS;
+   sensors[SENSOR_HUMID].phase = 7;
+
+   slot = 0;
+   bus_used = false;
+   runs = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method is called once by the RTOS scheduler. Each time around the for (;;)
+ *  loop, which runs once per slot, each sensor's state machine gets a turn. The loop
+ *  timing uses delay_from_to_ms() so the slots don't drift. The motor controller's
+ *  periods start at tick counts which are multiples of the control period, so the
+ *  slots are started \c SENSOR_SLOT_OFFSET_MS after those tick counts; a sensor's bus
+ *  work then never runs just as the control loop is due.
+ */
+
+void task_sensors::run (void) {
+   portTickType slot_ticks = configMS_TO_TICKS (SENSOR_SLOT_MS);
+   portTickType previousTicks = xTaskGetTickCount ();
+
+   previousTicks -= previousTicks % slot_ticks;
+   previousTicks += configMS_TO_TICKS (SENSOR_SLOT_OFFSET_MS);
+
+   // The compass may have been put in continuous mode after this task was created,
+   // so its measurement period is found here
+   if (p_compass != NULL) {
+      sensors[SENSOR_COMPASS].period =
+         p_compass->get_update_period_ms () / SENSOR_SLOT_MS;
+   }
+
+   for (;;) {
+      bus_used = false;
+
+      service_compass ();
+      service_thermo ();
+      service_humid ();
+
+      if (++slot >= SENSOR_SLOT_WRAP) {
+         slot = 0;
+      }
+      runs++;
+      delay_from_to_ms (previousTicks, SENSOR_SLOT_MS);
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method lets one sensor use the bus in the current slot, as long as no other
+ *  sensor has done so already. If the bus has been used, the request is counted as a
+ *  deferral and the sensor will try again in the next slot.
+ *  @param which The sensor which wants to use the bus
+ *  @return True if the sensor may use the bus now, false if it must wait
+ */
+
+bool task_sensors::claim_bus (sensor_index which) {
+   if (bus_used) {
+      sensors[which].deferrals++;
+      return (false);
+   }
+   bus_used = true;
+   return (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method saves a good reading from a sensor along with the time it was read.
+ *  @param which The sensor which gave the reading
+ *  @param value The reading, already converted to engineering units
+ */
+
+void task_sensors::record_good (sensor_index which, int16_t value) {
+   time_stamp now;
+   now.set_to_now ();
+
+   portENTER_CRITICAL ();
+   readings[which] = value;
+   sensors[which].last_good = now;
+   portEXIT_CRITICAL ();
+
+   sensors[which].good_reads++;
+   sensors[which].state = SNS_IDLE;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method records a failed measurement and puts the sensor back to idle, so it
+ *  will be tried again at its next start slot.
+ *  @param which The sensor which failed
+ *  @param timed_out True if the sensor never finished, false for any other error
+ */
+
+void task_sensors::record_error (sensor_index which, bool timed_out) {
+   if (timed_out) {
+      sensors[which].timeouts++;
+   } else {
+      sensors[which].errors++;
+   }
+   sensors[which].state = SNS_IDLE;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method services the compass. In continuous mode the HMC6352 measures on its
+ *  own, so all that's needed is one quick read of its output register each period.
+ */
+
+void task_sensors::service_compass (void) {
+   sensor_entry& me = sensors[SENSOR_COMPASS];
+
+   if (p_compass == NULL) {
+      return;
+   }
+   if (me.state == SNS_IDLE && (slot % me.period) == me.phase) {
+      me.state = SNS_DUE;
+   }
+   if (me.state == SNS_DUE && claim_bus (SENSOR_COMPASS)) {
+      if (p_compass->update ()) {
+         record_good (SENSOR_COMPASS, p_compass->cached_heading ());
+      } else {
+         record_error (SENSOR_COMPASS, false);
+      }
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method services the DS182X thermometer: start a conversion in its slot, check
+ *  each slot after that for the conversion to finish, and then read the result.
+ */
+
+void task_sensors::service_thermo (void) {
+   sensor_entry& me = sensors[SENSOR_THERMO];
+   int16_t raw_data;
+
+   if (p_thermo == NULL) {
+      return;
+   }
+   switch (me.state) {
+      case SNS_IDLE:
+         if ((slot % me.period) == me.phase) {
+            me.state = SNS_DUE;
+         }
+         break;
+
+      case SNS_DUE:                        // A start which had to wait for the bus
+         if (claim_bus (SENSOR_THERMO)) {    // is tried again in each later slot
+            if (p_thermo->start_conversion ()) {
+               me.state = SNS_CONVERTING;
+               me.wait_slots = 0;
+            } else {
+               record_error (SENSOR_THERMO, false);
+            }
+         }
+         break;
+
+      case SNS_CONVERTING:
+         if (++me.wait_slots > SENSOR_TIMEOUT_SLOTS) {
+            record_error (SENSOR_THERMO, true);
+         }
+         else if (p_thermo->conversion_done () && claim_bus (SENSOR_THERMO)) {
+            if (p_thermo->read_conversion (&raw_data)) {
+               record_good (SENSOR_THERMO, p_thermo->raw_to_celsius (raw_data));
+            } else {
+               record_error (SENSOR_THERMO, false);
+            }
+         }
+         break;
+
+      default:
+         me.state = SNS_IDLE;
+         break;
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method services the SHT15. A cycle is a temperature measurement followed by a
+ *  humidity measurement; the sensor signals each one's completion on its data line,
+ *  which costs nothing to check.
+ */
+
+void task_sensors::service_humid (void) {
+   sensor_entry& me = sensors[SENSOR_HUMID];
+
+   if (p_humid == NULL) {
+      return;
+   }
+   switch (me.state) {
+      case SNS_IDLE:
+         if ((slot % me.period) == me.phase) {
+            me.state = SNS_DUE;
+         }
+         break;
+
+      case SNS_DUE:                        // A start which had to wait for the bus
+         if (claim_bus (SENSOR_HUMID)) {     // is tried again in each later slot
+            p_humid->start_temperature ();
+            me.state = SNS_CONVERTING;
+            me.wait_slots = 0;
+         }
+         break;
+
+      case SNS_CONVERTING:
+         if (++me.wait_slots > SENSOR_TIMEOUT_SLOTS) {
+            record_error (SENSOR_HUMID, true);
+            p_humid->reset ();
+         }
+         else if (p_humid->measurement_ready () && claim_bus (SENSOR_HUMID)) {
+            int16_t temperature =
+               p_humid->raw_to_celsius (p_humid->read_measurement ());
+            portENTER_CRITICAL ();
+            humid_temperature = temperature;
+            portEXIT_CRITICAL ();
+            p_humid->start_humidity ();
+            me.state = SNS_CONVERTING_2;
+            me.wait_slots = 0;
+         }
+         break;
+
+      case SNS_CONVERTING_2:
+         if (++me.wait_slots > SENSOR_TIMEOUT_SLOTS) {
+            record_error (SENSOR_HUMID, true);
+            p_humid->reset ();
+         }
+         else if (p_humid->measurement_ready () && claim_bus (SENSOR_HUMID)) {
+            record_good (SENSOR_HUMID,
+                         p_humid->raw_to_humidity (p_humid->read_measurement ()));
+         }
+         break;
+
+      default:
+         me.state = SNS_IDLE;
+         break;
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method returns the latest good reading from a sensor. The compass heading is
+ *  in tenths of a degree, the DS182X temperature in tenths of a degree Celsius, and
+ *  the SHT15 humidity in percent. Use get_age_ms() to see how fresh the reading is.
+ *  @param which The sensor whose reading is wanted
+ *  @return The latest good reading
+ */
+
+int16_t task_sensors::get_reading (sensor_index which) {
+   int16_t a_copy;
+
+   portENTER_CRITICAL ();
+   a_copy = readings[which];
+   portEXIT_CRITICAL ();
+
+   return (a_copy);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method returns the temperature measured by the SHT15 in its latest cycle.
+ *  @return The temperature in tenths of a degree Celsius
+ */
+
+int16_t task_sensors::get_humid_temperature (void) {
+   int16_t a_copy;
+
+   portENTER_CRITICAL ();
+   a_copy = humid_temperature;
+   portEXIT_CRITICAL ();
+
+   return (a_copy);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finds how long ago a sensor gave its latest good reading.
+ *  @param which The sensor whose reading's age is wanted
+ *  @return The age of the reading in milliseconds, or 0xFFFFFFFF if there hasn't been
+ *          a good reading yet
+ */
+
+uint32_t task_sensors::get_age_ms (sensor_index which) {
+   time_stamp then;
+
+   if (sensors[which].good_reads == 0) {
+      return (0xFFFFFFFF);
+   }
+   portENTER_CRITICAL ();
+   then = sensors[which].last_good;
+   portEXIT_CRITICAL ();
+
+   time_stamp age;
+   age.set_to_now ();
+   age -= then;
+
+   return (age.get_seconds () * 1000UL + age.get_microsec () / 1000UL);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints the usual task status, then one line per fitted sensor showing
+ *  its latest reading, how old it is, and its good, error, timeout and deferral counts.
+ *  @param ser_thing The serial device on which to print
+ */
+
+void task_sensors::print_status (emstream& ser_thing) {
+   // Call the parent task's printing function first
+   frt_task::print_status (ser_thing);
+
+   // Now add the additional data
+   ser_thing << "\t " << runs << PMS (" runs");
+
+   void* fitted[SENSOR_COUNT] = { p_compass, p_thermo, p_humid };
+   for (uint8_t index = 0; index < SENSOR_COUNT; index++) {
+      if (fitted[index] == NULL) {
+         continue;
+      }
+      sensor_entry& me = sensors[index];
+      ser_thing << endl << PMS ("   sensor ") << index << PMS (": ")
+                << get_reading ((sensor_index)index) << PMS (" age ")
+                << get_age_ms ((sensor_index)index) << PMS (" ms, ")
+                << me.good_reads << PMS (" good, ") << me.errors << PMS (" err, ")
+                << me.timeouts << PMS (" tout, ") << me.deferrals << PMS (" defer");
+   }
+}
@@ -0,0 +1,168 @@
+//**************************************************************************************
+/** \file task_sensors.h
+ *    This file contains the header for a task which owns all the slow sensors (the
+ *    DS182X thermometer, the SHT15 temperature and humidity sensor, and the HMC6352
+ *    compass). Instead of each sensor blocking inside its own task while it converts,
+ *    this one task starts each sensor's conversion, checks back on it once per time
+ *    slot, and reads the result when it's done. Each sensor is started in its own
+ *    phase of the schedule so their bus traffic never lands in the same slot, and the
+ *    slots are lined up with the control period so that the bus work lands halfway
+ *    between the control loop's wakeups. */
+//**************************************************************************************
+
+// This define prevents this .h file from being included multiple times in a .cpp file
+#ifndef _TASK_SENSORS_H_
+#define _TASK_SENSORS_H_
+
+#include <stdlib.h>                    // Prototype declarations for I/O functions
+
+#include "FreeRTOS.h"                  // Primary header for FreeRTOS
+#include "task.h"                      // Header for FreeRTOS task functions
+
+#include "frt_task.h"                  // ME405/507 base task class
+#include "frt_queue.h"                 // Header of wrapper for FreeRTOS queues
+#include "frt_shared_data.h"           // Header for thread-safe shared data
+#include "frt_text_queue.h"            // Header for text queue class
+#include "shares.h"                    // Shared items, including the control period
+#include "time_stamp.h"                // Class to implement a microsecond timer
+#include "avr_ds182x.h"                // DS182X one-wire thermometer driver
+#include "avr_sht15.h"                 // SHT15 temperature and humidity driver
+#include "hmc6352.h"                   // HMC6352 compass driver
+
+
+/// The length of one schedule slot in milliseconds; the task runs once per slot.
+const uint8_t SENSOR_SLOT_MS = CONTROL_PERIOD_MS;
+
+/** How long after the start of each control period a slot begins, in milliseconds.
+ *  The control task wakes at the start of the period; starting the sensors' bus work
+ *  half a period later keeps it clear of the control loop's deadline.
+ */
+const uint8_t SENSOR_SLOT_OFFSET_MS = CONTROL_PERIOD_MS / 2;
+
+/// How many slots a sensor may wait for a conversion before it counts as a timeout.
+const uint8_t SENSOR_TIMEOUT_SLOTS = 100;
+
+/// These are the indices of the sensors in the schedule and statistics tables.
+typedef enum
+{
+   SENSOR_COMPASS = 0,                 ///< The HMC6352 compass
+   SENSOR_THERMO = 1,                  ///< The DS182X thermometer
+   SENSOR_HUMID = 2,                   ///< The SHT15 temperature/humidity sensor
+   SENSOR_COUNT = 3                    ///< How many sensors there are
+}
+sensor_index;
+
+/// These are the steps each sensor goes through in a measurement cycle.
+typedef enum
+{
+   SNS_IDLE,                           ///< Waiting for the sensor's next start slot
+   SNS_DUE,                            ///< Start slot reached, waiting for the bus
+   SNS_CONVERTING,                     ///< Waiting for a (first) conversion to finish
+   SNS_CONVERTING_2                    ///< Waiting for a second conversion (SHT15 RH)
+}
+sensor_state;
+
+
+//-------------------------------------------------------------------------------------
+/** This structure holds the schedule and statistics for one sensor. The sensor is
+ *  started in slots where (slot % period) == phase; between starts, the task only
+ *  checks (cheaply) whether the conversion is done.
+ */
+
+typedef struct
+{
+   uint16_t period;                    ///< Slots between the starts of measurements
+   uint16_t phase;                     ///< Slot within the period to start measuring
+   sensor_state state;                 ///< Where the sensor is in its cycle
+   uint8_t wait_slots;                 ///< Slots spent waiting for this conversion
+   uint16_t good_reads;                ///< Number of successful measurements
+   uint16_t errors;                    ///< Number of failed starts or bad readings
+   uint16_t timeouts;                  ///< Number of conversions which never finished
+   uint16_t deferrals;                 ///< Bus operations pushed to a later slot
+   time_stamp last_good;               ///< When the last good measurement was read
+}
+sensor_entry;
+
+
+//-------------------------------------------------------------------------------------
+/** This task runs all the slow sensors on a staggered schedule. At most one bus
+ *  operation (a start or a read) is done in each slot; if two sensors need the bus
+ *  in the same slot, the later one waits for the next slot and the wait is counted
+ *  as a deferral. Any of the sensor pointers may be NULL if that sensor isn't fitted.
+ */
+
+class task_sensors : public frt_task
+{
+private:
+
+protected:
+   /// A pointer to the compass driver, or NULL if there's no compass.
+   hmc6352* p_compass;
+
+   /// A pointer to the one-wire thermometer driver, or NULL if there's none.
+   avr_ds182x* p_thermo;
+
+   /// A pointer to the temperature and humidity sensor driver, or NULL if none.
+   avr_sht15* p_humid;
+
+   /// The schedule and statistics for each sensor.
+   sensor_entry sensors[SENSOR_COUNT];
+
+   /// The latest good readings: heading (0.1 deg), temperature (0.1 C), RH (%).
+   int16_t readings[SENSOR_COUNT];
+
+   /// The latest SHT15 temperature (0.1 C), read just before its humidity.
+   int16_t humid_temperature;
+
+   /// The number of the current schedule slot, counting up from zero.
+   uint16_t slot;
+
+   /// This flag is set once a bus operation has been done in the current slot.
+   bool bus_used;
+
+   // Try to claim the bus for one operation in the current slot
+   bool claim_bus (sensor_index);
+
+   // Record a good reading for a sensor
+   void record_good (sensor_index, int16_t);
+
+   // Record a failed measurement and put the sensor back to idle
+   void record_error (sensor_index, bool);
+
+   // Run one slot's worth of the state machine for each sensor
+   void service_compass (void);
+   void service_thermo (void);
+   void service_humid (void);
+
+public:
+   uint32_t runs;                   ///< How many times through the task loop
+
+   // This constructor creates the sensor service task
+   task_sensors (const char* a_name,
+                 unsigned portBASE_TYPE a_priority,
+                 size_t a_stack_size,
+                 emstream* p_ser_dev,
+                 hmc6352* p_a_compass,
+                 avr_ds182x* p_a_thermo,
+                 avr_sht15* p_a_humid
+                );
+
+   /** This run method is called by the RTOS and contains a loop which services each
+    *  sensor once per slot.
+    */
+   void run (void);
+
+   // Get the latest good reading from a sensor
+   int16_t get_reading (sensor_index);
+
+   // Get the SHT15's latest temperature reading
+   int16_t get_humid_temperature (void);
+
+   // Find how long ago, in milliseconds, a sensor last gave a good reading
+   uint32_t get_age_ms (sensor_index);
+
+   // Print how this task is doing on its tests
+   void print_status (emstream&);
+};
+
+#endif
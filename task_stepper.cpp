@@ -43,6 +43,7 @@ task_stepper::task_stepper (const char* a_name,
    driver = p_driver;
    speed = p_speed;
    numSteps = p_numSteps;
+   rpm = p_params->get (&machine_params::stepper_rpm);
 }
 
 
@@ -57,6 +58,11 @@ void task_stepper::run (void) {
    // This is the task loop for the motor control task. This loop runs until the
    // power is turned off or something equally dramatic occurs.
    for (;;) {
+     // If the speed setting has been tuned, use the new speed
+     if (p_params->get (&machine_params::stepper_rpm) != rpm) {
+        rpm = p_params->get (&machine_params::stepper_rpm);
+        driver->setSpeed(rpm);
+     }
      if (speed->get()) {
         driver->setSpeed(speed->get());
         speed->put(0);
@@ -22,6 +22,7 @@
 #include "frt_queue.h"                 // Header of wrapper for FreeRTOS queues
 #include "frt_shared_data.h"           // Header for thread-safe shared data
 #include "Stepper.h"
+#include "params.h"                    // Tunable settings kept in EEPROM
 #include "adc.h"
 
 
@@ -43,6 +44,9 @@ protected:
    /// A pointer to the power shared data.
    shared_data<int16_t>* numSteps;
 
+   /// The stepper speed setting last given to the driver, so changes can be seen.
+   int16_t rpm;
+
 public:
    uint32_t runs;                   ///< How many times through the task loop
 
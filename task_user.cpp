@@ -27,23 +27,106 @@
 
 #include <avr/io.h>							// Port I/O for SFR's
 #include <avr/wdt.h>							// Watchdog timer header
-#include <util/delay.h>
+#include <avr/pgmspace.h>						// For the tables kept in flash memory
+#include <avr/eeprom.h>						// For macros saved in EEPROM
+#include <string.h>							// For memcpy_P()
+#include <stddef.h>							// For offsetof()
 
 #include "nRF24L01_text.h"					// Header for Nordic Semi radio module
 
+#include "isr_profile.h"					// For printing interrupt timing
+#include "ansi_terminal.h"					// Escape codes for the live dashboard
 #include "task_user.h"						// Header for this file
-#define BUFF_LEN 6
-#define NUM_SQUARES 16
 
 
 /** This constant sets how many RTOS ticks the task delays if the user's not talking.
  *  The duration is calculated to be about 5 ms.
  */
 const portTickType ticks_to_delay = ((configTICK_RATE_HZ / 1000) * 5);
+
+/// This constant sets how often, in RTOS ticks, the live dashboard is updated.
+const portTickType dash_period = configTICK_RATE_HZ;
 /// Determines which motor is being selected in the user interface.
 bool motor_select;
 
 
+/** This is the command table for the user interface. Each row gives a key, the menus 
+ *  in which the key works, what kind of argument it takes, the method which carries it
+ *  out, and its help text. The help messages are printed from this table, so each
+ *  command's help text is written only once. The rows are in the order in which
+ *  they're shown in the help messages.
+ */
+const user_command task_user::command_table[] PROGMEM =
+{
+	{ 'n', CMD_MENU_MAIN, CMD_ARG_NONE, 0, 0, &task_user::cmd_show_time,
+	  "", "Show the real time NOW" },
+	{ 'v', CMD_MENU_MAIN, CMD_ARG_NONE, 0, 0, &task_user::cmd_show_version,
+	  "", "Show program version and setup" },
+	{ 's', CMD_MENU_MAIN, CMD_ARG_NONE, 0, 0, &task_user::cmd_dump_stacks,
+	  "", "Dump all tasks' stacks" },
+	{ 'm', CMD_MENU_MAIN, CMD_ARG_NONE, 0, 0, &task_user::cmd_motor_menu,
+	  "", "Click this for total control. Muahahaha" },
+	{ 'w', CMD_MENU_MOTOR, CMD_ARG_INT, INT16_MIN, INT16_MAX, &task_user::cmd_set_steps,
+	  "number of steps", "Set number of steps (<0 for backwards)" },
+	{ 'f', CMD_MENU_MOTOR, CMD_ARG_NONE, 0, 0, &task_user::cmd_fire,
+	  "", "FIRE!!!!" },
+	{ 'm', CMD_MENU_MOTOR, CMD_ARG_INT, -4000L, 4000L, &task_user::cmd_set_position,
+	  "distance", "where should encoder motor go [-4000 to 4000]" },
+	{ 'b', CMD_MENU_MOTOR, CMD_ARG_NONE, 0, 0, &task_user::cmd_zero_encoder,
+	  "", "Zero the encoder" },
+	{ 'z', CMD_MENU_MOTOR, CMD_ARG_NONE, 0, 0, &task_user::cmd_find_limit,
+	  "", "Zero the stepper" },
+	{ 'c', CMD_MENU_MOTOR, CMD_ARG_INT, 11L, 44L, &task_user::cmd_go_to_square,
+	  "coords", "Enter Coords [1-4][1-4]" },
+	{ 'x', CMD_MENU_MOTOR, CMD_ARG_NONE, 0, 0, &task_user::cmd_main_menu,
+	  "", "Exit motor setting menu" },
+	{ 'r', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_INT, 1L, 
+	  MACRO_SLOTS, &task_user::cmd_record_macro, "macro slot", 
+	  "Record commands into a macro" },
+	{ 'e', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_end_macro, "", "End macro recording and save it" },
+	{ 'p', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_INT, 1L, 
+	  MACRO_SLOTS, &task_user::cmd_play_macro, "macro slot", 
+	  "Play a macro at full speed" },
+	{ 't', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_INT, 1L, 
+	  MACRO_SLOTS, &task_user::cmd_play_timed, "macro slot", 
+	  "Play a macro with its recorded timing" },
+	{ 'l', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_INT, 0L, 
+	  9999L, &task_user::cmd_macro_loops, "loop count", 
+	  "Set how many times macros play" },
+	{ 'g', CMD_MENU_MAIN | CMD_MENU_MOTOR, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_show_params, "", "Show the tunable settings" },
+	{ 'k', CMD_MENU_MAIN | CMD_MENU_MOTOR, CMD_ARG_INT, 0L, 
+	  sizeof (machine_params) / sizeof (int16_t) - 1, &task_user::cmd_select_param,
+	  "setting number", "Pick a setting to change" },
+	{ '=', CMD_MENU_MAIN | CMD_MENU_MOTOR, CMD_ARG_INT, INT16_MIN, INT16_MAX, 
+	  &task_user::cmd_set_param, "new value", "Change the picked setting" },
+	{ 'a', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_show_shots, "", "Show the aim and fire stage times" },
+	{ 'd', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_dashboard, "", "Turn the live status dashboard on/off" },
+	{ 'i', CMD_MENU_MAIN | CMD_NOT_RECORDED, CMD_ARG_INT, 1L, 10000L, 
+	  &task_user::cmd_notify_bench, "rounds", "Time notifications, semaphore and queue" },
+	{ 'h', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_help, "", "Print this help message" },
+	{ '?', CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_help, "", "" },
+	{ 3, CMD_MENU_MAIN | CMD_MENU_MOTOR | CMD_NOT_RECORDED, CMD_ARG_NONE, 0, 0, 
+	  &task_user::cmd_reboot, "", "Reboot the AVR" }
+};
+
+/// This is the number of rows in the command table.
+const uint8_t task_user::num_commands = sizeof (command_table) 
+										/ sizeof (command_table[0]);
+
+
+/** These are the macros saved in EEPROM. The compiler decides where in EEPROM they go,
+ *  so they won't run into anything else which is kept there. 
+ */
+macro_slot macro_eeprom[MACRO_SLOTS] EEMEM;
+
+
+
 //-------------------------------------------------------------------------------------
 /** This constructor creates a new data acquisition task. Its main job is to call the
  *  parent class's constructor which does most of the work.
@@ -60,100 +143,111 @@ task_user::task_user (const char* a_name,
 					  size_t a_stack_size,
 					  emstream* p_ser_dev
 					 )
-	: frt_task (a_name, a_priority, a_stack_size, p_ser_dev)
+	: frt_task (a_name, a_priority, a_stack_size, p_ser_dev), editor (p_ser_dev)
 {
 	// Save a pointer to the serial port so it can be used to communicate with the user
 	p_serial = p_ser_dev;
 
 	// Initialize the runs counter
 	runs = 0;
+
+	// Start in the main menu, with no command waiting for its argument
+	pending_cmd = CMD_NONE;
+	set_menu (CMD_MENU_MAIN);
+
+	// No macro is being recorded or played; macros play once unless told otherwise
+	record_slot = MACRO_NONE;
+	play_slot = MACRO_NONE;
+	macro_loops = 1;
+
+	// The '=' command changes the first setting until another one is picked
+	selected_param = 0;
+	key_ticks = 0;
+
+	// The motors aren't being aimed and nothing is waiting for the limit switch
+	aim_state = AIM_IDLE;
+	aim_axes = 0;
+
+	// The dashboard isn't made until it's first wanted, as it needs some memory
+	p_dash = NULL;
+	dash_shown = false;
 }
 
 
 //-------------------------------------------------------------------------------------
-/** This task is the main loop that runs the menu. You can chose options from 
-	the main menu, including printing the time, version, and stack, or you can
-	go to the motor menu implemented in motor_menu()
+/** This task is the main loop that runs the menu. Each character typed by the user is
+ *  handed to handle_char(), which looks it up in the command table for the current
+ *  menu (the main menu or the motor menu) or adds it to a command's argument. While 
+ *  waiting for the user to type, the task sleeps in the serial port's 
+ *  \c wait_for_char() and uses no processor time; it wakes up when a key is pressed,
+ *  or every few milliseconds to print any characters other tasks have queued.
  */
 
 void task_user::run (void)
 {
-	char char_in;							// Character read from serial device
-	time_stamp a_time;						// Holds the time so it can be displayed
-
 	// Right before running the loop, print the help message so the user knows which 
 	// keys to press to do something
 	print_help_message ();
 
+	// From now on this task prints the other tasks' lines, so they go through the 
+	// print queue instead of straight to the serial port
+	frt_line_buffer::start_console ();
+
 	// This is the task loop. Once the task has been initialized in the code just
 	// above, the task loop runs, and it keeps running until the power is shut off.
 	// In the loop, we check for characters typed into the serial port and also check
 	// for characters in the print queue; those characters are to be displayed
 	for (;;)
 	{
-		// Check for any characters which might have been typed by the user
-		if (p_serial->check_for_char ())
+		// Sleep until the user types something, or until it's time to check the print
+		// queue or play the next command in a macro; don't sleep if there's already 
+		// something waiting to be printed
+		profile_sleep ();
+		bool key_waiting = p_serial->wait_for_char (print_ser_queue->check_for_char () 
+													? 0 : macro_wait ());
+		profile_wake ();
+		if (key_waiting)
 		{
-			char_in = p_serial->getchar ();			// Read the character
-
-			switch (char_in)
+			// Any key pressed while a macro is playing stops the macro
+			if (play_slot != MACRO_NONE)
+			{
+				p_serial->getchar ();
+				stop_macro ();
+			}
+			else
 			{
-				// The 't' command asks what time it is now
-				case 'n':
-					*p_serial << (a_time.set_to_now ()) << endl;
-					break;
-
-				// The 's' command means dump all the tasks' stacks for examination
-				case 's':
-					print_task_stacks (p_serial);
-					break;
-
-				// Pressing 'v' gives the version number and setup of this program
-				case 'v':
-					show_status ();
-					break;
-
-				// Pressing 'm' gives the motor setting menu
-				case 'm':
-				   motor_menu ();
-				   motor_settings ();
-				   break;
-
-				// A '?' or 'h' is a plea for help; respond with a help message
-				case '?':
-				case 'h':
-					print_help_message ();
-					break;
-
-				// The number 3 is control-C, which means reset the AVR processor
-				case (3):
-					*p_serial << PMS ("Resetting AVR") << endl;
-					wdt_enable (WDTO_120MS);
-					for (;;)
-					{
-					}
-					break;
-
-				// If the character isn't recognized, ask: What's That Function?
-				default:
-					p_serial->putchar (char_in);
-					*p_serial << PMS (":WTF?") << endl;
-					break;
-			};
+				handle_char (p_serial->getchar ());
+			}
+		}
+		// If no key was pressed for a while, a lone Escape cancels an argument
+		else if (pending_cmd != CMD_NONE && editor.idle () == LINE_CANCELLED)
+		{
+			*p_serial << PMS (" cancelled") << endl;
+			pending_cmd = CMD_NONE;
 		}
-		// If no character was typed in, check the print queue to see if another task
-		// has sent this task something to be printed
-		else if (print_ser_queue->check_for_char ())
+
+		// Print whatever other tasks have sent this task to be printed
+		while (print_ser_queue->check_for_char ())
 		{
 			p_serial->putchar (print_ser_queue->getchar ());
 		}
-		// If no character has been typed and no other task sent us something to print, 
-		// wait for approximately a millisecond before we check again
-		else	
+
+		// Move an aim-and-fire sequence along if the step it's waiting for is done
+		step_aim ();
+
+		// If a macro is playing and its next command is due, run that command
+		play_macro ();
+
+		// Keep the live dashboard up to date, if it's being shown
+		if (dash_shown && (portTickType)(xTaskGetTickCount () - dash_ticks) 
+						  >= dash_period)
 		{
-			vTaskDelay (configTICK_RATE_HZ / 1000);
+			paint_dashboard ();
 		}
 
+		// Save the settings to EEPROM once they've stopped being changed for a while
+		p_params->service ();
+
 		// We've made it safely through the loop one more time; claim some credit
 		runs++;
 	}
@@ -161,19 +255,425 @@ void task_user::run (void)
 
 
 //-------------------------------------------------------------------------------------
-/** This method prints out the diferent options for the main menu imlpmented in run(). 
-	It shows the possible inputs it accepts as well as what they do.
+/** This method switches to a different menu. It rebuilds the index which finds each 
+ *  key's row in the command table, so that looking up a command takes the same short
+ *  time no matter how many commands there are. 
+ *  @param new_menu The menu bit, \c CMD_MENU_MAIN or \c CMD_MENU_MOTOR
+ */
+
+void task_user::set_menu (uint8_t new_menu)
+{
+	menu = new_menu;
+
+	memset (cmd_index, CMD_NONE, CMD_KEY_SPAN);
+	for (uint8_t row = 0; row < num_commands; row++)
+	{
+		if (pgm_read_byte (&command_table[row].menus) & menu)
+		{
+			cmd_index[(uint8_t)pgm_read_byte (&command_table[row].key)] = row;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method deals with one character typed by the user. If a command is waiting 
+ *  for its argument, the character goes to the line editor, which handles backspace
+ *  and the arrow keys for recalling earlier arguments; Enter finishes the argument 
+ *  and Escape cancels the command. Otherwise the character is looked up in
+ *  the command index; commands without arguments run right away, and commands with
+ *  arguments prompt for them.
+ *  @param char_in The character which the user typed
+ */
+
+void task_user::handle_char (char char_in)
+{
+	// Note when this key arrived; if it finishes a command, that's when the command
+	// was received as far as the shot timer is concerned
+	key_ticks = xTaskGetTickCount ();
+
+	// If a command is collecting its argument, this character is part of it
+	if (pending_cmd != CMD_NONE)
+	{
+		switch (editor.feed (char_in))
+		{
+			case LINE_DONE:
+				*p_serial << endl;
+				finish_argument ();
+				break;
+			case LINE_CANCELLED:
+				*p_serial << PMS (" cancelled") << endl;
+				pending_cmd = CMD_NONE;
+				break;
+			default:
+				break;
+		}
+		return;
+	}
+
+	// Look up the key; anything outside the index can't be a command
+	uint8_t row = ((uint8_t)char_in < CMD_KEY_SPAN) ? cmd_index[(uint8_t)char_in] 
+													: CMD_NONE;
+	if (row == CMD_NONE)
+	{
+		// If the character isn't recognized, ask: What's That Function?
+		p_serial->putchar (char_in);
+		*p_serial << PMS (":WTF?") << endl;
+		return;
+	}
+
+	if (pgm_read_byte (&command_table[row].arg_type) == CMD_ARG_INT)
+	{
+		*p_serial << PMS ("Enter ") << _p_str << command_table[row].name << PMS (": ");
+		pending_cmd = row;
+		editor.start (CMD_ARG_LEN);
+	}
+	else
+	{
+		run_command (row, 0);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method converts a finished argument to a number, checks it against the limits
+ *  in the command's table row, and runs the command if the number is acceptable. 
+ */
+
+void task_user::finish_argument (void)
+{
+	uint8_t row = pending_cmd;
+	pending_cmd = CMD_NONE;
+
+	char* p_end;
+	int32_t number = strtol (editor.get_line (), &p_end, 10);
+
+	if (editor.get_length () == 0 || *p_end != '\0'
+		|| number < (int32_t)pgm_read_dword (&command_table[row].arg_min)
+		|| number > (int32_t)pgm_read_dword (&command_table[row].arg_max))
+	{
+		*p_serial << PMS ("Bad Input") << endl;
+		return;
+	}
+	run_command (row, number);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method runs the handler method in one row of the command table.
+ *  @param row The row of the command table whose command is to be run
+ *  @param argument The number typed after the command, or 0 if it takes none
+ */
+
+void task_user::run_command (uint8_t row, int32_t argument)
+{
+	user_cmd_handler handler;
+
+	record_step (row, argument);
+
+	memcpy_P (&handler, &command_table[row].handler, sizeof (handler));
+	(this->*handler) (argument);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method prints out the options for the current menu. The keys and their help
+ *  text come from the command table; rows with no help text aren't shown.
  */
 
 void task_user::print_help_message (void)
 {
-	*p_serial << PMS ("FreeRTOS Task Communications Test Program help") << endl;
-	*p_serial << PMS (" n:  Show the real time NOW") << endl;
-	*p_serial << PMS (" v:  Show program version and setup") << endl;
-	*p_serial << PMS (" s:  Dump all tasks' stacks") << endl;
-	*p_serial << PMS (" m:  Click this for total control. Muahahaha") << endl;
-	*p_serial << PMS (" h:  Print this help message") << endl;
-	*p_serial << PMS ("^C:  Reboot the AVR") << endl;
+	if (menu == CMD_MENU_MAIN)
+	{
+		*p_serial << PMS ("FreeRTOS Task Communications Test Program help") << endl;
+	}
+	else
+	{
+		*p_serial << PMS ("Motor Settings") << endl;
+	}
+
+	for (uint8_t row = 0; row < num_commands; row++)
+	{
+		if ((pgm_read_byte (&command_table[row].menus) & menu)
+			&& pgm_read_byte (&command_table[row].help[0]) != '\0')
+		{
+			char key = pgm_read_byte (&command_table[row].key);
+			if (key < ' ')
+			{
+				*p_serial << '^' << (char)(key + '@');
+			}
+			else
+			{
+				*p_serial << ' ' << key;
+			}
+			*p_serial << PMS (":  ") << _p_str << command_table[row].help << endl;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command prints the current time. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_show_time (int32_t argument)
+{
+	time_stamp a_time;						// Holds the time so it can be displayed
+
+	(void)argument;
+	*p_serial << (a_time.set_to_now ()) << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command dumps all the tasks' stacks for examination. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_dump_stacks (int32_t argument)
+{
+	(void)argument;
+	print_task_stacks (p_serial);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command gives the version number and setup of this program. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_show_version (int32_t argument)
+{
+	(void)argument;
+	show_status ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command responds to a plea for help with a help message for the current menu.
+ *  @param argument Not used
+ */
+
+void task_user::cmd_help (int32_t argument)
+{
+	(void)argument;
+	print_help_message ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command, run by typing control-C, resets the AVR processor by letting the
+ *  watchdog timer run out. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_reboot (int32_t argument)
+{
+	(void)argument;
+	*p_serial << PMS ("Resetting AVR") << endl;
+	wdt_enable (WDTO_120MS);
+	for (;;)
+	{
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command switches to the motor setting menu and shows its help message. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_motor_menu (int32_t argument)
+{
+	(void)argument;
+	set_menu (CMD_MENU_MOTOR);
+	print_help_message ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command leaves the motor setting menu and goes back to the main menu. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_main_menu (int32_t argument)
+{
+	(void)argument;
+	*p_serial << PMS ("Returning to main...") << endl;
+	set_menu (CMD_MENU_MAIN);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command tells the stepper motor how many steps to move. 
+ *  @param argument The number of steps; negative numbers go backwards
+ */
+
+void task_user::cmd_set_steps (int32_t argument)
+{
+	p_numSteps->put ((int16_t)argument);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command fires the solenoid. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_fire (int32_t argument)
+{
+	(void)argument;
+	*p_serial << PMS ("FIRE") << endl;
+	p_fire->put (true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command tells the encoded motor where to go. 
+ *  @param argument The position to which the motor should go, -4000 to 4000
+ */
+
+void task_user::cmd_set_position (int32_t argument)
+{
+	pot_1->put (false);
+	correctPos->put (argument);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command sends the encoded motor all the way to the left, to position zero. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_zero_encoder (int32_t argument)
+{
+	(void)argument;
+	pot_1->put (false);
+	correctPos->put (0);
+	*p_serial << PMS ("Full Left") << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command starts waiting for the stepper's limit switch to be pressed. The wait
+ *  is carried on by \c step_aim() in the task loop, so the user interface keeps
+ *  working until the switch is found.
+ *  @param argument Not used
+ */
+
+void task_user::cmd_find_limit (int32_t argument)
+{
+	(void)argument;
+
+	if (aim_state != AIM_IDLE)
+	{
+		*p_serial << PMS ("Busy aiming") << endl;
+		return;
+	}
+	DDRA |= 1 << PIN7;
+	PORTA |= 1 << PIN7;
+	*p_serial << PMS ("Waiting for the limit switch") << endl;
+	aim_state = AIM_LIMIT;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command aims at one square of the target grid. When both motors are in 
+ *  position the solenoid is fired, and then the encoded motor is sent back to zero 
+ *  and the stepper's limit switch is waited for; \c step_aim() does those steps from
+ *  the task loop, so the user interface isn't held up. The aiming numbers for each 
+ *  square come from the settings, so they can be tuned with the 'k' and '=' commands.
+ *  @param argument The square's row and column, as in 11 through 44
+ */
+
+void task_user::cmd_go_to_square (int32_t argument)
+{
+	aim_point aim;
+
+	if (aim_state != AIM_IDLE)
+	{
+		*p_serial << PMS ("Busy aiming") << endl;
+		return;
+	}
+
+	uint8_t index = param_square_index (argument);
+	if (index >= PARAM_SQUARES)
+	{
+		*p_serial << PMS ("Bad Input") << endl;
+		return;
+	}
+	p_params->read (offsetof (machine_params, targets) + index * sizeof (aim_point), 
+					&aim, sizeof (aim_point));
+	p_shots->begin (key_ticks);
+
+	pot_1->put (false);
+	isCorrectPos->put (false);
+	stepperDone->put (false);
+	correctPos->put (aim.position);
+	p_numSteps->put (aim.steps);
+	p_shots->mark (SHOT_PUBLISHED);
+
+	aim_axes = 0;
+	aim_state = AIM_MOVING;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method checks whether the step an aim-and-fire sequence is waiting for has 
+ *  been done and, if so, starts the next one. It's called from every pass through the
+ *  task loop, so it never waits itself. Each motor is counted as in position once 
+ *  it's been seen there, as the motor task can clear \c isCorrectPos again while the 
+ *  stepper is still moving; the solenoid fires only when both axes are in position.
+ */
+
+void task_user::step_aim (void)
+{
+	switch (aim_state)
+	{
+		case AIM_MOVING:
+			if (isCorrectPos->get ())
+			{
+				aim_axes |= SHOT_AXIS_MOTOR;
+			}
+			if (stepperDone->get ())
+			{
+				aim_axes |= SHOT_AXIS_STEPPER;
+			}
+			if (aim_axes == SHOT_AXES_ALL)
+			{
+				doneFiring->put (false);
+				p_fire->put (true);
+				aim_state = AIM_FIRING;
+			}
+			break;
+
+		case AIM_FIRING:
+			if (doneFiring->get ())
+			{
+				correctPos->put (0);
+				DDRA |= 1 << PIN7;
+				PORTA |= 1 << PIN7;
+				aim_state = AIM_HOMING;
+			}
+			break;
+
+		case AIM_HOMING:
+		case AIM_LIMIT:
+			if (!(PINA & (1 << PIN7)))
+			{
+				*p_serial << PMS ("Limit Switch Activated!") << endl;
+				if (aim_state == AIM_HOMING)
+				{
+					p_shots->finish ();
+				}
+				aim_state = AIM_IDLE;
+			}
+			break;
+
+		default:
+			break;
+	}
 }
 
 
@@ -182,7 +682,14 @@ void task_user::print_help_message (void)
  *    \li The name and version of the program
  *    \li The name, status, priority, and free stack space of each task
  *    \li Processor cycles used by each task
+ *    \li The peak depth, throughput and blocked puts of each queue
+ *    \li The number of lines from the tasks which the print queue had no room for
+ *    \li How full the serial port's receiver buffer has been and what it has lost
  *    \li Amount of heap space free and setting of RTOS tick timer
+ *    \li Worst-case response times and recommended task priorities, if 
+ *        \c TASK_PROFILE is defined
+ *    \li The longest critical sections, if \c CRITICAL_PROFILE is defined
+ *    \li Histograms of interrupt run times, if \c ISR_PROFILE is defined
  */
 
 void task_user::show_status (void)
@@ -195,6 +702,13 @@ void task_user::show_status (void)
 	// Have the tasks print their status
 	print_task_list (p_serial);
 
+	// Show how full each queue has been and how many puts had to wait or gave up
+	*p_serial << endl;
+	print_queue_list (p_serial);
+	*p_serial << PMS ("Lines dropped by full print queue: ") 
+			  << frt_line_buffer::get_lines_dropped () << endl;
+	rs232_print_stats (p_serial);
+
 	// Show free heap and the configured heap size
 	*p_serial << PMS ("Heap: ") << heap_left() << "/" << configTOTAL_HEAP_SIZE;
 
@@ -206,6 +720,78 @@ void task_user::show_status (void)
 	#else
 		*p_serial << PMS (", OCR1A=") << OCR1A << endl;
 	#endif
+
+	// If task timing is being measured, check whether the tasks meet their deadlines
+	#ifdef TASK_PROFILE
+		*p_serial << endl;
+		print_schedule (p_serial);
+	#endif
+
+	// If critical sections are being timed, show the worst ones
+	#ifdef CRITICAL_PROFILE
+		*p_serial << endl;
+		crit_profile_print (p_serial);
+	#endif
+
+	// If interrupts are being timed, show their run time histograms
+	#ifdef ISR_PROFILE
+		*p_serial << endl;
+		isr_profile_print (p_serial);
+	#endif
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method draws the live dashboard, or updates it if it's already been drawn. It
+ *  shows the same things as \c show_status() and the motors' positions and states,
+ *  but after the first drawing, only the numbers which have changed are sent to the 
+ *  terminal; at 9600 baud a full status table takes seconds to print, while an 
+ *  update usually takes a few dozen characters.
+ */
+
+void task_user::paint_dashboard (void)
+{
+	dash_ticks = xTaskGetTickCount ();
+
+	p_dash->begin ();
+
+	if (p_dash->is_drawing ())
+	{
+		*p_serial << ATERM_BOLD << PROGRAM_VERSION << ATERM_NORM_INT;
+	}
+	p_dash->label_P (1, 40, PSTR ("Up"));
+	p_dash->show (1, 43, 7, dash_ticks / configTICK_RATE_HZ);
+	p_dash->label_P (1, 52, PSTR ("Heap"));
+	p_dash->show (1, 57, 5, heap_left ());
+
+	// The encoder motor and the stepper, with where they've been told to go
+	p_dash->label_P (3, 1, PSTR ("Encoder"));
+	p_dash->show (3, 10, 8, count->get ());
+	p_dash->label_P (3, 20, PSTR ("Target"));
+	p_dash->show (3, 28, 8, correctPos->get ());
+	p_dash->label_P (3, 38, PSTR ("Power"));
+	p_dash->show (3, 45, 6, power_1->get ());
+	p_dash->label_P (3, 53, PSTR ("In place"));
+	p_dash->show (3, 62, 1, isCorrectPos->get ());
+
+	p_dash->label_P (4, 1, PSTR ("Steps"));
+	p_dash->show (4, 10, 8, p_numSteps->get ());
+	p_dash->label_P (4, 20, PSTR ("Speed"));
+	p_dash->show (4, 28, 8, (int32_t)(p_speed->get ()));
+	p_dash->label_P (4, 38, PSTR ("Done"));
+	p_dash->show (4, 50, 1, stepperDone->get ());
+	p_dash->label_P (4, 53, PSTR ("Fire"));
+	p_dash->show (4, 62, 1, p_fire->get ());
+	p_dash->label_P (4, 66, PSTR ("Fired"));
+	p_dash->show (4, 72, 1, doneFiring->get ());
+
+	// The tables of tasks and queues, with a blank line after each
+	uint8_t row = dashboard_task_list (p_dash, 6);
+	row = dashboard_queue_list (p_dash, row + 1);
+	p_dash->label_P (row + 1, 1, PSTR ("Lines dropped by full print queue"));
+	p_dash->show (row + 1, 35, 5, frt_line_buffer::get_lines_dropped ());
+
+	p_dash->end ();
 }
 
 
@@ -237,235 +823,385 @@ void task_user::print_status (emstream& ser_thing)
 	ser_thing << "\t " << runs << PMS (" runs");
 }
 
-/**
-	This method prints out the diferent options for the motor menu imlpmented in run(). 
-	It shows the possible inputs it accepts as well as what they do.
- */
-void task_user::motor_menu (void)
-{
-   *p_serial << PMS ("Motor Settings") << endl;
-  	*p_serial << PMS (" w:  Set number of steps (<0 for backwards)") << endl;
-  	*p_serial << PMS (" f:  FIRE!!!!") << endl;
-  	*p_serial << PMS (" m:  where should encoder motor go [-4000 to 4000]") << endl;
-	*p_serial << PMS (" h:  print this help message") << endl;
-	*p_serial << PMS (" b:  Zero the encoder") << endl;
-	*p_serial << PMS (" z:  Zero the stepper") << endl;
-	*p_serial << PMS (" c:  Enter Coords [0-3][0-3]") << endl;
-	*p_serial << PMS (" x:  Exit motor setting menu") << endl;
-}
-
-/**
-	This function is the implementation of the motor menu. Given correct inputs it will let you
-	change motor, change pot state, change power settings, run the brakes, and switch back to
-	the main menu. Incorrect input are more or less ignored
-*/
-void task_user::motor_settings (void)
-{
-	char char_in;
-	char buf[BUFF_LEN];
-	int i = 0;
-	int num;
-	bool exit = false;
-	int goodInputs[NUM_SQUARES] = {11, 12, 13, 14, 21, 22, 23, 24, 31, 32, 33, 34, 41, 42, 43, 44};
-	bool motor1Set = false, motor2Set = false;
-
-   while (!exit) {
-   	if (p_serial->check_for_char()) {
-			char_in = p_serial->getchar();
-			for(i = 0; i < BUFF_LEN; i++)
-				buf[i] = 0;
-			i = 0;
-			switch (char_in)
-			{
-				case 'w':
-				   *p_serial << PMS ("Enter number of steps: ");
-				   while (!p_serial->check_for_char());
-				   while ((char_in = p_serial->getchar()) != '\r')
-				   {
-				   	buf[i] = char_in;
-				   	i++;
-				   	*p_serial << char_in;
-				   	while (!p_serial->check_for_char());
-				   }
-				   *p_serial << endl;
-				   // TODO: no error checking yet...
-				   num = strtol(buf, NULL, 10);
-				   p_numSteps->put(num);
-					break;
-				case 'm':
-				   *p_serial << PMS ("Enter distance: ");
-				   while (!p_serial->check_for_char());
-				   while ((char_in = p_serial->getchar()) != '\r')
-				   {
-				   	buf[i] = char_in;
-				   	i++;
-				   	*p_serial << char_in;
-				   	while (!p_serial->check_for_char());
-				   }
-				   *p_serial << endl;
-				   // TODO: no error checking yet...
-				   num = strtol(buf, NULL, 10);
-				   pot_1->put(false);
-				   correctPos->put(num);
-					break;
-				case 'f':
-					*p_serial << char_in;
-				    *p_serial << endl;
-					*p_serial << "FIRE" << endl;
-
-					p_fire->put(true);
-					break;
-				case 'x':
-					*p_serial << PMS ("Returning to main...") << endl;
-					exit = true;
-				   break;
-				case 'h':
-					motor_menu();
-					break;
-				case 'b':
-				    pot_1->put(false);
-				    correctPos->put(0);
-				    *p_serial << PMS ("Full Left") << endl;
-					break;
-				case 'z':
-					DDRA |= 1 << PIN7;
-					PORTA |= 1 << PIN7;
-					while((PINA & (1 << PIN7))){
-						_delay_ms(200);
-						*p_serial << PMS ("Limit switch not activated") << endl;
-					}
-					*p_serial << PMS ("Limit Switch Activated!") << endl;
-					break;
-				case 'c':
-				   *p_serial << PMS ("Enter Coords: ");
-				   while (!p_serial->check_for_char());
-				   while ((char_in = p_serial->getchar()) != '\r')
-				   {
-				   	buf[i] = char_in;
-				   	i++;
-				   	*p_serial << char_in;
-				   	while (!p_serial->check_for_char());
-				   }
-				   *p_serial << endl;
-				   // TODO: no error checking yet...
-				   num = strtol(buf, NULL, 10);
-
-					for(i = 0; i < NUM_SQUARES; i++){
-						if(num == goodInputs[i])
-							break;
-					}
-					if(i == NUM_SQUARES){
-						*p_serial << PMS ("Bad Input") << endl;
-						break;
-					}
-					pot_1->put(false);
-					stepperDone->put(false);
-					switch(num){
-						case 11:
-							correctPos->put(1000); //hard coded number for encoded motor
-							p_numSteps->put(-10); //hard coded number for stepper
-							break;
-						case 12:
-							correctPos->put(3000); //hard coded number for encoded motor
-							p_numSteps->put(-20); //hard coded number for stepper
-							break;
-						case 13:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 14:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 21:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 22:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 23:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 24:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 31:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 32:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 33:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 34:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 41:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 42:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 43:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						case 44:
-							correctPos->put(0); //hard coded number for encoded motor
-							p_numSteps->put(0); //hard coded number for stepper
-							break;
-						default:
-							break;
-					}
-					
-					motor2Set = motor1Set = false;
-
-					while(!motor1Set && !motor2Set){
-						if(isCorrectPos->get())
-							motor1Set = true;
-						if(stepperDone->get())
-							motor2Set = true;
-						*p_serial << "m1: " << motor1Set << "m2: " << motor2Set << endl;
-						delay(100);
-					}
-
-					doneFiring->put(false);
-					p_fire->put(true);
-
-					while(!doneFiring->get()){
-						delay(10);
-					}
-
-					correctPos->put(0);
-
-					DDRA |= 1 << PIN7;
-					PORTA |= 1 << PIN7;
-					while((PINA & (1 << PIN7))){
-
-						_delay_ms(200);
-						*p_serial << PMS ("Limit switch not activated") << endl;
-					}
-
-
-
-					break;
-				default:
-					p_serial->putchar (char_in);
-					*p_serial << PMS (":WTF?") << endl;
-				   break;
-			}
+
+
+//-------------------------------------------------------------------------------------
+/** This method saves a command in the macro being recorded, if there is one. Commands
+ *  which control macros, or which only print help, aren't recorded. Each command is 
+ *  written to EEPROM as soon as it's run, so nothing needs to be kept in RAM.
+ *  @param row The row of the command table whose command is being run
+ *  @param argument The argument which was typed for the command
+ */
+
+void task_user::record_step (uint8_t row, int32_t argument)
+{
+	if (record_slot == MACRO_NONE 
+		|| (pgm_read_byte (&command_table[row].menus) & CMD_NOT_RECORDED))
+	{
+		return;
+	}
+	if (record_count >= MACRO_MAX_STEPS)
+	{
+		*p_serial << PMS ("Macro full; command not recorded") << endl;
+		return;
+	}
+
+	portTickType now = xTaskGetTickCount ();
+	uint32_t gap = (record_count == 0) ? 0 
+				   : (uint32_t)(now - record_ticks) * 1000UL / configTICK_RATE_HZ;
+	record_ticks = now;
+
+	macro_step step;
+	step.key = pgm_read_byte (&command_table[row].key);
+	step.menu = menu;
+	step.gap_ms = (gap > 0xFFFF) ? 0xFFFF : (uint16_t)gap;
+	step.argument = argument;
+
+	eeprom_update_block (&step, &macro_eeprom[record_slot].steps[record_count], 
+						 sizeof (macro_step));
+	record_count++;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method begins playing a macro from EEPROM. The commands are run directly from
+ *  their table rows, without going through the character-by-character parser. 
+ *  @param slot The macro slot to be played, 1 through \c MACRO_SLOTS
+ *  @param timed True to play with the recorded timing, false to play at full speed
+ */
+
+void task_user::start_macro (int32_t slot, bool timed)
+{
+	if (record_slot != MACRO_NONE)
+	{
+		*p_serial << PMS ("Can't play a macro while recording") << endl;
+		return;
+	}
+
+	uint8_t num_steps = eeprom_read_byte (&macro_eeprom[slot - 1].num_steps);
+	if (num_steps == 0 || num_steps > MACRO_MAX_STEPS)
+	{
+		*p_serial << PMS ("Macro ") << (uint8_t)slot << PMS (" is empty") << endl;
+		return;
+	}
+
+	*p_serial << PMS ("Playing macro ") << (uint8_t)slot 
+			  << PMS ("; press any key to stop") << endl;
+	play_slot = slot - 1;
+	play_step = 0;
+	play_loops = macro_loops;
+	play_timed = timed;
+	play_ticks = xTaskGetTickCount ();
+	play_wait = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method finds how long the task may sleep before the next command in a playing
+ *  macro is due. When no macro is playing, or the motors are still being aimed by one
+ *  of its commands, it's the usual wait for the user. 
+ *  @return The number of RTOS ticks the task may sleep
+ */
+
+portTickType task_user::macro_wait (void)
+{
+	// A macro's next command waits until an aim-and-fire sequence has finished
+	if (play_slot == MACRO_NONE || aim_state != AIM_IDLE)
+	{
+		return (ticks_to_delay);
+	}
+
+	portTickType waited = xTaskGetTickCount () - play_ticks;
+	if (waited >= play_wait)
+	{
+		return (0);
+	}
+	portTickType left = play_wait - waited;
+	return ((left < ticks_to_delay) ? left : ticks_to_delay);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method runs the next command of a playing macro if it's due. At full speed 
+ *  each command runs as soon as the previous one is done; with recorded timing, the
+ *  same gaps are left between commands as were left when the macro was recorded. 
+ */
+
+void task_user::play_macro (void)
+{
+	if (play_slot == MACRO_NONE || macro_wait () != 0)
+	{
+		return;
+	}
+
+	macro_step step;
+	eeprom_read_block (&step, &macro_eeprom[play_slot].steps[play_step], 
+					   sizeof (macro_step));
+
+	// Find the command's row; it must be in the menu in which it was recorded
+	uint8_t row;
+	for (row = 0; row < num_commands; row++)
+	{
+		if (pgm_read_byte (&command_table[row].key) == step.key
+			&& (pgm_read_byte (&command_table[row].menus) & step.menu))
+		{
+			break;
+		}
+	}
+	if (row < num_commands)
+	{
+		if (menu != step.menu)
+		{
+			set_menu (step.menu);
+		}
+		key_ticks = xTaskGetTickCount ();
+		run_command (row, step.argument);
+	}
+
+	// Move to the next command, going back to the first one at the end of each loop
+	if (++play_step >= eeprom_read_byte (&macro_eeprom[play_slot].num_steps))
+	{
+		play_step = 0;
+		if (play_loops != 0 && --play_loops == 0)
+		{
+			*p_serial << PMS ("Macro done") << endl;
+			play_slot = MACRO_NONE;
+			return;
 		}
-   }
+	}
+
+	play_ticks = xTaskGetTickCount ();
+	play_wait = 0;
+	if (play_timed)
+	{
+		eeprom_read_block (&step, &macro_eeprom[play_slot].steps[play_step], 
+						   sizeof (macro_step));
+		play_wait = (portTickType)((uint32_t)step.gap_ms * configTICK_RATE_HZ / 1000UL);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This method stops a macro which is playing. 
+ */
+
+void task_user::stop_macro (void)
+{
+	play_slot = MACRO_NONE;
+	*p_serial << PMS ("Macro stopped") << endl;
 }
 
+
+//-------------------------------------------------------------------------------------
+/** This command starts recording commands into a macro slot. Every command run after
+ *  this one, along with the time between commands, is saved until the 'e' command
+ *  ends the recording. A recording which has been started must be ended before 
+ *  another can begin, so its slot isn't left marked empty.
+ *  @param argument The macro slot to record into, 1 through \c MACRO_SLOTS
+ */
+
+void task_user::cmd_record_macro (int32_t argument)
+{
+	if (play_slot != MACRO_NONE)
+	{
+		return;
+	}
+	if (record_slot != MACRO_NONE)
+	{
+		*p_serial << PMS ("Already recording macro ") << (uint8_t)(record_slot + 1)
+				  << PMS ("; 'e' to end it first") << endl;
+		return;
+	}
+
+	// Mark the slot empty until the recording is finished
+	record_slot = argument - 1;
+	record_count = 0;
+	eeprom_update_byte (&macro_eeprom[record_slot].num_steps, 0);
+
+	*p_serial << PMS ("Recording macro ") << (uint8_t)argument 
+			  << PMS ("; 'e' to end") << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command ends recording and saves the number of commands in the macro. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_end_macro (int32_t argument)
+{
+	(void)argument;
+
+	if (record_slot == MACRO_NONE)
+	{
+		*p_serial << PMS ("Not recording") << endl;
+		return;
+	}
+
+	eeprom_update_byte (&macro_eeprom[record_slot].num_steps, record_count);
+	*p_serial << PMS ("Saved ") << record_count << PMS (" commands in macro ") 
+			  << (uint8_t)(record_slot + 1) << endl;
+	record_slot = MACRO_NONE;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command plays a macro as fast as its commands can run. 
+ *  @param argument The macro slot to play, 1 through \c MACRO_SLOTS
+ */
+
+void task_user::cmd_play_macro (int32_t argument)
+{
+	start_macro (argument, false);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command plays a macro with the timing used when it was recorded. 
+ *  @param argument The macro slot to play, 1 through \c MACRO_SLOTS
+ */
+
+void task_user::cmd_play_timed (int32_t argument)
+{
+	start_macro (argument, true);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command sets how many times each macro is played. 
+ *  @param argument The number of times to play; 0 means play until a key is pressed
+ */
+
+void task_user::cmd_macro_loops (int32_t argument)
+{
+	macro_loops = (uint16_t)argument;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command prints every tunable setting with its number, followed by how many 
+ *  times the settings have been saved to EEPROM since the program started. 
+ *  @param argument Not used
+ */
+
+void task_user::cmd_show_params (int32_t argument)
+{
+	(void)argument;
+
+	for (uint8_t index = 0; index < param_count (); index++)
+	{
+		*p_serial << index << PMS (": ");
+		param_print_name (*p_serial, index);
+		*p_serial << PMS (" = ") << param_get (index) << endl;
+	}
+	*p_serial << PMS ("Saved copy ") << p_params->get_sequence () << PMS (", ") 
+			  << p_params->get_writes () << PMS (" writes");
+	if (p_params->is_dirty ())
+	{
+		*p_serial << PMS (", changes not saved yet");
+	}
+	*p_serial << endl << PMS ("Gains: ") << p_gains->get_applied_count () << PMS (" of ")
+			  << p_gains->get_staged_count () << PMS (" sets applied, latest in period ")
+			  << p_gains->get_applied_period () << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command picks the setting which the '=' command will change, and shows its 
+ *  name and present value.
+ *  @param argument The number of the setting, as shown by the 'g' command
+ */
+
+void task_user::cmd_select_param (int32_t argument)
+{
+	selected_param = (uint8_t)argument;
+
+	param_print_name (*p_serial, selected_param);
+	*p_serial << PMS (" = ") << param_get (selected_param) << endl;
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command changes the setting picked with the 'k' command. The change is saved
+ *  to EEPROM a couple of seconds after the last change. If the setting is one of the
+ *  control gains, the whole set of gains is staged for task_P, which swaps it in at
+ *  the start of its next period and says in which period it did so.
+ *  @param argument The new value for the setting
+ */
+
+void task_user::cmd_set_param (int32_t argument)
+{
+	param_print_name (*p_serial, selected_param);
+	if (param_set (selected_param, (int16_t)argument))
+	{
+		*p_serial << PMS (" = ") << param_get (selected_param) << endl;
+		if (param_is_gain (selected_param))
+		{
+			control_gains new_gains;
+			param_get_gains (&new_gains);
+			p_gains->stage (new_gains);
+		}
+	}
+	else
+	{
+		*p_serial << PMS (": value out of range") << endl;
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command shows how long each stage of the recent aim-and-fire cycles took,
+ *  so that the slowest stage can be found.
+ *  @param argument Not used
+ */
+
+void task_user::cmd_show_shots (int32_t argument)
+{
+	(void)argument;
+	p_shots->print (*p_serial);
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command turns the live dashboard on or off. While it's on, the top of the
+ *  screen shows the system's status, updated once a second, and everything else 
+ *  scrolls below it, so commands can still be typed.
+ *  @param argument Not used
+ */
+
+void task_user::cmd_dashboard (int32_t argument)
+{
+	(void)argument;
+
+	if (dash_shown)
+	{
+		dash_shown = false;
+		p_dash->stop ();
+		return;
+	}
+
+	if (p_dash == NULL)
+	{
+		p_dash = new ansi_dashboard (p_serial, DASH_FIELDS);
+	}
+	if (p_dash == NULL || !p_dash->is_ready ())
+	{
+		*p_serial << PMS ("Not enough memory for the dashboard") << endl;
+		return;
+	}
+	p_dash->redraw ();
+	dash_shown = true;
+	paint_dashboard ();
+}
+
+
+//-------------------------------------------------------------------------------------
+/** This command times how long it takes to signal a task with a task notification,
+ *  a binary semaphore and a queue, so the quickest way can be chosen for a driver.
+ *  @param argument The number of signals to time with each way
+ */
+
+void task_user::cmd_notify_bench (int32_t argument)
+{
+	notify_benchmark (p_serial, (uint16_t)argument);
+}
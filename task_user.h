@@ -40,7 +40,12 @@
 #include "frt_task.h"						// Header for ME405/507 base task class
 #include "frt_queue.h"						// Header of wrapper for FreeRTOS queues
 #include "frt_text_queue.h"					// Header for a "<<" queue class
+#include "frt_line_buffer.h"					// Whole lines from other tasks to print
 #include "frt_shared_data.h"				// Header for thread-safe shared data
+#include "line_editor.h"					// Line editor for typed arguments
+#include "params.h"							// Tunable settings kept in EEPROM
+#include "shot_trace.h"						// Stage timing of aim-and-fire cycles
+#include "ansi_dashboard.h"					// Live display of the system's status
 
 #include "shares.h"							// Global ('extern') queue declarations
 
@@ -48,6 +53,100 @@
 /// This macro defines a string that identifies the name and version of this program. 
 #define PROGRAM_VERSION		PMS ("PolyDAQ/FreeRTOS Test V0.2 ")
 
+/// This is the longest argument (digits and sign) which can be typed after a command.
+const uint8_t CMD_ARG_LEN = 12;
+
+/// This is the number of keys for which there's a slot in the dispatch index.
+const uint8_t CMD_KEY_SPAN = 128;
+
+/// This value in the dispatch index means that a key has no command in this menu.
+const uint8_t CMD_NONE = 0xFF;
+
+/// These bits tell in which menus a command can be used.
+const uint8_t CMD_MENU_MAIN = 0x01;         ///< The command is in the main menu
+const uint8_t CMD_MENU_MOTOR = 0x02;        ///< The command is in the motor menu
+
+/// This bit, put with the menu bits, keeps a command from being recorded in a macro.
+const uint8_t CMD_NOT_RECORDED = 0x80;
+
+/// This is the number of macros which can be saved in EEPROM.
+const uint8_t MACRO_SLOTS = 4;
+
+/// This is the largest number of commands which can be recorded in one macro.
+const uint8_t MACRO_MAX_STEPS = 16;
+
+/// This value means that no macro is being recorded or played.
+const uint8_t MACRO_NONE = 0xFF;
+
+/// These values tell how far an aim-and-fire sequence or a limit switch wait has got.
+const uint8_t AIM_IDLE = 0;                 ///< Nothing is being waited for
+const uint8_t AIM_MOVING = 1;               ///< Both motors are moving into position
+const uint8_t AIM_FIRING = 2;               ///< The solenoid is firing
+const uint8_t AIM_HOMING = 3;               ///< Waiting for the limit switch after a shot
+const uint8_t AIM_LIMIT = 4;                ///< Waiting for the limit switch alone
+
+/// This is the number of numbers the live dashboard can keep up to date.
+const uint8_t DASH_FIELDS = 80;
+
+/// These values say what, if anything, a command wants typed after its key.
+const uint8_t CMD_ARG_NONE = 0;             ///< The key alone runs the command
+const uint8_t CMD_ARG_INT = 1;              ///< A number and Enter must follow the key
+
+
+class task_user;                            // The command table refers to this class
+
+/// This is the type of a method which carries out a command from the user.
+typedef void (task_user::*user_cmd_handler) (int32_t);
+
+
+//-------------------------------------------------------------------------------------
+/** This structure holds one row of the user interface's command table. The table is
+ *  kept in program (flash) memory, so the strings are stored right in the rows rather
+ *  than pointed to. Adding a command means adding one row and writing its handler.
+ */
+
+typedef struct
+{
+	char key;                               ///< The key which runs the command
+	uint8_t menus;                          ///< Bits for menus which have the command
+	uint8_t arg_type;                       ///< \c CMD_ARG_NONE or \c CMD_ARG_INT
+	int32_t arg_min;                        ///< The smallest argument accepted
+	int32_t arg_max;                        ///< The largest argument accepted
+	user_cmd_handler handler;               ///< Method which carries out the command
+	char name[16];                          ///< Name of the argument, used in prompts
+	char help[48];                          ///< Help text; an empty string hides a row
+}
+user_command;
+
+
+//-------------------------------------------------------------------------------------
+/** This structure holds one recorded command in a macro. The command is saved by its
+ *  key and menu rather than by its row in the command table, so macros still work if
+ *  rows are added to the table. 
+ */
+
+typedef struct
+{
+	char key;                               ///< The key which ran the command
+	uint8_t menu;                           ///< The menu which was in use at the time
+	uint16_t gap_ms;                        ///< Milliseconds since the previous command
+	int32_t argument;                       ///< The argument typed for the command
+}
+macro_step;
+
+
+/** This structure holds one macro as it's saved in EEPROM. Blank EEPROM reads as 0xFF,
+ *  which is more than \c MACRO_MAX_STEPS, so a slot which has never been used is 
+ *  seen as empty. 
+ */
+
+typedef struct
+{
+	uint8_t num_steps;                      ///< How many commands have been recorded
+	macro_step steps[MACRO_MAX_STEPS];      ///< The commands, in the order they're run
+}
+macro_slot;
+
 
 //-------------------------------------------------------------------------------------
 /** This task reads measurements that were taken by the data acquisition task in
@@ -64,6 +163,78 @@ protected:
 	 */
 	emstream* p_serial;
 
+	/// The command table, in flash, which lists every command in every menu.
+	static const user_command command_table[];
+
+	/// The number of rows in the command table.
+	static const uint8_t num_commands;
+
+	/// This is the menu whose commands are currently being accepted.
+	uint8_t menu;
+
+	/** This index finds the row of the command table belonging to a key in the current
+	 *  menu, so a command is found without searching. It's rebuilt when the menu 
+	 *  changes. Keys without commands hold \c CMD_NONE.
+	 */
+	uint8_t cmd_index[CMD_KEY_SPAN];
+
+	/// The row of a command whose argument is being typed, or \c CMD_NONE if none.
+	uint8_t pending_cmd;
+
+	/// This line editor collects the argument of a command as it's being typed.
+	line_editor editor;
+
+	/// The macro slot being recorded into, or \c MACRO_NONE if not recording.
+	uint8_t record_slot;
+
+	/// The number of commands recorded so far in the macro being recorded.
+	uint8_t record_count;
+
+	/// The time at which the previous command was recorded.
+	portTickType record_ticks;
+
+	/// The macro slot being played, or \c MACRO_NONE if no macro is playing.
+	uint8_t play_slot;
+
+	/// The number of the next command to be played from the macro.
+	uint8_t play_step;
+
+	/// How many more times the macro is to be played; 0 means until a key is pressed.
+	uint16_t play_loops;
+
+	/// The number of times a macro will be played, set with the 'l' command.
+	uint16_t macro_loops;
+
+	/// True if the macro is played with its recorded timing, false for full speed.
+	bool play_timed;
+
+	/// The time at which the previous command in the macro was played.
+	portTickType play_ticks;
+
+	/// The time to wait after the previous command before playing the next one.
+	portTickType play_wait;
+
+	/// The number of the setting which the '=' command changes.
+	uint8_t selected_param;
+
+	/// The time at which the last key of the latest command arrived.
+	portTickType key_ticks;
+
+	/// How far the aim-and-fire sequence has got, or \c AIM_IDLE if it isn't running.
+	uint8_t aim_state;
+
+	/// Bits for the axes, \c SHOT_AXIS_MOTOR and \c SHOT_AXIS_STEPPER, now in position.
+	uint8_t aim_axes;
+
+	/// The live dashboard, made the first time it's shown; NULL until then.
+	ansi_dashboard* p_dash;
+
+	/// True while the live dashboard is being kept up to date.
+	bool dash_shown;
+
+	/// The time at which the dashboard was last painted.
+	portTickType dash_ticks;
+
 	// This method displays a simple help message telling the user what to do. It's
 	// protected so that only methods of this class or possibly descendents can use it
 	void print_help_message (void);
@@ -78,8 +249,50 @@ protected:
 	// This method displays information about the status of the system
 	void show_status (void);
 
-   void motor_menu (void);
-	void motor_settings (void);
+	// This method draws or updates the live dashboard
+	void paint_dashboard (void);
+
+	// These methods find and run commands from the command table
+	void set_menu (uint8_t);
+	void handle_char (char);
+	void run_command (uint8_t, int32_t);
+	void finish_argument (void);
+
+	// These methods record commands into macros and play them back
+	void record_step (uint8_t, int32_t);
+	void start_macro (int32_t, bool);
+	void play_macro (void);
+	void stop_macro (void);
+	portTickType macro_wait (void);
+
+	// This method moves the aim-and-fire sequence along when its next step is ready
+	void step_aim (void);
+
+	// These methods carry out the commands; each row in the table points to one
+	void cmd_show_time (int32_t);
+	void cmd_dump_stacks (int32_t);
+	void cmd_show_version (int32_t);
+	void cmd_help (int32_t);
+	void cmd_reboot (int32_t);
+	void cmd_motor_menu (int32_t);
+	void cmd_main_menu (int32_t);
+	void cmd_set_steps (int32_t);
+	void cmd_fire (int32_t);
+	void cmd_set_position (int32_t);
+	void cmd_zero_encoder (int32_t);
+	void cmd_find_limit (int32_t);
+	void cmd_go_to_square (int32_t);
+	void cmd_record_macro (int32_t);
+	void cmd_end_macro (int32_t);
+	void cmd_play_macro (int32_t);
+	void cmd_play_timed (int32_t);
+	void cmd_macro_loops (int32_t);
+	void cmd_show_params (int32_t);
+	void cmd_select_param (int32_t);
+	void cmd_set_param (int32_t);
+	void cmd_show_shots (int32_t);
+	void cmd_dashboard (int32_t);
+	void cmd_notify_bench (int32_t);
 
 public:
 	// This constructor creates a user interface task object
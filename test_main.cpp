@@ -44,6 +44,7 @@
 #include "time_stamp.h"                     // Class to implement a microsecond timer
 #include "frt_task.h"                       // Header of wrapper for FreeRTOS tasks
 #include "frt_text_queue.h"                 // Wrapper for FreeRTOS character queues
+#include "frt_line_buffer.h"                // Whole-line printing through the console
 #include "frt_queue.h"                      // Header of wrapper for FreeRTOS queues
 #include "frt_shared_data.h"                // Header for thread-safe shared data
 #include "shares.h"                         // Global ('extern') queue declarations
@@ -54,6 +55,10 @@
 #include "task_P.h"
 #include "task_solenoid.h"
 #include "task_stepper.h"
+#include "params.h"                         // Tunable settings kept in EEPROM
+#include "sd_spi.h"                         // Driver for an SD card on the SPI port
+#include "task_logger.h"                    // Task which writes the data log
+#include "shot_trace.h"                     // Stage timing of aim-and-fire cycles
 
 
 /** This is the number of tasks which will be instantiated from the task_multi class.
@@ -62,6 +67,25 @@
  */
 const uint8_t N_MULTI_TASKS = 4;
 
+/** This is the stack size of the user interface task, in bytes. Its commands use much
+ *  more stack than the other tasks' loops do; see where the task is made.
+ */
+const size_t USER_STACK = 400;
+
+/** This is the stack size of the data logger's task, which is made only when the
+ *  program is built with \c DATA_LOGGER defined.
+ */
+const size_t LOGGER_STACK = 240;
+
+/** This is how much heap must still be free, after all the other tasks have been 
+ *  made, for the data logger to be made: room for its objects and their buffers, its
+ *  task's stack, and 64 more bytes for the task's control block and the heap's own
+ *  bookkeeping.
+ */
+const size_t LOGGER_HEAP_NEEDED = sizeof (frt_line_buffer) + LINE_BUFFER_SIZE 
+								  + sizeof (sd_spi) + sizeof (sector_logger) 
+								  + sizeof (task_logger) + LOGGER_STACK + 64;
+
 
 // Declare the queues which are used by tasks to communicate with each other here. 
 // Each queue must also be declared 'extern' in a header file which will be read 
@@ -137,6 +161,23 @@ shared_data<bool>* stepperDone;
 
 shared_data<bool>* doneFiring;
 
+/** This is the store of tunable settings, kept in EEPROM with a copy in RAM. 
+ */
+param_store* p_params;
+
+/** These are the control gains used by task_P. New gains are staged here by the user
+ *  interface and swapped in by task_P at the start of a control period.
+ */
+shadow_data<control_gains>* p_gains;
+
+/** This is the data log, which is written to an SD card by the logging task. 
+ */
+sector_logger* p_logger;
+
+/** This times the stages of each aim-and-fire cycle for the user interface.
+ */
+shot_trace* p_shots;
+
 
 //=====================================================================================
 /** The main function sets up the RTOS.  Some test tasks are created. Then the 
@@ -155,15 +196,18 @@ int main (void)
 	// Configure a serial port which can be used by a task to print debugging infor-
 	// mation, or to allow user interaction, or for whatever use is appropriate.  The
 	// serial port will be used by the user interface task after setup is complete and
-	// the task scheduler has been started by the function vTaskStartScheduler()
-	rs232 ser_port (9600, 1);
+	// the task scheduler has been started by the function vTaskStartScheduler().
+	// XON/XOFF flow control keeps the receiver buffer from overflowing at 115200 baud
+	rs232 ser_port (115200, 1);
+	ser_port.use_xon_xoff ();
 	ser_port << clrscr << PMS ("ME507/FreeRTOS Test Program") << endl;
 
-	// Create the queues and other shared data items here
-	print_ser_queue = new frt_text_queue (32, &ser_port, 10);
+	// Create the queues and other shared data items here. The print queue holds two
+	// lines from the tasks' line buffers
+	print_ser_queue = new frt_text_queue (2 * LINE_BUFFER_SIZE, &ser_port, 10, "Print");
 	count = new shared_data<int32_t>;
 	error = new shared_data<int32_t>;
-	p_queue_1 = new frt_queue<uint32_t> (20);
+	p_queue_1 = new frt_queue<uint32_t> (20, &ser_port, portMAX_DELAY, "Queue 1");
 	p_share_1 = new shared_data<uint32_t>;
 	power_1 = new shared_data<int16_t>;
 	brake_1 = new shared_data<bool>;
@@ -181,23 +225,93 @@ int main (void)
 
 	stepperDone = new shared_data<bool>;
 	doneFiring = new shared_data<bool>;
+
+	// Get the settings from EEPROM before anything which uses them is created
+	p_params = new param_store (param_pages, &param_defaults);
+	if (!p_params->load ())
+	{
+		ser_port << PMS ("No saved settings; using defaults") << endl;
+	}
+	control_gains starting_gains;
+	param_get_gains (&starting_gains);
+	p_gains = new shadow_data<control_gains> (starting_gains);
+	p_shots = new shot_trace;
+
+   // Each task except the user interface prints through its own line buffer, so its
+   // lines reach the console whole; drivers which print while the tasks are running
+   // share their tasks' buffers
+   emstream* p_step_out = new frt_line_buffer (print_ser_queue, &ser_port);
+
    //make new stepper here
-   Stepper* stepDrive = new Stepper(&ser_port, 200, 1, 2, &DDRA, &PORTA);
+   Stepper* stepDrive = new Stepper(p_step_out, 200, 1, 2, &DDRA, &PORTA);
    Solenoid* solDrive = new Solenoid(&ser_port, 0, &DDRA, &PORTA);
    motor_driver *p_my_motor_driver1 = new motor_driver(&ser_port, &DDRC, 0x07, &DDRB, 0x40, &PORTC, 0x04, &TCCR1A, 0xA9, &TCCR1B, 0x0B, &OCR1B);
 
 
    //make new task stepper here
-   new task_stepper("Stepper1", tskIDLE_PRIORITY + 1, 240, &ser_port, stepDrive, p_speed, p_numSteps);
-   new task_solenoid("Solenoid1", tskIDLE_PRIORITY + 1, 240, &ser_port, solDrive, p_fire);
-   new task_P ("P1", tskIDLE_PRIORITY + 1, 240, &ser_port, p_my_motor_driver1);
-   new task_motor ("Motor1", tskIDLE_PRIORITY + 1, 240, 3, p_my_motor_driver1, brake_1, power_1, pot_1, 1, &ser_port);
-   new task_encoder ("Encoder1", tskIDLE_PRIORITY + 1, 240, &ser_port, PE4, 0b01010101);
-   new task_encoder ("Encoder2", tskIDLE_PRIORITY + 1, 240, &ser_port, PE5, 0b01010101);
+   new task_stepper("Stepper1", tskIDLE_PRIORITY + 1, 240, p_step_out, stepDrive, p_speed, p_numSteps);
+   new task_solenoid("Solenoid1", tskIDLE_PRIORITY + 1, 240, 
+                    new frt_line_buffer (print_ser_queue, &ser_port), solDrive, p_fire);
+   new task_P ("P1", tskIDLE_PRIORITY + 1, 240, 
+               new frt_line_buffer (print_ser_queue, &ser_port), p_my_motor_driver1);
+   new task_motor ("Motor1", tskIDLE_PRIORITY + 1, 240, 3, p_my_motor_driver1, brake_1, power_1, pot_1, 1, 
+                   new frt_line_buffer (print_ser_queue, &ser_port));
+   new task_encoder ("Encoder1", tskIDLE_PRIORITY + 1, 240, 
+                     new frt_line_buffer (print_ser_queue, &ser_port), PE4, 0b01010101);
+   new task_encoder ("Encoder2", tskIDLE_PRIORITY + 1, 240, 
+                     new frt_line_buffer (print_ser_queue, &ser_port), PE5, 0b01010101);
 
 	// The user interface is at low priority; it could have been run in the idle task
 	// but it is desired to exercise the RTOS more thoroughly in this test program.
-	new task_user ("UserInt", tskIDLE_PRIORITY + 1, 240, &ser_port);
+	// Its stack is larger than the others', as its commands go deepest: painting the
+	// dashboard, the status tables, and the notification benchmark all print through
+	// several layers of calls, and the receiver ISR can now switch tasks from on top
+	// of them. If commands are added, run each one and then check that the task's 
+	// free stack, shown by 'v' and in the dashboard's Stack column, is still a few 
+	// dozen bytes
+	new task_user ("UserInt", tskIDLE_PRIORITY + 1, USER_STACK, &ser_port);
+
+	// The data log, which needs over a kilobyte for its sector buffers, is made last
+	// and only if there's room left for it, so it can't starve the tasks above. The 
+	// tasks check p_logger and don't log if it's NULL
+	p_logger = NULL;
+	#ifdef DATA_LOGGER
+		if (xPortGetFreeHeapSize () < LOGGER_HEAP_NEEDED)
+		{
+			ser_port << PMS ("Not enough memory; data log is off") << endl;
+		}
+		else
+		{
+			// The SD card's chip select is on PB4; the radio has PB0, and its interrupt
+			// on INT0 is held off while the card has the SPI port
+			emstream* p_log_out = new frt_line_buffer (print_ser_queue, &ser_port);
+			sd_spi* p_card = NULL;
+			sector_logger* p_new_log = NULL;
+			task_logger* p_log_task = NULL;
+			if (p_log_out != NULL)
+			{
+				p_card = new sd_spi (p_log_out, &DDRB, &PORTB, (1 << 4), 
+									 &EIMSK, (1 << INT0));
+			}
+			if (p_card != NULL)
+			{
+				p_new_log = new sector_logger (p_card, 0, 0);
+			}
+			if (p_new_log != NULL)
+			{
+				p_log_task = new task_logger ("Logger", tskIDLE_PRIORITY + 1, 
+											  LOGGER_STACK, p_log_out, p_new_log);
+			}
+			if (p_log_task != NULL && *p_log_task)
+			{
+				p_logger = p_new_log;
+			}
+			else
+			{
+				ser_port << PMS ("Can't make the data log") << endl;
+			}
+		}
+	#endif // DATA_LOGGER
 
 
 	// Print an empty line so that there's space between task hellos and help message
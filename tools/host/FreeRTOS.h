@@ -0,0 +1,30 @@
+//**************************************************************************************
+/** \file FreeRTOS.h
+ *    This file stands in for the FreeRTOS headers when driver code is compiled on a
+ *    PC. There is no scheduler: a test program runs the drivers from one loop, so
+ *    critical sections do nothing and the tick count comes from the PC's clock. */
+//**************************************************************************************
+
+#ifndef _HOST_FREERTOS_H_
+#define _HOST_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "host_avr.h"                       // For the PC's clock
+
+typedef uint32_t portTickType;
+typedef int8_t portBASE_TYPE;
+
+#define pdTRUE                 1
+#define pdFALSE                0
+#define configTICK_RATE_HZ     ((portTickType)1000)
+#define configCPU_CLOCK_HZ     ((uint32_t)16000000)
+#define portCLOCK_PRESCALER    ((uint32_t)64)
+#define configMS_TO_TICKS(x)   ((((x) * configTICK_RATE_HZ / 1000) > 0) \
+                               ? ((x) * configTICK_RATE_HZ / 1000) : 1)
+
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#endif // _HOST_FREERTOS_H_
@@ -0,0 +1,16 @@
+//**************************************************************************************
+/** \file interrupt.h
+ *    This file stands in for the AVR's interrupt header when driver code is compiled
+ *    on a PC. An interrupt service routine becomes an ordinary function with the
+ *    vector's name, which a simulated device calls when it raises the interrupt. */
+//**************************************************************************************
+
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+
+#define ISR(vector)    extern "C" void vector (void); extern "C" void vector (void)
+
+#define sei()
+#define cli()
+
+#endif // _HOST_AVR_INTERRUPT_H_
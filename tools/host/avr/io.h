@@ -0,0 +1,34 @@
+//**************************************************************************************
+/** \file io.h
+ *    This file stands in for the AVR's register definitions when driver code is
+ *    compiled on a PC. Only the registers and bits used by the radio drivers are
+ *    here. The output ports and SPI data register are objects which pass what's
+ *    written to them on to a simulated device; the rest are plain variables. */
+//**************************************************************************************
+
+#ifndef _HOST_AVR_IO_H_
+#define _HOST_AVR_IO_H_
+
+#include "host_avr.h"                       // Port objects and hooks
+
+extern host_port PORTB, PORTD, PORTE;
+extern uint8_t DDRB, DDRD, DDRE;
+extern uint8_t EICRA, EICRB, EIMSK;
+extern uint8_t SPCR, SPSR;
+extern host_spi_data SPDR;
+
+// Bits in the SPI registers
+#define SPR0     0
+#define MSTR     4
+#define SPE      6
+#define SPIF     7
+
+// Bits in the external interrupt registers
+#define INT0     0
+#define INT2     2
+#define INT7     7
+#define ISC01    1
+#define ISC21    5
+#define ISC71    7
+
+#endif // _HOST_AVR_IO_H_
@@ -0,0 +1,24 @@
+//**************************************************************************************
+/** \file pgmspace.h
+ *    This file stands in for the AVR's program memory header when driver code is
+ *    compiled on a PC, where constants in "flash" are just ordinary memory. */
+//**************************************************************************************
+
+#ifndef _HOST_AVR_PGMSPACE_H_
+#define _HOST_AVR_PGMSPACE_H_
+
+#include <string.h>
+
+#include "host_avr.h"                       // For itoa() and the like
+
+#define PROGMEM
+#define PSTR(s)                (s)
+#define pgm_read_byte(p)       (*(const uint8_t*)(p))
+#define pgm_read_byte_near(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)       (*(const uint16_t*)(p))
+#define pgm_read_dword(p)      (*(const uint32_t*)(p))
+#define strlen_P               strlen
+#define strcmp_P               strcmp
+#define memcpy_P               memcpy
+
+#endif // _HOST_AVR_PGMSPACE_H_
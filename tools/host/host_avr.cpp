@@ -0,0 +1,179 @@
+//**************************************************************************************
+/** \file host_avr.cpp
+ *    This file contains the registers, clocks and library functions which let AVR
+ *    driver code run on a PC. */
+//**************************************************************************************
+
+#include <stdio.h>
+#include <time.h>
+#include <sched.h>
+
+#include "avr/io.h"                         // The stand-in registers
+#include "task.h"                           // The stand-in tick count
+#include "emstream.h"                        // Needed by the time stamp header
+#include "time_stamp.h"                     // The board's microsecond clock
+
+
+// These are the stand-in registers
+host_port PORTB, PORTD, PORTE;
+uint8_t DDRB, DDRD, DDRE;
+uint8_t EICRA, EICRB, EIMSK;
+uint8_t SPCR, SPSR;
+host_spi_data SPDR;
+
+// These are the hooks through which a simulated device sees the registers
+void (*host_port_hook) (void) = NULL;
+uint8_t (*host_spi_hook) (uint8_t) = NULL;
+
+// These make the simulated board's clock differ from the PC's
+int64_t host_clock_offset_us = 0;
+int32_t host_clock_skew_ppm = 0;
+
+
+//--------------------------------------------------------------------------------------
+/** This operator sends a byte to the SPI device and keeps the byte which comes back.
+ *  @param to_send The byte written to the SPI data register
+ *  @return A reference to the register
+ */
+
+host_spi_data& host_spi_data::operator= (uint8_t to_send) {
+   received = host_spi_hook ? host_spi_hook (to_send) : 0xFF;
+   SPSR |= (1 << SPIF);
+   return (*this);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function reads the PC's monotonic clock. Every process on the PC sees the
+ *  same clock, so a time sent from one simulated node can be compared with the time
+ *  at which another received it.
+ *  @return The time in microseconds
+ */
+
+uint64_t host_time_us (void) {
+   struct timespec now;
+   clock_gettime (CLOCK_MONOTONIC, &now);
+   return ((uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function reads the simulated board's clock, which is the PC's clock with this
+ *  process's offset and crystal error added. Boards in different processes can be
+ *  given different clocks to test time synchronization.
+ *  @return The board's time in microseconds
+ */
+
+uint64_t host_board_us (void) {
+   int64_t now = (int64_t)host_time_us ();
+   return ((uint64_t)(now + now / 1000000 * host_clock_skew_ppm
+                      + (now % 1000000) * host_clock_skew_ppm / 1000000
+                      + host_clock_offset_us));
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method fills a time stamp from the simulated board's clock, split into RTOS
+ *  ticks and hardware timer counts as the AVR's timer would split it.
+ *  @return A reference to the time stamp
+ */
+
+time_stamp& time_stamp::set_to_now (void) {
+   uint64_t now = host_board_us ();
+   uint64_t us_per_tick = 1000000 / configTICK_RATE_HZ;
+   tick_count = (portTickType)(now / us_per_tick);
+   hardware_count = (HW_CTR_TYPE)((now % us_per_tick) * HW_TICK_RATE_HZ / 1000000);
+   return (*this);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This method fills a time stamp from within a simulated interrupt.
+ */
+
+void time_stamp::set_to_now_in_ISR (void) {
+   set_to_now ();
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function waits as the AVR's delay loops do, but lets other processes run
+ *  while it waits, so that two simulated nodes can share one CPU.
+ *  @param us The time to wait in microseconds
+ */
+
+void host_spin_us (uint32_t us) {
+   uint64_t until = host_time_us () + us;
+   while (host_time_us () < until) {
+      sched_yield ();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function gives the RTOS tick count: milliseconds since it was first called.
+ *  @return The number of ticks
+ */
+
+portTickType xTaskGetTickCount (void) {
+   static uint64_t start = host_time_us ();
+   return ((portTickType)((host_time_us () - start) / 1000));
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function gives the tick count from within a simulated interrupt.
+ *  @return The number of ticks
+ */
+
+portTickType xTaskGetTickCountFromISR (void) {
+   return (xTaskGetTickCount ());
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function stands in for a task's sleep. It waits for the given number of ticks
+ *  of the PC's clock, letting other processes run meanwhile as \c host_spin_us() does.
+ *  @param ticks The number of RTOS ticks, each a millisecond, to wait
+ */
+
+void vTaskDelay (portTickType ticks) {
+   host_spin_us ((uint32_t)ticks * 1000UL);
+}
+
+
+// These are the avr-libc number conversions which the serial stream classes use
+extern "C"
+{
+   char* ltoa (long num, char* str, int base) {
+      unsigned long mag = (num < 0 && base == 10) ? -(unsigned long)num : num;
+      char* p_start = str;
+      if (num < 0 && base == 10) {
+         *str++ = '-';
+      }
+      ultoa (mag, str, base);
+      return (p_start);
+   }
+
+   char* ultoa (unsigned long num, char* str, int base) {
+      char digits[33];
+      int count = 0;
+      do {
+         digits[count++] = "0123456789abcdefghijklmnopqrstuvwxyz"[num % base];
+         num /= base;
+      } while (num);
+      for (int index = 0; index < count; index++) {
+         str[index] = digits[count - 1 - index];
+      }
+      str[count] = '\0';
+      return (str);
+   }
+
+   char* itoa (int num, char* str, int base) {
+      return (ltoa (num, str, base));
+   }
+
+   char* utoa (unsigned int num, char* str, int base) {
+      return (ultoa (num, str, base));
+   }
+}
@@ -0,0 +1,115 @@
+//**************************************************************************************
+/** \file host_avr.h
+ *    This file contains the declarations which let AVR driver code be compiled and
+ *    run on a PC. The I/O port registers which drivers write are objects which tell
+ *    a hook function when they change, and the SPI data register hands each byte to
+ *    a hook which plays the part of the device on the other end of the SPI bus. It
+ *    also declares the AVR C library functions which a PC's library doesn't have,
+ *    and a clock which the RTOS tick count and the delays are taken from. */
+//**************************************************************************************
+
+#ifndef _HOST_AVR_H_
+#define _HOST_AVR_H_
+
+#ifndef __AVR__                             // Only for programs which run on a PC
+
+#include <stdint.h>
+
+
+/// This function is called whenever an I/O port register is written.
+extern void (*host_port_hook) (void);
+
+/// This function is given each byte written to the SPI data register and returns
+/// the byte which comes back from the SPI device.
+extern uint8_t (*host_spi_hook) (uint8_t);
+
+
+//--------------------------------------------------------------------------------------
+/** This class stands in for an 8-bit I/O port output register. Writing it in any way
+ *  calls \c host_port_hook, so that a simulated device can watch its pins.
+ */
+
+class host_port
+{
+protected:
+   /// The value last written to the register.
+   uint8_t value;
+
+public:
+   /// The constructor clears the register, as a reset does.
+   host_port (void) : value (0) { }
+
+   host_port& operator= (uint8_t new_value) {
+      value = new_value;
+      if (host_port_hook) {
+         host_port_hook ();
+      }
+      return (*this);
+   }
+
+   host_port& operator|= (uint8_t bits) {
+      return (*this = value | bits);
+   }
+
+   host_port& operator&= (uint8_t bits) {
+      return (*this = value & bits);
+   }
+
+   operator uint8_t (void) const {
+      return (value);
+   }
+};
+
+
+//--------------------------------------------------------------------------------------
+/** This class stands in for the SPI data register. Writing a byte exchanges it with
+ *  the device through \c host_spi_hook and sets the transfer complete flag; reading
+ *  gets the byte which came back.
+ */
+
+class host_spi_data
+{
+protected:
+   /// The byte which came back from the device in the last transfer.
+   uint8_t received;
+
+public:
+   /// The constructor clears the register.
+   host_spi_data (void) : received (0xFF) { }
+
+   host_spi_data& operator= (uint8_t to_send);
+
+   operator uint8_t (void) const {
+      return (received);
+   }
+};
+
+
+// These are the C library functions which avr-libc has and a PC's library doesn't
+extern "C"
+{
+   char* itoa (int, char*, int);
+   char* ltoa (long, char*, int);
+   char* utoa (unsigned int, char*, int);
+   char* ultoa (unsigned long, char*, int);
+}
+
+// Get the time in microseconds from the PC's monotonic clock, which all processes share
+uint64_t host_time_us (void);
+
+/// This is how far this process's simulated board clock is ahead of the PC's clock.
+extern int64_t host_clock_offset_us;
+
+/// This is how fast this process's simulated board clock runs, in parts per million
+/// fast (positive) or slow (negative), as a crystal's error would make it.
+extern int32_t host_clock_skew_ppm;
+
+// Get the time in microseconds from this process's simulated board clock
+uint64_t host_board_us (void);
+
+// Wait for a number of microseconds, as the AVR's delays do
+void host_spin_us (uint32_t);
+
+#endif // __AVR__
+
+#endif // _HOST_AVR_H_
@@ -0,0 +1,17 @@
+//**************************************************************************************
+/** \file task.h
+ *    This file stands in for the FreeRTOS task header when driver code is compiled
+ *    on a PC. Only the tick count functions and \c vTaskDelay() are here; one tick is
+ *    a millisecond of the PC's clock since the program started. */
+//**************************************************************************************
+
+#ifndef _HOST_TASK_H_
+#define _HOST_TASK_H_
+
+#include "FreeRTOS.h"
+
+portTickType xTaskGetTickCount (void);
+portTickType xTaskGetTickCountFromISR (void);
+void vTaskDelay (portTickType);
+
+#endif // _HOST_TASK_H_
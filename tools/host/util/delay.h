@@ -0,0 +1,16 @@
+//**************************************************************************************
+/** \file delay.h
+ *    This file stands in for the AVR's busy-wait delays when driver code is compiled
+ *    on a PC. The delays spin on the PC's clock, so they take about as long as they
+ *    would on the AVR. */
+//**************************************************************************************
+
+#ifndef _HOST_UTIL_DELAY_H_
+#define _HOST_UTIL_DELAY_H_
+
+#include "host_avr.h"                       // For host_spin_us()
+
+#define _delay_us(us)          host_spin_us ((uint32_t)(us))
+#define _delay_ms(ms)          host_spin_us ((uint32_t)(ms) * 1000UL)
+
+#endif // _HOST_UTIL_DELAY_H_
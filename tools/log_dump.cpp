@@ -0,0 +1,63 @@
+//**************************************************************************************
+/** \file log_dump.cpp
+ *    This file contains a program for a PC which prints the records in a data log 
+ *    from an SD card image, one record per line, as comma separated text which can 
+ *    be read by a spreadsheet or a plotting program. A time range can be given, in 
+ *    which case the log's index blocks are used to go straight to the start of the 
+ *    range instead of reading the whole log. Copy the card to an image file with a 
+ *    tool such as \c dd, then build and run this program on the PC:
+ *    \code
+ *    g++ -I../lib/sd_card -o log_dump log_dump.cpp ../lib/sd_card/log_reader.cpp \
+ *        ../lib/sd_card/host_file_device.cpp
+ *    ./log_dump card.img 0 60000 120000 > one_minute.csv
+ *    \endcode */
+//**************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host_file_device.h"               // Block device kept in a file on the PC
+#include "log_reader.h"                     // Reads records back from the data log
+
+
+//-------------------------------------------------------------------------------------
+/** The main function opens the card image, finds the start of the time range, and
+ *  prints each record's time, type, and data bytes until the end of the range. 
+ *  @param argc The number of command line arguments
+ *  @param argv The arguments: image file, first sector, start time, end time (ms)
+ *  @return 0 if the log was read, 1 if it couldn't be
+ */
+
+int main (int argc, char** argv)
+{
+   if (argc < 2) {
+      fprintf (stderr, "Usage: %s image [first_sector [start_ms [end_ms]]]\n", argv[0]);
+      return (1);
+   }
+   uint32_t first_sector = (argc > 2) ? strtoul (argv[2], NULL, 0) : 0;
+   uint32_t start_ms = (argc > 3) ? strtoul (argv[3], NULL, 0) : 0;
+   uint32_t end_ms = (argc > 4) ? strtoul (argv[4], NULL, 0) : 0xFFFFFFFF;
+
+   // The image's size isn't known, so let the reader find the end of the log
+   host_file_device card (argv[1], 0xFFFFFFFF);
+   log_reader reader (&card, first_sector);
+   log_entry entry;
+
+   if (!card.init () || !reader.seek_time (start_ms)) {
+      fprintf (stderr, "No log found in %s\n", argv[1]);
+      return (1);
+   }
+
+   printf ("time_ms,type,bytes\n");
+   while (reader.next (&entry) && entry.time <= end_ms) {
+      printf ("%lu,%u,", (unsigned long)entry.time, entry.type);
+      for (uint8_t index = 0; index < entry.size; index++) {
+         printf ("%02X", entry.p_data[index]);
+      }
+      printf ("\n");
+   }
+   fprintf (stderr, "%lu blocks read, %lu bad blocks skipped\n",
+            (unsigned long)reader.get_reads (), (unsigned long)reader.get_bad_blocks ());
+
+   return (0);
+}
@@ -0,0 +1,399 @@
+//**************************************************************************************
+/** \file radio_bench.cpp
+ *    This file contains a program for a PC which measures how well the nRF24L01 radio
+ *    drivers carry data, without any boards. It forks into two processes, each with
+ *    a simulated radio (see \c nRF24L01_host.h), joined by a socket which plays the
+ *    part of the air. The sender sends time stamps at a steady rate through the text
+ *    driver, the replicator or the star network; the receiver works out the goodput
+ *    (useful bytes per second) and the delay of each time stamp. Both use the PC's
+ *    monotonic clock, so the delays are real. In the \c sync mode, the receiver's
+ *    board clock is set far off and made to run fast, and the receiver follows the
+ *    sender's clock with \c nRF24L01_time_sync; the true error of its estimate is
+ *    compared with the error bound which the time keeper claims. The air can be made
+ *    to lose packets, add delay and jitter, and carry fewer bits per second, so a
+ *    protocol change can be judged before it's tried on a bench. Build and run it
+ *    from this directory:
+ *    \code
+ *    g++ -O2 -DSWOOP_BOARD -Ihost -I../lib/comm -I../lib/serial -I../lib/misc \
+ *        -I../lib/frtcpp \
+ *        -o radio_bench radio_bench.cpp host/host_avr.cpp ../lib/comm/nRF24L01_*.cpp \
+ *        ../lib/frtcpp/time_stamp_get_us.cpp ../lib/serial/emstream.cpp \
+ *        ../lib/serial/emstream_[biu]*.cpp ../lib/serial/emstream_pointer.cpp
+ *    ./radio_bench -m replica -l 50 -d 300 -j 200 -b 250000 -t 5 -r 100
+ *    \endcode */
+//**************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "nRF24L01_host.h"                  // The simulated radio and air
+#include "nRF24L01_text.h"                  // Text mode radio driver
+#include "nRF24L01_shared_data.h"           // Replicated data items
+#include "nRF24L01_star.h"                  // Polled star network
+#include "nRF24L01_time_sync.h"             // Time synchronization
+
+
+/// This is the largest number of delays which are kept for the percentiles.
+#define MAX_SAMPLES  100000
+
+
+//--------------------------------------------------------------------------------------
+/** This class is a serial stream which prints on the PC's standard output, so that the
+ *  drivers' own statistics can be printed.
+ */
+
+class stdout_stream : public emstream
+{
+public:
+   bool putchar (char a_char) {
+      fputc (a_char, stdout);
+      return (true);
+   }
+};
+
+
+// These are the measurements made by the receiver
+static uint32_t delays[MAX_SAMPLES];
+static uint32_t samples = 0;
+static uint32_t useful_bytes = 0;
+static uint64_t bound_total = 0;
+static uint32_t bound_exceeded = 0;
+
+
+//--------------------------------------------------------------------------------------
+/** This function gets the low 32 bits of the PC's clock, which is what is sent.
+ *  @return The time in microseconds
+ */
+
+static uint32_t stamp_now (void) {
+   return ((uint32_t)host_time_us ());
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function records the delay of a time stamp which has arrived.
+ *  @param stamp The time stamp
+ *  @param bytes The number of useful bytes which carried it
+ */
+
+static void record (uint32_t stamp, uint8_t bytes) {
+   if (samples < MAX_SAMPLES) {
+      delays[samples++] = stamp_now () - stamp;
+   }
+   useful_bytes += bytes;
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function finds how far the time keeper's estimate of the sender's clock is
+ *  from the truth. The sender's board clock is the PC's clock, so the truth is known.
+ *  @param p_sync The time keeper at the receiver
+ */
+
+static void check_sync (nRF24L01_time_sync* p_sync) {
+   uint32_t estimate = p_sync->to_remote (nRF24L01_time_sync::local_us ());
+   int32_t error = (int32_t)(estimate - (uint32_t)host_time_us ());
+   uint32_t bound = p_sync->get_error_us ();
+
+   if (error < 0) {
+      error = -error;
+   }
+   if (samples < MAX_SAMPLES) {
+      delays[samples++] = error;
+   }
+   bound_total += bound;
+   if ((uint32_t)error > bound) {
+      bound_exceeded++;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function reads time stamps, written as hexadecimal lines, from a stream.
+ *  @param p_stream The stream from which to read
+ */
+
+static void read_lines (emstream* p_stream) {
+   static char line[16];
+   static uint8_t length = 0;
+
+   while (p_stream->check_for_char ()) {
+      char a_char = (char)p_stream->getchar ();
+      if (a_char == '\n') {
+         line[length] = '\0';
+         if (length == 8) {
+            record ((uint32_t)strtoul (line, NULL, 16), length + 1);
+         }
+         length = 0;
+      }
+      else if (length < sizeof (line) - 1) {
+         line[length++] = a_char;
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function compares two delays for sorting.
+ */
+
+static int compare (const void* p_one, const void* p_two) {
+   uint32_t one = *(const uint32_t*)p_one;
+   uint32_t two = *(const uint32_t*)p_two;
+   return ((one > two) - (one < two));
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function prints the goodput and the spread of the delays.
+ *  @param sent The number of time stamps sent
+ *  @param seconds How long the test ran
+ */
+
+static void print_results (uint32_t sent, double seconds) {
+   printf ("Receiver: %u of %u stamps arrived, goodput %.0f bytes/s\n", samples, sent,
+           useful_bytes / seconds);
+   if (samples == 0) {
+      return;
+   }
+   qsort (delays, samples, sizeof (delays[0]), compare);
+   double total = 0;
+   for (uint32_t index = 0; index < samples; index++) {
+      total += delays[index];
+   }
+   printf ("Delay (us): min %u, mean %.0f, p50 %u, p99 %u, max %u\n", delays[0],
+           total / samples, delays[samples / 2], delays[(samples * 99) / 100],
+           delays[samples - 1]);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function prints the spread of the time keeper's true errors and how often
+ *  they were larger than the bound which it claimed.
+ */
+
+static void print_sync_results (void) {
+   printf ("Receiver: %u checks of the synchronized clock\n", samples);
+   if (samples == 0) {
+      return;
+   }
+   qsort (delays, samples, sizeof (delays[0]), compare);
+   double total = 0;
+   for (uint32_t index = 0; index < samples; index++) {
+      total += delays[index];
+   }
+   printf ("True error (us): mean %.0f, p50 %u, p99 %u, max %u\n", total / samples,
+           delays[samples / 2], delays[(samples * 99) / 100], delays[samples - 1]);
+   printf ("Claimed bound (us): mean %.0f, exceeded %u times\n",
+           (double)bound_total / samples, bound_exceeded);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function prints how to use the program.
+ *  @param name The program's name
+ */
+
+static void usage (const char* name) {
+   fprintf (stderr, "Usage: %s [-m text|replica|star|sync] [-l loss_per_1000] "
+            "[-d latency_us] [-j jitter_us]\n       [-b bits_per_s] [-t seconds] "
+            "[-r stamps_or_requests_per_s] [-k skew_ppm] [-s seed]\n", name);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** The main function reads the options, forks into the sender and the receiver, and
+ *  runs the chosen driver in each until the time is up. The receiver tells the
+ *  sender how many stamps were sent through a pipe so the results can be printed
+ *  together.
+ *  @param argc The number of command line arguments
+ *  @param argv The arguments
+ *  @return 0 if the test ran, 1 if it couldn't be started
+ */
+
+int main (int argc, char** argv) {
+   const char* mode = "text";
+   nRF24_air air;
+   double seconds = 5.0;
+   uint32_t rate = 50;
+   unsigned int seed = 1;
+   int32_t skew_ppm = 40;
+   int option;
+
+   memset (&air, 0, sizeof (air));
+   air.bit_rate = 2000000;
+   air.spi_byte_us = 4;
+
+   while ((option = getopt (argc, argv, "m:l:d:j:b:t:r:k:s:")) != -1) {
+      switch (option) {
+         case 'm': mode = optarg; break;
+         case 'l': air.loss_per_1000 = atoi (optarg); break;
+         case 'd': air.latency_us = atoi (optarg); break;
+         case 'j': air.jitter_us = atoi (optarg); break;
+         case 'b': air.bit_rate = atoi (optarg); break;
+         case 't': seconds = atof (optarg); break;
+         case 'r': rate = atoi (optarg); break;
+         case 'k': skew_ppm = atoi (optarg); break;
+         case 's': seed = atoi (optarg); break;
+         default: usage (argv[0]); return (1);
+      }
+   }
+   bool text = (strcmp (mode, "text") == 0);
+   bool replica = (strcmp (mode, "replica") == 0);
+   bool star = (strcmp (mode, "star") == 0);
+   bool sync = (strcmp (mode, "sync") == 0);
+   if (!(text || replica || star || sync) || air.bit_rate == 0) {
+      usage (argv[0]);
+      return (1);
+   }
+
+   int air_sockets[2], count_pipe[2];
+   if (socketpair (AF_UNIX, SOCK_DGRAM, 0, air_sockets) != 0 || pipe (count_pipe) != 0) {
+      perror ("radio_bench");
+      return (1);
+   }
+   fflush (stdout);
+   pid_t child = fork ();
+   bool sender = (child != 0);
+
+   // The receiver's board was started long after the sender's and its crystal is off
+   if (sync && !sender) {
+      host_clock_offset_us = -1234567890LL;
+      host_clock_skew_ppm = skew_ppm;
+   }
+
+   nRF24_host_start (air_sockets[sender ? 0 : 1], &air, seed * 2 + (sender ? 1 : 0));
+   stdout_stream console;
+   nRF24L01_text radio;
+   radio.set_RX_address (0xA4, 0x05, 0x01, 0);
+   radio.set_TX_address (0xA4, 0x05, 0x01);
+
+   // The sender is node 1 of a star network and the receiver is the base station
+   static const uint8_t address[nRF24_ADDR_WIDTH] = {0xA4, 0x05, 0x10};
+   nRF24L01_replicator* p_replicator = NULL;
+   nRF24L01_shared_data<uint32_t>* p_stamp = NULL;
+   nRF24L01_star* p_star = NULL;
+   nRF24L01_time_sync* p_sync = NULL;
+   if (replica) {
+      p_replicator = new nRF24L01_replicator (&radio, 250);
+      p_stamp = new nRF24L01_shared_data<uint32_t> (p_replicator, 1, sender, 0, 1000);
+   }
+   else if (star) {
+      p_star = new nRF24L01_star (&radio, sender ? 1 : 0, address, 5);
+      if (!sender) {
+         p_star->add_node (1);
+      }
+   }
+   else if (sync) {
+      p_sync = new nRF24L01_time_sync (&radio, sender, rate ? 1000 / rate : 1000);
+   }
+
+   uint64_t start = host_time_us ();
+   uint64_t stop = start + (uint64_t)(seconds * 1e6);
+   uint64_t period = rate ? 1000000ULL / rate : 0;
+   uint64_t next_at = start;
+   uint32_t sent = 0;
+   uint32_t last_stamp = 0;
+
+   // The receiver keeps listening a little longer for stamps still on their way
+   uint64_t now;
+   while ((now = host_time_us ()) < (sender ? stop : stop + 250000)) {
+      sched_yield ();
+      nRF24_host_poll ();
+
+      if (sender && now >= stop) {
+         continue;
+      }
+      if (sender && !sync && now >= next_at) {
+         next_at += period;
+         char line[12];
+         snprintf (line, sizeof (line), "%08x\n", stamp_now ());
+         if (text) {
+            radio << line;
+         }
+         else if (replica) {
+            p_stamp->put (stamp_now ());
+         }
+         else {
+            *(p_star->link (1)) << line;
+         }
+         sent++;
+      }
+
+      if (replica) {
+         p_replicator->service ();
+         uint32_t stamp = p_stamp->get ();
+         if (!sender && stamp != last_stamp) {
+            record (stamp, sizeof (stamp));
+            last_stamp = stamp;
+         }
+      }
+      else if (star) {
+         p_star->service ();
+         if (!sender) {
+            read_lines (p_star->link (1));
+         }
+      }
+      else if (sync) {
+         p_sync->service ();
+         if (!sender && now >= next_at && p_sync->is_synced ()) {
+            next_at = now + 50000;
+            check_sync (p_sync);
+         }
+      }
+      else if (!sender) {
+         read_lines (&radio);
+      }
+   }
+
+   if (sender) {
+      ssize_t written = write (count_pipe[1], &sent, sizeof (sent));
+      (void)written;
+      waitpid (child, NULL, 0);
+      uint16_t packets, retries, failures;
+      radio.take_tx_counts (packets, retries, failures);
+      printf ("Sender: %u stamps sent in %u packets, %u retries, %u failures\n", sent,
+              packets, retries, failures);
+      nRF24_host_print_stats (stdout, "Sender");
+      if (replica) {
+         p_replicator->print_stats (&console);
+      }
+      else if (star) {
+         p_star->print_stats (&console);
+      }
+      else if (sync) {
+         p_sync->print_stats (&console);
+      }
+      fflush (stdout);
+   }
+   else {
+      if (read (count_pipe[0], &sent, sizeof (sent)) != sizeof (sent)) {
+         sent = 0;
+      }
+      printf ("Mode %s, loss %u/1000, latency %u+%u us, %u bit/s, %u stamps/s\n", mode,
+              air.loss_per_1000, air.latency_us, air.jitter_us, air.bit_rate, rate);
+      if (sync) {
+         print_sync_results ();
+      }
+      else {
+         print_results (sent, seconds);
+      }
+      nRF24_host_print_stats (stdout, "Receiver");
+      if (replica) {
+         p_replicator->print_stats (&console);
+      }
+      else if (star) {
+         p_star->print_stats (&console);
+      }
+      else if (sync) {
+         p_sync->print_stats (&console);
+      }
+      fflush (stdout);
+   }
+   return (0);
+}
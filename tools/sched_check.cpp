@@ -0,0 +1,121 @@
+//**************************************************************************************
+/** \file sched_check.cpp
+ *    This file contains a program for a PC which checks whether a set of tasks can
+ *    always meet their deadlines. It reads one task per line: a name, the shortest
+ *    period in microseconds, the longest execution time in microseconds, and
+ *    optionally a deadline in microseconds. Lines which don't start that way, such as
+ *    headings and comments, are skipped, so the table printed on the target when
+ *    \c TASK_PROFILE is defined can be pasted in as it is. The program gives the
+ *    tasks rate-monotonic or deadline-monotonic priorities, prints each task's
+ *    worst-case response time and the priority table to use in \c test_main.cpp, and
+ *    exits with status 1 if any task can miss its deadline:
+ *    \code
+ *    g++ -I../lib/frtcpp -o sched_check sched_check.cpp ../lib/frtcpp/sched_analysis.cpp
+ *    ./sched_check -d -l 3 -t 40 tasks.txt
+ *    \endcode */
+//**************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sched_analysis.h"                 // Response time analysis of the tasks
+
+
+//-------------------------------------------------------------------------------------
+/** The main function reads the tasks, assigns their priorities, works out their
+ *  response times and prints the results.
+ *  @param argc The number of command line arguments
+ *  @param argv The arguments: \c -d for deadline-monotonic priorities instead of
+ *              rate-monotonic, \c -l for the number of priority levels, \c -t for the
+ *              tick interrupt's run time in microseconds, then the file of tasks
+ *  @return 0 if every task meets its deadline, 1 if not or if there was an error
+ */
+
+int main (int argc, char** argv)
+{
+   bool deadline_monotonic = false;
+   uint8_t levels = 3;
+   uint32_t tick_us = 0;
+   int option;
+
+   while ((option = getopt (argc, argv, "dl:t:")) != -1) {
+      switch (option) {
+         case 'd':
+            deadline_monotonic = true;
+            break;
+         case 'l':
+            levels = (uint8_t)atoi (optarg);
+            break;
+         case 't':
+            tick_us = strtoul (optarg, NULL, 0);
+            break;
+         default:
+            fprintf (stderr, "Usage: %s [-d] [-l levels] [-t tick_us] file\n", argv[0]);
+            return (1);
+      }
+   }
+   FILE* p_file = (optind < argc) ? fopen (argv[optind], "r") : stdin;
+   if (p_file == NULL || levels == 0) {
+      fprintf (stderr, "Can't read the tasks\n");
+      return (1);
+   }
+
+   static char names[SCHED_MAX_TASKS][32];
+   sched_task tasks[SCHED_MAX_TASKS];
+   uint8_t count = 0;
+   char line[256];
+
+   while (fgets (line, sizeof (line), p_file) && count < SCHED_MAX_TASKS) {
+      unsigned long period, wcet, deadline = 0;
+      if (sscanf (line, "%31s %lu %lu %lu", names[count], &period, &wcet, &deadline)
+          < 3 || names[count][0] == '#') {
+         continue;
+      }
+      tasks[count].name = names[count];
+      tasks[count].period = period;
+      tasks[count].wcet = wcet;
+      tasks[count].deadline = (deadline == period) ? 0 : deadline;
+      tasks[count].priority = 0;
+      count++;
+   }
+
+   sched_assign_priorities (tasks, count, deadline_monotonic, levels);
+   bool all_met = sched_find_responses (tasks, count, tick_us);
+   uint16_t used = sched_utilisation (tasks, count, tick_us);
+
+   printf ("%s priorities, %u levels, tick ISR %lu us, utilisation %u.%u%%\n",
+           deadline_monotonic ? "Deadline-monotonic" : "Rate-monotonic", levels,
+           (unsigned long)tick_us, used / 10, used % 10);
+   printf ("%-16s%10s%10s%10s%10s%6s\n", "Task", "Period", "WCET", "Deadline",
+           "Response", "Pri.");
+   for (uint8_t index = 0; index < count; index++) {
+      const sched_task* p_task = tasks + index;
+      char response[16];
+
+      if (p_task->period == 0) {
+         strcpy (response, "-");
+      }
+      else if (p_task->response == SCHED_UNBOUNDED) {
+         strcpy (response, "MISS");
+      }
+      else {
+         sprintf (response, "%lu", (unsigned long)p_task->response);
+      }
+      printf ("%-16s%10lu%10lu%10lu%10s%6u\n", p_task->name,
+              (unsigned long)p_task->period, (unsigned long)p_task->wcet,
+              (unsigned long)sched_deadline (p_task), response, p_task->new_priority);
+   }
+
+   printf ("\nPriorities for test_main.cpp:\n");
+   for (uint8_t index = 0; index < count; index++) {
+      printf ("   %-16s task_priority (%u)\n", tasks[index].name,
+              tasks[index].new_priority);
+   }
+   if (!all_met) {
+      printf ("\nNOT SCHEDULABLE: tasks marked MISS can miss their deadlines\n");
+   }
+
+   return (all_met ? 0 : 1);
+}
@@ -0,0 +1,321 @@
+//**************************************************************************************
+/** \file uart_demux.cpp
+ *    This file contains a program for a PC which sorts the frames sent by a board's
+ *    \c uart_mux back into separate streams. One channel, the console unless another
+ *    is chosen, is shown on the screen; each of the others is written to its own
+ *    file, so telemetry can be saved at full rate while the console is used. Keys
+ *    typed at the PC are sent to the board's console, or in frames to another
+ *    channel such as the command channel. A file captured from the serial port can
+ *    be read instead of the port itself. Use \c -x or \c -r to match the flow control
+ *    which the board's serial port uses. Build and run it from this directory:
+ *    \code
+ *    g++ -I../lib/serial -o uart_demux uart_demux.cpp ../lib/serial/mux_frame.cpp
+ *    ./uart_demux -b 115200 -x -p run1_ /dev/ttyUSB0
+ *    \endcode */
+//**************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/select.h>
+
+#include "mux_frame.h"                      // Packing and unpacking of frames
+
+
+/// The files to which the channels not shown on the screen are written.
+static FILE* files[MUX_MAX_CHANNELS];
+
+/// The number of frames and characters which came on each channel.
+static unsigned long frames[MUX_MAX_CHANNELS], bytes[MUX_MAX_CHANNELS];
+
+/// The terminal settings of the keyboard, put back when the program ends.
+static struct termios saved_keyboard;
+static bool keyboard_changed = false;
+
+/// This is set by the interrupt signal, so the program can stop cleanly.
+static volatile sig_atomic_t stopping = 0;
+
+
+//--------------------------------------------------------------------------------------
+/** This function notes that the user pressed Ctrl-C.
+ *  @param signal_number The number of the signal, which isn't needed
+ */
+
+static void stop (int signal_number) {
+   (void)signal_number;
+   stopping = 1;
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function finds the terminal speed code for a baud rate.
+ *  @param baud The baud rate
+ *  @return The speed code, or 0 if the rate isn't one which is supported
+ */
+
+static speed_t speed_code (long baud) {
+   switch (baud) {
+      case 9600: return (B9600);
+      case 19200: return (B19200);
+      case 38400: return (B38400);
+      case 57600: return (B57600);
+      case 115200: return (B115200);
+      case 230400: return (B230400);
+      default: return (0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function opens a serial port and sets it up to pass bytes through unchanged,
+ *  except for any flow control.
+ *  @param path The name of the port, such as /dev/ttyUSB0
+ *  @param baud The baud rate
+ *  @param xon_xoff True to stop and start with XON and XOFF characters
+ *  @param rts_cts True to stop and start with the RTS and CTS lines
+ *  @return The file descriptor of the port, or -1 if it couldn't be set up
+ */
+
+static int open_port (const char* path, long baud, bool xon_xoff, bool rts_cts) {
+   int port = open (path, O_RDWR | O_NOCTTY);
+   struct termios settings;
+
+   if (port < 0 || tcgetattr (port, &settings) != 0) {
+      perror (path);
+      return (-1);
+   }
+   cfmakeraw (&settings);
+   cfsetispeed (&settings, speed_code (baud));
+   cfsetospeed (&settings, speed_code (baud));
+   settings.c_cflag |= CLOCAL | CREAD;
+   if (xon_xoff) {
+      settings.c_iflag |= IXON | IXOFF;
+   }
+   if (rts_cts) {
+      settings.c_cflag |= CRTSCTS;
+   }
+   settings.c_cc[VMIN] = 1;
+   settings.c_cc[VTIME] = 0;
+   if (tcsetattr (port, TCSANOW, &settings) != 0) {
+      perror (path);
+      return (-1);
+   }
+   return (port);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function sets the keyboard to send each key as it's pressed, without echo,
+ *  so the board's user interface sees keys just as it would from a terminal program.
+ */
+
+static void keys_at_once (void) {
+   struct termios settings;
+
+   if (!isatty (STDIN_FILENO) || tcgetattr (STDIN_FILENO, &saved_keyboard) != 0) {
+      return;
+   }
+   settings = saved_keyboard;
+   settings.c_lflag &= ~(ICANON | ECHO);
+   settings.c_cc[VMIN] = 1;
+   settings.c_cc[VTIME] = 0;
+   tcsetattr (STDIN_FILENO, TCSANOW, &settings);
+   keyboard_changed = true;
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function writes the contents of a frame, or a character which came outside
+ *  any frame, to the screen or to the channel's file.
+ *  @param channel The channel number
+ *  @param p_data A pointer to the characters
+ *  @param length The number of characters
+ *  @param shown The channel which is shown on the screen
+ *  @param prefix The start of the names of the channels' files
+ */
+
+static void save (uint8_t channel, const uint8_t* p_data, uint8_t length,
+                  uint8_t shown, const char* prefix) {
+   FILE* p_out = stdout;
+
+   if (channel != shown) {
+      if (files[channel] == NULL) {
+         char name[256];
+         snprintf (name, sizeof (name), "%s%u.txt", prefix, channel);
+         files[channel] = fopen (name, "wb");
+         if (files[channel] == NULL) {
+            perror (name);
+            return;
+         }
+      }
+      p_out = files[channel];
+   }
+   fwrite (p_data, 1, length, p_out);
+   fflush (p_out);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function sends the keys which were typed at the PC to the board. Keys for
+ *  the console are sent just as they were typed; keys for any other channel are put
+ *  into frames.
+ *  @param port The serial port
+ *  @param p_keys A pointer to the keys
+ *  @param count The number of keys
+ *  @param channel The channel to which the keys are sent
+ */
+
+static void send_keys (int port, const uint8_t* p_keys, ssize_t count, uint8_t channel) {
+   if (channel == MUX_CONSOLE) {
+      if (write (port, p_keys, count) != count) {
+         perror ("uart_demux");
+      }
+      return;
+   }
+   while (count > 0) {
+      uint8_t length = (count > MUX_FRAME_SIZE) ? MUX_FRAME_SIZE : (uint8_t)count;
+      uint8_t wire[MUX_WIRE_SIZE];
+      uint8_t size = mux_frame_encode (channel, p_keys, length, wire);
+
+      if (write (port, wire, size) != size) {
+         perror ("uart_demux");
+      }
+      p_keys += length;
+      count -= length;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------
+/** This function prints how to use the program.
+ *  @param name The program's name
+ */
+
+static void usage (const char* name) {
+   fprintf (stderr, "Usage: %s [-b baud] [-x|-r] [-c shown_channel] "
+            "[-s send_channel] [-p file_prefix]\n       port|capture_file|-\n", name);
+}
+
+
+//--------------------------------------------------------------------------------------
+/** The main function reads the options, opens the port or capture file, and sorts
+ *  frames into the channels until the input ends or Ctrl-C is pressed. Then it
+ *  prints how much came on each channel.
+ *  @param argc The number of command line arguments
+ *  @param argv The arguments
+ *  @return 0 if the input was read, 1 if it couldn't be opened
+ */
+
+int main (int argc, char** argv) {
+   long baud = 115200;
+   bool xon_xoff = false;
+   bool rts_cts = false;
+   uint8_t shown = MUX_CONSOLE;
+   uint8_t send_to = MUX_CONSOLE;
+   const char* prefix = "channel_";
+   int option;
+
+   while ((option = getopt (argc, argv, "b:xrc:s:p:")) != -1) {
+      switch (option) {
+         case 'b': baud = atol (optarg); break;
+         case 'x': xon_xoff = true; break;
+         case 'r': rts_cts = true; break;
+         case 'c': shown = atoi (optarg); break;
+         case 's': send_to = atoi (optarg); break;
+         case 'p': prefix = optarg; break;
+         default: usage (argv[0]); return (1);
+      }
+   }
+   if (optind != argc - 1 || speed_code (baud) == 0 || shown >= MUX_MAX_CHANNELS
+       || send_to >= MUX_MAX_CHANNELS) {
+      usage (argv[0]);
+      return (1);
+   }
+
+   // A serial port is set up and gets keys from the keyboard; a capture file is
+   // just read through
+   const char* path = argv[optind];
+   bool is_port = false;
+   int input = STDIN_FILENO;
+   if (strcmp (path, "-") != 0) {
+      input = open (path, O_RDONLY);
+      if (input >= 0 && isatty (input)) {
+         close (input);
+         input = open_port (path, baud, xon_xoff, rts_cts);
+         is_port = true;
+      }
+      if (input < 0) {
+         perror (path);
+         return (1);
+      }
+   }
+   if (is_port) {
+      keys_at_once ();
+   }
+   signal (SIGINT, stop);
+
+   mux_frame_decoder decoder;
+   uint8_t buffer[256];
+   while (!stopping) {
+      fd_set ready;
+      FD_ZERO (&ready);
+      FD_SET (input, &ready);
+      if (is_port) {
+         FD_SET (STDIN_FILENO, &ready);
+      }
+      if (select (input + 1, &ready, NULL, NULL, NULL) < 0) {
+         break;
+      }
+
+      if (is_port && FD_ISSET (STDIN_FILENO, &ready)) {
+         ssize_t count = read (STDIN_FILENO, buffer, sizeof (buffer));
+         if (count <= 0) {
+            break;
+         }
+         send_keys (input, buffer, count, send_to);
+      }
+      if (FD_ISSET (input, &ready)) {
+         ssize_t count = read (input, buffer, sizeof (buffer));
+         if (count <= 0) {
+            break;
+         }
+         for (ssize_t index = 0; index < count; index++) {
+            switch (decoder.take (buffer[index])) {
+               case MUX_RAW:
+                  // Printed before the board's multiplexer started, so it's console
+                  save (MUX_CONSOLE, buffer + index, 1, shown, prefix);
+                  break;
+               case MUX_GOOD:
+                  save (decoder.get_channel (), decoder.get_data (),
+                        decoder.get_length (), shown, prefix);
+                  frames[decoder.get_channel ()]++;
+                  bytes[decoder.get_channel ()] += decoder.get_length ();
+                  break;
+               default:
+                  break;
+            }
+         }
+      }
+   }
+
+   if (keyboard_changed) {
+      tcsetattr (STDIN_FILENO, TCSANOW, &saved_keyboard);
+   }
+   fprintf (stderr, "\nChannel  Frames    Bytes\n");
+   for (uint8_t channel = 0; channel < MUX_MAX_CHANNELS; channel++) {
+      if (frames[channel] != 0) {
+         fprintf (stderr, "%7u %7lu %8lu\n", channel, frames[channel], bytes[channel]);
+      }
+      if (files[channel] != NULL) {
+         fclose (files[channel]);
+      }
+   }
+   fprintf (stderr, "%u good frames, %u bad frames\n", decoder.get_good_frames (),
+            decoder.get_bad_frames ());
+
+   return (0);
+}